@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+// Time growing and shrinking an array along its last axis, which adds or removes chunks in the
+// middle of the offsets index, for a sparse super-chunk and for in-memory and on-disk frames.
+
+# include <caterva.h>
+# include <inttypes.h>
+
+int main() {
+    blosc_timestamp_t t0, t1;
+
+    int nresizes = 10;
+
+    int8_t ndim = 2;
+    uint8_t itemsize = sizeof(int64_t);
+
+    int64_t shape[] = {2000, 200};
+    int32_t chunkshape[] = {10, 10};
+    int32_t blockshape[] = {5, 5};
+
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 4;
+
+    caterva_ctx_t *ctx;
+    caterva_ctx_new(&cfg, &ctx);
+
+    char *urlpath = "bench_resize.b2frame";
+    const char *names[] = {"sparse", "frame", "frame on disk"};
+
+    for (int backend = 0; backend < 3; ++backend) {
+        caterva_params_t params;
+        params.itemsize = itemsize;
+        params.ndim = ndim;
+        for (int i = 0; i < ndim; ++i) {
+            params.shape[i] = shape[i];
+        }
+
+        caterva_storage_t storage = {0};
+        storage.contiguous = backend > 0;
+        storage.urlpath = backend == 2 ? urlpath : NULL;
+        for (int i = 0; i < ndim; ++i) {
+            storage.chunkshape[i] = chunkshape[i];
+            storage.blockshape[i] = blockshape[i];
+        }
+
+        caterva_remove(ctx, urlpath);
+        caterva_array_t *arr;
+        CATERVA_ERROR(caterva_zeros(ctx, &params, &storage, &arr));
+
+        // Every resize adds (or removes) a column of chunks in the middle of each row
+        int64_t new_shape[CATERVA_MAX_DIM];
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        new_shape[0] = shape[0];
+        start[1] = shape[1] / 2;
+
+        blosc_set_timestamp(&t0);
+        for (int i = 0; i < nresizes; ++i) {
+            new_shape[1] = arr->shape[1] + chunkshape[1];
+            CATERVA_ERROR(caterva_resize(ctx, arr, new_shape, start));
+        }
+        blosc_set_timestamp(&t1);
+        printf("%s, extend: %.4f s (%" PRId64 " chunks)\n", names[backend],
+               blosc_elapsed_secs(t0, t1), arr->nchunks);
+
+        blosc_set_timestamp(&t0);
+        for (int i = 0; i < nresizes; ++i) {
+            new_shape[1] = arr->shape[1] - chunkshape[1];
+            CATERVA_ERROR(caterva_resize(ctx, arr, new_shape, start));
+        }
+        blosc_set_timestamp(&t1);
+        printf("%s, shrink: %.4f s (%" PRId64 " chunks)\n", names[backend],
+               blosc_elapsed_secs(t0, t1), arr->nchunks);
+
+        caterva_free(ctx, &arr);
+    }
+    caterva_remove(ctx, urlpath);
+
+    caterva_ctx_free(&ctx);
+
+    return 0;
+}
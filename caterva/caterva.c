@@ -12,8 +12,12 @@
 #include <caterva.h>
 
 #include "caterva_utils.h"
+#include "caterva_internal.h"
 #include "blosc2.h"
 #include <inttypes.h>
+#ifdef CATERVA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 
 int caterva_ctx_new(caterva_config_t *cfg, caterva_ctx_t **ctx) {
@@ -51,6 +55,28 @@ int caterva_ctx_free(caterva_ctx_t **ctx) {
 // Only for internal use
 int caterva_update_shape(caterva_array_t *array, int8_t ndim, const int64_t *shape,
                                const int32_t *chunkshape, const int32_t *blockshape) {
+    // The statistics are kept for the chunks whose items do not change
+    int8_t old_ndim = 0;
+    int64_t old_shape[CATERVA_MAX_DIM];
+    int32_t old_chunkshape[CATERVA_MAX_DIM];
+    int32_t old_blockshape[CATERVA_MAX_DIM];
+    if (array->stats != NULL) {
+        old_ndim = array->ndim;
+        memcpy(old_shape, array->shape, sizeof(old_shape));
+        memcpy(old_chunkshape, array->chunkshape, sizeof(old_chunkshape));
+        memcpy(old_blockshape, array->blockshape, sizeof(old_blockshape));
+    }
+    // The overviews are rebuilt when the shape changes
+    if (array->overviews != NULL) {
+        bool reshaped = ndim != array->ndim;
+        for (int i = 0; i < ndim && !reshaped; ++i) {
+            reshaped = shape[i] != array->shape[i];
+        }
+        if (reshaped) {
+            CATERVA_ERROR(caterva_overviews_invalidate(array));
+        }
+    }
+
     array->ndim = ndim;
     array->nitems = 1;
     array->extnitems = 1;
@@ -122,6 +148,10 @@ int caterva_update_shape(caterva_array_t *array, int8_t ndim, const int64_t *sha
             array->chunk_array_strides[i] = 0;
         }
     }
+    if (array->stats != NULL) {
+        CATERVA_ERROR(caterva_stats_reshape(array, old_ndim, old_shape, old_chunkshape,
+                                            old_blockshape));
+    }
     if (array->sc) {
         uint8_t *smeta = NULL;
         // Serialize the dimension info ...
@@ -148,7 +178,485 @@ int caterva_update_shape(caterva_array_t *array, int8_t ndim, const int64_t *sha
     return CATERVA_SUCCEED;
 }
 
-// Only for internal use
+// Only for internal use: the number of chunks in each row of chunks along the first axis
+int64_t ring_chunks_per_row(caterva_array_t *array) {
+    int64_t nchunks = 1;
+    for (int i = 1; i < array->ndim; ++i) {
+        nchunks *= array->extshape[i] / array->chunkshape[i];
+    }
+    return nchunks;
+}
+
+// Only for internal use: the position of a chunk in the super-chunk
+static int64_t caterva_physical_nchunk(caterva_array_t *array, int64_t nchunk) {
+    struct caterva_ring_s *ring = array->ring;
+    if (ring == NULL || ring->capacity == 0) {
+        return nchunk;
+    }
+    int64_t per_row = ring_chunks_per_row(array);
+    int64_t row = (ring->origin + nchunk / per_row) % ring->capacity;
+    return row * per_row + nchunk % per_row;
+}
+
+static int ring_store(caterva_array_t *array) {
+    // Build an array with 3 entries (version, origin, capacity)
+    uint8_t sdata[1 + 1 + 2 * (1 + sizeof(int64_t))];
+    uint8_t *pdata = sdata;
+    *pdata++ = 0x90 + 3;
+    *pdata++ = CATERVA_METALAYER_VERSION;
+    *pdata++ = 0xd3;  // int64
+    swap_store(pdata, &array->ring->origin, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    *pdata++ = 0xd3;  // int64
+    swap_store(pdata, &array->ring->capacity, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+
+    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+    int rc;
+    if (blosc2_vlmeta_exists(array->sc, "caterva_ring") < 0) {
+        rc = blosc2_vlmeta_add(array->sc, "caterva_ring", sdata, (int32_t) sizeof(sdata), &cparams);
+    } else {
+        rc = blosc2_vlmeta_update(array->sc, "caterva_ring", sdata, (int32_t) sizeof(sdata),
+                                  &cparams);
+    }
+    if (rc < 0) {
+        CATERVA_TRACE_ERROR("Error storing the ring buffer layout");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+static int ring_load(caterva_array_t *array) {
+    if (blosc2_vlmeta_exists(array->sc, "caterva_ring") < 0) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *sdata;
+    int32_t sdata_len;
+    if (blosc2_vlmeta_get(array->sc, "caterva_ring", &sdata, &sdata_len) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    if (sdata_len != 1 + 1 + 2 * (1 + sizeof(int64_t))) {
+        free(sdata);
+        CATERVA_TRACE_ERROR("The ring buffer layout is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    struct caterva_ring_s *ring = array->cfg->alloc(sizeof(struct caterva_ring_s));
+    CATERVA_ERROR_NULL(ring);
+    uint8_t *pdata = sdata + 3;
+    swap_store(&ring->origin, pdata, sizeof(int64_t));
+    pdata += 1 + sizeof(int64_t);
+    swap_store(&ring->capacity, pdata, sizeof(int64_t));
+    free(sdata);
+    array->ring = ring;
+    return CATERVA_SUCCEED;
+}
+
+// Only for internal use: store the chunks in the natural order and remove the unused ones
+static int ring_normalize(caterva_array_t *array) {
+    struct caterva_ring_s *ring = array->ring;
+    if (ring == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    int64_t nrows = array->extshape[0] / array->chunkshape[0];
+    if (ring->origin == 0 && ring->capacity == nrows) {
+        return CATERVA_SUCCEED;
+    }
+    int64_t per_row = ring_chunks_per_row(array);
+    int64_t nchunks = ring->capacity * per_row;
+    if (ring->origin != 0 && nchunks > 0) {
+        int64_t *order = malloc(nchunks * sizeof(int64_t));
+        CATERVA_ERROR_NULL(order);
+        for (int64_t i = 0; i < nchunks; ++i) {
+            order[i] = ((ring->origin + i / per_row) % ring->capacity) * per_row + i % per_row;
+        }
+        int rc = blosc2_schunk_reorder_offsets(array->sc, order);
+        free(order);
+        if (rc < 0) {
+            CATERVA_TRACE_ERROR("Blosc error when reordering the chunks");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+    for (int64_t i = nchunks - 1; i >= nrows * per_row; --i) {
+        if (blosc2_schunk_delete_chunk(array->sc, i) < 0) {
+            CATERVA_TRACE_ERROR("Blosc error when deleting a chunk");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+    ring->origin = 0;
+    ring->capacity = nrows;
+    array->nchunks = array->sc->nchunks;
+    CATERVA_ERROR(ring_store(array));
+
+    return CATERVA_SUCCEED;
+}
+
+
+// Chunk access
+
+// The postfilter applied to the reads of the user
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    int64_t nchunk;
+    //!< The chunk being decompressed.
+} caterva_postfilter_state_t;
+
+// Compute the coordinates of a block: the ones of its chunk in the grid of chunks, the ones of
+// its first item in the array and the shape of its items inside the array
+void caterva_block_coords(caterva_array_t *array, int64_t nchunk, int64_t nblock,
+                          int64_t *chunk_coords, int64_t *block_start,
+                          int32_t *block_shape) {
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        int64_t nchunks_i = array->extshape[i] / array->chunkshape[i];
+        int64_t nblocks_i = array->extchunkshape[i] / array->blockshape[i];
+        chunk_coords[i] = nchunk % nchunks_i;
+        nchunk /= nchunks_i;
+        int64_t offset = nblock % nblocks_i * array->blockshape[i];
+        nblock /= nblocks_i;
+        block_start[i] = chunk_coords[i] * array->chunkshape[i] + offset;
+        int64_t size = array->blockshape[i];
+        if (size > array->chunkshape[i] - offset) {
+            size = array->chunkshape[i] - offset;
+        }
+        if (size > array->shape[i] - block_start[i]) {
+            size = array->shape[i] - block_start[i];
+        }
+        block_shape[i] = (int32_t) (size > 0 ? size : 0);
+    }
+}
+
+// Pass a decompressed block to the postfilter of the context
+static int caterva_postfilter_block(caterva_postfilter_state_t *state, int32_t offset,
+                                    const uint8_t *input, uint8_t *output, int32_t size,
+                                    int tid) {
+    caterva_array_t *array = state->array;
+    caterva_postfilter_params_t block = {0};
+    block.user_data = state->ctx->cfg->postparams;
+    block.ndim = array->ndim;
+    block.itemsize = array->itemsize;
+    block.nchunk = state->nchunk;
+    block.nblock = (int32_t) (offset / (array->blocknitems * array->itemsize));
+    caterva_block_coords(array, block.nchunk, block.nblock, block.chunk_coords,
+                         block.block_start, block.block_shape);
+    for (int i = 0; i < array->ndim; ++i) {
+        block.blockshape[i] = array->blockshape[i];
+    }
+    block.input = input;
+    block.output = output;
+    block.size = size;
+    block.tid = tid;
+    if (state->ctx->cfg->postfilter(&block) != 0) {
+        CATERVA_TRACE_ERROR("The postfilter failed");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+static int caterva_postfilter_trampoline(blosc2_postfilter_params *params) {
+    return caterva_postfilter_block((caterva_postfilter_state_t *) params->user_data,
+                                    params->offset, params->input, params->output, params->size,
+                                    params->tid);
+}
+
+// Create a decompression context that passes every block to the postfilter of the context. The
+// chunk being decompressed must be set in @p state before every decompression.
+static blosc2_context *caterva_create_postfilter_dctx(caterva_postfilter_state_t *state) {
+    blosc2_dparams *dparams;
+    if (blosc2_schunk_get_dparams(state->array->sc, &dparams) < 0) {
+        return NULL;
+    }
+    blosc2_postfilter_params postparams = {0};
+    postparams.user_data = state;
+    dparams->nthreads = state->ctx->cfg->nthreads;
+    dparams->postfilter = caterva_postfilter_trampoline;
+    dparams->postparams = &postparams;
+    blosc2_context *dctx = blosc2_create_dctx(*dparams);
+    free(dparams);
+    return dctx;
+}
+
+// Create a decompression context for a thread that decompresses whole chunks by itself
+blosc2_context *caterva_create_thread_dctx(caterva_array_t *array) {
+    blosc2_dparams *dparams;
+    if (blosc2_schunk_get_dparams(array->sc, &dparams) < 0) {
+        return NULL;
+    }
+    dparams->nthreads = 1;
+    blosc2_context *dctx = blosc2_create_dctx(*dparams);
+    free(dparams);
+    return dctx;
+}
+
+// Decompress a chunk with a context owned by the calling thread
+int caterva_decompress_chunk_ctx(caterva_array_t *array, int64_t nchunk,
+                                 blosc2_context *dctx, uint8_t *data, int32_t nbytes) {
+    // The chunks kept by the buffered append mode are newer than the ones in the super-chunk
+    uint8_t *buffered = append_buffer_chunk(array, nchunk);
+    if (buffered != NULL) {
+        memcpy(data, buffered, nbytes);
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *chunk;
+    bool needs_free;
+    int cbytes = caterva_get_chunk_locked(array, nchunk, &chunk, &needs_free);
+    if (cbytes < 0) {
+        CATERVA_TRACE_ERROR("Blosc can not get the chunk");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int rc = blosc2_decompress_ctx(dctx, chunk, cbytes, data, nbytes);
+    if (needs_free) {
+        free(chunk);
+    }
+    if (rc < 0) {
+        CATERVA_TRACE_ERROR("Error decompressing chunk");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Create the lock of the chunks of an array (see caterva_schunk_lock_s)
+static int caterva_schunk_lock_new(caterva_array_t *array) {
+    array->schunk_lock = NULL;
+#ifdef CATERVA_HAVE_PTHREAD
+    struct caterva_schunk_lock_s *lock = array->cfg->alloc(sizeof(struct caterva_schunk_lock_s));
+    CATERVA_ERROR_NULL(lock);
+    if (pthread_rwlock_init(&lock->rwlock, NULL) != 0) {
+        array->cfg->free(lock);
+        CATERVA_TRACE_ERROR("Can not create the lock of the chunks");
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    array->schunk_lock = lock;
+#endif
+    return CATERVA_SUCCEED;
+}
+
+static void caterva_schunk_lock_free(caterva_array_t *array) {
+#ifdef CATERVA_HAVE_PTHREAD
+    if (array->schunk_lock != NULL) {
+        pthread_rwlock_destroy(&array->schunk_lock->rwlock);
+        array->cfg->free(array->schunk_lock);
+    }
+#endif
+    array->schunk_lock = NULL;
+}
+
+// Get a chunk of the super-chunk under the lock of its chunks. The gets of a frame are exclusive,
+// as blosc decodes its offsets with the context of the super-chunk (see caterva_array_t).
+int caterva_get_chunk_locked(caterva_array_t *array, int64_t nchunk, uint8_t **chunk,
+                             bool *needs_free) {
+#ifdef CATERVA_HAVE_PTHREAD
+    struct caterva_schunk_lock_s *lock = array->schunk_lock;
+    if (lock != NULL && array->sc->frame != NULL) {
+        pthread_rwlock_wrlock(&lock->rwlock);
+    } else if (lock != NULL) {
+        pthread_rwlock_rdlock(&lock->rwlock);
+    }
+#endif
+    int cbytes = blosc2_schunk_get_chunk(array->sc, caterva_physical_nchunk(array, nchunk), chunk,
+                                         needs_free);
+#ifdef CATERVA_HAVE_PTHREAD
+    if (lock != NULL) {
+        pthread_rwlock_unlock(&lock->rwlock);
+    }
+#endif
+    return cbytes;
+}
+
+// Replace a chunk of the super-chunk under the write lock of its chunks. The super-chunk owns
+// the chunk, unless the update fails.
+static int64_t caterva_update_chunk_locked(caterva_array_t *array, int64_t nchunk,
+                                           uint8_t *chunk) {
+#ifdef CATERVA_HAVE_PTHREAD
+    struct caterva_schunk_lock_s *lock = array->schunk_lock;
+    if (lock != NULL) {
+        pthread_rwlock_wrlock(&lock->rwlock);
+    }
+#endif
+    int64_t rc = blosc2_schunk_update_chunk(array->sc, caterva_physical_nchunk(array, nchunk),
+                                            chunk, false);
+#ifdef CATERVA_HAVE_PTHREAD
+    if (lock != NULL) {
+        pthread_rwlock_unlock(&lock->rwlock);
+    }
+#endif
+    return rc;
+}
+
+static int caterva_pool_init(struct caterva_context_pool_s *pool) {
+    pool->ncontexts = 0;
+    pool->capacity = 0;
+    pool->contexts = NULL;
+#ifdef CATERVA_HAVE_PTHREAD
+    if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+        CATERVA_TRACE_ERROR("Can not create the lock of the contexts");
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+#endif
+    return CATERVA_SUCCEED;
+}
+
+// Take an idle context from a pool, or NULL if there is none
+static blosc2_context *caterva_pool_take(struct caterva_context_pool_s *pool) {
+    blosc2_context *context = NULL;
+    if (pool == NULL) {
+        return NULL;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_lock(&pool->mutex);
+#endif
+    if (pool->ncontexts > 0) {
+        context = pool->contexts[--pool->ncontexts];
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_unlock(&pool->mutex);
+#endif
+    return context;
+}
+
+// Keep an idle context in a pool (or free it if there is no room for it)
+static void caterva_pool_give(struct caterva_context_pool_s *pool, blosc2_context *context) {
+    if (pool == NULL) {
+        blosc2_free_ctx(context);
+        return;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_lock(&pool->mutex);
+#endif
+    if (pool->ncontexts == pool->capacity) {
+        int capacity = pool->capacity == 0 ? 4 : 2 * pool->capacity;
+        blosc2_context **contexts = realloc(pool->contexts, capacity * sizeof(blosc2_context *));
+        if (contexts != NULL) {
+            pool->contexts = contexts;
+            pool->capacity = capacity;
+        }
+    }
+    if (pool->ncontexts < pool->capacity) {
+        pool->contexts[pool->ncontexts++] = context;
+        context = NULL;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_unlock(&pool->mutex);
+#endif
+    if (context != NULL) {
+        blosc2_free_ctx(context);
+    }
+}
+
+static void caterva_pool_destroy(struct caterva_context_pool_s *pool) {
+    for (int i = 0; i < pool->ncontexts; ++i) {
+        blosc2_free_ctx(pool->contexts[i]);
+    }
+    free(pool->contexts);
+    pool->contexts = NULL;
+    pool->ncontexts = 0;
+    pool->capacity = 0;
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_destroy(&pool->mutex);
+#endif
+}
+
+// Take a decompression context for a read of the array from its pool (or create a new one). The
+// context must be given back with caterva_release_dctx.
+blosc2_context *caterva_acquire_dctx(caterva_array_t *array) {
+    blosc2_context *dctx = caterva_pool_take(array->dctx_pool);
+    if (dctx != NULL) {
+        return dctx;
+    }
+    // The context uses the threads of the super-chunk, like the reads did with its own context
+    blosc2_dparams *dparams;
+    if (blosc2_schunk_get_dparams(array->sc, &dparams) < 0) {
+        return NULL;
+    }
+    dctx = blosc2_create_dctx(*dparams);
+    free(dparams);
+    return dctx;
+}
+
+// Give back a context taken with caterva_acquire_dctx. The context of a read that failed (whose
+// return code is @p rc) is freed, since it may still keep the mask of blocks of that read.
+void caterva_release_dctx(caterva_array_t *array, blosc2_context *dctx, int rc) {
+    if (rc != CATERVA_SUCCEED) {
+        blosc2_free_ctx(dctx);
+        return;
+    }
+    caterva_pool_give(array->dctx_pool, dctx);
+}
+
+static void caterva_dctx_pool_free(caterva_array_t *array) {
+    if (array->dctx_pool == NULL) {
+        return;
+    }
+    caterva_pool_destroy(array->dctx_pool);
+    array->cfg->free(array->dctx_pool);
+    array->dctx_pool = NULL;
+}
+
+// Take a compression context for a write of the array. The writes share the context of the
+// super-chunk, unless the chunk locks are enabled and they can run concurrently.
+static blosc2_context *caterva_acquire_cctx(caterva_array_t *array) {
+    if (array->chunk_locks == NULL) {
+        return array->sc->cctx;
+    }
+    blosc2_context *cctx = caterva_pool_take(&array->chunk_locks->cctx_pool);
+    if (cctx != NULL) {
+        return cctx;
+    }
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        return NULL;
+    }
+    cctx = blosc2_create_cctx(*cparams);
+    free(cparams);
+    return cctx;
+}
+
+static void caterva_release_cctx(caterva_array_t *array, blosc2_context *cctx) {
+    if (cctx != array->sc->cctx) {
+        caterva_pool_give(&array->chunk_locks->cctx_pool, cctx);
+    }
+}
+
+// Create a compression context for a thread that compresses whole chunks by itself. When
+// @p prefilter is not NULL, it produces the blocks of every chunk compressed by the context.
+blosc2_context *caterva_create_thread_cctx(caterva_array_t *array,
+                                           blosc2_prefilter_fn prefilter,
+                                           void *user_data) {
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        return NULL;
+    }
+    blosc2_prefilter_params pparams = {0};
+    pparams.user_data = user_data;
+    cparams->nthreads = 1;
+    cparams->prefilter = prefilter;
+    cparams->preparams = prefilter != NULL ? &pparams : NULL;
+    blosc2_context *cctx = blosc2_create_cctx(*cparams);
+    free(cparams);
+    return cctx;
+}
+
+// Compress a chunk with a context owned by the calling thread and replace it in the array
+int caterva_compress_chunk_ctx(caterva_array_t *array, int64_t nchunk,
+                               blosc2_context *cctx, const uint8_t *data, int32_t nbytes) {
+    int32_t chunk_nbytes = nbytes + BLOSC2_MAX_OVERHEAD;
+    uint8_t *chunk = malloc(chunk_nbytes);
+    CATERVA_ERROR_NULL(chunk);
+    if (blosc2_compress_ctx(cctx, data, nbytes, chunk, chunk_nbytes) < 0) {
+        free(chunk);
+        CATERVA_TRACE_ERROR("Blosc can not compress the data");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    if (caterva_update_chunk_locked(array, nchunk, chunk) < 0) {
+        free(chunk);
+        CATERVA_TRACE_ERROR("Blosc can not update the chunk");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+
+// Arrays
+
 int caterva_array_without_schunk(caterva_ctx_t *ctx, caterva_params_t *params,
                                        caterva_storage_t *storage, caterva_array_t **array) {
     /* Create a caterva_array_t buffer */
@@ -156,13 +664,48 @@ int caterva_array_without_schunk(caterva_ctx_t *ctx, caterva_params_t *params,
     CATERVA_ERROR_NULL(*array);
 
     (*array)->cfg = (caterva_config_t *) ctx->cfg->alloc(sizeof(caterva_config_t));
+    if ((*array)->cfg == NULL) {
+        ctx->cfg->free(*array);
+        *array = NULL;
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
     memcpy((*array)->cfg, ctx->cfg, sizeof(caterva_config_t));
 
     (*array)->sc = NULL;
+    (*array)->stats = NULL;
+    (*array)->overviews = NULL;
+    (*array)->chunk_locks = NULL;
+    (*array)->schunk_lock = NULL;
+    (*array)->dctx_pool = ctx->cfg->alloc(sizeof(struct caterva_context_pool_s));
+    int rc = CATERVA_ERR_NULL_POINTER;
+    if ((*array)->dctx_pool != NULL) {
+        rc = caterva_pool_init((*array)->dctx_pool);
+        if (rc != CATERVA_SUCCEED) {
+            ctx->cfg->free((*array)->dctx_pool);
+            (*array)->dctx_pool = NULL;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_schunk_lock_new(*array);
+    }
 
     (*array)->ndim = params->ndim;
     (*array)->itemsize = params->itemsize;
 
+    // Fill the chunkshape and blockshape left to zero by the user
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_compute_storage_shapes(params, storage);
+    }
+    // Unwind the partially built array
+    if (rc != CATERVA_SUCCEED) {
+        caterva_dctx_pool_free(*array);
+        caterva_schunk_lock_free(*array);
+        ctx->cfg->free((*array)->cfg);
+        ctx->cfg->free(*array);
+        *array = NULL;
+        CATERVA_ERROR(rc);
+    }
+
     int64_t *shape = params->shape;
     int32_t *chunkshape = storage->chunkshape;
     int32_t *blockshape = storage->blockshape;
@@ -172,6 +715,8 @@ int caterva_array_without_schunk(caterva_ctx_t *ctx, caterva_params_t *params,
     // The partition cache (empty initially)
     (*array)->chunk_cache.data = NULL;
     (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
+    (*array)->append_buffer = NULL;
+    (*array)->ring = NULL;
 
     if ((*array)->nitems != 0) {
         (*array)->nchunks = (*array)->extnitems / (*array)->chunknitems;
@@ -361,16 +906,18 @@ int caterva_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *schunk, caterva_array
     caterva_ctx_t *ctx_sc;
     caterva_ctx_new(&cfg, &ctx_sc);
 
-    caterva_array_without_schunk(ctx_sc, &params, &storage, array);
+    int rc = caterva_array_without_schunk(ctx_sc, &params, &storage, array);
 
     caterva_ctx_free(&ctx_sc);
 
-    (*array)->sc = schunk;
-
-    if ((*array) == NULL) {
+    if (rc != CATERVA_SUCCEED || (*array) == NULL) {
         CATERVA_TRACE_ERROR("Error creating a caterva container from a frame");
         return CATERVA_ERR_NULL_POINTER;
     }
+    (*array)->sc = schunk;
+    CATERVA_ERROR(ring_load(*array));
+    CATERVA_ERROR(caterva_stats_load(*array));
+    CATERVA_ERROR(caterva_overviews_load(*array));
 
     return CATERVA_SUCCEED;
 }
@@ -384,6 +931,8 @@ caterva_to_cframe(caterva_ctx_t *ctx, caterva_array_t *array, uint8_t **cframe,
     CATERVA_ERROR_NULL(cframe_len);
     CATERVA_ERROR_NULL(needs_free);
 
+    CATERVA_ERROR(caterva_flush(ctx, array));
+    CATERVA_ERROR(ring_normalize(array));
     *cframe_len = blosc2_schunk_to_buffer(array->sc, cframe, needs_free);
     if (*cframe_len <= 0) {
         CATERVA_TRACE_ERROR("Error serializing the caterva array");
@@ -425,8 +974,18 @@ int caterva_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **arra
 int caterva_free(caterva_ctx_t *ctx, caterva_array_t **array) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(caterva_flush(ctx, *array));
+    CATERVA_ERROR(caterva_disable_append_buffer(ctx, *array));
+    CATERVA_ERROR(caterva_disable_chunk_locks(ctx, *array));
     void (*free)(void *) = (*array)->cfg->free;
 
+    if ((*array)->ring != NULL) {
+        free((*array)->ring);
+    }
+    caterva_stats_free(*array);
+    caterva_overviews_free(ctx, *array);
+    caterva_dctx_pool_free(*array);
+    caterva_schunk_lock_free(*array);
     free((*array)->cfg);
     if (*array) {
         if ((*array)->sc != NULL) {
@@ -488,99 +1047,580 @@ int caterva_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
 }
 
 
-// Only for internal use: It is used for setting slices and for getting slices.
-int caterva_blosc_slice(caterva_ctx_t *ctx, void *buffer,
-                        int64_t buffersize, int64_t *start, int64_t *stop, int64_t *shape,
-                        caterva_array_t *array, bool set_slice) {
-    CATERVA_ERROR_NULL(ctx);
-    CATERVA_ERROR_NULL(buffer);
-    CATERVA_ERROR_NULL(start);
-    CATERVA_ERROR_NULL(stop);
-    CATERVA_ERROR_NULL(array);
-    if (buffersize < 0) {
-        CATERVA_TRACE_ERROR("buffersize is < 0");
-        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+// Only for internal use: compress an uncompressed chunk and store it in the super-chunk
+static int caterva_commit_chunk(caterva_array_t *array, int64_t nchunk, uint8_t *data,
+                                int32_t data_nbytes) {
+    int32_t chunk_nbytes = data_nbytes + BLOSC2_MAX_OVERHEAD;
+    uint8_t *chunk = malloc(chunk_nbytes);
+    blosc2_context *cctx = caterva_acquire_cctx(array);
+    if (chunk == NULL || cctx == NULL) {
+        free(chunk);
+        CATERVA_TRACE_ERROR("Can not allocate the compression resources");
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    int brc = blosc2_compress_ctx(cctx, data, data_nbytes, chunk, chunk_nbytes);
+    caterva_release_cctx(array, cctx);
+    if (brc < 0) {
+        free(chunk);
+        CATERVA_TRACE_ERROR("Blosc can not compress the data");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    if (caterva_update_chunk_locked(array, nchunk, chunk) < 0) {
+        free(chunk);
+        CATERVA_TRACE_ERROR("Blosc can not update the chunk");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
     }
+    caterva_stats_update(array, nchunk, data);
+    return CATERVA_SUCCEED;
+}
 
-    uint8_t *buffer_b = (uint8_t *) buffer;
-    int64_t *buffer_start = start;
-    int64_t *buffer_stop = stop;
-    int64_t *buffer_shape = shape;
+// Returns the append buffer slot of a chunk, or -1 if the chunk can not be buffered
+static int64_t append_buffer_slot(caterva_array_t *array, const int64_t *nchunk_ndim) {
+    struct caterva_append_buffer_s *buf = array->append_buffer;
+    if (buf == NULL) {
+        return -1;
+    }
+    int64_t slot = 0;
+    for (int i = 0; i < array->ndim; ++i) {
+        if (i == buf->axis) {
+            continue;
+        }
+        slot = slot * (array->extshape[i] / array->chunkshape[i]) + nchunk_ndim[i];
+    }
+    return slot;
+}
 
-    int8_t ndim = array->ndim;
+// Returns the uncompressed data of a chunk kept by the buffered append mode, or NULL if the
+// chunk is only in the super-chunk
+uint8_t *append_buffer_chunk(caterva_array_t *array, int64_t nchunk) {
+    struct caterva_append_buffer_s *buf = array->append_buffer;
+    if (buf == NULL) {
+        return NULL;
+    }
+    int64_t chunks_in_array[CATERVA_MAX_DIM];
+    for (int i = 0; i < array->ndim; ++i) {
+        chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
+    }
+    int64_t nchunk_ndim[CATERVA_MAX_DIM];
+    blosc2_unidim_to_multidim(array->ndim, chunks_in_array, nchunk, nchunk_ndim);
+    int64_t slot = append_buffer_slot(array, nchunk_ndim);
+    return buf->rows[slot] == nchunk_ndim[buf->axis] ? buf->chunks[slot] : NULL;
+}
 
-    // 0-dim case
-    if (ndim == 0) {
-        if (set_slice) {
-            int32_t chunk_size = array->itemsize + BLOSC2_MAX_OVERHEAD;
-            uint8_t *chunk = malloc(chunk_size);
-            if (blosc2_compress_ctx(array->sc->cctx, buffer_b, array->itemsize, chunk, chunk_size) < 0) {
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
-            }
-            if (blosc2_schunk_update_chunk(array->sc, 0, chunk, false) < 0) {
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
-            }
+// Whether some chunks are kept by the buffered append mode
+bool append_buffer_pending(caterva_array_t *array) {
+    struct caterva_append_buffer_s *buf = array->append_buffer;
+    if (buf == NULL) {
+        return false;
+    }
+    for (int64_t slot = 0; slot < buf->nslots; ++slot) {
+        if (buf->rows[slot] >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        } else {
-            if (blosc2_schunk_decompress_chunk(array->sc, 0, buffer_b, array->itemsize) < 0) {
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+// Whether a resize keeps the position of the buffered chunks, that is, the array only grows at
+// the end of the buffered axis
+static bool append_buffer_kept(caterva_array_t *array, const int64_t *new_shape,
+                               const int64_t *start) {
+    struct caterva_append_buffer_s *buf = array->append_buffer;
+    if (buf == NULL) {
+        return true;
+    }
+    for (int i = 0; i < array->ndim; ++i) {
+        if (i != buf->axis) {
+            if (new_shape[i] != array->shape[i]) {
+                return false;
             }
+        } else if (new_shape[i] < array->shape[i] ||
+                   (new_shape[i] > array->shape[i] && start != NULL &&
+                    start[i] != array->shape[i])) {
+            return false;
         }
-        return CATERVA_SUCCEED;
     }
+    return true;
+}
 
+static int append_buffer_flush_slot(caterva_array_t *array, int64_t slot) {
+    struct caterva_append_buffer_s *buf = array->append_buffer;
+    if (buf->rows[slot] < 0) {
+        return CATERVA_SUCCEED;
+    }
+    // Recover the chunk coordinates from the slot
+    int64_t nchunk = 0;
+    int64_t rest = slot;
+    int64_t stride = 1;
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        int64_t nchunks_i = array->extshape[i] / array->chunkshape[i];
+        int64_t coord;
+        if (i == buf->axis) {
+            coord = buf->rows[slot];
+        } else {
+            coord = rest % nchunks_i;
+            rest /= nchunks_i;
+        }
+        nchunk += coord * stride;
+        stride *= nchunks_i;
+    }
     int32_t data_nbytes = (int32_t) array->extchunknitems * array->itemsize;
-    uint8_t *data = malloc(data_nbytes);
+    CATERVA_ERROR(caterva_commit_chunk(array, nchunk, buf->chunks[slot], data_nbytes));
+    buf->ncommits++;
+    array->cfg->free(buf->chunks[slot]);
+    buf->chunks[slot] = NULL;
+    buf->rows[slot] = -1;
+    return CATERVA_SUCCEED;
+}
 
-    int64_t chunks_in_array[CATERVA_MAX_DIM] = {0};
-    for (int i = 0; i < ndim; ++i) {
-        chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
+int append_buffer_flush(caterva_array_t *array) {
+    if (array->append_buffer == NULL) {
+        return CATERVA_SUCCEED;
     }
-
-    int64_t chunks_in_array_strides[CATERVA_MAX_DIM];
-    chunks_in_array_strides[ndim - 1] = 1;
-    for (int i = ndim - 2; i >= 0; --i) {
-        chunks_in_array_strides[i] = chunks_in_array_strides[i + 1] * chunks_in_array[i + 1];
+    for (int64_t slot = 0; slot < array->append_buffer->nslots; ++slot) {
+        CATERVA_ERROR(append_buffer_flush_slot(array, slot));
     }
+    return CATERVA_SUCCEED;
+}
 
-    int64_t blocks_in_chunk[CATERVA_MAX_DIM] = {0};
-    for (int i = 0; i < ndim; ++i) {
-        blocks_in_chunk[i] = array->extchunkshape[i] / array->blockshape[i];
+int caterva_flush(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(append_buffer_flush(array));
+    if (array->stats != NULL && array->stats->dirty) {
+        CATERVA_ERROR(caterva_stats_store(array));
     }
+    return CATERVA_SUCCEED;
+}
 
-    // Compute the number of chunks to update
-    int64_t update_start[CATERVA_MAX_DIM];
-    int64_t update_shape[CATERVA_MAX_DIM];
+int caterva_enable_append_buffer(caterva_ctx_t *ctx, caterva_array_t *array, int8_t axis) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
 
-    int64_t update_nchunks = 1;
-    for (int i = 0; i < ndim; ++i) {
-        int64_t pos = 0;
-        while (pos <= buffer_start[i]) {
-            pos += array->chunkshape[i];
-        }
-        update_start[i] = pos / array->chunkshape[i] - 1;
-        while (pos < buffer_stop[i]) {
-            pos += array->chunkshape[i];
-        }
-        update_shape[i] = pos / array->chunkshape[i] - update_start[i];
-        update_nchunks *= update_shape[i];
+    if (axis < 0 || axis >= array->ndim) {
+        CATERVA_TRACE_ERROR("`axis` must be lower than the number of dimensions");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (array->chunk_locks != NULL) {
+        CATERVA_TRACE_ERROR("The buffered append mode can not be combined with the chunk locks");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
     }
+    CATERVA_ERROR(caterva_disable_append_buffer(ctx, array));
 
-    for (int update_nchunk = 0; update_nchunk < update_nchunks; ++update_nchunk) {
-        int64_t nchunk_ndim[CATERVA_MAX_DIM] = {0};
-        blosc2_unidim_to_multidim(ndim, update_shape, update_nchunk, nchunk_ndim);
-        for (int i = 0; i < ndim; ++i) {
-            nchunk_ndim[i] += update_start[i];
+    struct caterva_append_buffer_s *buf = array->cfg->alloc(sizeof(struct caterva_append_buffer_s));
+    CATERVA_ERROR_NULL(buf);
+    buf->axis = axis;
+    buf->ncommits = 0;
+    buf->nslots = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        if (i != axis) {
+            buf->nslots *= array->extshape[i] / array->chunkshape[i];
         }
-        int64_t nchunk;
-        blosc2_multidim_to_unidim(nchunk_ndim, ndim, chunks_in_array_strides, &nchunk);
+    }
+    buf->rows = array->cfg->alloc(buf->nslots * sizeof(int64_t));
+    buf->chunks = array->cfg->alloc(buf->nslots * sizeof(uint8_t *));
+    for (int64_t slot = 0; slot < buf->nslots; ++slot) {
+        buf->rows[slot] = -1;
+        buf->chunks[slot] = NULL;
+    }
+    array->append_buffer = buf;
 
-        // check if the chunk needs to be updated
-        int64_t chunk_start[CATERVA_MAX_DIM] = {0};
-        int64_t chunk_stop[CATERVA_MAX_DIM] = {0};
-        for (int i = 0; i < ndim; ++i) {
-            chunk_start[i] = nchunk_ndim[i] * array->chunkshape[i];
-            chunk_stop[i] = chunk_start[i] + array->chunkshape[i];
+    return CATERVA_SUCCEED;
+}
+
+int caterva_disable_append_buffer(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    if (array->append_buffer == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    CATERVA_ERROR(caterva_flush(ctx, array));
+    array->cfg->free(array->append_buffer->rows);
+    array->cfg->free(array->append_buffer->chunks);
+    array->cfg->free(array->append_buffer);
+    array->append_buffer = NULL;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_enable_ring_buffer(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    if (array->ndim == 0) {
+        CATERVA_TRACE_ERROR("The ring buffer mode needs at least one dimension");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (array->ring != NULL) {
+        return CATERVA_SUCCEED;
+    }
+    struct caterva_ring_s *ring = array->cfg->alloc(sizeof(struct caterva_ring_s));
+    CATERVA_ERROR_NULL(ring);
+    ring->origin = 0;
+    ring->capacity = array->extshape[0] / array->chunkshape[0];
+    array->ring = ring;
+    CATERVA_ERROR(ring_store(array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_disable_ring_buffer(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    if (array->ring == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    CATERVA_ERROR(ring_normalize(array));
+    if (blosc2_vlmeta_delete(array->sc, "caterva_ring") < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    array->cfg->free(array->ring);
+    array->ring = NULL;
+
+    return CATERVA_SUCCEED;
+}
+
+// The maximum number of chunk locks of an array (beyond that, the chunks share the locks)
+#define CATERVA_CHUNK_LOCKS_MAX 4096
+
+int caterva_enable_chunk_locks(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+#ifdef CATERVA_HAVE_PTHREAD
+    if (array->append_buffer != NULL || array->overviews != NULL || array->stats != NULL) {
+        CATERVA_TRACE_ERROR("The chunk locks can not be combined with the buffered append mode, "
+                            "overviews nor statistics");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (array->chunk_locks != NULL) {
+        return CATERVA_SUCCEED;
+    }
+    struct caterva_chunk_locks_s *locks = array->cfg->alloc(sizeof(struct caterva_chunk_locks_s));
+    CATERVA_ERROR_NULL(locks);
+    memset(locks, 0, sizeof(struct caterva_chunk_locks_s));
+    // A lock per chunk, up to a limit
+    locks->nlocks = array->nchunks < CATERVA_CHUNK_LOCKS_MAX ? array->nchunks
+                                                             : CATERVA_CHUNK_LOCKS_MAX;
+    if (locks->nlocks < 1) {
+        locks->nlocks = 1;
+    }
+    locks->locks = array->cfg->alloc(locks->nlocks * sizeof(pthread_rwlock_t));
+    int64_t ninit = 0;
+    while (locks->locks != NULL && ninit < locks->nlocks &&
+           pthread_rwlock_init(&locks->locks[ninit], NULL) == 0) {
+        ninit++;
+    }
+    if (ninit < locks->nlocks) {
+        for (int64_t i = 0; i < ninit; ++i) {
+            pthread_rwlock_destroy(&locks->locks[i]);
+        }
+        if (locks->locks != NULL) {
+            array->cfg->free(locks->locks);
+        }
+        array->cfg->free(locks);
+        CATERVA_TRACE_ERROR("Can not create the chunk locks");
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    array->chunk_locks = locks;
+
+    return CATERVA_SUCCEED;
+#else
+    CATERVA_TRACE_ERROR("The chunk locks need threads");
+    CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+#endif
+}
+
+int caterva_disable_chunk_locks(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    struct caterva_chunk_locks_s *locks = array->chunk_locks;
+    if (locks == NULL) {
+        return CATERVA_SUCCEED;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    for (int64_t i = 0; i < locks->nlocks; ++i) {
+        pthread_rwlock_destroy(&locks->locks[i]);
+    }
+    array->cfg->free(locks->locks);
+#endif
+    caterva_pool_destroy(&locks->cctx_pool);
+    array->cfg->free(locks);
+    array->chunk_locks = NULL;
+
+    return CATERVA_SUCCEED;
+}
+
+// Take the locks marked in @p marked, in increasing order so that the reads and writes that lock
+// several chunks can not deadlock
+static void caterva_lock_marked(caterva_array_t *array, const bool *marked, bool write) {
+#ifdef CATERVA_HAVE_PTHREAD
+    struct caterva_chunk_locks_s *locks = array->chunk_locks;
+    for (int64_t i = 0; i < locks->nlocks; ++i) {
+        if (!marked[i]) {
+            continue;
+        }
+        if (write) {
+            pthread_rwlock_wrlock(&locks->locks[i]);
+        } else {
+            pthread_rwlock_rdlock(&locks->locks[i]);
+        }
+    }
+#endif
+}
+
+// Give back the locks taken by caterva_lock_region or caterva_lock_plan
+static void caterva_unlock_chunks(caterva_array_t *array, bool *marked) {
+    if (marked == NULL) {
+        return;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    struct caterva_chunk_locks_s *locks = array->chunk_locks;
+    for (int64_t i = 0; i < locks->nlocks; ++i) {
+        if (marked[i]) {
+            pthread_rwlock_unlock(&locks->locks[i]);
+        }
+    }
+#endif
+    array->cfg->free(marked);
+}
+
+// Lock the chunks of the region [start, stop) when the chunk locks are enabled. @p marked gets
+// the locks to give back with caterva_unlock_chunks (NULL if the chunk locks are disabled).
+static int caterva_lock_region(caterva_array_t *array, const int64_t *start, const int64_t *stop,
+                               bool write, bool **marked) {
+    *marked = NULL;
+    struct caterva_chunk_locks_s *locks = array->chunk_locks;
+    if (locks == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    bool *m = array->cfg->alloc(locks->nlocks * sizeof(bool));
+    CATERVA_ERROR_NULL(m);
+    memset(m, 0, locks->nlocks * sizeof(bool));
+
+    int8_t ndim = array->ndim;
+    int64_t first[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t strides[CATERVA_MAX_DIM];
+    int64_t nchunks = 1;
+    for (int i = ndim - 1; i >= 0; --i) {
+        first[i] = start[i] / array->chunkshape[i];
+        shape[i] = stop[i] > start[i] ? (stop[i] - 1) / array->chunkshape[i] + 1 - first[i] : 0;
+        strides[i] = i == ndim - 1 ? 1 : strides[i + 1] * (array->extshape[i + 1] /
+                                                            array->chunkshape[i + 1]);
+        nchunks *= shape[i];
+    }
+    for (int64_t k = 0; k < nchunks; ++k) {
+        int64_t coords[CATERVA_MAX_DIM] = {0};
+        if (ndim > 0) {
+            blosc2_unidim_to_multidim(ndim, shape, k, coords);
+        }
+        int64_t nchunk = 0;
+        for (int i = 0; i < ndim; ++i) {
+            nchunk += (first[i] + coords[i]) * strides[i];
+        }
+        m[nchunk % locks->nlocks] = true;
+    }
+    caterva_lock_marked(array, m, write);
+    *marked = m;
+    return CATERVA_SUCCEED;
+}
+
+// Only for internal use: drop the first rows of chunks along the first axis
+static int ring_trim(caterva_array_t *array, int64_t nrows) {
+    struct caterva_ring_s *ring = array->ring;
+    int64_t per_row = ring_chunks_per_row(array);
+
+    // The buffered chunks are addressed by their logical position
+    struct caterva_append_buffer_s *buf = array->append_buffer;
+    if (buf != NULL) {
+        for (int64_t slot = 0; slot < buf->nslots; ++slot) {
+            if (buf->rows[slot] < 0) {
+                continue;
+            }
+            if (buf->axis != 0 || buf->rows[slot] < nrows) {
+                CATERVA_ERROR(append_buffer_flush_slot(array, slot));
+            } else {
+                buf->rows[slot] -= nrows;
+            }
+        }
+    }
+
+    // The freed chunks are reset to zeros, so that the appends can reuse them
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    uint8_t chunk[BLOSC_EXTENDED_HEADER_LENGTH];
+    int csize = blosc2_chunk_zeros(*cparams, array->sc->chunksize, chunk,
+                                   BLOSC_EXTENDED_HEADER_LENGTH);
+    free(cparams);
+    if (csize < 0) {
+        CATERVA_TRACE_ERROR("Blosc error when creating a chunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    for (int64_t row = 0; row < nrows; ++row) {
+        int64_t prow = (ring->origin + row) % ring->capacity;
+        for (int64_t i = 0; i < per_row; ++i) {
+            if (blosc2_schunk_update_chunk(array->sc, prow * per_row + i, chunk, true) < 0) {
+                CATERVA_TRACE_ERROR("Blosc error when updating a chunk");
+                return CATERVA_ERR_BLOSC_FAILED;
+            }
+        }
+    }
+    ring->origin = (ring->origin + nrows) % ring->capacity;
+    caterva_stats_shift(array, nrows * per_row);
+
+    int64_t new_shape[CATERVA_MAX_DIM];
+    memcpy(new_shape, array->shape, array->ndim * sizeof(int64_t));
+    new_shape[0] -= nrows * array->chunkshape[0];
+    CATERVA_ERROR(caterva_update_shape(array, array->ndim, new_shape, array->chunkshape,
+                                       array->blockshape));
+    array->nchunks = array->extnitems / array->chunknitems;
+    CATERVA_ERROR(ring_store(array));
+
+    return CATERVA_SUCCEED;
+}
+
+static int caterva_blosc_slice_chunks(caterva_ctx_t *ctx, void *buffer,
+                                      int64_t buffersize, int64_t *start, int64_t *stop,
+                                      int64_t *shape, caterva_array_t *array, bool set_slice,
+                                      bool postfilter);
+
+// Only for internal use: It is used for setting slices and for getting slices. The postfilter of
+// the context is applied to the slices that are got when @p postfilter is true.
+int caterva_blosc_slice(caterva_ctx_t *ctx, void *buffer,
+                        int64_t buffersize, int64_t *start, int64_t *stop, int64_t *shape,
+                        caterva_array_t *array, bool set_slice, bool postfilter) {
+    CATERVA_ERROR_NULL(start);
+    CATERVA_ERROR_NULL(stop);
+    CATERVA_ERROR_NULL(array);
+
+    // With chunk locks, the chunks of the slice are locked during the whole read or write
+    bool *locked;
+    CATERVA_ERROR(caterva_lock_region(array, start, stop, set_slice, &locked));
+    int rc = caterva_blosc_slice_chunks(ctx, buffer, buffersize, start, stop, shape, array,
+                                        set_slice, postfilter);
+    caterva_unlock_chunks(array, locked);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+static int caterva_blosc_slice_chunks(caterva_ctx_t *ctx, void *buffer,
+                                      int64_t buffersize, int64_t *start, int64_t *stop,
+                                      int64_t *shape, caterva_array_t *array, bool set_slice,
+                                      bool postfilter) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR_NULL(start);
+    CATERVA_ERROR_NULL(stop);
+    CATERVA_ERROR_NULL(array);
+    if (buffersize < 0) {
+        CATERVA_TRACE_ERROR("buffersize is < 0");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    uint8_t *buffer_b = (uint8_t *) buffer;
+    int64_t *buffer_start = start;
+    int64_t *buffer_stop = stop;
+    int64_t *buffer_shape = shape;
+
+    int8_t ndim = array->ndim;
+
+    caterva_postfilter_state_t filter = {ctx, array, 0};
+    blosc2_context *filter_dctx = NULL;
+    if (!set_slice && postfilter && ctx->cfg->postfilter != NULL) {
+        filter_dctx = caterva_create_postfilter_dctx(&filter);
+        if (filter_dctx == NULL) {
+            CATERVA_TRACE_ERROR("Can not create the decompression context");
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    }
+
+    // 0-dim case
+    if (ndim == 0) {
+        if (set_slice) {
+            CATERVA_ERROR(caterva_commit_chunk(array, 0, buffer_b, array->itemsize));
+        } else if (filter_dctx != NULL) {
+            int rc = caterva_decompress_chunk_ctx(array, 0, filter_dctx, buffer_b, array->itemsize);
+            blosc2_free_ctx(filter_dctx);
+            CATERVA_ERROR(rc);
+        } else {
+            blosc2_context *dctx = caterva_acquire_dctx(array);
+            CATERVA_ERROR_NULL(dctx);
+            int rc = caterva_decompress_chunk_ctx(array, 0, dctx, buffer_b, array->itemsize);
+            caterva_release_dctx(array, dctx, rc);
+            CATERVA_ERROR(rc);
+        }
+        return CATERVA_SUCCEED;
+    }
+
+    int32_t data_nbytes = (int32_t) array->extchunknitems * array->itemsize;
+    uint8_t *data = malloc(data_nbytes);
+    if (data == NULL) {
+        if (filter_dctx != NULL) {
+            blosc2_free_ctx(filter_dctx);
+        }
+        CATERVA_ERROR_NULL(data);
+    }
+    // Every error from here on goes to the cleanup, which releases the chunk buffer and the
+    // postfilter context (with its threads)
+    int rc = CATERVA_SUCCEED;
+
+    int64_t chunks_in_array[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < ndim; ++i) {
+        chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
+    }
+
+    int64_t chunks_in_array_strides[CATERVA_MAX_DIM];
+    chunks_in_array_strides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        chunks_in_array_strides[i] = chunks_in_array_strides[i + 1] * chunks_in_array[i + 1];
+    }
+
+    int64_t blocks_in_chunk[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < ndim; ++i) {
+        blocks_in_chunk[i] = array->extchunkshape[i] / array->blockshape[i];
+    }
+
+    // Compute the number of chunks to update
+    int64_t update_start[CATERVA_MAX_DIM];
+    int64_t update_shape[CATERVA_MAX_DIM];
+
+    int64_t update_nchunks = 1;
+    for (int i = 0; i < ndim; ++i) {
+        int64_t pos = 0;
+        while (pos <= buffer_start[i]) {
+            pos += array->chunkshape[i];
+        }
+        update_start[i] = pos / array->chunkshape[i] - 1;
+        while (pos < buffer_stop[i]) {
+            pos += array->chunkshape[i];
+        }
+        update_shape[i] = pos / array->chunkshape[i] - update_start[i];
+        update_nchunks *= update_shape[i];
+    }
+
+    for (int update_nchunk = 0; update_nchunk < update_nchunks; ++update_nchunk) {
+        int64_t nchunk_ndim[CATERVA_MAX_DIM] = {0};
+        blosc2_unidim_to_multidim(ndim, update_shape, update_nchunk, nchunk_ndim);
+        for (int i = 0; i < ndim; ++i) {
+            nchunk_ndim[i] += update_start[i];
+        }
+        int64_t nchunk;
+        blosc2_multidim_to_unidim(nchunk_ndim, ndim, chunks_in_array_strides, &nchunk);
+
+        // check if the chunk needs to be updated
+        int64_t chunk_start[CATERVA_MAX_DIM] = {0};
+        int64_t chunk_stop[CATERVA_MAX_DIM] = {0};
+        for (int i = 0; i < ndim; ++i) {
+            chunk_start[i] = nchunk_ndim[i] * array->chunkshape[i];
+            chunk_stop[i] = chunk_start[i] + array->chunkshape[i];
             if (chunk_stop[i] > array->shape[i]) {
                 chunk_stop[i] = array->shape[i];
             }
@@ -595,28 +1635,77 @@ int caterva_blosc_slice(caterva_ctx_t *ctx, void *buffer,
 
         int32_t nblocks = (int32_t)array->extchunknitems / array->blocknitems;
 
+        // Chunks kept uncompressed by the buffered append mode are used directly
+        uint8_t *chunk_data = data;
+        int64_t slot = append_buffer_slot(array, nchunk_ndim);
+        bool buffered = false;
+        bool keep_buffered = false;
+        if (slot >= 0) {
+            int8_t axis = array->append_buffer->axis;
+            buffered = array->append_buffer->rows[slot] == nchunk_ndim[axis];
+            keep_buffered = chunk_stop[axis] < chunk_start[axis] + array->chunkshape[axis];
+            if (buffered) {
+                chunk_data = array->append_buffer->chunks[slot];
+            }
+        }
 
-
-        if (set_slice) {
+        // The buffered data is always up to date, so it does not need to be decompressed
+        if (set_slice && !buffered) {
+            if (keep_buffered) {
+                // The slot is only replaced once its new chunk exists and the old one is stored
+                chunk_data = array->cfg->alloc(data_nbytes);
+                if (chunk_data == NULL) {
+                    CATERVA_TRACE_ERROR("Pointer is null");
+                    rc = CATERVA_ERR_NULL_POINTER;
+                    goto cleanup;
+                }
+                rc = append_buffer_flush_slot(array, slot);
+                if (rc != CATERVA_SUCCEED) {
+                    array->cfg->free(chunk_data);
+                    goto cleanup;
+                }
+                array->append_buffer->rows[slot] = nchunk_ndim[array->append_buffer->axis];
+                array->append_buffer->chunks[slot] = chunk_data;
+            }
             // Check if all the chunk is going to be updated and avoid the decompression
             bool decompress_chunk = false;
             for (int i = 0; i < ndim; ++i) {
                 decompress_chunk |= (chunk_start[i] < buffer_start[i] || chunk_stop[i] > buffer_stop[i]);
             }
 
-            if (decompress_chunk) {
-                int err = blosc2_schunk_decompress_chunk(array->sc, nchunk, data, data_nbytes);
+            if (decompress_chunk && array->chunk_locks != NULL) {
+                // Concurrent writes can not share the context of the super-chunk
+                blosc2_context *dctx = caterva_acquire_dctx(array);
+                if (dctx == NULL) {
+                    CATERVA_TRACE_ERROR("Can not create the decompression context");
+                    rc = CATERVA_ERR_NULL_POINTER;
+                    goto cleanup;
+                }
+                rc = caterva_decompress_chunk_ctx(array, nchunk, dctx, chunk_data, data_nbytes);
+                caterva_release_dctx(array, dctx, rc);
+                if (rc != CATERVA_SUCCEED) {
+                    goto cleanup;
+                }
+            } else if (decompress_chunk) {
+                int err = blosc2_schunk_decompress_chunk(array->sc,
+                                                         caterva_physical_nchunk(array, nchunk),
+                                                         chunk_data, data_nbytes);
                 if (err < 0) {
                     CATERVA_TRACE_ERROR("Error decompressing chunk");
-                    CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+                    rc = CATERVA_ERR_BLOSC_FAILED;
+                    goto cleanup;
                 }
             } else {
                 // Avoid writing non zero padding from previous chunk
-                memset(data, 0, data_nbytes);
+                memset(chunk_data, 0, data_nbytes);
             }
-        } else {
+        } else if (!set_slice && !buffered) {
             bool *block_maskout = ctx->cfg->alloc(nblocks);
-            CATERVA_ERROR_NULL(block_maskout);
+            if (block_maskout == NULL) {
+                CATERVA_TRACE_ERROR("Pointer is null");
+                rc = CATERVA_ERR_NULL_POINTER;
+                goto cleanup;
+            }
             for (int nblock = 0; nblock < nblocks; ++nblock) {
                 int64_t nblock_ndim[CATERVA_MAX_DIM] = {0};
                 blosc2_unidim_to_multidim(ndim, blocks_in_chunk, nblock, nblock_ndim);
@@ -645,18 +1734,44 @@ int caterva_blosc_slice(caterva_ctx_t *ctx, void *buffer,
                 block_maskout[nblock] = block_empty ? true : false;
             }
 
-            if (blosc2_set_maskout(array->sc->dctx, block_maskout, nblocks) != BLOSC2_ERROR_SUCCESS) {
+            // The mask is set in a context owned by this read, so that other threads can read
+            // the array at the same time
+            blosc2_context *dctx = filter_dctx;
+            if (dctx == NULL) {
+                dctx = caterva_acquire_dctx(array);
+            }
+            if (dctx == NULL) {
+                CATERVA_TRACE_ERROR("Can not create the decompression context");
+                rc = CATERVA_ERR_NULL_POINTER;
+            } else if (blosc2_set_maskout(dctx, block_maskout, nblocks) != BLOSC2_ERROR_SUCCESS) {
                 CATERVA_TRACE_ERROR("Error setting the maskout");
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+                rc = CATERVA_ERR_BLOSC_FAILED;
+            } else {
+                // With a postfilter, the blocks are transformed by the decompression threads
+                filter.nchunk = nchunk;
+                rc = caterva_decompress_chunk_ctx(array, nchunk, dctx, data, data_nbytes);
             }
-
-            int err = blosc2_schunk_decompress_chunk(array->sc, nchunk, data, data_nbytes);
-            if (err < 0) {
-                CATERVA_TRACE_ERROR("Error decompressing chunk");
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            if (dctx != NULL && dctx != filter_dctx) {
+                caterva_release_dctx(array, dctx, rc);
             }
 
             ctx->cfg->free(block_maskout);
+            if (rc != CATERVA_SUCCEED) {
+                goto cleanup;
+            }
+        } else if (filter_dctx != NULL) {
+            // The buffered blocks are not decompressed, so they are transformed here
+            int32_t blocksize = (int32_t) (array->blocknitems * array->itemsize);
+            filter.nchunk = nchunk;
+            for (int nblock = 0; nblock < nblocks && rc == CATERVA_SUCCEED; ++nblock) {
+                rc = caterva_postfilter_block(&filter, nblock * blocksize,
+                                              &chunk_data[nblock * blocksize],
+                                              &data[nblock * blocksize], blocksize, 0);
+            }
+            if (rc != CATERVA_SUCCEED) {
+                goto cleanup;
+            }
+            chunk_data = data;
         }
 
         // Iterate over blocks
@@ -730,7 +1845,7 @@ int caterva_blosc_slice(caterva_ctx_t *ctx, void *buffer,
                 src_stop[i] = slice_stop[i] - buffer_start[i];
             }
 
-            uint8_t *dst = &data[nblock * array->blocknitems * array->itemsize];
+            uint8_t *dst = &chunk_data[nblock * array->blocknitems * array->itemsize];
             int64_t dst_pad_shape[CATERVA_MAX_DIM];
             for (int i = 0; i < ndim; ++i) {
                 dst_pad_shape[i] = array->blockshape[i];
@@ -755,33 +1870,36 @@ int caterva_blosc_slice(caterva_ctx_t *ctx, void *buffer,
         }
 
         if (set_slice) {
-            // Recompress the data
-            int32_t chunk_nbytes = data_nbytes + BLOSC2_MAX_OVERHEAD;
-            uint8_t *chunk = malloc(chunk_nbytes);
-            int brc;
-            brc = blosc2_compress_ctx(array->sc->cctx, data, data_nbytes, chunk, chunk_nbytes);
-            if (brc < 0) {
-                CATERVA_TRACE_ERROR("Blosc can not compress the data");
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            // Recompress the data, unless the chunk is still being filled by appends
+            if (chunk_data == data) {
+                rc = caterva_commit_chunk(array, nchunk, data, data_nbytes);
+            } else if (!keep_buffered) {
+                rc = append_buffer_flush_slot(array, slot);
+            } else if (array->stats != NULL) {
+                // The statistics of a buffered chunk are computed when it is committed
+                array->stats->valid[nchunk] = false;
             }
-            int64_t brc_ = blosc2_schunk_update_chunk(array->sc, nchunk, chunk, false);
-            if (brc_ < 0) {
-                CATERVA_TRACE_ERROR("Blosc can not update the chunk");
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            if (rc != CATERVA_SUCCEED) {
+                goto cleanup;
             }
         }
     }
 
+cleanup:
     free(data);
-
+    if (filter_dctx != NULL) {
+        blosc2_free_ctx(filter_dctx);
+    }
+    CATERVA_ERROR(rc);
 
     return CATERVA_SUCCEED;
 }
 
-int caterva_get_slice_buffer(caterva_ctx_t *ctx,
-                             caterva_array_t *array,
-                             int64_t *start, int64_t *stop,
-                             void *buffer, int64_t *buffershape, int64_t buffersize) {
+// Get a slice, applying the postfilter of the context when @p postfilter is true
+int caterva_get_slice_buffer_filtered(caterva_ctx_t *ctx, caterva_array_t *array,
+                                      int64_t *start, int64_t *stop, void *buffer,
+                                      int64_t *buffershape, int64_t buffersize,
+                                      bool postfilter) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
     CATERVA_ERROR_NULL(start);
@@ -805,7 +1923,18 @@ int caterva_get_slice_buffer(caterva_ctx_t *ctx,
     if (buffersize < size) {
         CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
     }
-    CATERVA_ERROR(caterva_blosc_slice(ctx, buffer, buffersize, start, stop, buffershape, array, false));
+    CATERVA_ERROR(caterva_blosc_slice(ctx, buffer, buffersize, start, stop, buffershape, array,
+                                      false, postfilter));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_get_slice_buffer(caterva_ctx_t *ctx,
+                             caterva_array_t *array,
+                             int64_t *start, int64_t *stop,
+                             void *buffer, int64_t *buffershape, int64_t buffersize) {
+    CATERVA_ERROR(caterva_get_slice_buffer_filtered(ctx, array, start, stop, buffer, buffershape,
+                                                    buffersize, true));
 
     return CATERVA_SUCCEED;
 }
@@ -833,7 +1962,9 @@ int caterva_set_slice_buffer(caterva_ctx_t *ctx,
         return CATERVA_SUCCEED;
     }
 
-    CATERVA_ERROR(caterva_blosc_slice(ctx, buffer, buffersize, start, stop, buffershape, array, true));
+    CATERVA_ERROR(caterva_blosc_slice(ctx, buffer, buffersize, start, stop, buffershape, array,
+                                      true, false));
+    CATERVA_ERROR(caterva_overviews_update(ctx, array, start, stop));
 
     return CATERVA_SUCCEED;
 }
@@ -895,8 +2026,8 @@ int caterva_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, const int64_t *s
             buffersize *= chunk_shape[i];
         }
         uint8_t *buffer = ctx->cfg->alloc(buffersize);
-        CATERVA_ERROR(caterva_get_slice_buffer(ctx, src, src_start, src_stop, buffer, chunk_shape,
-                                               buffersize));
+        CATERVA_ERROR(caterva_get_slice_buffer_filtered(ctx, src, src_start, src_stop, buffer,
+                                                        chunk_shape, buffersize, false));
         CATERVA_ERROR(caterva_set_slice_buffer(ctx, buffer, chunk_shape, buffersize, chunk_start,
                                                chunk_stop, *array));
         ctx->cfg->free(buffer);
@@ -927,6 +2058,25 @@ int caterva_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *array, const bool
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
 
+    if (array->ring != NULL && index[0]) {
+        CATERVA_ERROR(caterva_disable_ring_buffer(ctx, array));
+    }
+    CATERVA_ERROR(ring_normalize(array));
+    // The buffered chunks are indexed by the array dimensions
+    if (array->append_buffer != NULL) {
+        int8_t axis = array->append_buffer->axis;
+        if (index[axis]) {
+            CATERVA_ERROR(caterva_disable_append_buffer(ctx, array));
+        } else {
+            CATERVA_ERROR(caterva_flush(ctx, array));
+            for (int i = 0; i < axis; ++i) {
+                if (index[i]) {
+                    array->append_buffer->axis--;
+                }
+            }
+        }
+    }
+
     uint8_t nones = 0;
     int64_t newshape[CATERVA_MAX_DIM];
     int32_t newchunkshape[CATERVA_MAX_DIM];
@@ -967,6 +2117,7 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
     CATERVA_ERROR_NULL(storage);
     CATERVA_ERROR_NULL(array);
 
+    CATERVA_ERROR(ring_normalize(src));
 
     caterva_params_t params;
     params.itemsize = src->itemsize;
@@ -975,7 +2126,8 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
         params.shape[i] = src->shape[i];
     }
 
-    bool equals = true;
+    // The super-chunk is copied as is, unless some chunks or statistics are not stored yet
+    bool equals = !append_buffer_pending(src) && (src->stats == NULL || !src->stats->dirty);
     for (int i = 0; i < src->ndim; ++i) {
         if (src->chunkshape[i] != storage->chunkshape[i]) {
             equals = false;
@@ -1030,6 +2182,11 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
 
         // Copy vlmetayers
         for (int i = 0; i < src->sc->nvlmetalayers; ++i) {
+            if (strcmp(src->sc->vlmetalayers[i]->name, "caterva_ring") == 0 ||
+                strcmp(src->sc->vlmetalayers[i]->name, "caterva_stats") == 0 ||
+                strcmp(src->sc->vlmetalayers[i]->name, "caterva_overviews") == 0) {
+                continue;
+            }
             uint8_t *content;
             int32_t content_len;
             if (blosc2_vlmeta_get(src->sc, src->sc->vlmetalayers[i]->name, &content,
@@ -1045,6 +2202,18 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
         }
 
     }
+    if (src->ring != NULL) {
+        CATERVA_ERROR(caterva_enable_ring_buffer(ctx, *array));
+    }
+    if (equals) {
+        // The statistics are copied with the rest of vlmetalayers
+        CATERVA_ERROR(caterva_stats_load(*array));
+    } else if (src->stats != NULL) {
+        CATERVA_ERROR(caterva_enable_stats(ctx, *array, src->stats->dtype));
+    }
+    if (src->overviews != NULL) {
+        CATERVA_ERROR(caterva_overviews_copy(src, *array));
+    }
     return CATERVA_SUCCEED;
 }
 
@@ -1073,6 +2242,16 @@ int caterva_remove(caterva_ctx_t *ctx, char *urlpath) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(urlpath);
 
+    // The overviews are stored next to the array
+    blosc2_schunk *sc = blosc2_schunk_open(urlpath);
+    if (sc != NULL) {
+        struct caterva_overviews_s overviews;
+        if (caterva_overviews_read(sc, &overviews) == CATERVA_SUCCEED) {
+            caterva_overviews_remove(urlpath, overviews.nlevels);
+        }
+        blosc2_schunk_free(sc);
+    }
+
     int rc = blosc2_remove_urlpath(urlpath);
     if (rc != BLOSC2_ERROR_SUCCESS) {
         CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
@@ -1230,13 +2409,77 @@ int caterva_meta_update(caterva_ctx_t *ctx, caterva_array_t *array,
     return CATERVA_SUCCEED;
 }
 
-int extend_shape(caterva_array_t *array, const int64_t *new_shape, const int64_t *start) {
-    CATERVA_ERROR_NULL(array);
-    CATERVA_ERROR_NULL(new_shape);
-
+// Add the chunks of the region of `new_shape` that starts at `start` and is not in `old` (an
+// array with the old shapes)
+static int extend_chunks(caterva_array_t *array, caterva_array_t *old, const int64_t *new_shape,
+                         const int64_t *start) {
     int8_t ndim = array->ndim;
-    int64_t diffs_shape[CATERVA_MAX_DIM];
-    int64_t diffs_sum = 0;
+    int64_t old_nchunks = array->nchunks;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int64_t chunks_in_array[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < ndim; ++i) {
+        chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
+    }
+    // The new chunks are appended and then moved to their place in a single reorder,
+    // so that the offsets index is rewritten only once. This is linear in the number of
+    // chunks for sparse super-chunks; frames still rewrite their index on every append,
+    // so growing a frame by k chunks costs O(k * nchunks) (see bench/bench_resize.c).
+    int64_t *order = malloc(nchunks * sizeof(int64_t));
+    CATERVA_ERROR_NULL(order);
+    int64_t nchunk_old = 0;
+    int64_t nchunk_new = old_nchunks;
+    bool in_place = true;
+    int64_t nchunk_ndim[CATERVA_MAX_DIM];
+    for (int64_t i = 0; i < nchunks; ++i) {
+        blosc2_unidim_to_multidim(ndim, chunks_in_array, i, nchunk_ndim);
+        bool is_new = false;
+        for (int j = 0; j < ndim; ++j) {
+            if (start[j] <= (array->chunkshape[j] * nchunk_ndim[j])
+                && (array->chunkshape[j] * nchunk_ndim[j]) <
+                   (start[j] + new_shape[j] - old->shape[j])) {
+                is_new = true;
+                break;
+            }
+        }
+        order[i] = is_new ? nchunk_new++ : nchunk_old++;
+        in_place &= order[i] == i;
+    }
+
+    // All the new chunks share the same zero chunk
+    blosc2_cparams *cparams;
+    blosc2_schunk_get_cparams(array->sc, &cparams);
+    uint8_t chunk[BLOSC_EXTENDED_HEADER_LENGTH];
+    int csize = blosc2_chunk_zeros(*cparams, array->sc->chunksize, chunk,
+                                   BLOSC_EXTENDED_HEADER_LENGTH);
+    free(cparams);
+    if (csize < 0) {
+        free(order);
+        CATERVA_TRACE_ERROR("Blosc error when creating a chunk");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    for (int64_t i = old_nchunks; i < nchunks; ++i) {
+        if (blosc2_schunk_append_chunk(array->sc, chunk, true) < 0) {
+            free(order);
+            CATERVA_TRACE_ERROR("Blosc error when appending a chunk");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+    if (!in_place && blosc2_schunk_reorder_offsets(array->sc, order) < 0) {
+        free(order);
+        CATERVA_TRACE_ERROR("Blosc error when reordering the chunks");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    free(order);
+    return CATERVA_SUCCEED;
+}
+
+int extend_shape(caterva_array_t *array, const int64_t *new_shape, const int64_t *start) {
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(new_shape);
+
+    int8_t ndim = array->ndim;
+    int64_t diffs_shape[CATERVA_MAX_DIM];
+    int64_t diffs_sum = 0;
     for (int i = 0; i < ndim; i++) {
         diffs_shape[i] = new_shape[i] - array->shape[i];
         diffs_sum += diffs_shape[i];
@@ -1254,58 +2497,108 @@ int extend_shape(caterva_array_t *array, const int64_t *new_shape, const int64_t
         return CATERVA_SUCCEED;
     }
 
+    if (array->ring != NULL) {
+        // Appends along the first axis use the rows of chunks left by the deletions
+        bool append_rows = start == NULL || start[0] == array->shape[0];
+        for (int i = 1; i < ndim; ++i) {
+            append_rows &= diffs_shape[i] == 0;
+        }
+        int64_t nrows = (new_shape[0] + array->chunkshape[0] - 1) / array->chunkshape[0];
+        if (append_rows && nrows <= array->ring->capacity) {
+            CATERVA_ERROR(caterva_update_shape(array, ndim, new_shape, array->chunkshape,
+                                               array->blockshape));
+            array->nchunks = array->extnitems / array->chunknitems;
+            return CATERVA_SUCCEED;
+        }
+        CATERVA_ERROR(ring_normalize(array));
+    }
+
     int64_t old_nchunks = array->nchunks;
     // aux array to keep old shapes
     caterva_array_t *aux = malloc(sizeof (caterva_array_t));
+    CATERVA_ERROR_NULL(aux);
     aux->sc = NULL;
-    CATERVA_ERROR(caterva_update_shape(aux, ndim, array->shape, array->chunkshape, array->blockshape));
+    aux->stats = NULL;
+    aux->overviews = NULL;
+    aux->dctx_pool = NULL;
+    aux->schunk_lock = NULL;
+    aux->chunk_locks = NULL;
+    int rc = caterva_update_shape(aux, ndim, array->shape, array->chunkshape, array->blockshape);
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_update_shape(array, ndim, new_shape, array->chunkshape, array->blockshape);
+    }
+    if (rc == CATERVA_SUCCEED && start != NULL) {
+        // The chunks after the new ones are moved
+        caterva_stats_invalidate(array, start[0] / array->chunkshape[0] *
+                                        ring_chunks_per_row(array));
+    }
+    if (rc == CATERVA_SUCCEED && array->extnitems / array->chunknitems != old_nchunks) {
+        rc = extend_chunks(array, aux, new_shape, start == NULL ? aux->shape : start);
+    }
+    free(aux);
+    CATERVA_ERROR(rc);
+    array->nchunks = array->sc->nchunks;
+    if (array->ring != NULL) {
+        array->ring->capacity = array->extshape[0] / array->chunkshape[0];
+        CATERVA_ERROR(ring_store(array));
+    }
 
-    CATERVA_ERROR(caterva_update_shape(array, ndim, new_shape, array->chunkshape, array->blockshape));
+    return CATERVA_SUCCEED;
+}
 
-    int64_t nchunks = array->extnitems / array->chunknitems;
-    int64_t nchunks_;
-    int64_t nchunk_ndim[CATERVA_MAX_DIM];
-    blosc2_cparams *cparams;
-    blosc2_schunk_get_cparams(array->sc, &cparams);
-    void* chunk;
-    int64_t csize;
-    if (nchunks != old_nchunks) {
-        if (start == NULL) {
-            start = aux->shape;
-        }
-        int64_t chunks_in_array[CATERVA_MAX_DIM] = {0};
-        for (int i = 0; i < ndim; ++i) {
-            chunks_in_array[i] = array->extshape[i] / array->chunkshape[i];
-        }
-        for (int i = 0; i < nchunks; ++i) {
-            blosc2_unidim_to_multidim(ndim, chunks_in_array, i, nchunk_ndim);
-            for (int j = 0; j < ndim; ++j) {
-                if (start[j] <= (array->chunkshape[j] * nchunk_ndim[j])
-                    && (array->chunkshape[j] * nchunk_ndim[j]) < (start[j] + new_shape[j] - aux->shape[j])) {
-                    chunk = malloc(BLOSC_EXTENDED_HEADER_LENGTH);
-                    csize = blosc2_chunk_zeros(*cparams, array->sc->chunksize, chunk, BLOSC_EXTENDED_HEADER_LENGTH);
-                    if (csize < 0) {
-                        free(aux);
-                        free(cparams);
-                        CATERVA_TRACE_ERROR("Blosc error when creating a chunk");
-                        return CATERVA_ERR_BLOSC_FAILED;
-                    }
-                    nchunks_ = blosc2_schunk_insert_chunk(array->sc, i, chunk, false);
-                    if (nchunks_ < 0) {
-                        free(aux);
-                        free(cparams);
-                        CATERVA_TRACE_ERROR("Blosc error when inserting a chunk");
-                        return CATERVA_ERR_BLOSC_FAILED;
-                    }
-                    break;
-                }
-            }
+// Whether the chunk `nchunk` of the old array falls into the region removed by `shrink_shape`
+static bool shrink_chunk_removed(caterva_array_t *array, const int64_t *chunks_in_array_old,
+                                 const int64_t *old_shape, const int64_t *new_shape,
+                                 const int64_t *start, int64_t nchunk) {
+    int64_t nchunk_ndim[CATERVA_MAX_DIM] = {0};
+    blosc2_unidim_to_multidim(array->ndim, (int64_t *) chunks_in_array_old, nchunk, nchunk_ndim);
+    for (int j = 0; j < array->ndim; ++j) {
+        if (start[j] <= (array->chunkshape[j] * nchunk_ndim[j])
+            && (array->chunkshape[j] * nchunk_ndim[j]) < (start[j] + old_shape[j] - new_shape[j])) {
+            return true;
         }
     }
-    array->nchunks = array->sc->nchunks;
-    free(aux);
-    free(cparams);
+    return false;
+}
 
+// Delete the chunks of the region of `old` (an array with the old shapes) that starts at `start`
+// and is not in `new_shape`
+static int shrink_chunks(caterva_array_t *array, caterva_array_t *old, int64_t old_nchunks,
+                         const int64_t *new_shape, const int64_t *start) {
+    int64_t chunks_in_array_old[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < array->ndim; ++i) {
+        chunks_in_array_old[i] = old->extshape[i] / old->chunkshape[i];
+    }
+
+    // Move the chunks to be removed to the end, so that they can be deleted without shifting
+    // the rest of the offsets index. The reorder is skipped when the kept chunks are a prefix.
+    // As when extending, frames still rewrite their index on every deletion.
+    int64_t *order = malloc(old_nchunks * sizeof(int64_t));
+    CATERVA_ERROR_NULL(order);
+    int64_t nkept = 0;
+    int64_t nremoved = 0;
+    bool in_place = true;
+    for (int64_t i = 0; i < old_nchunks; ++i) {
+        if (shrink_chunk_removed(array, chunks_in_array_old, old->shape, new_shape, start, i)) {
+            // The order of the removed chunks does not matter
+            order[old_nchunks - 1 - nremoved++] = i;
+        } else {
+            in_place &= nkept == i;
+            order[nkept++] = i;
+        }
+    }
+    if (!in_place && blosc2_schunk_reorder_offsets(array->sc, order) < 0) {
+        free(order);
+        CATERVA_TRACE_ERROR("Blosc error when reordering the chunks");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    free(order);
+    for (int64_t i = old_nchunks - 1; i >= nkept; --i) {
+        if (blosc2_schunk_delete_chunk(array->sc, i) < 0) {
+            CATERVA_TRACE_ERROR("Blosc error when deleting a chunk");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
     return CATERVA_SUCCEED;
 }
 
@@ -1333,73 +2626,173 @@ int shrink_shape(caterva_array_t *array, const int64_t *new_shape, const int64_t
         return CATERVA_SUCCEED;
     }
 
+    CATERVA_ERROR(ring_normalize(array));
+
     int64_t old_nchunks = array->nchunks;
     // aux array to keep old shapes
     caterva_array_t *aux = malloc(sizeof (caterva_array_t));
+    CATERVA_ERROR_NULL(aux);
     aux->sc = NULL;
-    CATERVA_ERROR(caterva_update_shape(aux, ndim, array->shape, array->chunkshape, array->blockshape));
+    aux->stats = NULL;
+    aux->overviews = NULL;
+    aux->dctx_pool = NULL;
+    aux->schunk_lock = NULL;
+    aux->chunk_locks = NULL;
+    int rc = caterva_update_shape(aux, ndim, array->shape, array->chunkshape, array->blockshape);
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_update_shape(array, ndim, new_shape, array->chunkshape, array->blockshape);
+    }
+    if (rc == CATERVA_SUCCEED && start != NULL) {
+        // The chunks after the removed ones are moved
+        caterva_stats_invalidate(array, start[0] / array->chunkshape[0] *
+                                        ring_chunks_per_row(array));
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = shrink_chunks(array, aux, old_nchunks, new_shape, start == NULL ? new_shape : start);
+    }
+    free(aux);
+    CATERVA_ERROR(rc);
+    array->nchunks = array->sc->nchunks;
+    if (array->ring != NULL) {
+        array->ring->capacity = array->extshape[0] / array->chunkshape[0];
+        CATERVA_ERROR(ring_store(array));
+    }
+
+    return CATERVA_SUCCEED;
+}
 
-    CATERVA_ERROR(caterva_update_shape(array, ndim, new_shape, array->chunkshape, array->blockshape));
 
-    // Delete chunks if needed
-    int64_t chunks_in_array_old[CATERVA_MAX_DIM] = {0};
-    for (int i = 0; i < ndim; ++i) {
-        chunks_in_array_old[i] = aux->extshape[i] / aux->chunkshape[i];
+// Only for internal use: make room for `shift` zeros at `pos` along `axis` moving the items after
+// it forward or, if `shift` is negative, overwrite the `-shift` items at `pos` moving the items
+// after them backwards. Only the chunks from `pos` to the end of the axis are rewritten, one chunk
+// at a time.
+static int caterva_shift_axis(caterva_ctx_t *ctx, caterva_array_t *array, int8_t axis,
+                              int64_t pos, int64_t shift) {
+    int8_t ndim = array->ndim;
+    if (array->nitems == 0 || shift == 0) {
+        return CATERVA_SUCCEED;
     }
-    if (start == NULL) {
-        start = new_shape;
+    int64_t dst_begin = pos;
+    int64_t dst_end = shift > 0 ? array->shape[axis] : array->shape[axis] + shift;
+    if (dst_begin >= dst_end) {
+        return CATERVA_SUCCEED;
     }
+    int32_t chunklen = array->chunkshape[axis];
+    int64_t first_row = dst_begin / chunklen;
+    int64_t last_row = (dst_end - 1) / chunklen;
 
-    int64_t nchunk_ndim[CATERVA_MAX_DIM] = {0};
-    int64_t nchunks_;
-    for (int i = (int)old_nchunks - 1; i >= 0; --i) {
-        blosc2_unidim_to_multidim(ndim, chunks_in_array_old, i, nchunk_ndim);
-        for (int j = 0; j < ndim; ++j) {
-            if (start[j] <= (array->chunkshape[j] * nchunk_ndim[j])
-                && (array->chunkshape[j] * nchunk_ndim[j]) < (start[j] + aux->shape[j] - new_shape[j])) {
-                nchunks_ = blosc2_schunk_delete_chunk(array->sc, i);
-                if (nchunks_ < 0) {
-                    free(aux);
-                    CATERVA_TRACE_ERROR("Blosc error when deleting a chunk");
-                    return CATERVA_ERR_BLOSC_FAILED;
+    // The chunks in the rest of dimensions
+    int64_t tiles_shape[CATERVA_MAX_DIM];
+    int64_t ntiles = 1;
+    for (int i = 0; i < ndim; ++i) {
+        tiles_shape[i] = i == axis ? 1 : array->extshape[i] / array->chunkshape[i];
+        ntiles *= tiles_shape[i];
+    }
+
+    int64_t chunk_nbytes = array->chunknitems * array->itemsize;
+    uint8_t *tile = ctx->cfg->alloc(chunk_nbytes);
+    uint8_t *src_tile = ctx->cfg->alloc(chunk_nbytes);
+    int rc = CATERVA_SUCCEED;
+
+    // Moving forward, the chunks are rewritten from the end so that the source is never overwritten
+    for (int64_t n = 0; n <= last_row - first_row && rc == CATERVA_SUCCEED; ++n) {
+        int64_t row = shift > 0 ? last_row - n : first_row + n;
+        for (int64_t ntile = 0; ntile < ntiles; ++ntile) {
+            int64_t tile_ndim[CATERVA_MAX_DIM];
+            blosc2_unidim_to_multidim(ndim, tiles_shape, ntile, tile_ndim);
+            int64_t start[CATERVA_MAX_DIM];
+            int64_t stop[CATERVA_MAX_DIM];
+            int64_t shape[CATERVA_MAX_DIM];
+            for (int i = 0; i < ndim; ++i) {
+                int64_t nchunk_i = i == axis ? row : tile_ndim[i];
+                start[i] = nchunk_i * array->chunkshape[i];
+                stop[i] = start[i] + array->chunkshape[i];
+                if (stop[i] > array->shape[i]) {
+                    stop[i] = array->shape[i];
                 }
+            }
+            if (start[axis] < dst_begin) {
+                start[axis] = dst_begin;
+            }
+            if (stop[axis] > dst_end) {
+                stop[axis] = dst_end;
+            }
+            int64_t nbytes = array->itemsize;
+            for (int i = 0; i < ndim; ++i) {
+                shape[i] = stop[i] - start[i];
+                nbytes *= shape[i];
+            }
+
+            // The part of the tile coming from the source
+            int64_t copy_start[CATERVA_MAX_DIM] = {0};
+            int64_t copy_shape[CATERVA_MAX_DIM];
+            int64_t src_start[CATERVA_MAX_DIM];
+            int64_t src_stop[CATERVA_MAX_DIM];
+            memcpy(copy_shape, shape, ndim * sizeof(int64_t));
+            if (start[axis] < pos + shift) {
+                copy_start[axis] = (pos + shift < stop[axis] ? pos + shift : stop[axis]) - start[axis];
+                copy_shape[axis] = shape[axis] - copy_start[axis];
+                memset(tile, 0, nbytes);
+            }
+            int64_t copy_nbytes = array->itemsize;
+            for (int i = 0; i < ndim; ++i) {
+                src_start[i] = start[i] + copy_start[i] - (i == axis ? shift : 0);
+                src_stop[i] = src_start[i] + copy_shape[i];
+                copy_nbytes *= copy_shape[i];
+            }
+            if (copy_nbytes > 0) {
+                rc = caterva_get_slice_buffer_filtered(ctx, array, src_start, src_stop, src_tile,
+                                                       copy_shape, copy_nbytes, false);
+                if (rc != CATERVA_SUCCEED) {
+                    break;
+                }
+                int64_t zeros[CATERVA_MAX_DIM] = {0};
+                caterva_copy_buffer(ndim, array->itemsize, src_tile, copy_shape, zeros, copy_shape,
+                                    tile, shape, copy_start);
+            }
+            rc = caterva_set_slice_buffer(ctx, tile, shape, nbytes, start, stop, array);
+            if (rc != CATERVA_SUCCEED) {
                 break;
             }
         }
     }
-    array->nchunks = array->sc->nchunks;
-    free(aux);
+    ctx->cfg->free(tile);
+    ctx->cfg->free(src_tile);
+    CATERVA_ERROR(rc);
 
     return CATERVA_SUCCEED;
 }
 
-
 int caterva_resize(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *new_shape,
                    const int64_t *start) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
     CATERVA_ERROR_NULL(new_shape);
 
+    // Buffered chunks are addressed by their position, which may change
+    if (!append_buffer_kept(array, new_shape, start)) {
+        CATERVA_ERROR(caterva_flush(ctx, array));
+    }
+
+    // Edits that do not cut chunks just move whole chunks, the rest shift the items after them
+    bool unaligned[CATERVA_MAX_DIM] = {false};
+    bool any_unaligned = false;
     if (start != NULL) {
         for (int i = 0; i < array->ndim; ++i) {
             if (start[i] > array->shape[i]) {
                 CATERVA_TRACE_ERROR("`start` must be lower or equal than old array shape in all dims");
                 CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
             }
+            if (new_shape[i] < array->shape[i] && start[i] > new_shape[i]) {
+                CATERVA_TRACE_ERROR("The items to delete must be inside the array");
+                CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+            }
             if ((new_shape[i] > array->shape[i] && start[i] != array->shape[i])
                 || (new_shape[i] < array->shape[i]
                     && (start[i] + array->shape[i] - new_shape[i]) != array->shape[i])) {
-                // Chunks cannot be cut unless they are in the last position
-                if (start[i] % array->chunkshape[i] != 0) {
-                    CATERVA_TRACE_ERROR("If array end is not being modified "
-                        "`start` must be a multiple of chunkshape in all dims");
-                    CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
-                }
-                if ((new_shape[i] - array->shape[i]) % array->chunkshape[i] != 0) {
-                    CATERVA_TRACE_ERROR("If array end is not being modified "
-                        "`(new_shape - shape)` must be multiple of chunkshape in all dims");
-                    CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
-                }
+                unaligned[i] = start[i] % array->chunkshape[i] != 0 ||
+                               (new_shape[i] - array->shape[i]) % array->chunkshape[i] != 0;
+                any_unaligned |= unaligned[i];
             }
         }
     }
@@ -1414,8 +2807,41 @@ int caterva_resize(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *ne
         }
     }
 
-    CATERVA_ERROR(shrink_shape(array, shrinked_shape, start));
-    CATERVA_ERROR(extend_shape(array, new_shape, start));
+    if (!any_unaligned) {
+        CATERVA_ERROR(shrink_shape(array, shrinked_shape, start));
+        CATERVA_ERROR(extend_shape(array, new_shape, start));
+        return CATERVA_SUCCEED;
+    }
+
+    // Resize one dimension at a time, deleting first as in the aligned case
+    int64_t shape[CATERVA_MAX_DIM];
+    memcpy(shape, array->shape, array->ndim * sizeof(int64_t));
+    for (int8_t i = 0; i < array->ndim; ++i) {
+        if (shrinked_shape[i] == shape[i]) {
+            continue;
+        }
+        int64_t shift = shrinked_shape[i] - shape[i];
+        shape[i] = shrinked_shape[i];
+        if (unaligned[i]) {
+            CATERVA_ERROR(caterva_shift_axis(ctx, array, i, start[i], shift));
+            CATERVA_ERROR(shrink_shape(array, shape, NULL));
+        } else {
+            CATERVA_ERROR(shrink_shape(array, shape, start));
+        }
+    }
+    for (int8_t i = 0; i < array->ndim; ++i) {
+        if (new_shape[i] == shape[i]) {
+            continue;
+        }
+        int64_t shift = new_shape[i] - shape[i];
+        shape[i] = new_shape[i];
+        if (unaligned[i]) {
+            CATERVA_ERROR(extend_shape(array, shape, NULL));
+            CATERVA_ERROR(caterva_shift_axis(ctx, array, i, start[i], shift));
+        } else {
+            CATERVA_ERROR(extend_shape(array, shape, start));
+        }
+    }
 
     return CATERVA_SUCCEED;
 }
@@ -1491,6 +2917,13 @@ int caterva_delete(caterva_ctx_t *ctx, caterva_array_t *array, const int8_t axis
     }
 
 
+    // In the ring buffer mode, dropping leading chunks only moves the array origin
+    if (array->ring != NULL && axis == 0 && delete_start == 0 && delete_len > 0 &&
+        delete_len < array->shape[0] && delete_len % array->chunkshape[0] == 0) {
+        CATERVA_ERROR(ring_trim(array, delete_len / array->chunkshape[0]));
+        return CATERVA_SUCCEED;
+    }
+
     int64_t newshape[CATERVA_MAX_DIM];
     memcpy(newshape, array->shape, array->ndim * sizeof(int64_t));
     newshape[axis] -= delete_len;
@@ -1515,353 +2948,780 @@ typedef struct {
 } caterva_selection_t;
 
 int caterva_compare_selection(const void * a, const void * b) {
-    int res = (int) (((caterva_selection_t *) a)->value - ((caterva_selection_t *) b)->value);
+    const caterva_selection_t *sa = (const caterva_selection_t *) a;
+    const caterva_selection_t *sb = (const caterva_selection_t *) b;
+    // Compare instead of subtracting, as the difference of two indexes may not fit in an int
+    if (sa->value != sb->value) {
+        return sa->value < sb->value ? -1 : 1;
+    }
     // In case values are equal, sort by index
-    if (res == 0) {
-        res = (int) (((caterva_selection_t *) a)->index - ((caterva_selection_t *) b)->index);
+    if (sa->index != sb->index) {
+        return sa->index < sb->index ? -1 : 1;
     }
-    return res;
+    return 0;
 }
 
-int caterva_copy_block_buffer_data(caterva_array_t *array,
-                                   int8_t ndim,
-                                   int64_t *block_selection_size,
-                                   caterva_selection_t **chunk_selection,
-                                   caterva_selection_t **p_block_selection_0,
-                                   caterva_selection_t **p_block_selection_1,
-                                   uint8_t *block,
-                                   uint8_t *buffer,
-                                   int64_t *buffershape,
-                                   int64_t *bufferstrides,
-                                   bool get) {
-    p_block_selection_0[ndim] = chunk_selection[ndim];
-    p_block_selection_1[ndim] = chunk_selection[ndim];
-    while (p_block_selection_1[ndim] - p_block_selection_0[ndim] < block_selection_size[ndim]) {
-        if (ndim == array->ndim - 1) {
+#define CATERVA_RADIX_BITS 11
+#define CATERVA_RADIX_SORT_MIN 256
+
+// Sort a selection by value, keeping the order of the indexes for equal values. Large
+// selections are sorted with a LSD radix sort whose number of passes depends on the largest
+// value. Returns the buffer (@p sel or @p tmp) where the sorted selection ends up.
+static caterva_selection_t *caterva_sort_selection(caterva_selection_t *sel,
+                                                   caterva_selection_t *tmp, int64_t n,
+                                                   int64_t maxvalue) {
+    if (n < CATERVA_RADIX_SORT_MIN) {
+        qsort(sel, n, sizeof(caterva_selection_t), caterva_compare_selection);
+        return sel;
+    }
+    int64_t count[1 << CATERVA_RADIX_BITS];
+    int64_t mask = (1 << CATERVA_RADIX_BITS) - 1;
+    for (int shift = 0; shift < 63 && (maxvalue >> shift) > 0; shift += CATERVA_RADIX_BITS) {
+        memset(count, 0, sizeof(count));
+        for (int64_t j = 0; j < n; ++j) {
+            count[(sel[j].value >> shift) & mask]++;
+        }
+        int64_t pos = 0;
+        for (int64_t d = 0; d <= mask; ++d) {
+            int64_t c = count[d];
+            count[d] = pos;
+            pos += c;
+        }
+        for (int64_t j = 0; j < n; ++j) {
+            tmp[count[(sel[j].value >> shift) & mask]++] = sel[j];
+        }
+        caterva_selection_t *aux = sel;
+        sel = tmp;
+        tmp = aux;
+    }
+    return sel;
+}
+
+// Returns 1 if the indexes of a list never decrease, -1 if they always decrease or 0 otherwise
+static int caterva_list_order(const caterva_selector_t *selector) {
+    const int64_t *indexes = selector->indexes;
+    bool increasing = true;
+    bool decreasing = true;
+    for (int64_t j = 1; j < selector->nindexes && (increasing || decreasing); ++j) {
+        increasing = increasing && indexes[j] >= indexes[j - 1];
+        decreasing = decreasing && indexes[j] < indexes[j - 1];
+    }
+    return increasing ? 1 : (decreasing ? -1 : 0);
+}
 
-            int64_t index_in_block_n[CATERVA_MAX_DIM];
-            for (int i = 0; i < array->ndim; ++i) {
-                index_in_block_n[i] = p_block_selection_1[i]->value % array->chunkshape[i] % array->blockshape[i];
+// The items selected along one axis, in increasing order, grouped by the chunk and the block
+// that contain them. Items that are consecutive both in the array and in the user buffer are
+// merged into segments. All the offsets are already multiplied by the corresponding strides.
+typedef struct {
+    int64_t block_stride;
+    //!< The distance between consecutive items of a segment inside a block.
+    int64_t buffer_stride;
+    //!< The distance between consecutive items of a segment inside the user buffer.
+    int64_t nsegments;
+    //!< The number of segments.
+    int64_t *block_offset;
+    //!< The offset of each segment inside its block.
+    int64_t *buffer_offset;
+    //!< The offset of each segment inside the user buffer.
+    int64_t *length;
+    //!< The number of items of each segment.
+    int64_t nchunks;
+    //!< The number of chunks with selected items.
+    int64_t *chunk_offset;
+    //!< The offset of each chunk in the array.
+    int64_t *chunk_blocks;
+    //!< The first block group of each chunk (@p nchunks + 1 entries).
+    int64_t *chunk_missing;
+    //!< The number of items of each chunk that are not selected (0 means fully covered).
+    int64_t nblock_groups;
+    //!< The number of block groups.
+    int64_t *block_offset_in_chunk;
+    //!< The offset of each block group in its chunk.
+    int64_t *block_segments;
+    //!< The first segment of each block group (@p nblock_groups + 1 entries).
+    int64_t *block_missing;
+    //!< The number of items of each block group that are not selected.
+    int64_t last_value;
+    int64_t last_index;
+} caterva_axis_selection_t;
+
+// Add the item @p value, stored at @p index of the user buffer, to an axis selection. Items
+// must be added in increasing order of values. When the arrays of @p sel are NULL, the groups
+// and segments are only counted.
+static inline void caterva_axis_selection_add(caterva_array_t *array, int8_t axis,
+                                              caterva_axis_selection_t *sel, int64_t value,
+                                              int64_t index) {
+    int64_t chunklen = array->chunkshape[axis];
+    int64_t blocklen = array->blockshape[axis];
+    bool store = sel->length != NULL;
+    int64_t nchunk = value / chunklen;
+    int64_t nblock = value % chunklen / blocklen;
+    bool new_chunk = sel->nsegments == 0 || nchunk != sel->last_value / chunklen;
+    bool new_block = new_chunk || nblock != sel->last_value % chunklen / blocklen;
+    int64_t len = array->shape[axis];
+
+    if (new_chunk) {
+        if (store) {
+            sel->chunk_offset[sel->nchunks] = nchunk;
+            sel->chunk_blocks[sel->nchunks] = sel->nblock_groups;
+            int64_t chunk_start = nchunk * chunklen;
+            sel->chunk_missing[sel->nchunks] = chunk_start + chunklen < len ? chunklen :
+                                               len - chunk_start;
+        }
+        sel->nchunks++;
+    }
+    if (new_block) {
+        if (store) {
+            sel->block_offset_in_chunk[sel->nblock_groups] = nblock *
+                                                             array->block_chunk_strides[axis];
+            sel->block_segments[sel->nblock_groups] = sel->nsegments;
+            // Blocks are clipped by the end of their chunk and by the end of the array
+            int64_t block_start = nchunk * chunklen + nblock * blocklen;
+            int64_t block_stop = block_start + blocklen;
+            if (block_stop > (nchunk + 1) * chunklen) {
+                block_stop = (nchunk + 1) * chunklen;
             }
-            int64_t index_in_block = 0;
-            for (int i = 0; i < array->ndim; ++i) {
-                index_in_block += index_in_block_n[i] * array->item_block_strides[i];
+            if (block_stop > len) {
+                block_stop = len;
             }
+            sel->block_missing[sel->nblock_groups] = block_stop - block_start;
+        }
+        sel->nblock_groups++;
+    }
+    if (store && (new_block || value != sel->last_value)) {
+        sel->chunk_missing[sel->nchunks - 1]--;
+        sel->block_missing[sel->nblock_groups - 1]--;
+    }
+    if (!new_block && value == sel->last_value + 1 && index == sel->last_index + 1) {
+        if (store) {
+            sel->length[sel->nsegments - 1]++;
+        }
+    } else {
+        if (store) {
+            sel->block_offset[sel->nsegments] = value % chunklen % blocklen * sel->block_stride;
+            sel->buffer_offset[sel->nsegments] = index * sel->buffer_stride;
+            sel->length[sel->nsegments] = 1;
+        }
+        sel->nsegments++;
+    }
+    sel->last_value = value;
+    sel->last_index = index;
+}
 
-            int64_t index_in_buffer_n[CATERVA_MAX_DIM];
-            for (int i = 0; i < array->ndim; ++i) {
-                index_in_buffer_n[i] = p_block_selection_1[i]->index;
+// Add all the items of a selector to an axis selection. Lists that are not monotone must be
+// passed already sorted in @p sorted.
+static void caterva_axis_selection_build(caterva_array_t *array, int8_t axis,
+                                         const caterva_selector_t *selector,
+                                         const caterva_selection_t *sorted, int64_t nitems,
+                                         caterva_axis_selection_t *sel) {
+    sel->nsegments = 0;
+    sel->nchunks = 0;
+    sel->nblock_groups = 0;
+    switch (selector->kind) {
+        case CATERVA_SELECTOR_SLICE: {
+            int64_t step = selector->step == 0 ? 1 : selector->step;
+            for (int64_t j = 0; j < nitems; ++j) {
+                // Negative steps are walked backwards to keep the values increasing
+                int64_t k = step > 0 ? j : nitems - 1 - j;
+                caterva_axis_selection_add(array, axis, sel, selector->start + k * step, k);
             }
-            int64_t index_in_buffer = 0;
-            for (int i = 0; i < array->ndim; ++i) {
-                index_in_buffer += index_in_buffer_n[i] * bufferstrides[i];
+            break;
+        }
+        case CATERVA_SELECTOR_MASK: {
+            int64_t k = 0;
+            for (int64_t value = 0; value < array->shape[axis]; ++value) {
+                if (selector->mask[value]) {
+                    caterva_axis_selection_add(array, axis, sel, value, k++);
+                }
             }
-            if (get) {
-                memcpy(&buffer[index_in_buffer * array->itemsize],
-                       &block[index_in_block * array->itemsize],
-                       array->itemsize);
+            break;
+        }
+        case CATERVA_SELECTOR_LIST:
+            if (sorted != NULL) {
+                for (int64_t j = 0; j < nitems; ++j) {
+                    caterva_axis_selection_add(array, axis, sel, sorted[j].value,
+                                               sorted[j].index);
+                }
+            } else if (caterva_list_order(selector) > 0) {
+                for (int64_t j = 0; j < nitems; ++j) {
+                    caterva_axis_selection_add(array, axis, sel, selector->indexes[j], j);
+                }
             } else {
-                memcpy(&block[index_in_block * array->itemsize],
-                       &buffer[index_in_buffer * array->itemsize],
-                       array->itemsize);
+                for (int64_t j = nitems - 1; j >= 0; --j) {
+                    caterva_axis_selection_add(array, axis, sel, selector->indexes[j], j);
+                }
             }
-        } else {
-            caterva_copy_block_buffer_data(array, (int8_t) (ndim + 1), block_selection_size,
-                                           chunk_selection,
-                                           p_block_selection_0, p_block_selection_1, block,
-                                           buffer, buffershape, bufferstrides, get);
-        }
-        p_block_selection_1[ndim]++;
-    }
-    return CATERVA_SUCCEED;
-}
-
-int caterva_iterate_over_block_copy(caterva_array_t *array, int8_t ndim,
-                                    int64_t *chunk_selection_size,
-                                    caterva_selection_t **ordered_selection,
-                                    caterva_selection_t **chunk_selection_0,
-                                    caterva_selection_t **chunk_selection_1,
-                                    uint8_t *data,
-                                    uint8_t *buffer,
-                                    int64_t *buffershape,
-                                    int64_t *bufferstrides,
-                                    bool get) {
-    chunk_selection_0[ndim] = ordered_selection[ndim];
-    chunk_selection_1[ndim] = ordered_selection[ndim];
-    while(chunk_selection_1[ndim] - ordered_selection[ndim] < chunk_selection_size[ndim]) {
-        int64_t block_index_ndim = ((*chunk_selection_1[ndim]).value % array->chunkshape[ndim]) / array->blockshape[ndim];
-        while (chunk_selection_1[ndim] - ordered_selection[ndim] < chunk_selection_size[ndim] &&
-               block_index_ndim == ((*chunk_selection_1[ndim]).value % array->chunkshape[ndim]) / array->blockshape[ndim]) {
-            chunk_selection_1[ndim]++;
-        }
-        if (ndim == array->ndim - 1) {
-            int64_t block_chunk_strides[CATERVA_MAX_DIM];
-            block_chunk_strides[array->ndim - 1] = 1;
-            for (int i = array->ndim - 2; i >= 0; --i) {
-                block_chunk_strides[i] = block_chunk_strides[i + 1] * (array->extchunkshape[i + 1] / array->blockshape[i + 1]);
-            }
-            int64_t block_index[CATERVA_MAX_DIM];
-            for (int i = 0; i < array->ndim; ++i) {
-                block_index[i] = ((*chunk_selection_0[i]).value % array->chunkshape[i]) / array->blockshape[i];
+            break;
+    }
+    if (sel->length != NULL) {
+        sel->chunk_blocks[sel->nchunks] = sel->nblock_groups;
+        sel->block_segments[sel->nblock_groups] = sel->nsegments;
+    }
+}
+
+// Advance a counter over the items of the segments in [first, last) of each axis
+static inline bool caterva_segment_next(int8_t ndim, const caterva_axis_selection_t *sel,
+                                        int64_t *segment, int64_t *item, const int64_t *first,
+                                        const int64_t *last) {
+    for (int i = ndim - 1; i >= 0; --i) {
+        if (++item[i] < sel[i].length[segment[i]]) {
+            return true;
+        }
+        item[i] = 0;
+        if (++segment[i] < last[i]) {
+            return true;
+        }
+        segment[i] = first[i];
+    }
+    return false;
+}
+
+// Copy the selected items of a block from/to the user buffer
+static void caterva_copy_block_selection(caterva_array_t *array, caterva_axis_selection_t *sel,
+                                         const int64_t *block_group, uint8_t *block,
+                                         uint8_t *buffer, bool get) {
+    int8_t ndim = array->ndim;
+    uint8_t itemsize = array->itemsize;
+    int64_t first[CATERVA_MAX_DIM];
+    int64_t last[CATERVA_MAX_DIM];
+    int64_t segment[CATERVA_MAX_DIM];
+    int64_t item[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < ndim; ++i) {
+        first[i] = sel[i].block_segments[block_group[i]];
+        last[i] = sel[i].block_segments[block_group[i] + 1];
+        segment[i] = first[i];
+    }
+    caterva_axis_selection_t *inner = &sel[ndim - 1];
+    do {
+        int64_t block_base = 0;
+        int64_t buffer_base = 0;
+        for (int i = 0; i < ndim - 1; ++i) {
+            block_base += sel[i].block_offset[segment[i]] + item[i] * sel[i].block_stride;
+            buffer_base += sel[i].buffer_offset[segment[i]] + item[i] * sel[i].buffer_stride;
+        }
+        // The segments of the last axis are contiguous in the block and in the buffer
+        for (int64_t j = first[ndim - 1]; j < last[ndim - 1]; ++j) {
+            uint8_t *pblock = &block[(block_base + inner->block_offset[j]) * itemsize];
+            uint8_t *pbuffer = &buffer[(buffer_base + inner->buffer_offset[j]) * itemsize];
+            if (get) {
+                memcpy(pbuffer, pblock, inner->length[j] * itemsize);
+            } else {
+                memcpy(pblock, pbuffer, inner->length[j] * itemsize);
             }
-            int64_t nblock = 0;
-            for (int i = 0; i < array->ndim; ++i) {
-                nblock += block_index[i] * block_chunk_strides[i];
-            }
-            caterva_selection_t **p_block_selection_0 = malloc(array->ndim * sizeof(caterva_selection_t *));
-            caterva_selection_t **p_block_selection_1 = malloc(array->ndim * sizeof(caterva_selection_t *));
-            int64_t *block_selection_size = malloc(array->ndim * sizeof(int64_t));
-            for (int i = 0; i < array->ndim; ++i) {
-                block_selection_size[i] = chunk_selection_1[i] - chunk_selection_0[i];
-            }
-
-            caterva_copy_block_buffer_data(array,
-                                           (int8_t) 0,
-                                           block_selection_size,
-                                           chunk_selection_0,
-                                           p_block_selection_0,
-                                           p_block_selection_1,
-                                           &data[nblock * array->blocknitems * array->itemsize],
-                                           buffer,
-                                           buffershape,
-                                           bufferstrides,
-                                           get);
-            free(p_block_selection_0);
-            free(p_block_selection_1);
-            free(block_selection_size);
-        } else {
-            caterva_iterate_over_block_copy(array, (int8_t) (ndim + 1), chunk_selection_size,
-                                            ordered_selection, chunk_selection_0, chunk_selection_1,
-                                            data, buffer, buffershape, bufferstrides, get);
         }
-        chunk_selection_0[ndim] = chunk_selection_1[ndim];
+    } while (caterva_segment_next((int8_t) (ndim - 1), sel, segment, item, first, last));
+}
 
+// The chunks touched by an orthogonal selection, in C order of their chunk groups
+typedef struct {
+    caterva_array_t *array;
+    caterva_axis_selection_t *sel;
+    int64_t chunks_strides[CATERVA_MAX_DIM];
+    int64_t nchunks;
+    //!< The number of chunks with selected items.
+    uint8_t *buffer;
+    bool get;
+    caterva_postfilter_state_t *filter;
+    //!< The state of the postfilter applied to the gets, or NULL.
+} caterva_selection_plan_t;
+
+// Returns the number of the k-th chunk of the plan and fills its chunk group per axis
+static int64_t caterva_selection_chunk(caterva_selection_plan_t *plan, int64_t k,
+                                       int64_t *chunk_group) {
+    int64_t nchunk = 0;
+    for (int i = plan->array->ndim - 1; i >= 0; --i) {
+        chunk_group[i] = k % plan->sel[i].nchunks;
+        k /= plan->sel[i].nchunks;
+        nchunk += plan->sel[i].chunk_offset[chunk_group[i]] * plan->chunks_strides[i];
+    }
+    return nchunk;
+}
+
+// Returns whether a set selection overwrites every item of a chunk
+static bool caterva_selection_chunk_covered(caterva_selection_plan_t *plan,
+                                            const int64_t *chunk_group) {
+    if (plan->get) {
+        return false;
     }
+    for (int i = 0; i < plan->array->ndim; ++i) {
+        if (plan->sel[i].chunk_missing[chunk_group[i]] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
 
+// Lock the chunks visited by a plan when the chunk locks are enabled (see caterva_lock_region)
+static int caterva_lock_plan(caterva_selection_plan_t *plan, bool **marked) {
+    caterva_array_t *array = plan->array;
+    *marked = NULL;
+    struct caterva_chunk_locks_s *locks = array->chunk_locks;
+    if (locks == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    bool *m = array->cfg->alloc(locks->nlocks * sizeof(bool));
+    CATERVA_ERROR_NULL(m);
+    memset(m, 0, locks->nlocks * sizeof(bool));
+    int64_t chunk_group[CATERVA_MAX_DIM];
+    for (int64_t k = 0; k < plan->nchunks; ++k) {
+        m[caterva_selection_chunk(plan, k, chunk_group) % locks->nlocks] = true;
+    }
+    caterva_lock_marked(array, m, !plan->get);
+    *marked = m;
     return CATERVA_SUCCEED;
 }
 
-int caterva_iterate_over_block_maskout(caterva_array_t *array, int8_t ndim,
-                                       int64_t *sel_block_size,
-                                       caterva_selection_t **o_selection,
-                                       caterva_selection_t **p_o_sel_block_0,
-                                       caterva_selection_t **p_o_sel_block_1,
-                                       bool *maskout) {
-    p_o_sel_block_0[ndim] = o_selection[ndim];
-    p_o_sel_block_1[ndim] = o_selection[ndim];
-    while(p_o_sel_block_1[ndim] - o_selection[ndim] < sel_block_size[ndim]) {
-        int64_t block_index_ndim = ((*p_o_sel_block_1[ndim]).value % array->chunkshape[ndim]) / array->blockshape[ndim];
-        while (p_o_sel_block_1[ndim] - o_selection[ndim] < sel_block_size[ndim] &&
-               block_index_ndim == ((*p_o_sel_block_1[ndim]).value % array->chunkshape[ndim]) / array->blockshape[ndim]) {
-            p_o_sel_block_1[ndim]++;
-        }
-        if (ndim == array->ndim - 1) {
-            int64_t block_chunk_strides[CATERVA_MAX_DIM];
-            block_chunk_strides[array->ndim - 1] = 1;
-            for (int i = array->ndim - 2; i >= 0; --i) {
-                block_chunk_strides[i] = block_chunk_strides[i + 1] * (array->extchunkshape[i + 1] / array->blockshape[i + 1]);
-            }
-            int64_t block_index[CATERVA_MAX_DIM];
-            for (int i = 0; i < array->ndim; ++i) {
-                block_index[i] = ((*p_o_sel_block_0[i]).value % array->chunkshape[i]) / array->blockshape[i];
+// Decompress the k-th chunk of the plan and copy the selected items from/to the user buffer.
+// When getting, only the blocks with selected items are decompressed (and the chunks kept by the
+// buffered append mode are read in place, unless they pass through the postfilter); when setting,
+// the blocks (or the whole chunk) that are fully overwritten are not. @p dctx must be a context
+// owned by the caller, which runs the postfilter of the plan, if any.
+static int caterva_selection_visit_chunk(caterva_selection_plan_t *plan, int64_t k,
+                                         blosc2_context *dctx, uint8_t *data, bool *maskout) {
+    caterva_array_t *array = plan->array;
+    caterva_axis_selection_t *sel = plan->sel;
+    int8_t ndim = array->ndim;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    int32_t data_nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+
+    int64_t chunk_group[CATERVA_MAX_DIM];
+    int64_t nchunk = caterva_selection_chunk(plan, k, chunk_group);
+    int64_t block_first[CATERVA_MAX_DIM];
+    int64_t block_last[CATERVA_MAX_DIM];
+    int64_t block_group[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        block_first[i] = sel[i].chunk_blocks[chunk_group[i]];
+        block_last[i] = sel[i].chunk_blocks[chunk_group[i] + 1];
+        block_group[i] = block_first[i];
+    }
+    bool covered = caterva_selection_chunk_covered(plan, chunk_group);
+    uint8_t *buffered = plan->get ? append_buffer_chunk(array, nchunk) : NULL;
+
+    if (plan->filter != NULL) {
+        plan->filter->nchunk = nchunk;
+    }
+    if (buffered != NULL && plan->filter != NULL) {
+        // The buffered blocks are not decompressed, so they are transformed here
+        int32_t blocksize = (int32_t) (array->blocknitems * array->itemsize);
+        do {
+            int64_t nblock = 0;
+            for (int i = 0; i < ndim; ++i) {
+                nblock += sel[i].block_offset_in_chunk[block_group[i]];
             }
+            CATERVA_ERROR(caterva_postfilter_block(plan->filter, (int32_t) nblock * blocksize,
+                                                   &buffered[nblock * blocksize],
+                                                   &data[nblock * blocksize], blocksize, 0));
+        } while (caterva_selection_next(ndim, block_group, block_first, block_last));
+    } else if (buffered != NULL) {
+        // The items are copied from the buffered chunk
+        data = buffered;
+    } else if (plan->get) {
+        memset(maskout, true, nblocks * sizeof(bool));
+        do {
             int64_t nblock = 0;
-            for (int i = 0; i < array->ndim; ++i) {
-                nblock += block_index[i] * block_chunk_strides[i];
+            for (int i = 0; i < ndim; ++i) {
+                nblock += sel[i].block_offset_in_chunk[block_group[i]];
             }
             maskout[nblock] = false;
-        } else {
-            caterva_iterate_over_block_maskout(array, (int8_t) (ndim + 1), sel_block_size,
-                                               o_selection, p_o_sel_block_0, p_o_sel_block_1,
-                                               maskout);
+        } while (caterva_selection_next(ndim, block_group, block_first, block_last));
+        if (blosc2_set_maskout(dctx, maskout, (int) nblocks) != BLOSC2_ERROR_SUCCESS) {
+            CATERVA_TRACE_ERROR("Error setting the maskout");
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
         }
-        p_o_sel_block_0[ndim] = p_o_sel_block_1[ndim];
-
+    } else if (covered) {
+        // The chunk is built from scratch (the padding is zeroed)
+        memset(data, 0, data_nbytes);
+    } else {
+        bool skip = false;
+        memset(maskout, false, nblocks * sizeof(bool));
+        do {
+            bool block_covered = true;
+            int64_t nblock = 0;
+            for (int i = 0; i < ndim; ++i) {
+                nblock += sel[i].block_offset_in_chunk[block_group[i]];
+                block_covered = block_covered && sel[i].block_missing[block_group[i]] == 0;
+            }
+            if (block_covered) {
+                // Masked out blocks are left untouched by the decompression
+                maskout[nblock] = true;
+                memset(&data[nblock * array->blocknitems * array->itemsize], 0,
+                       array->blocknitems * array->itemsize);
+                skip = true;
+            }
+        } while (caterva_selection_next(ndim, block_group, block_first, block_last));
+        if (skip && blosc2_set_maskout(dctx, maskout, (int) nblocks) != BLOSC2_ERROR_SUCCESS) {
+            CATERVA_TRACE_ERROR("Error setting the maskout");
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    }
+    if (!covered && buffered == NULL) {
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, dctx, data, data_nbytes));
     }
 
+    do {
+        int64_t nblock = 0;
+        for (int i = 0; i < ndim; ++i) {
+            nblock += sel[i].block_offset_in_chunk[block_group[i]];
+        }
+        caterva_copy_block_selection(array, sel, block_group,
+                                     &data[nblock * array->blocknitems * array->itemsize],
+                                     plan->buffer, plan->get);
+    } while (caterva_selection_next(ndim, block_group, block_first, block_last));
+
     return CATERVA_SUCCEED;
 }
 
-int caterva_iterate_over_chunk(caterva_array_t *array, int8_t ndim,
-                               int64_t *selection_size,
-                               caterva_selection_t **ordered_selection,
-                               caterva_selection_t **p_ordered_selection_0,
-                               caterva_selection_t **p_ordered_selection_1,
-                               uint8_t *buffer,
-                               int64_t *buffershape,
-                               int64_t *bufferstrides,
-                               bool get) {
-    p_ordered_selection_0[ndim] = ordered_selection[ndim];
-    p_ordered_selection_1[ndim] = ordered_selection[ndim];
-    while(p_ordered_selection_1[ndim] - ordered_selection[ndim] < selection_size[ndim]) {
-        int64_t chunk_index_ndim = (*p_ordered_selection_1[ndim]).value / array->chunkshape[ndim];
-        while (p_ordered_selection_1[ndim] - ordered_selection[ndim] < selection_size[ndim] &&
-               chunk_index_ndim == (*p_ordered_selection_1[ndim]).value / array->chunkshape[ndim]) {
-            p_ordered_selection_1[ndim]++;
-        }
-        if (ndim == array->ndim - 1) {
-            int64_t chunk_array_strides[CATERVA_MAX_DIM];
-            chunk_array_strides[array->ndim - 1] = 1;
-            for (int i = array->ndim - 2; i >= 0; --i) {
-                chunk_array_strides[i] = chunk_array_strides[i + 1] *
-                                         (array->extshape[i + 1] / array->chunkshape[i + 1]);
-            }
-            int64_t chunk_index[CATERVA_MAX_DIM];
-            for (int i = 0; i < array->ndim; ++i) {
-                chunk_index[i] = (*p_ordered_selection_0[i]).value / array->chunkshape[i];
-            }
-            int64_t nchunk = 0;
-            for (int i = 0; i < array->ndim; ++i) {
-                nchunk += chunk_index[i] * chunk_array_strides[i];
-            }
-
-            int64_t nblocks = array->extchunknitems / array->blocknitems;
-            caterva_selection_t **p_chunk_selection_0 = malloc(
-                    array->ndim * sizeof(caterva_selection_t *));
-            caterva_selection_t **p_chunk_selection_1 = malloc(
-                    array->ndim * sizeof(caterva_selection_t *));
-            int64_t *chunk_selection_size = malloc(array->ndim * sizeof(int64_t));
-            for (int i = 0; i < array->ndim; ++i) {
-                chunk_selection_size[i] = p_ordered_selection_1[i] - p_ordered_selection_0[i];
-            }
+typedef struct {
+    caterva_selection_plan_t *plan;
+    // Resources of each thread (there are no compression contexts for a serial visit)
+    blosc2_context **dctx;
+    blosc2_context **cctx;
+    uint8_t **data;
+    bool **maskout;
+} caterva_selection_job_t;
+
+// Visit the k-th chunk of a plan and, when setting, store it back in the array
+static int caterva_selection_task(void *arg, int64_t k, int thread) {
+    caterva_selection_job_t *job = (caterva_selection_job_t *) arg;
+    caterva_selection_plan_t *plan = job->plan;
+    caterva_array_t *array = plan->array;
+    uint8_t *data = job->data[thread];
+    CATERVA_ERROR(caterva_selection_visit_chunk(plan, k, job->dctx[thread], data,
+                                                job->maskout[thread]));
+    if (plan->get) {
+        return CATERVA_SUCCEED;
+    }
+    int64_t chunk_group[CATERVA_MAX_DIM];
+    int64_t nchunk = caterva_selection_chunk(plan, k, chunk_group);
+    int32_t data_nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    if (job->cctx == NULL) {
+        CATERVA_ERROR(caterva_commit_chunk(array, nchunk, data, data_nbytes));
+        return CATERVA_SUCCEED;
+    }
+    // The statistics of every chunk are computed by its own thread (the caller marks them dirty)
+    caterva_stats_compute(array, nchunk, data);
+    CATERVA_ERROR(caterva_compress_chunk_ctx(array, nchunk, job->cctx[thread], data,
+                                             data_nbytes));
+    return CATERVA_SUCCEED;
+}
 
-            if (get) {
-                bool *maskout = calloc(nblocks, sizeof(bool));
-                for (int i = 0; i < nblocks; ++i) {
-                    maskout[i] = true;
+// Check a selector and compute the number of items it selects
+int caterva_selector_nitems(int64_t len, const caterva_selector_t *selector,
+                            int64_t *nitems) {
+    switch (selector->kind) {
+        case CATERVA_SELECTOR_SLICE: {
+            int64_t start = selector->start;
+            int64_t stop = selector->stop;
+            int64_t step = selector->step == 0 ? 1 : selector->step;
+            if (step > 0) {
+                if (start < 0 || stop < start || stop > len) {
+                    CATERVA_TRACE_ERROR("The slice %" PRId64 ":%" PRId64 " is out of bounds",
+                                        start, stop);
+                    CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
                 }
-
-                CATERVA_ERROR(caterva_iterate_over_block_maskout(array, (int8_t) 0,
-                                                                 chunk_selection_size,
-                                                                 p_ordered_selection_0,
-                                                                 p_chunk_selection_0,
-                                                                 p_chunk_selection_1,
-                                                                 maskout));
-
-                if (blosc2_set_maskout(array->sc->dctx, maskout, (int) nblocks) !=
-                    BLOSC2_ERROR_SUCCESS) {
-                    CATERVA_TRACE_ERROR("Error setting the maskout");
-                    CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+                *nitems = (stop - start + step - 1) / step;
+            } else {
+                if (stop < -1 || start < stop || start >= len) {
+                    CATERVA_TRACE_ERROR("The slice %" PRId64 ":%" PRId64 " is out of bounds",
+                                        start, stop);
+                    CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
                 }
-                free(maskout);
-            }
-            int data_nitems = (int) array->extchunknitems;
-            int data_nbytes = data_nitems * array->itemsize;
-            uint8_t *data = malloc(data_nitems * array->itemsize);
-            int err = blosc2_schunk_decompress_chunk(array->sc, nchunk, data, data_nbytes);
-            if (err < 0) {
-                CATERVA_TRACE_ERROR("Error decompressing chunk");
-                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+                *nitems = (start - stop - step - 1) / -step;
             }
-            caterva_iterate_over_block_copy(array,
-                                            0,
-                                            chunk_selection_size,
-                                            p_ordered_selection_0,
-                                            p_chunk_selection_0,
-                                            p_chunk_selection_1,
-                                            data,
-                                            buffer,
-                                            buffershape,
-                                            bufferstrides,
-                                            get);
-
-            if (!get) {
-                int32_t chunk_size = data_nbytes + BLOSC_EXTENDED_HEADER_LENGTH;
-                uint8_t *chunk = malloc(chunk_size);
-                err = blosc2_compress_ctx(array->sc->cctx, data, data_nbytes, chunk, chunk_size);
-                if (err < 0) {
-                    CATERVA_TRACE_ERROR("Error compressing data");
-                    CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
-                }
-                err = (int) blosc2_schunk_update_chunk(array->sc, nchunk, chunk, false);
-                if (err < 0) {
-                    CATERVA_TRACE_ERROR("Error updating chunk");
-                    CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            break;
+        }
+        case CATERVA_SELECTOR_LIST:
+            if (selector->nindexes > 0) {
+                CATERVA_ERROR_NULL(selector->indexes);
+            }
+            for (int64_t j = 0; j < selector->nindexes; ++j) {
+                if (selector->indexes[j] < 0 || selector->indexes[j] >= len) {
+                    CATERVA_TRACE_ERROR("The index %" PRId64 " is out of bounds",
+                                        selector->indexes[j]);
+                    CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
                 }
             }
-            free(data);
-            free(chunk_selection_size);
-            free(p_chunk_selection_0);
-            free(p_chunk_selection_1);
-        } else {
-            CATERVA_ERROR(caterva_iterate_over_chunk(array, (int8_t) (ndim + 1), selection_size,
-                                                     ordered_selection, p_ordered_selection_0, p_ordered_selection_1,
-                                                     buffer, buffershape, bufferstrides, get));
-        }
-
-        p_ordered_selection_0[ndim] = p_ordered_selection_1[ndim];
+            *nitems = selector->nindexes;
+            break;
+        case CATERVA_SELECTOR_MASK:
+            if (len > 0) {
+                CATERVA_ERROR_NULL(selector->mask);
+            }
+            *nitems = 0;
+            for (int64_t j = 0; j < len; ++j) {
+                *nitems += selector->mask[j] ? 1 : 0;
+            }
+            break;
+        default:
+            CATERVA_TRACE_ERROR("Unknown selector kind");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
     }
     return CATERVA_SUCCEED;
 }
 
-int caterva_orthogonal_selection(caterva_ctx_t *ctx, caterva_array_t *array,
-                                     int64_t **selection, int64_t *selection_size,
-                                     void *buffer, int64_t *buffershape, int64_t buffersize,
-                                     bool get) {
+static int caterva_selection(caterva_ctx_t *ctx, caterva_array_t *array,
+                             const caterva_selector_t *selectors, void *buffer,
+                             int64_t *buffershape, int64_t buffersize, bool get) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
-    CATERVA_ERROR_NULL(selection);
-    CATERVA_ERROR_NULL(selection_size);
+    CATERVA_ERROR_NULL(selectors);
+    CATERVA_ERROR_NULL(buffer);
+
+    // The chunks are written directly in the super-chunk. Gets read the buffered chunks in place,
+    // so that they do not modify the array.
+    if (!get) {
+        CATERVA_ERROR(caterva_flush(ctx, array));
+    }
 
     int8_t ndim = array->ndim;
 
+    int64_t nitems[CATERVA_MAX_DIM];
+    int64_t sel_size = array->itemsize;
     for (int i = 0; i < ndim; ++i) {
-        CATERVA_ERROR_NULL(selection[i]);
-        // Check that indexes are not larger than array shape
-        for (int j = 0; j < selection_size[i]; ++j) {
-            if (selection[i][j] > array->shape[i]) {
-                CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
-            }
+        CATERVA_ERROR(caterva_selector_nitems(array->shape[i], &selectors[i], &nitems[i]));
+        if (buffershape[i] < nitems[i]) {
+            CATERVA_TRACE_ERROR("The buffer shape is smaller than the selection");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
         }
+        sel_size *= nitems[i];
     }
 
     // Check buffer size
-    int64_t sel_size = array->itemsize;
-    for (int i = 0; i < ndim; ++i) {
-        sel_size *= selection_size[i];
+    if (buffersize < sel_size) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (sel_size == 0) {
+        return CATERVA_SUCCEED;
+    }
+    if (ndim == 0) {
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        if (get) {
+            CATERVA_ERROR(caterva_get_slice_buffer_filtered(ctx, array, start, start, buffer,
+                                                            buffershape, buffersize, true));
+        } else {
+            CATERVA_ERROR(caterva_set_slice_buffer(ctx, buffer, buffershape, buffersize, start,
+                                                   start, array));
+        }
+        return CATERVA_SUCCEED;
     }
 
-    if (sel_size < buffersize) {
-        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    int64_t bufferstrides[CATERVA_MAX_DIM];
+    bufferstrides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        bufferstrides[i] = bufferstrides[i + 1] * buffershape[i + 1];
     }
 
-    // Sort selections
-    caterva_selection_t **ordered_selection = malloc(ndim * sizeof(caterva_selection_t *));
+    // Slices, masks and monotone lists are counted in a first pass, while the other lists have
+    // at most one segment per index. Then all the temporaries can live in a single arena.
+    caterva_axis_selection_t sel[CATERVA_MAX_DIM] = {0};
+    bool needs_sort[CATERVA_MAX_DIM] = {0};
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    int64_t data_nbytes = array->extchunknitems * array->itemsize;
+    size_t arena_size = (size_t) data_nbytes + (size_t) nblocks * sizeof(bool);
     for (int i = 0; i < ndim; ++i) {
-        ordered_selection[i] = malloc(selection_size[i] * sizeof(caterva_selection_t));
-        for (int j = 0; j < selection_size[i]; ++j) {
-            ordered_selection[i][j].index = j;
-            ordered_selection[i][j].value = selection[i][j];
+        int64_t nsegments = nitems[i];
+        needs_sort[i] = selectors[i].kind == CATERVA_SELECTOR_LIST &&
+                        caterva_list_order(&selectors[i]) == 0;
+        if (needs_sort[i]) {
+            arena_size += (size_t) 2 * nitems[i] * sizeof(caterva_selection_t);
+        } else {
+            caterva_axis_selection_build(array, (int8_t) i, &selectors[i], NULL, nitems[i], &sel[i]);
+            nsegments = sel[i].nsegments;
         }
-        qsort(ordered_selection[i], selection_size[i], sizeof(caterva_selection_t), caterva_compare_selection);
+        arena_size += (size_t) (9 * nsegments + 2) * sizeof(int64_t);
     }
+    uint8_t *arena = ctx->cfg->alloc(arena_size);
+    CATERVA_ERROR_NULL(arena);
+    uint8_t *parena = arena;
 
-    // Define pointers to iterate over ordered_selection data
-    caterva_selection_t **p_ordered_selection_0 = malloc(ndim * sizeof(caterva_selection_t *));
-    caterva_selection_t **p_ordered_selection_1 = malloc(ndim * sizeof(caterva_selection_t *));
+    // Group the selections by chunk and by block
+    for (int i = 0; i < ndim; ++i) {
+        caterva_selection_t *sorted = NULL;
+        int64_t nsegments = sel[i].nsegments;
+        if (needs_sort[i]) {
+            sorted = (caterva_selection_t *) parena;
+            parena += 2 * nitems[i] * sizeof(caterva_selection_t);
+            for (int64_t j = 0; j < nitems[i]; ++j) {
+                sorted[j].index = j;
+                sorted[j].value = selectors[i].indexes[j];
+            }
+            sorted = caterva_sort_selection(sorted, sorted + nitems[i], nitems[i],
+                                            array->shape[i] - 1);
+            nsegments = nitems[i];
+        }
 
+        int64_t *pint = (int64_t *) parena;
+        sel[i].block_stride = array->item_block_strides[i];
+        sel[i].buffer_stride = bufferstrides[i];
+        sel[i].block_offset = pint;
+        sel[i].buffer_offset = pint + nsegments;
+        sel[i].length = pint + 2 * nsegments;
+        sel[i].chunk_offset = pint + 3 * nsegments;
+        sel[i].chunk_blocks = pint + 4 * nsegments;
+        sel[i].block_offset_in_chunk = pint + 5 * nsegments + 1;
+        sel[i].block_segments = pint + 6 * nsegments + 1;
+        sel[i].chunk_missing = pint + 7 * nsegments + 2;
+        sel[i].block_missing = pint + 8 * nsegments + 2;
+        parena += (9 * nsegments + 2) * sizeof(int64_t);
+        caterva_axis_selection_build(array, (int8_t) i, &selectors[i], sorted, nitems[i], &sel[i]);
+    }
+    uint8_t *data = parena;
+    bool *maskout = (bool *) (parena + data_nbytes);
+
+    caterva_selection_plan_t plan;
+    plan.array = array;
+    plan.sel = sel;
+    plan.buffer = buffer;
+    plan.get = get;
+    plan.filter = NULL;
+    plan.nchunks = 1;
+    plan.chunks_strides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        plan.chunks_strides[i] = plan.chunks_strides[i + 1] *
+                                 (array->extshape[i + 1] / array->chunkshape[i + 1]);
+    }
+    for (int i = 0; i < ndim; ++i) {
+        plan.nchunks *= sel[i].nchunks;
+    }
+
+    // With chunk locks, the chunks of the selection are locked during the whole read or write
+    bool *locked;
+    int rc = caterva_lock_plan(&plan, &locked);
+    if (rc != CATERVA_SUCCEED) {
+        ctx->cfg->free(arena);
+        CATERVA_ERROR(rc);
+    }
+
+    // Every thread visits whole chunks, so there is no point in more threads than chunks. With a
+    // postfilter, the chunks are visited serially and the postfilter runs in the decompression
+    // threads, as in the slice gets.
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > plan.nchunks) {
+        nthreads = (int) plan.nchunks;
+    }
+    caterva_postfilter_state_t filter = {ctx, array, 0};
+    if (get && ctx->cfg->postfilter != NULL) {
+        plan.filter = &filter;
+        nthreads = 1;
+    }
+    caterva_selection_job_t job;
+    job.plan = &plan;
+    if (nthreads == 1) {
+        // A serial visit uses a context of the array pool, the arena and the commit of the writes
+        blosc2_context *dctx = plan.filter != NULL ? caterva_create_postfilter_dctx(&filter)
+                                                   : caterva_acquire_dctx(array);
+        job.dctx = &dctx;
+        job.cctx = NULL;
+        job.data = &data;
+        job.maskout = &maskout;
+        rc = dctx == NULL ? CATERVA_ERR_NULL_POINTER : CATERVA_SUCCEED;
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_parallel_for(1, plan.nchunks, caterva_selection_task, &job);
+        }
+        if (dctx != NULL && plan.filter != NULL) {
+            blosc2_free_ctx(dctx);
+        } else if (dctx != NULL) {
+            caterva_release_dctx(array, dctx, rc);
+        }
+    } else {
+        job.dctx = calloc(nthreads, sizeof(blosc2_context *));
+        job.cctx = calloc(nthreads, sizeof(blosc2_context *));
+        job.data = calloc(nthreads, sizeof(uint8_t *));
+        job.maskout = calloc(nthreads, sizeof(bool *));
+        if (job.dctx == NULL || job.cctx == NULL || job.data == NULL || job.maskout == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+        for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+            job.dctx[t] = caterva_create_thread_dctx(array);
+            job.cctx[t] = get ? NULL : caterva_create_thread_cctx(array, NULL, NULL);
+            job.data[t] = ctx->cfg->alloc(data_nbytes);
+            job.maskout[t] = ctx->cfg->alloc(nblocks * sizeof(bool));
+            if (job.dctx[t] == NULL || (!get && job.cctx[t] == NULL) || job.data[t] == NULL ||
+                job.maskout[t] == NULL) {
+                rc = CATERVA_ERR_NULL_POINTER;
+            }
+        }
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_parallel_for(nthreads, plan.nchunks, caterva_selection_task, &job);
+        }
+        if (!get && array->stats != NULL) {
+            array->stats->dirty = true;
+        }
+        for (int t = 0; t < nthreads; ++t) {
+            if (job.dctx != NULL && job.dctx[t] != NULL) {
+                blosc2_free_ctx(job.dctx[t]);
+            }
+            if (job.cctx != NULL && job.cctx[t] != NULL) {
+                blosc2_free_ctx(job.cctx[t]);
+            }
+            if (job.data != NULL && job.data[t] != NULL) {
+                ctx->cfg->free(job.data[t]);
+            }
+            if (job.maskout != NULL && job.maskout[t] != NULL) {
+                ctx->cfg->free(job.maskout[t]);
+            }
+        }
+        free(job.dctx);
+        free(job.cctx);
+        free(job.data);
+        free(job.maskout);
+    }
+    caterva_unlock_chunks(array, locked);
 
-    int64_t bufferstrides[CATERVA_MAX_DIM];
-    bufferstrides[array->ndim - 1] = 1;
-    for (int i = array->ndim - 2; i >= 0; --i) {
-        bufferstrides[i] = bufferstrides[i + 1] * buffershape[i + 1];
+    if (!get && rc == CATERVA_SUCCEED && array->overviews != NULL) {
+        // The overviews are updated over the bounding box of the written chunks
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t stop[CATERVA_MAX_DIM];
+        for (int i = 0; i < ndim; ++i) {
+            int64_t first = sel[i].chunk_offset[0];
+            int64_t last = sel[i].chunk_offset[0];
+            for (int64_t j = 1; j < sel[i].nchunks; ++j) {
+                first = sel[i].chunk_offset[j] < first ? sel[i].chunk_offset[j] : first;
+                last = sel[i].chunk_offset[j] > last ? sel[i].chunk_offset[j] : last;
+            }
+            start[i] = first * array->chunkshape[i];
+            stop[i] = (last + 1) * array->chunkshape[i];
+            stop[i] = stop[i] < array->shape[i] ? stop[i] : array->shape[i];
+        }
+        rc = caterva_overviews_update(ctx, array, start, stop);
     }
 
-    CATERVA_ERROR(caterva_iterate_over_chunk(array, 0,
-                                             selection_size, ordered_selection,
-                                             p_ordered_selection_0,
-                                             p_ordered_selection_1,
-                                             buffer, buffershape, bufferstrides, get));
+    ctx->cfg->free(arena);
+    CATERVA_ERROR(rc);
 
-    // Free allocated memory
-    free(p_ordered_selection_0);
-    free(p_ordered_selection_1);
-    for (int i = 0; i < ndim; ++i) {
-        free(ordered_selection[i]);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_get_selection(caterva_ctx_t *ctx, caterva_array_t *array,
+                          const caterva_selector_t *selectors, void *buffer,
+                          int64_t *buffershape, int64_t buffersize) {
+
+    return caterva_selection(ctx, array, selectors, buffer, buffershape, buffersize, true);
+}
+
+int caterva_set_selection(caterva_ctx_t *ctx, caterva_array_t *array,
+                          const caterva_selector_t *selectors, void *buffer,
+                          int64_t *buffershape, int64_t buffersize) {
+
+    return caterva_selection(ctx, array, selectors, buffer, buffershape, buffersize, false);
+}
+
+int caterva_orthogonal_selection(caterva_ctx_t *ctx, caterva_array_t *array,
+                                 int64_t **selection, int64_t *selection_size,
+                                 void *buffer, int64_t *buffershape, int64_t buffersize,
+                                 bool get) {
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(selection);
+    CATERVA_ERROR_NULL(selection_size);
+
+    caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < array->ndim; ++i) {
+        selectors[i].kind = CATERVA_SELECTOR_LIST;
+        selectors[i].indexes = selection[i];
+        selectors[i].nindexes = selection_size[i];
     }
-    free(ordered_selection);
 
-    return CATERVA_SUCCEED;
+    return caterva_selection(ctx, array, selectors, buffer, buffershape, buffersize, get);
 }
 
 int caterva_get_orthogonal_selection(caterva_ctx_t *ctx, caterva_array_t *array,
@@ -1976,3 +3836,4 @@ int32_t caterva_deserialize_meta(uint8_t *smeta, int32_t smeta_len, int8_t *ndim
     int32_t slen = (int32_t)(pmeta - smeta);
     return slen;
 }
+
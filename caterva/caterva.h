@@ -107,6 +107,50 @@ static char *print_error(int rc) {
 /* The maximum number of metalayers for caterva arrays */
 #define CATERVA_MAX_METALAYERS (BLOSC2_MAX_METALAYERS - 1)
 
+/**
+ * @brief The parameters passed to a @ref caterva_postfilter_fn for every block that is read.
+ *
+ * The buffers hold a whole block, with the items in C order over @p blockshape. The items
+ * outside @p block_shape are padding and their values are not used.
+ */
+typedef struct {
+    void *user_data;
+    //!< The @p postparams of the configuration.
+    int8_t ndim;
+    //!< The number of dimensions of the array.
+    uint8_t itemsize;
+    //!< The size of the items of the array.
+    int64_t nchunk;
+    //!< The index of the chunk.
+    int64_t chunk_coords[CATERVA_MAX_DIM];
+    //!< The coordinates of the chunk in the grid of chunks.
+    int32_t nblock;
+    //!< The index of the block in the chunk.
+    int64_t block_start[CATERVA_MAX_DIM];
+    //!< The coordinates in the array of the first item of the block.
+    int32_t block_shape[CATERVA_MAX_DIM];
+    //!< The shape of the items of the block inside the array (some can be zero).
+    int32_t blockshape[CATERVA_MAX_DIM];
+    //!< The shape of the buffers.
+    const uint8_t *input;
+    //!< The decompressed items of the block.
+    uint8_t *output;
+    //!< The buffer where the transformed items must be written.
+    int32_t size;
+    //!< The size of the buffers.
+    int tid;
+    //!< The index of the calling thread.
+} caterva_postfilter_params_t;
+
+/**
+ * @brief A function that transforms the items of a block after its decompression.
+ *
+ * It can be called by several threads at the same time.
+ *
+ * @return Zero on success.
+ */
+typedef int (*caterva_postfilter_fn)(caterva_postfilter_params_t *params);
+
 /**
  * @brief Configuration parameters used to create a caterva context.
  */
@@ -137,6 +181,15 @@ typedef struct {
     //!< Indicates the parameters of the prefilter function.
     blosc2_btune *udbtune;
     //!< Indicates user-defined parameters for btune.
+    caterva_postfilter_fn postfilter;
+    //!< Defines the function applied to the data read by @ref caterva_get_slice_buffer,
+    //!< @ref caterva_to_buffer, @ref caterva_get_selection and
+    //!< @ref caterva_get_orthogonal_selection, inside the decompression threads.
+    void *postparams;
+    //!< Indicates the user data passed to the postfilter function.
+    int64_t memory_budget;
+    //!< The maximum number of bytes of temporary memory used by the out-of-core operations, like
+    //!< @ref caterva_transpose, or 0 for no limit.
 } caterva_config_t;
 
 /**
@@ -155,6 +208,9 @@ static const caterva_config_t CATERVA_CONFIG_DEFAULTS = {.alloc = malloc,
                                                          .prefilter = NULL,
                                                          .pparams = NULL,
                                                          .udbtune = NULL,
+                                                         .postfilter = NULL,
+                                                         .postparams = NULL,
+                                                         .memory_budget = 256 * 1024 * 1024,
                                                          };
 
 /**
@@ -181,12 +237,26 @@ typedef struct {
 
 /**
  * @brief The storage properties for an array backed by a Blosc super-chunk.
+ *
+ * @note When the chunkshape or the blockshape is filled with zeros, the functions that create an
+ * array write the shapes that they choose back into the storage passed by the caller, so the same
+ * storage gives the same shapes when it is used again.
  */
 typedef struct {
     int32_t chunkshape[CATERVA_MAX_DIM];
-    //!< The shape of each chunk of Blosc.
+    //!< The shape of each chunk of Blosc. If it is filled with zeros, caterva chooses a chunkshape
+    //!< whose compressed size fits the last level cache (see @ref caterva_storage_t.cratio and
+    //!< @ref caterva_storage_t.preferred_axes).
     int32_t blockshape[CATERVA_MAX_DIM];
-    //!< The shape of each block of Blosc.
+    //!< The shape of each block of Blosc. If it is filled with zeros, caterva chooses a blockshape
+    //!< whose size fits the L2 cache.
+    bool preferred_axes[CATERVA_MAX_DIM];
+    //!< Optional hint for the automatic chunkshape and blockshape selection. The axes set to
+    //!< @p true are the ones along which data is usually read, so they are kept as long as possible.
+    int32_t cratio;
+    //!< Optional hint for the automatic chunkshape selection: the expected compression ratio of
+    //!< the data (0 means no compression). The uncompressed chunks are up to @p cratio times the
+    //!< last level cache, with a limit of 256 MB.
     bool contiguous;
     //!< Flag to indicate if the super-chunk is stored contiguously or sparsely.
     char *urlpath;
@@ -223,8 +293,189 @@ struct chunk_cache_s {
     //!< The chunk number in cache. If @p nchunk equals to -1, it means that the cache is empty.
 };
 
+/**
+ * @brief The types of the items, for the functions that compute with them.
+ */
+typedef enum {
+    CATERVA_INT8 = 0,
+    CATERVA_INT16 = 1,
+    CATERVA_INT32 = 2,
+    CATERVA_INT64 = 3,
+    CATERVA_UINT8 = 4,
+    CATERVA_UINT16 = 5,
+    CATERVA_UINT32 = 6,
+    CATERVA_UINT64 = 7,
+    CATERVA_FLOAT32 = 8,
+    CATERVA_FLOAT64 = 9,
+} caterva_dtype_t;
+
+/**
+ * @brief The reductions supported by @ref caterva_reduce.
+ */
+typedef enum {
+    CATERVA_REDUCE_SUM = 0,
+    //!< The sum, as an int64 (signed types), an uint64 (unsigned types) or a double.
+    CATERVA_REDUCE_MIN = 1,
+    //!< The minimum, with the type of the items.
+    CATERVA_REDUCE_MAX = 2,
+    //!< The maximum, with the type of the items.
+    CATERVA_REDUCE_MEAN = 3,
+    //!< The mean, as a double.
+    CATERVA_REDUCE_STD = 4,
+    //!< The (population) standard deviation, as a double.
+    CATERVA_REDUCE_ARGMIN = 5,
+    //!< The position of the first minimum, as an int64.
+    CATERVA_REDUCE_ARGMAX = 6,
+    //!< The position of the first maximum, as an int64.
+} caterva_reduce_op_t;
+
+/**
+ * @brief The cumulative operations supported by @ref caterva_scan.
+ */
+typedef enum {
+    CATERVA_SCAN_SUM = 0,
+    //!< The cumulative sum.
+    CATERVA_SCAN_PROD = 1,
+    //!< The cumulative product.
+} caterva_scan_op_t;
+
+/**
+ * @brief A value of any of the types in @ref caterva_dtype_t.
+ */
+typedef union {
+    int64_t i;
+    //!< The value of a signed integer.
+    uint64_t u;
+    //!< The value of an unsigned integer.
+    double f;
+    //!< The value of a floating point number.
+} caterva_scalar_t;
+
+/**
+ * @brief The operations of a @ref caterva_predicate_t.
+ */
+typedef enum {
+    CATERVA_PREDICATE_LT = 0,
+    //!< The items lower than @p value.
+    CATERVA_PREDICATE_LE = 1,
+    //!< The items lower than or equal to @p value.
+    CATERVA_PREDICATE_GT = 2,
+    //!< The items greater than @p value.
+    CATERVA_PREDICATE_GE = 3,
+    //!< The items greater than or equal to @p value.
+    CATERVA_PREDICATE_EQ = 4,
+    //!< The items equal to @p value.
+    CATERVA_PREDICATE_NE = 5,
+    //!< The items not equal to @p value (NaNs included).
+    CATERVA_PREDICATE_RANGE = 6,
+    //!< The items from @p value (included) to @p upper (excluded).
+    CATERVA_PREDICATE_AND = 7,
+    //!< The items matching both @p left and @p right.
+    CATERVA_PREDICATE_OR = 8,
+    //!< The items matching @p left, @p right or both.
+} caterva_predicate_op_t;
+
+/**
+ * @brief A condition on the items of an array (see @ref caterva_where).
+ *
+ * The values are compared with the items in the field of @ref caterva_scalar_t that matches
+ * the type of the items (@p i for signed integers, @p u for unsigned ones and @p f for floating
+ * point numbers). NaNs only match @ref CATERVA_PREDICATE_NE.
+ */
+typedef struct caterva_predicate_s {
+    caterva_predicate_op_t op;
+    //!< The operation.
+    caterva_scalar_t value;
+    //!< The value of a comparison or the lower bound of a range.
+    caterva_scalar_t upper;
+    //!< The upper bound of a range.
+    const struct caterva_predicate_s *left;
+    //!< The first operand of @ref CATERVA_PREDICATE_AND and @ref CATERVA_PREDICATE_OR.
+    const struct caterva_predicate_s *right;
+    //!< The second operand of @ref CATERVA_PREDICATE_AND and @ref CATERVA_PREDICATE_OR.
+} caterva_predicate_t;
+
+/**
+ * @brief The statistics of the items of a chunk or a block (see @ref caterva_enable_stats).
+ *
+ * The padding is not taken into account and the NaNs are not taken into account for @p min and
+ * @p max. The fields of @p min and @p max that are used depend on the type of the items.
+ */
+typedef struct {
+    int64_t nitems;
+    //!< The number of items.
+    int64_t nnans;
+    //!< The number of NaNs (always 0 for the integer types).
+    caterva_scalar_t min;
+    //!< The minimum (only meaningful if @p nitems > @p nnans).
+    caterva_scalar_t max;
+    //!< The maximum (only meaningful if @p nitems > @p nnans).
+} caterva_stats_t;
+
+/**
+ * @brief The reductions of the windows of an overview (see @ref caterva_build_overviews).
+ */
+typedef enum {
+    CATERVA_OVERVIEW_MEAN = 0,
+    //!< The mean of the items (rounded towards zero for the integers).
+    CATERVA_OVERVIEW_MAX = 1,
+    //!< The maximum of the items.
+    CATERVA_OVERVIEW_NEAREST = 2,
+    //!< The first item.
+} caterva_overview_reducer_t;
+
+/**
+ * @brief The kinds of selection along an axis (see @ref caterva_selector_t).
+ */
+typedef enum {
+    CATERVA_SELECTOR_SLICE = 0,
+    //!< The items from @p start to @p stop (excluded) every @p step.
+    CATERVA_SELECTOR_LIST = 1,
+    //!< The items in @p indexes, in any order and possibly repeated.
+    CATERVA_SELECTOR_MASK = 2,
+    //!< The items whose entry in @p mask is true.
+} caterva_selector_kind_t;
+
+/**
+ * @brief The selection of items along an axis, used to mix slices with index lists and
+ * boolean masks in a single selection.
+ */
+typedef struct {
+    caterva_selector_kind_t kind;
+    //!< The kind of selection.
+    int64_t start;
+    //!< The first item of a slice.
+    int64_t stop;
+    //!< The item where a slice stops (excluded). It may be -1 for a negative @p step.
+    int64_t step;
+    //!< The step of a slice. It can be negative, but not 0. A 0 is taken as a step of 1.
+    const int64_t *indexes;
+    //!< The indexes of a list.
+    int64_t nindexes;
+    //!< The number of indexes of a list.
+    const bool *mask;
+    //!< A mask with as many entries as items in the axis.
+} caterva_selector_t;
+
+struct caterva_append_buffer_s;
+struct caterva_ring_s;
+struct caterva_stats_s;
+struct caterva_overviews_s;
+struct caterva_context_pool_s;
+struct caterva_schunk_lock_s;
+struct caterva_chunk_locks_s;
+
 /**
  * @brief A multidimensional array of data that can be compressed.
+ *
+ * Several threads can read the same array at once (with @ref caterva_to_buffer,
+ * @ref caterva_get_slice_buffer, @ref caterva_get_orthogonal_selection or
+ * @ref caterva_get_selection), as every read decompresses with a context of its own. Contiguous
+ * arrays (frames, in memory or on disk) decode the offsets of their chunks with the context of
+ * the super-chunk, so their reads take turns to fetch every compressed chunk, and only the
+ * decompressions run at the same time. The reads of sparse arrays do not wait for each other. The
+ * functions that modify the array must not run at the same time as any other access to it, unless
+ * the chunk locks are enabled (see @ref caterva_enable_chunk_locks).
  */
 typedef struct {
     caterva_config_t *cfg;
@@ -271,8 +522,196 @@ typedef struct {
     //!< Item - shape strides.
     int64_t chunk_array_strides[CATERVA_MAX_DIM];
     //!< Item - shape strides.
+    struct caterva_append_buffer_s *append_buffer;
+    //!< The uncompressed tail chunks kept by the buffered append mode (@p NULL if disabled).
+    struct caterva_ring_s *ring;
+    //!< The layout of the chunks in the ring buffer mode (@p NULL if disabled).
+    struct caterva_stats_s *stats;
+    //!< The statistics of every chunk and block (@p NULL if disabled).
+    struct caterva_overviews_s *overviews;
+    //!< The downsampled overviews of the array (@p NULL if disabled).
+    struct caterva_context_pool_s *dctx_pool;
+    //!< The decompression contexts kept for the reads of the array.
+    struct caterva_schunk_lock_s *schunk_lock;
+    //!< The lock of the chunks of the super-chunk (@p NULL without threads).
+    struct caterva_chunk_locks_s *chunk_locks;
+    //!< The locks of the chunks in the chunk locks mode (@p NULL if disabled).
 } caterva_array_t;
 
+/**
+ * @brief An array that joins several caterva arrays along an axis without copying them.
+ */
+typedef struct {
+    caterva_config_t *cfg;
+    //!< The configuration used to open the sources.
+    int8_t ndim;
+    //!< Data dimensions.
+    uint8_t itemsize;
+    //!< Size of each item.
+    int64_t shape[CATERVA_MAX_DIM];
+    //!< The shape of the joined array.
+    int8_t axis;
+    //!< The axis along which the sources are joined.
+    int64_t nsources;
+    //!< The number of sources.
+    caterva_array_t **sources;
+    //!< The sources (@p NULL for the ones that are not opened yet).
+    char **urlpaths;
+    //!< The urlpaths of the sources (@p NULL for the ones in memory).
+    int64_t *offsets;
+    //!< The offset of every source along the axis (@p nsources + 1 entries).
+    bool owned;
+    //!< Whether the sources are opened (and freed) by the virtual array.
+} caterva_virtual_t;
+
+/**
+ * @brief The operations of a @ref caterva_expr_t.
+ */
+typedef enum {
+    CATERVA_EXPR_ARRAY = 0,
+    //!< The items of @p array.
+    CATERVA_EXPR_SCALAR = 1,
+    //!< The constant @p value.
+    CATERVA_EXPR_ADD = 2,
+    //!< @p left + @p right.
+    CATERVA_EXPR_SUB = 3,
+    //!< @p left - @p right.
+    CATERVA_EXPR_MUL = 4,
+    //!< @p left * @p right.
+    CATERVA_EXPR_DIV = 5,
+    //!< @p left / @p right (the integer divisions by zero give zero).
+} caterva_expr_op_t;
+
+/**
+ * @brief An elementwise expression over arrays with the same shape, chunkshape, blockshape and
+ * type of items (see @ref caterva_eval).
+ *
+ * The operations are done with the type of the items; the integers wrap around.
+ */
+typedef struct caterva_expr_s {
+    caterva_expr_op_t op;
+    //!< The operation.
+    caterva_array_t *array;
+    //!< The array of @ref CATERVA_EXPR_ARRAY.
+    caterva_scalar_t value;
+    //!< The value of @ref CATERVA_EXPR_SCALAR, in the field that matches the type of the items.
+    const struct caterva_expr_s *left;
+    //!< The first operand of the arithmetic operations.
+    const struct caterva_expr_s *right;
+    //!< The second operand of the arithmetic operations.
+} caterva_expr_t;
+
+/**
+ * @brief The parameters passed to a @ref caterva_prefilter_fn for every block.
+ *
+ * The output buffer holds a whole block, with the items in C order over @p blockshape. The items
+ * outside @p block_shape are padding and their values are not used.
+ */
+typedef struct {
+    void *user_data;
+    //!< The user data given to @ref caterva_from_prefilter.
+    int8_t ndim;
+    //!< The number of dimensions of the array.
+    uint8_t itemsize;
+    //!< The size of the items of the array.
+    int64_t nchunk;
+    //!< The index of the chunk.
+    int64_t chunk_coords[CATERVA_MAX_DIM];
+    //!< The coordinates of the chunk in the grid of chunks.
+    int32_t nblock;
+    //!< The index of the block in the chunk.
+    int64_t block_start[CATERVA_MAX_DIM];
+    //!< The coordinates in the array of the first item of the block.
+    int32_t block_shape[CATERVA_MAX_DIM];
+    //!< The shape of the items of the block inside the array (some can be zero).
+    int32_t blockshape[CATERVA_MAX_DIM];
+    //!< The shape of the output buffer.
+    uint8_t *output;
+    //!< The buffer where the items of the block must be written.
+    int32_t output_size;
+    //!< The size of the output buffer.
+    int tid;
+    //!< The index of the calling thread, lower than the number of threads of the context.
+} caterva_prefilter_params_t;
+
+/**
+ * @brief A function that produces the items of a block (see @ref caterva_from_prefilter).
+ *
+ * It can be called by several threads at the same time.
+ *
+ * @return Zero on success.
+ */
+typedef int (*caterva_prefilter_fn)(caterva_prefilter_params_t *params);
+
+/**
+ * @brief How the items outside an array are taken by a stencil (see @ref caterva_stencil_t).
+ */
+typedef enum {
+    CATERVA_BOUNDARY_CONSTANT = 0,
+    //!< The items outside the array are @p value.
+    CATERVA_BOUNDARY_NEAREST = 1,
+    //!< The items outside the array are the nearest item of the array.
+} caterva_boundary_t;
+
+/**
+ * @brief The parameters passed to a @ref caterva_stencil_fn for every block of the result.
+ *
+ * The input buffer holds the items of the array around the block, with the items in C order over
+ * @p blockshape + 2 * @p halo: its item `j` is the item `block_start - halo + j` of the array.
+ * The output buffer holds a whole block, with the items in C order over @p blockshape. The items
+ * outside @p block_shape (and @p block_shape + 2 * @p halo in the input) are padding.
+ */
+typedef struct {
+    void *user_data;
+    //!< The @p user_data of the stencil.
+    int8_t ndim;
+    //!< The number of dimensions of the array.
+    uint8_t itemsize;
+    //!< The size of the items of the array.
+    int64_t block_start[CATERVA_MAX_DIM];
+    //!< The coordinates in the array of the first item of the block.
+    int32_t block_shape[CATERVA_MAX_DIM];
+    //!< The shape of the items of the block inside the array.
+    int32_t blockshape[CATERVA_MAX_DIM];
+    //!< The shape of the output buffer.
+    int32_t halo[CATERVA_MAX_DIM];
+    //!< The @p halo of the stencil.
+    const uint8_t *input;
+    //!< The items of the array around the block.
+    uint8_t *output;
+    //!< The buffer where the items of the block must be written.
+    int tid;
+    //!< The index of the calling thread, lower than the number of threads of the context.
+} caterva_stencil_params_t;
+
+/**
+ * @brief A function that computes the items of a block from the items around it (see
+ * @ref caterva_stencil).
+ *
+ * It can be called by several threads at the same time.
+ *
+ * @return Zero on success.
+ */
+typedef int (*caterva_stencil_fn)(caterva_stencil_params_t *params);
+
+/**
+ * @brief A stencil, which computes every item from the items around it (see @ref caterva_stencil).
+ */
+typedef struct {
+    int32_t halo[CATERVA_MAX_DIM];
+    //!< The number of neighbours needed on each side of an item along every axis.
+    caterva_boundary_t boundary;
+    //!< How the items outside the array are taken.
+    caterva_scalar_t value;
+    //!< The items outside the array with @ref CATERVA_BOUNDARY_CONSTANT.
+    const double *weights;
+    //!< The weights of the built-in kernel, in C order over 2 * @p halo + 1.
+    caterva_stencil_fn kernel;
+    //!< A kernel of the user, or NULL for the built-in one.
+    void *user_data;
+    //!< The user data passed to @p kernel.
+} caterva_stencil_t;
+
 /**
  * @brief Create a context for caterva.
  *
@@ -439,9 +878,30 @@ int caterva_from_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersize,
                         caterva_params_t *params, caterva_storage_t *storage,
                         caterva_array_t **array);
 
+/**
+ * @brief Create a caterva array whose items are produced by a function.
+ *
+ * The function fills every block while the chunk is compressed, so no intermediate buffer is
+ * needed. The chunks are produced by up to `nthreads` threads.
+ *
+ * @param ctx The caterva context to be used.
+ * @param params The general params of the array desired.
+ * @param storage The storage params of the array desired.
+ * @param prefilter The function that produces the items of every block.
+ * @param user_data The data passed to @p prefilter.
+ * @param array The memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_from_prefilter(caterva_ctx_t *ctx, caterva_params_t *params,
+                           caterva_storage_t *storage, caterva_prefilter_fn prefilter,
+                           void *user_data, caterva_array_t **array);
+
 /**
  * @brief Extract the data into a C buffer from a caterva array.
  *
+ * The postfilter of the context, if any, is applied to the blocks that are read.
+ *
  * @param ctx The caterva context to be used.
  * @param array The caterva array.
  * @param buffer The buffer where the data will be stored.
@@ -497,6 +957,8 @@ int caterva_squeeze(caterva_ctx_t *ctx, caterva_array_t *array);
 /**
  * @brief Get a slice from an array and store it into a C buffer.
  *
+ * The postfilter of the context, if any, is applied to the blocks that are read.
+ *
  * @param ctx The caterva context to be used.
  * @param array The array from which the slice will be extracted.
  * @param start The coordinates where the slice will begin.
@@ -541,10 +1003,207 @@ int caterva_set_slice_buffer(caterva_ctx_t *ctx,
 int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *storage,
                  caterva_array_t **array);
 
+/**
+ * @brief Permute the axes of an array into a new array.
+ *
+ * The axis @p i of the result is the axis `perm[i]` of @p src. The result is built by tiles of
+ * chunks whose items fit in the `memory_budget` of the context (a tile has at least one chunk),
+ * so the arrays do not need to fit in memory. The chunks of every tile are decompressed and
+ * compressed by up to `nthreads` threads.
+ *
+ * @param ctx The caterva context to be used.
+ * @param src The array to be transposed.
+ * @param perm The permutation of the `ndim` axes of @p src.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the chunk and
+ * block shapes of @p src are permuted too.
+ * @param dest The transposed array.
+ *
+ * @return An error code
+ */
+int caterva_transpose(caterva_ctx_t *ctx, caterva_array_t *src, const int8_t *perm,
+                      caterva_storage_t *storage, caterva_array_t **dest);
+
+/**
+ * @brief Join arrays along an existing axis into a new array.
+ *
+ * When an array starts at a multiple of the chunkshape of the result along @p axis and it has
+ * the chunkshape, blockshape and compression parameters of the result, its compressed chunks are
+ * moved to the result as they are. Only the chunks of the result that are shared by several
+ * arrays, or that belong to other arrays, are decompressed and compressed again.
+ *
+ * @param ctx The caterva context to be used.
+ * @param arrays The arrays, with the same shape except along @p axis and the same itemsize.
+ * @param narrays The number of arrays.
+ * @param axis The axis along which the arrays are joined.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the chunk and
+ * block shapes of the first array are used.
+ * @param dest The joined array.
+ *
+ * @return An error code
+ */
+int caterva_concatenate(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays,
+                        int8_t axis, caterva_storage_t *storage, caterva_array_t **dest);
+
+/**
+ * @brief Join arrays along a new axis into a new array.
+ *
+ * The chunks are moved like in @ref caterva_concatenate when the chunkshape and blockshape of the
+ * result along the new axis are 1.
+ *
+ * @param ctx The caterva context to be used.
+ * @param arrays The arrays, with the same shape and itemsize.
+ * @param narrays The number of arrays.
+ * @param axis The position of the new axis in the result.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the chunk and
+ * block shapes of the first array are used, with 1 along the new axis.
+ * @param dest The stacked array.
+ *
+ * @return An error code
+ */
+int caterva_stack(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays, int8_t axis,
+                  caterva_storage_t *storage, caterva_array_t **dest);
+
+/**
+ * @brief Create a virtual array that joins arrays along an axis, without copying them.
+ *
+ * The reads of the virtual array are routed to the arrays that hold the items. The arrays are
+ * borrowed: they must outlive the virtual array.
+ *
+ * @param ctx The caterva context to be used.
+ * @param arrays The arrays, with the same shape except along @p axis and the same itemsize.
+ * @param narrays The number of arrays.
+ * @param axis The axis along which the arrays are joined.
+ * @param varray The virtual array.
+ *
+ * @return An error code
+ */
+int caterva_virtual_new(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays,
+                        int8_t axis, caterva_virtual_t **varray);
+
+/**
+ * @brief Store the description of a virtual array in a small file.
+ *
+ * Only the urlpaths and shapes of the sources are stored, so all of them must be persistent.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ * @param urlpath The path of the file.
+ *
+ * @return An error code
+ */
+int caterva_virtual_save(caterva_ctx_t *ctx, caterva_virtual_t *varray, const char *urlpath);
+
+/**
+ * @brief Open a virtual array stored by @ref caterva_virtual_save.
+ *
+ * The sources are opened the first time that one of their items is read.
+ *
+ * @param ctx The caterva context to be used.
+ * @param urlpath The path of the file.
+ * @param varray The virtual array.
+ *
+ * @return An error code
+ */
+int caterva_virtual_open(caterva_ctx_t *ctx, const char *urlpath, caterva_virtual_t **varray);
+
+/**
+ * @brief Free a virtual array, with the sources opened by it.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ *
+ * @return An error code
+ */
+int caterva_virtual_free(caterva_ctx_t *ctx, caterva_virtual_t **varray);
+
+/**
+ * @brief Get a slice of a virtual array into a buffer, like @ref caterva_get_slice_buffer.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ * @param start The coordinates where the slice begins.
+ * @param stop The coordinates where the slice ends.
+ * @param buffer The buffer where the items are stored.
+ * @param buffershape The shape of the buffer. It can not be smaller than the slice.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code
+ */
+int caterva_virtual_get_slice_buffer(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                     int64_t *start, int64_t *stop, void *buffer,
+                                     int64_t *buffershape, int64_t buffersize);
+
+/**
+ * @brief Get the items selected by a selector per axis, like @ref caterva_get_selection.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ * @param selectors The selector of each axis.
+ * @param buffer The buffer where the items are stored.
+ * @param buffershape The shape of the buffer. It can not be smaller than the selection.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code
+ */
+int caterva_virtual_get_selection(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                  const caterva_selector_t *selectors, void *buffer,
+                                  int64_t *buffershape, int64_t buffersize);
+
+/**
+ * @brief Get an orthogonal selection, like @ref caterva_get_orthogonal_selection.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ * @param selection The indexes selected in each axis.
+ * @param selection_size The number of indexes selected in each axis.
+ * @param buffer The buffer where the items are stored.
+ * @param buffershape The shape of the buffer. It can not be smaller than the selection.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code
+ */
+int caterva_virtual_get_orthogonal_selection(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                             int64_t **selection, int64_t *selection_size,
+                                             void *buffer, int64_t *buffershape,
+                                             int64_t buffersize);
+
+/**
+ * @brief Get all the items of a virtual array into a buffer, like @ref caterva_to_buffer.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ * @param buffer The buffer where the items are stored.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code
+ */
+int caterva_virtual_to_buffer(caterva_ctx_t *ctx, caterva_virtual_t *varray, void *buffer,
+                              int64_t buffersize);
+
+/**
+ * @brief Copy a slice of a virtual array into a new caterva array, like @ref caterva_get_slice.
+ *
+ * The slice is copied chunk by chunk of the new array.
+ *
+ * @param ctx The caterva context to be used.
+ * @param varray The virtual array.
+ * @param start The coordinates where the slice begins.
+ * @param stop The coordinates where the slice ends.
+ * @param storage The storage of the new array.
+ * @param array The new array.
+ *
+ * @return An error code
+ */
+int caterva_virtual_get_slice(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                              const int64_t *start, const int64_t *stop,
+                              caterva_storage_t *storage, caterva_array_t **array);
+
 
 /**
  * @brief Remove a Caterva file from the file system. Both backends are supported.
  *
+ * The overviews stored next to it (see @ref caterva_build_overviews) are removed too.
+ *
  * @param ctx The caterva context to be used.
  * @param urlpath The urlpath of the array to be removed.
  *
@@ -667,6 +1326,10 @@ int caterva_meta_update(caterva_ctx_t *ctx, caterva_array_t *array,
  * @param start The position in which the array will be extended or shrinked.
  *
  * @return An error code
+ *
+ * @note If @p start and the number of items inserted or deleted are multiples of the chunkshape,
+ * only whole chunks are added or removed. Otherwise, the chunks from @p start to the end of the
+ * axis are rewritten.
  */
 int caterva_resize(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *new_shape, const int64_t *start);
 
@@ -700,6 +1363,109 @@ int caterva_insert(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer, int
 int caterva_append(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer, int64_t buffersize,
                    const int8_t axis);
 
+/**
+ * @brief Enable the buffered append mode along an axis.
+ *
+ * In this mode, the chunks at the end of @p axis that are not full yet are kept uncompressed in
+ * memory, so that appending small buffers along @p axis does not recompress them every time.
+ * A chunk is compressed once it is full, when @ref caterva_flush is called or when the array is
+ * freed. Buffered data is visible to the functions that read the array, which read it in place
+ * and never compress it.
+ *
+ * @param ctx The context to be used.
+ * @param array The array to enable the mode.
+ * @param axis The axis along which data will be appended.
+ *
+ * @return An error code.
+ *
+ * @note Selection writes and operations that change the array layout (e.g. a resize not
+ * appending along @p axis or a serialization) flush the buffered chunks first.
+ */
+int caterva_enable_append_buffer(caterva_ctx_t *ctx, caterva_array_t *array, int8_t axis);
+
+/**
+ * @brief Flush the buffered chunks and disable the buffered append mode.
+ *
+ * @param ctx The context to be used.
+ * @param array The array.
+ *
+ * @return An error code.
+ */
+int caterva_disable_append_buffer(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Compress the chunks kept uncompressed by the buffered append mode, and store the
+ * statistics of the chunks if they have changed.
+ *
+ * The buffered append mode stays enabled. If it is not enabled, no chunk is compressed.
+ *
+ * @param ctx The context to be used.
+ * @param array The array to flush.
+ *
+ * @return An error code.
+ */
+int caterva_flush(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Enable the ring buffer mode along the first axis.
+ *
+ * In this mode, the position of the first item along the first axis is stored in the
+ * `caterva_ring` vl-metalayer, so that deleting leading chunks with @ref caterva_delete only
+ * advances it and resets the chunks to zeros, without moving the rest of them. Appends along the
+ * first axis reuse the chunks freed this way. The mode is persistent.
+ *
+ * @param ctx The context to be used.
+ * @param array The array to enable the mode.
+ *
+ * @return An error code.
+ *
+ * @note Only deletions starting at position 0 whose length is a multiple of the chunkshape take
+ * the fast path. The rest of operations that change the array layout (and copies or
+ * serializations) rearrange the chunks in the natural order first.
+ */
+int caterva_enable_ring_buffer(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Rearrange the chunks in the natural order and disable the ring buffer mode.
+ *
+ * @param ctx The context to be used.
+ * @param array The array.
+ *
+ * @return An error code.
+ */
+int caterva_disable_ring_buffer(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Enable the chunk locks mode, where slices and selections can be written while other
+ * threads read or write the array.
+ *
+ * The reads and writes of slices (@ref caterva_get_slice_buffer, @ref caterva_set_slice_buffer)
+ * and of selections (@ref caterva_get_orthogonal_selection, @ref caterva_set_orthogonal_selection,
+ * @ref caterva_get_selection, @ref caterva_set_selection) lock the chunks that they access, so a
+ * write only blocks the reads and writes of its own chunks, and a read sees every chunk either
+ * before or after a write. The mode is not persistent.
+ *
+ * @param ctx The context to be used.
+ * @param array The array to enable the mode.
+ *
+ * @return An error code.
+ *
+ * @note The mode can not be combined with the buffered append mode, overviews nor statistics
+ * (see @ref caterva_enable_stats), which every write updates. The rest of functions that modify
+ * the array (e.g. a resize) still need exclusive access to it.
+ */
+int caterva_enable_chunk_locks(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Disable the chunk locks mode.
+ *
+ * @param ctx The context to be used.
+ * @param array The array.
+ *
+ * @return An error code.
+ */
+int caterva_disable_chunk_locks(caterva_ctx_t *ctx, caterva_array_t *array);
+
 /**
  * @brief Delete shrinking the given axis delete_len items.
  *
@@ -730,6 +1496,310 @@ int caterva_set_orthogonal_selection(caterva_ctx_t *ctx, caterva_array_t *array,
                                      void *buffer, int64_t *buffershape,
                                      int64_t buffersize);
 
+/**
+ * @brief Get the items selected by a selector per axis, e.g. `[:, [3, 17, 90], 100:200]`.
+ *
+ * Slices, masks and monotone index lists are walked in order, so that only the other index
+ * lists are sorted, in linear time for large lists. The postfilter of the context, if any, is
+ * applied to the blocks with selected items (and then the chunks are visited by a single thread).
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The caterva array.
+ * @param selectors The selector of each axis.
+ * @param buffer The buffer where the items are stored.
+ * @param buffershape The shape of the buffer. It can not be smaller than the selection.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code.
+ */
+int caterva_get_selection(caterva_ctx_t *ctx, caterva_array_t *array,
+                          const caterva_selector_t *selectors, void *buffer,
+                          int64_t *buffershape, int64_t buffersize);
+
+/**
+ * @brief Set the items selected by a selector per axis.
+ *
+ * If an item is selected several times, the value stored is the last one in the buffer.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The caterva array.
+ * @param selectors The selector of each axis.
+ * @param buffer The buffer with the items to store.
+ * @param buffershape The shape of the buffer. It can not be smaller than the selection.
+ * @param buffersize The size (in bytes) of the buffer.
+ *
+ * @return An error code.
+ */
+int caterva_set_selection(caterva_ctx_t *ctx, caterva_array_t *array,
+                          const caterva_selector_t *selectors, void *buffer,
+                          int64_t *buffershape, int64_t buffersize);
+
+
+
+// Compute section
+
+/**
+ * @brief Reduce an array as a whole or along an axis.
+ *
+ * The chunks are processed by up to `nthreads` threads, each one keeping a chunk and the partial
+ * results of a tile in memory, so arrays larger than memory can be reduced.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array to reduce.
+ * @param dtype The type of the items of @p array.
+ * @param op The reduction (see @ref caterva_reduce_op_t for the types of the results).
+ * @param axis The axis to reduce, or -1 to reduce the whole array. The positions returned by
+ * the arg reductions are along @p axis or, for whole arrays, in C order.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the chunk and
+ * block shapes of @p array without @p axis are used.
+ * @param result The array with the reduction, with one dimension less than @p array (or zero
+ * dimensions when reducing the whole array).
+ *
+ * @return An error code.
+ */
+int caterva_reduce(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                   caterva_reduce_op_t op, int8_t axis, caterva_storage_t *storage,
+                   caterva_array_t **result);
+
+/**
+ * @brief Compute a cumulative sum or product along an axis into a new array.
+ *
+ * The chunks of every column of chunks along @p axis are scanned in order by a thread, which
+ * carries the last items of a chunk to the next one; the columns are scanned by up to `nthreads`
+ * threads. Every thread keeps a chunk and its carried items in memory, so arrays larger than
+ * memory can be scanned. The operations are done with the type of the items; the integers wrap
+ * around.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array to scan.
+ * @param dtype The type of the items of @p array and of the result.
+ * @param op The cumulative operation.
+ * @param axis The axis to scan.
+ * @param storage The storage of the result. Its chunkshape and blockshape must be the ones of
+ * @p array or be filled with zeros.
+ * @param result The array with the scan, with the shape of @p array.
+ *
+ * @return An error code.
+ */
+int caterva_scan(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                 caterva_scan_op_t op, int8_t axis, caterva_storage_t *storage,
+                 caterva_array_t **result);
+
+/**
+ * @brief Keep the minimum, the maximum and the number of NaNs of every chunk and block.
+ *
+ * The statistics are computed for the current data and then kept up to date by the writes, so
+ * that the chunks and blocks that can not match a query can be skipped without decompressing
+ * them. They are stored in the `caterva_stats` vlmetalayer, and are loaded back when the array is
+ * opened.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array.
+ * @param dtype The type of the items of @p array.
+ *
+ * @return An error code.
+ *
+ * @note The statistics can not be enabled while the chunk locks are (see
+ * @ref caterva_enable_chunk_locks).
+ */
+int caterva_enable_stats(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype);
+
+/**
+ * @brief Stop keeping the statistics of the chunks and blocks, and remove them from the array.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array.
+ *
+ * @return An error code.
+ */
+int caterva_disable_stats(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Get the statistics of a chunk.
+ *
+ * The statistics out of date are computed and kept, so this is a write of the array: it must not
+ * run at the same time as other accesses to it, including reads.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array (its statistics must be enabled).
+ * @param nchunk The chunk, in C order.
+ * @param stats The statistics of the chunk.
+ *
+ * @return An error code.
+ */
+int caterva_get_chunk_stats(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            caterva_stats_t *stats);
+
+/**
+ * @brief Get the statistics of a block.
+ *
+ * The statistics out of date are computed and kept, so this is a write of the array: it must not
+ * run at the same time as other accesses to it, including reads.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array (its statistics must be enabled).
+ * @param nchunk The chunk, in C order.
+ * @param nblock The block inside the chunk, in C order.
+ * @param stats The statistics of the block.
+ *
+ * @return An error code.
+ */
+int caterva_get_block_stats(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            int64_t nblock, caterva_stats_t *stats);
+
+/**
+ * @brief Build a pyramid of overviews of an array.
+ *
+ * The overview of level @p n halves every axis of the one of level @p n - 1 (the array is the
+ * level 0): each item is the reduction of a window of 2 items along every axis. The overviews
+ * have the chunkshape and blockshape of the array and are built chunk by chunk by up to
+ * `nthreads` threads. If the array is stored in `urlpath`, the overview of level @p n is stored
+ * in `urlpath.ovr<n>`.
+ *
+ * The overviews are updated by @ref caterva_set_slice_buffer and
+ * @ref caterva_set_orthogonal_selection. The other changes of the array rebuild them the next
+ * time they are got.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array (it must have at least one dimension).
+ * @param dtype The type of the items of the array.
+ * @param nlevels The number of overviews.
+ * @param reducer The reduction of the windows.
+ *
+ * @return An error code.
+ */
+int caterva_build_overviews(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                            int nlevels, caterva_overview_reducer_t reducer);
+
+/**
+ * @brief Get an overview of an array.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array (its overviews must be built).
+ * @param level The level of the overview, from 1 to the number of overviews.
+ * @param overview The overview. It belongs to @p array and it must not be changed or freed.
+ *
+ * @return An error code.
+ */
+int caterva_get_overview(caterva_ctx_t *ctx, caterva_array_t *array, int level,
+                         caterva_array_t **overview);
+
+/**
+ * @brief Remove the overviews of an array, including the ones stored next to it.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array.
+ *
+ * @return An error code.
+ */
+int caterva_remove_overviews(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Get the coordinates of the items that match a predicate.
+ *
+ * The chunks are evaluated by up to `nthreads` threads. If the statistics of the array are
+ * enabled (see @ref caterva_enable_stats), the chunks and blocks that can not match are not
+ * decompressed, and the ones that match as a whole are not evaluated.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array.
+ * @param dtype The type of the items of @p array.
+ * @param predicate The condition to evaluate.
+ * @param coords The coordinates of the matching items in C order, one row of `ndim` coordinates
+ * after another. It must be released with `free()`.
+ * @param ncoords The number of matching items.
+ *
+ * @return An error code.
+ */
+int caterva_where(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                  const caterva_predicate_t *predicate, int64_t **coords, int64_t *ncoords);
+
+/**
+ * @brief Evaluate a predicate into a boolean array.
+ *
+ * The chunks are pruned like in @ref caterva_where.
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array.
+ * @param dtype The type of the items of @p array.
+ * @param predicate The condition to evaluate.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the chunk and
+ * block shapes of @p array are used.
+ * @param mask The array with the shape of @p array and an item of 1 byte per item of @p array,
+ * set to 1 if it matches the predicate and to 0 otherwise.
+ *
+ * @return An error code.
+ */
+int caterva_where_mask(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                       const caterva_predicate_t *predicate, caterva_storage_t *storage,
+                       caterva_array_t **mask);
+
+/**
+ * @brief Evaluate an elementwise expression into a new array.
+ *
+ * The expression is evaluated block by block while the result is compressed, so every operand
+ * is decompressed once and no temporary array is created. The chunks are evaluated by up to
+ * `nthreads` threads.
+ *
+ * @param ctx The caterva context to be used.
+ * @param expr The expression. It must have at least one array.
+ * @param dtype The type of the items of the arrays and of the result.
+ * @param storage The storage of the result. Its chunkshape and blockshape must be the ones of the
+ * arrays or be filled with zeros.
+ * @param result The array with the result.
+ *
+ * @return An error code.
+ */
+int caterva_eval(caterva_ctx_t *ctx, const caterva_expr_t *expr, caterva_dtype_t dtype,
+                 caterva_storage_t *storage, caterva_array_t **result);
+
+/**
+ * @brief Apply a stencil to an array into a new array with the same shape.
+ *
+ * The built-in kernel is a weighted sum of the items around every item, computed as doubles and
+ * converted to the type of the items:
+ * `result[x] = sum(weights[t] * array[x - halo + t])` for every `t` in `2 * halo + 1`.
+ *
+ * The result is computed by tiles of chunks that fit in the `memory_budget` of the context:
+ * the chunks of the array needed by a tile, with the halo, are decompressed once into the tile,
+ * and then the chunks of the tile are computed by up to `nthreads` threads. So every chunk of the
+ * array is decompressed once per tile that it touches (once without memory budget).
+ *
+ * @param ctx The caterva context to be used.
+ * @param array The array.
+ * @param dtype The type of the items of the array and of the result.
+ * @param stencil The stencil.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the
+ * chunkshape and blockshape of the array are used.
+ * @param result The array with the result.
+ *
+ * @return An error code.
+ */
+int caterva_stencil(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                    const caterva_stencil_t *stencil, caterva_storage_t *storage,
+                    caterva_array_t **result);
+
+/**
+ * @brief Multiply two matrices into a new matrix.
+ *
+ * Every chunk of the result is computed by one of up to `nthreads` threads, which decompresses
+ * the panels of rows of @p a and of columns of @p b that it needs, one chunk of @p a along the
+ * inner axis at a time. So only a few chunks per thread are decompressed at the same time, and
+ * the matrices can be larger than the memory. The products are done with the type of the items;
+ * the integers wrap around.
+ *
+ * @param ctx The caterva context to be used.
+ * @param a The first matrix, with shape `(m, k)`.
+ * @param b The second matrix, with shape `(k, n)`.
+ * @param dtype The type of the items of the matrices and of the result.
+ * @param storage The storage of the result. If its chunkshape is filled with zeros, the result
+ * takes the chunks and blocks of the rows of @p a and of the columns of @p b.
+ * @param result The matrix with shape `(m, n)`.
+ *
+ * @return An error code.
+ */
+int caterva_matmul(caterva_ctx_t *ctx, caterva_array_t *a, caterva_array_t *b,
+                   caterva_dtype_t dtype, caterva_storage_t *storage, caterva_array_t **result);
 
 // Metainfo section
 int32_t caterva_serialize_meta(int8_t ndim, int64_t *shape, const int32_t *chunkshape,
@@ -0,0 +1,2590 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_internal.h"
+#include "blosc2.h"
+#include <math.h>
+
+
+// Rows
+
+// Visit the rows of valid items (i.e. not in the padding) of a decompressed chunk, block by block
+void caterva_chunk_rows(caterva_array_t *array, int64_t nchunk, const uint8_t *data,
+                        caterva_row_fn fn, void *arg) {
+    int8_t ndim = array->ndim;
+    int64_t coords[CATERVA_MAX_DIM] = {0};
+    if (ndim == 0) {
+        fn(arg, data, 1, coords);
+        return;
+    }
+
+    int64_t chunk_start[CATERVA_MAX_DIM];
+    int64_t rem = nchunk;
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t nchunks_i = array->extshape[i] / array->chunkshape[i];
+        chunk_start[i] = rem % nchunks_i * array->chunkshape[i];
+        rem /= nchunks_i;
+    }
+
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        int64_t block_start[CATERVA_MAX_DIM];
+        int64_t extent[CATERVA_MAX_DIM];
+        bool empty = false;
+        rem = nblock;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t nblocks_i = array->extchunkshape[i] / array->blockshape[i];
+            int64_t start_in_chunk = rem % nblocks_i * array->blockshape[i];
+            rem /= nblocks_i;
+            block_start[i] = chunk_start[i] + start_in_chunk;
+            // Clip the block by the end of its chunk and by the end of the array
+            extent[i] = array->blockshape[i];
+            if (start_in_chunk + extent[i] > array->chunkshape[i]) {
+                extent[i] = array->chunkshape[i] - start_in_chunk;
+            }
+            if (block_start[i] + extent[i] > array->shape[i]) {
+                extent[i] = array->shape[i] - block_start[i];
+            }
+            empty = empty || extent[i] <= 0;
+        }
+        if (empty) {
+            continue;
+        }
+
+        const uint8_t *block = &data[nblock * array->blocknitems * array->itemsize];
+        int64_t first[CATERVA_MAX_DIM] = {0};
+        int64_t row[CATERVA_MAX_DIM] = {0};
+        do {
+            int64_t offset = 0;
+            for (int i = 0; i < ndim - 1; ++i) {
+                coords[i] = block_start[i] + row[i];
+                offset += row[i] * array->item_block_strides[i];
+            }
+            coords[ndim - 1] = block_start[ndim - 1];
+            fn(arg, &block[offset * array->itemsize], extent[ndim - 1], coords);
+        } while (caterva_selection_next((int8_t) (ndim - 1), row, first, extent));
+    }
+}
+
+// Copy the rows of a chunk that are inside a region of the array into a buffer with the items of
+// the region in C order
+void caterva_region_row(void *arg, const uint8_t *row, int64_t n, const int64_t *coords) {
+    caterva_region_rows_t *rows = (caterva_region_rows_t *) arg;
+    int8_t last = (int8_t) (rows->array->ndim - 1);
+    int64_t offset = 0;
+    for (int i = 0; i < last; ++i) {
+        if (coords[i] < rows->start[i] || coords[i] >= rows->stop[i]) {
+            return;
+        }
+        offset += (coords[i] - rows->start[i]) * rows->strides[i];
+    }
+    int64_t first = coords[last] > rows->start[last] ? coords[last] : rows->start[last];
+    int64_t end = coords[last] + n < rows->stop[last] ? coords[last] + n : rows->stop[last];
+    if (first >= end) {
+        return;
+    }
+    offset += first - rows->start[last];
+    uint8_t itemsize = rows->array->itemsize;
+    memcpy(&rows->tile[offset * itemsize], &row[(first - coords[last]) * itemsize],
+           (end - first) * itemsize);
+}
+
+
+// Reductions
+
+// The partial result of a reduction
+struct caterva_reduce_acc_s {
+    int64_t count;
+    //!< The number of items reduced.
+    caterva_scalar_t sum;
+    caterva_scalar_t best;
+    //!< The minimum or the maximum.
+    int64_t arg;
+    //!< The position of @p best.
+    double mean;
+    double m2;
+    //!< The sum of the squared differences to @p mean.
+};
+
+// Merge the mean and the squared differences of n items into a partial result (before its count
+// is updated)
+static inline void caterva_reduce_merge_moments(caterva_reduce_acc_t *acc, int64_t n,
+                                                double mean, double m2) {
+    double count = (double) (acc->count + n);
+    double delta = mean - acc->mean;
+    acc->mean += delta * (double) n / count;
+    acc->m2 += m2 + delta * delta * (double) acc->count * (double) n / count;
+}
+
+// The integers are never NaN
+#define CATERVA_NOT_NAN(x) false
+
+// The kernels of a type: reduce a row into one partial result (the positions of its items are
+// arg, arg + 1, ...), reduce every item of a row into its own partial result (all of them at
+// position arg), add a row to the statistics of a block or compare a row with the value of a
+// predicate (the loops are kept branchless so that they can be vectorized)
+#define CATERVA_REDUCE_KERNELS(name, type, field, sumtype, isnan_fn)                             \
+static void caterva_reduce_row_##name(const uint8_t *src, int64_t n, int64_t arg,               \
+                                      caterva_reduce_op_t op, caterva_reduce_acc_t *acc) {       \
+    const type *x = (const type *) src;                                                          \
+    switch (op) {                                                                                \
+        case CATERVA_REDUCE_SUM: {                                                               \
+            sumtype sum = 0;                                                                     \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                sum += (sumtype) x[j];                                                           \
+            }                                                                                    \
+            acc->sum.field += sum;                                                               \
+            break;                                                                               \
+        }                                                                                        \
+        case CATERVA_REDUCE_MIN:                                                                 \
+        case CATERVA_REDUCE_MAX: {                                                               \
+            type best = x[0];                                                                    \
+            if (op == CATERVA_REDUCE_MIN) {                                                      \
+                for (int64_t j = 1; j < n; ++j) {                                                \
+                    best = x[j] < best ? x[j] : best;                                            \
+                }                                                                                \
+            } else {                                                                             \
+                for (int64_t j = 1; j < n; ++j) {                                                \
+                    best = x[j] > best ? x[j] : best;                                            \
+                }                                                                                \
+            }                                                                                    \
+            if (acc->count == 0 || (op == CATERVA_REDUCE_MIN ? best < acc->best.field :          \
+                                                                best > acc->best.field)) {       \
+                acc->best.field = best;                                                          \
+            }                                                                                    \
+            break;                                                                               \
+        }                                                                                        \
+        case CATERVA_REDUCE_ARGMIN:                                                              \
+        case CATERVA_REDUCE_ARGMAX: {                                                            \
+            type best = x[0];                                                                    \
+            int64_t jbest = 0;                                                                   \
+            bool min = op == CATERVA_REDUCE_ARGMIN;                                              \
+            for (int64_t j = 1; j < n; ++j) {                                                    \
+                if (min ? x[j] < best : x[j] > best) {                                           \
+                    best = x[j];                                                                 \
+                    jbest = j;                                                                   \
+                }                                                                                \
+            }                                                                                    \
+            if (acc->count == 0 || (min ? best < acc->best.field : best > acc->best.field) ||    \
+                (best == acc->best.field && arg + jbest < acc->arg)) {                           \
+                acc->best.field = best;                                                          \
+                acc->arg = arg + jbest;                                                          \
+            }                                                                                    \
+            break;                                                                               \
+        }                                                                                        \
+        case CATERVA_REDUCE_MEAN:                                                                \
+        case CATERVA_REDUCE_STD: {                                                               \
+            double sum = 0;                                                                      \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                sum += (double) x[j];                                                            \
+            }                                                                                    \
+            double mean = sum / (double) n;                                                      \
+            double m2 = 0;                                                                       \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                double d = (double) x[j] - mean;                                                 \
+                m2 += d * d;                                                                     \
+            }                                                                                    \
+            caterva_reduce_merge_moments(acc, n, mean, m2);                                      \
+            break;                                                                               \
+        }                                                                                        \
+    }                                                                                            \
+    acc->count += n;                                                                             \
+}                                                                                                \
+                                                                                                 \
+static void caterva_reduce_items_##name(const uint8_t *src, int64_t n, int64_t arg,             \
+                                        caterva_reduce_op_t op, caterva_reduce_acc_t *acc) {     \
+    const type *x = (const type *) src;                                                          \
+    switch (op) {                                                                                \
+        case CATERVA_REDUCE_SUM:                                                                 \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                acc[j].sum.field += (sumtype) x[j];                                              \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_REDUCE_MIN:                                                                 \
+        case CATERVA_REDUCE_ARGMIN:                                                              \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                if (acc[j].count == 0 || x[j] < acc[j].best.field) {                             \
+                    acc[j].best.field = x[j];                                                    \
+                    acc[j].arg = arg;                                                            \
+                }                                                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_REDUCE_MAX:                                                                 \
+        case CATERVA_REDUCE_ARGMAX:                                                              \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                if (acc[j].count == 0 || x[j] > acc[j].best.field) {                             \
+                    acc[j].best.field = x[j];                                                    \
+                    acc[j].arg = arg;                                                            \
+                }                                                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_REDUCE_MEAN:                                                                \
+        case CATERVA_REDUCE_STD:                                                                 \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                double d = (double) x[j] - acc[j].mean;                                          \
+                acc[j].mean += d / (double) (acc[j].count + 1);                                  \
+                acc[j].m2 += d * ((double) x[j] - acc[j].mean);                                  \
+            }                                                                                    \
+            break;                                                                               \
+    }                                                                                            \
+    for (int64_t j = 0; j < n; ++j) {                                                            \
+        acc[j].count++;                                                                          \
+    }                                                                                            \
+}                                                                                                \
+                                                                                                 \
+static void caterva_reduce_store_##name(const caterva_reduce_acc_t *acc, uint8_t *dest) {       \
+    type best = (type) acc->best.field;                                                          \
+    memcpy(dest, &best, sizeof(type));                                                           \
+}                                                                                                \
+                                                                                                 \
+static void caterva_stats_row_##name(const uint8_t *src, int64_t n, caterva_stats_t *stats) {   \
+    const type *x = (const type *) src;                                                          \
+    bool any = stats->nitems > stats->nnans;                                                     \
+    type min = any ? (type) stats->min.field : 0;                                                \
+    type max = any ? (type) stats->max.field : 0;                                                \
+    int64_t nnans = 0;                                                                           \
+    for (int64_t j = 0; j < n; ++j) {                                                            \
+        type v = x[j];                                                                           \
+        if (isnan_fn(v)) {                                                                       \
+            nnans++;                                                                             \
+        } else if (!any) {                                                                       \
+            min = v;                                                                             \
+            max = v;                                                                             \
+            any = true;                                                                          \
+        } else {                                                                                 \
+            min = v < min ? v : min;                                                             \
+            max = v > max ? v : max;                                                             \
+        }                                                                                        \
+    }                                                                                            \
+    stats->nitems += n;                                                                          \
+    stats->nnans += nnans;                                                                       \
+    if (any) {                                                                                   \
+        stats->min.field = min;                                                                  \
+        stats->max.field = max;                                                                  \
+    }                                                                                            \
+}                                                                                                \
+                                                                                                 \
+static void caterva_compare_row_##name(const uint8_t *src, int64_t n,                           \
+                                       const caterva_predicate_t *predicate, uint8_t *out) {    \
+    const type *x = (const type *) src;                                                          \
+    sumtype value = predicate->value.field;                                                      \
+    sumtype upper = predicate->upper.field;                                                      \
+    switch (predicate->op) {                                                                     \
+        case CATERVA_PREDICATE_LT:                                                               \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = (sumtype) x[j] < value;                                                 \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_PREDICATE_LE:                                                               \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = (sumtype) x[j] <= value;                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_PREDICATE_GT:                                                               \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = (sumtype) x[j] > value;                                                 \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_PREDICATE_GE:                                                               \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = (sumtype) x[j] >= value;                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_PREDICATE_EQ:                                                               \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = (sumtype) x[j] == value;                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_PREDICATE_NE:                                                               \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = (sumtype) x[j] != value;                                                \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_PREDICATE_RANGE:                                                            \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                out[j] = ((sumtype) x[j] >= value) & ((sumtype) x[j] < upper);                   \
+            }                                                                                    \
+            break;                                                                               \
+        default:                                                                                 \
+            break;                                                                               \
+    }                                                                                            \
+}
+
+CATERVA_REDUCE_KERNELS(int8, int8_t, i, int64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(int16, int16_t, i, int64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(int32, int32_t, i, int64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(int64, int64_t, i, int64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(uint8, uint8_t, u, uint64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(uint16, uint16_t, u, uint64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(uint32, uint32_t, u, uint64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(uint64, uint64_t, u, uint64_t, CATERVA_NOT_NAN)
+CATERVA_REDUCE_KERNELS(float32, float, f, double, isnan)
+CATERVA_REDUCE_KERNELS(float64, double, f, double, isnan)
+
+#define CATERVA_REDUCE_KERNELS_ENTRY(name, type, kind)                                           \
+    {sizeof(type), kind, caterva_reduce_row_##name, caterva_reduce_items_##name,                 \
+     caterva_reduce_store_##name, caterva_stats_row_##name, caterva_compare_row_##name}
+
+const caterva_reduce_kernels_t caterva_reduce_kernels[] = {
+    CATERVA_REDUCE_KERNELS_ENTRY(int8, int8_t, CATERVA_KIND_SIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(int16, int16_t, CATERVA_KIND_SIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(int32, int32_t, CATERVA_KIND_SIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(int64, int64_t, CATERVA_KIND_SIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(uint8, uint8_t, CATERVA_KIND_UNSIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(uint16, uint16_t, CATERVA_KIND_UNSIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(uint32, uint32_t, CATERVA_KIND_UNSIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(uint64, uint64_t, CATERVA_KIND_UNSIGNED),
+    CATERVA_REDUCE_KERNELS_ENTRY(float32, float, CATERVA_KIND_FLOAT),
+    CATERVA_REDUCE_KERNELS_ENTRY(float64, double, CATERVA_KIND_FLOAT),
+};
+
+// Merge two partial results of the same type, b after a
+static void caterva_reduce_merge(const caterva_reduce_kernels_t *kernels, caterva_reduce_op_t op,
+                                 caterva_reduce_acc_t *a, const caterva_reduce_acc_t *b) {
+    if (b->count == 0) {
+        return;
+    }
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+    switch (op) {
+        case CATERVA_REDUCE_SUM:
+            if (kernels->kind == CATERVA_KIND_FLOAT) {
+                a->sum.f += b->sum.f;
+            } else {
+                // Signed sums wrap around like the unsigned ones
+                a->sum.u += b->sum.u;
+            }
+            break;
+        case CATERVA_REDUCE_MIN:
+        case CATERVA_REDUCE_MAX:
+        case CATERVA_REDUCE_ARGMIN:
+        case CATERVA_REDUCE_ARGMAX: {
+            int cmp;
+            switch (kernels->kind) {
+                case CATERVA_KIND_SIGNED:
+                    cmp = (b->best.i > a->best.i) - (b->best.i < a->best.i);
+                    break;
+                case CATERVA_KIND_UNSIGNED:
+                    cmp = (b->best.u > a->best.u) - (b->best.u < a->best.u);
+                    break;
+                default:
+                    cmp = (b->best.f > a->best.f) - (b->best.f < a->best.f);
+                    break;
+            }
+            bool min = op == CATERVA_REDUCE_MIN || op == CATERVA_REDUCE_ARGMIN;
+            if ((min ? cmp < 0 : cmp > 0) || (cmp == 0 && b->arg < a->arg)) {
+                a->best = b->best;
+                a->arg = b->arg;
+            }
+            break;
+        }
+        case CATERVA_REDUCE_MEAN:
+        case CATERVA_REDUCE_STD:
+            caterva_reduce_merge_moments(a, b->count, b->mean, b->m2);
+            break;
+    }
+    a->count += b->count;
+}
+
+static uint8_t caterva_reduce_itemsize(const caterva_reduce_kernels_t *kernels,
+                                       caterva_reduce_op_t op) {
+    if (op == CATERVA_REDUCE_MIN || op == CATERVA_REDUCE_MAX) {
+        return kernels->itemsize;
+    }
+    return 8;
+}
+
+// Write the final result of a reduction
+static void caterva_reduce_store(const caterva_reduce_kernels_t *kernels, caterva_reduce_op_t op,
+                                 const caterva_reduce_acc_t *acc, uint8_t *dest) {
+    double value;
+    switch (op) {
+        case CATERVA_REDUCE_SUM:
+            memcpy(dest, &acc->sum, sizeof(acc->sum));
+            break;
+        case CATERVA_REDUCE_MIN:
+        case CATERVA_REDUCE_MAX:
+            kernels->store(acc, dest);
+            break;
+        case CATERVA_REDUCE_ARGMIN:
+        case CATERVA_REDUCE_ARGMAX:
+            memcpy(dest, &acc->arg, sizeof(acc->arg));
+            break;
+        case CATERVA_REDUCE_MEAN:
+            value = acc->count > 0 ? acc->mean : NAN;
+            memcpy(dest, &value, sizeof(value));
+            break;
+        case CATERVA_REDUCE_STD:
+            value = acc->count > 0 ? sqrt(acc->m2 / (double) acc->count) : NAN;
+            memcpy(dest, &value, sizeof(value));
+            break;
+    }
+}
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    caterva_reduce_op_t op;
+    const caterva_reduce_kernels_t *kernels;
+    int8_t axis;
+    //!< The reduced axis, or -1 for the whole array.
+    caterva_reduce_acc_t *chunk_accs;
+    //!< The partial result of each chunk (whole array only).
+    caterva_array_t *result;
+    int64_t ntiles[CATERVA_MAX_DIM];
+    //!< The number of tiles of the result along each axis (one tile per column of chunks).
+    int64_t tileshape[CATERVA_MAX_DIM];
+    int64_t tilenitems;
+    // Resources of each thread
+    blosc2_context **dctx;
+    uint8_t **data;
+    caterva_reduce_acc_t **tiles;
+    uint8_t **out;
+} caterva_reduce_job_t;
+
+typedef struct {
+    caterva_reduce_job_t *job;
+    caterva_reduce_acc_t *acc;
+    int64_t tile_start[CATERVA_MAX_DIM];
+} caterva_reduce_rows_t;
+
+static void caterva_reduce_array_row(void *arg, const uint8_t *row, int64_t n,
+                                     const int64_t *coords) {
+    caterva_reduce_rows_t *rows = (caterva_reduce_rows_t *) arg;
+    caterva_array_t *array = rows->job->array;
+    int64_t flat = 0;
+    for (int i = 0; i < array->ndim; ++i) {
+        flat += coords[i] * array->item_array_strides[i];
+    }
+    rows->job->kernels->row(row, n, flat, rows->job->op, rows->acc);
+}
+
+static void caterva_reduce_axis_row(void *arg, const uint8_t *row, int64_t n,
+                                    const int64_t *coords) {
+    caterva_reduce_rows_t *rows = (caterva_reduce_rows_t *) arg;
+    caterva_reduce_job_t *job = rows->job;
+    int8_t ndim = job->array->ndim;
+    int64_t t = 0;
+    for (int i = 0, j = 0; i < ndim; ++i) {
+        if (i != job->axis) {
+            t = t * job->tileshape[j] + coords[i] - rows->tile_start[j];
+            j++;
+        }
+    }
+    if (job->axis == ndim - 1) {
+        job->kernels->row(row, n, coords[job->axis], job->op, &rows->acc[t]);
+    } else {
+        job->kernels->items(row, n, coords[job->axis], job->op, &rows->acc[t]);
+    }
+}
+
+static int caterva_reduce_array_task(void *arg, int64_t nchunk, int thread) {
+    caterva_reduce_job_t *job = (caterva_reduce_job_t *) arg;
+    caterva_array_t *array = job->array;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, job->dctx[thread],
+                                               job->data[thread], nbytes));
+    caterva_reduce_rows_t rows = {job, &job->chunk_accs[nchunk], {0}};
+    caterva_chunk_rows(array, nchunk, job->data[thread], caterva_reduce_array_row, &rows);
+    return CATERVA_SUCCEED;
+}
+
+// Reduce the column of chunks along the axis that corresponds to a tile of the result
+static int caterva_reduce_axis_task(void *arg, int64_t tile, int thread) {
+    caterva_reduce_job_t *job = (caterva_reduce_job_t *) arg;
+    caterva_array_t *array = job->array;
+    int8_t ndim = array->ndim;
+    int8_t rdim = (int8_t) (ndim - 1);
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+
+    caterva_reduce_rows_t rows = {job, job->tiles[thread], {0}};
+    int64_t tile_coords[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    for (int j = rdim - 1; j >= 0; --j) {
+        tile_coords[j] = tile % job->ntiles[j];
+        tile /= job->ntiles[j];
+        start[j] = tile_coords[j] * job->tileshape[j];
+        stop[j] = start[j] + job->tileshape[j];
+        if (stop[j] > job->result->shape[j]) {
+            stop[j] = job->result->shape[j];
+        }
+        shape[j] = stop[j] - start[j];
+        rows.tile_start[j] = start[j];
+    }
+    memset(rows.acc, 0, job->tilenitems * sizeof(caterva_reduce_acc_t));
+
+    int64_t nchunks_axis = array->extshape[job->axis] / array->chunkshape[job->axis];
+    for (int64_t c = 0; c < nchunks_axis; ++c) {
+        int64_t nchunk = 0;
+        for (int i = 0, j = 0; i < ndim; ++i) {
+            nchunk *= array->extshape[i] / array->chunkshape[i];
+            nchunk += i == job->axis ? c : tile_coords[j++];
+        }
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, job->dctx[thread],
+                                                   job->data[thread], nbytes));
+        caterva_chunk_rows(array, nchunk, job->data[thread], caterva_reduce_axis_row, &rows);
+    }
+
+    // Store the valid part of the tile in C order
+    uint8_t itemsize = job->result->itemsize;
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t item[CATERVA_MAX_DIM] = {0};
+    int64_t k = 0;
+    do {
+        int64_t t = 0;
+        for (int j = 0; j < rdim; ++j) {
+            t = t * job->tileshape[j] + item[j];
+        }
+        caterva_reduce_store(job->kernels, job->op, &rows.acc[t], &job->out[thread][k * itemsize]);
+        k++;
+    } while (caterva_selection_next(rdim, item, first, shape));
+
+    caterva_parallel_lock();
+    int rc = caterva_set_slice_buffer(job->ctx, job->out[thread], shape, k * itemsize, start, stop,
+                                      job->result);
+    caterva_parallel_unlock();
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_reduce(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                   caterva_reduce_op_t op, int8_t axis, caterva_storage_t *storage,
+                   caterva_array_t **result) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(result);
+
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if ((int) op < 0 || op > CATERVA_REDUCE_ARGMAX) {
+        CATERVA_TRACE_ERROR("Unknown reduction");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (axis < -1 || axis >= array->ndim) {
+        CATERVA_TRACE_ERROR("The axis is out of range");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    // Reducing the only axis is the same as reducing the whole array
+    if (array->ndim <= 1) {
+        axis = -1;
+    }
+    int64_t nreduced = axis < 0 ? array->nitems : array->shape[axis];
+    if (nreduced == 0 && op != CATERVA_REDUCE_SUM && op != CATERVA_REDUCE_MEAN &&
+        op != CATERVA_REDUCE_STD) {
+        CATERVA_TRACE_ERROR("Can not reduce an empty axis");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    caterva_reduce_job_t job = {0};
+    job.ctx = ctx;
+    job.array = array;
+    job.op = op;
+    job.kernels = &caterva_reduce_kernels[dtype];
+    job.axis = axis;
+
+    caterva_params_t params = {0};
+    params.itemsize = caterva_reduce_itemsize(job.kernels, op);
+    caterva_storage_t rstorage = *storage;
+    int64_t ntasks;
+    if (axis < 0) {
+        params.ndim = 0;
+        ntasks = array->extnitems / array->chunknitems;
+        job.chunk_accs = calloc(ntasks, sizeof(caterva_reduce_acc_t));
+        CATERVA_ERROR_NULL(job.chunk_accs);
+    } else {
+        params.ndim = (int8_t) (array->ndim - 1);
+        bool auto_shapes = true;
+        for (int j = 0; j < params.ndim; ++j) {
+            auto_shapes = auto_shapes && rstorage.chunkshape[j] == 0;
+        }
+        ntasks = 1;
+        job.tilenitems = 1;
+        for (int i = 0, j = 0; i < array->ndim; ++i) {
+            if (i == axis) {
+                continue;
+            }
+            params.shape[j] = array->shape[i];
+            job.tileshape[j] = array->chunkshape[i];
+            job.ntiles[j] = array->extshape[i] / array->chunkshape[i];
+            if (auto_shapes) {
+                rstorage.chunkshape[j] = array->chunkshape[i];
+                rstorage.blockshape[j] = array->blockshape[i];
+            }
+            ntasks *= job.ntiles[j];
+            job.tilenitems *= job.tileshape[j];
+            j++;
+        }
+        CATERVA_ERROR(caterva_zeros(ctx, &params, &rstorage, &job.result));
+    }
+
+    // Allocate the resources of every thread
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > ntasks) {
+        nthreads = ntasks > 0 ? (int) ntasks : 1;
+    }
+    int rc = CATERVA_SUCCEED;
+    job.dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.data = calloc(nthreads, sizeof(uint8_t *));
+    job.tiles = calloc(nthreads, sizeof(caterva_reduce_acc_t *));
+    job.out = calloc(nthreads, sizeof(uint8_t *));
+    if (job.dctx == NULL || job.data == NULL || job.tiles == NULL || job.out == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.dctx[t] = caterva_create_thread_dctx(array);
+        job.data[t] = ctx->cfg->alloc(array->extchunknitems * array->itemsize);
+        if (job.dctx[t] == NULL || job.data[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+        if (axis >= 0) {
+            job.tiles[t] = ctx->cfg->alloc(job.tilenitems * sizeof(caterva_reduce_acc_t));
+            job.out[t] = ctx->cfg->alloc(job.tilenitems * params.itemsize);
+            if (job.tiles[t] == NULL || job.out[t] == NULL) {
+                rc = CATERVA_ERR_NULL_POINTER;
+            }
+        }
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, ntasks,
+                                  axis < 0 ? caterva_reduce_array_task : caterva_reduce_axis_task,
+                                  &job);
+    }
+    if (rc == CATERVA_SUCCEED && axis < 0) {
+        // The partial results are merged in chunk order, so results do not depend on threads
+        caterva_reduce_acc_t acc = {0};
+        for (int64_t nchunk = 0; nchunk < ntasks; ++nchunk) {
+            caterva_reduce_merge(job.kernels, op, &acc, &job.chunk_accs[nchunk]);
+        }
+        uint8_t value[8];
+        caterva_reduce_store(job.kernels, op, &acc, value);
+        rc = caterva_from_buffer(ctx, value, params.itemsize, &params, &rstorage, &job.result);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job.dctx != NULL && job.dctx[t] != NULL) {
+            blosc2_free_ctx(job.dctx[t]);
+        }
+        if (job.data != NULL && job.data[t] != NULL) {
+            ctx->cfg->free(job.data[t]);
+        }
+        if (job.tiles != NULL && job.tiles[t] != NULL) {
+            ctx->cfg->free(job.tiles[t]);
+        }
+        if (job.out != NULL && job.out[t] != NULL) {
+            ctx->cfg->free(job.out[t]);
+        }
+    }
+    free(job.dctx);
+    free(job.data);
+    free(job.tiles);
+    free(job.out);
+    free(job.chunk_accs);
+    if (rc != CATERVA_SUCCEED && job.result != NULL) {
+        caterva_free(ctx, &job.result);
+    }
+    CATERVA_ERROR(rc);
+
+    *result = job.result;
+    return CATERVA_SUCCEED;
+}
+
+
+// Expressions
+
+#define CATERVA_DIV_SIGNED(x, y, type, utype) \
+    ((y) == 0 ? 0 : (y) == -1 ? (type) (0 - (utype) (x)) : (type) ((x) / (y)))
+#define CATERVA_DIV_UNSIGNED(x, y, type, utype) ((y) == 0 ? 0 : (type) ((x) / (y)))
+#define CATERVA_DIV_FLOAT(x, y, type, utype) ((x) / (y))
+
+// The kernels of a type: compute an operation over two rows or fill a row with a constant. The
+// integer operations are done with an unsigned type, so that they wrap around.
+#define CATERVA_EXPR_KERNELS(name, type, utype, field, div)                                      \
+static void caterva_expr_row_##name(caterva_expr_op_t op, const uint8_t *a, const uint8_t *b,   \
+                                    int64_t n, uint8_t *dest) {                                  \
+    const type *x = (const type *) a;                                                            \
+    const type *y = (const type *) b;                                                            \
+    type *z = (type *) dest;                                                                     \
+    switch (op) {                                                                                \
+        case CATERVA_EXPR_ADD:                                                                   \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                z[j] = (type) ((utype) x[j] + (utype) y[j]);                                     \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_EXPR_SUB:                                                                   \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                z[j] = (type) ((utype) x[j] - (utype) y[j]);                                     \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_EXPR_MUL:                                                                   \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                z[j] = (type) ((utype) x[j] * (utype) y[j]);                                     \
+            }                                                                                    \
+            break;                                                                               \
+        case CATERVA_EXPR_DIV:                                                                   \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                z[j] = div(x[j], y[j], type, utype);                                             \
+            }                                                                                    \
+            break;                                                                               \
+        default:                                                                                 \
+            break;                                                                               \
+    }                                                                                            \
+}                                                                                                \
+                                                                                                 \
+static void caterva_expr_fill_##name(caterva_scalar_t value, int64_t n, uint8_t *dest) {        \
+    type v = (type) value.field;                                                                 \
+    type *z = (type *) dest;                                                                     \
+    for (int64_t j = 0; j < n; ++j) {                                                            \
+        z[j] = v;                                                                                \
+    }                                                                                            \
+}
+
+CATERVA_EXPR_KERNELS(int8, int8_t, uint32_t, i, CATERVA_DIV_SIGNED)
+CATERVA_EXPR_KERNELS(int16, int16_t, uint32_t, i, CATERVA_DIV_SIGNED)
+CATERVA_EXPR_KERNELS(int32, int32_t, uint32_t, i, CATERVA_DIV_SIGNED)
+CATERVA_EXPR_KERNELS(int64, int64_t, uint64_t, i, CATERVA_DIV_SIGNED)
+CATERVA_EXPR_KERNELS(uint8, uint8_t, uint32_t, u, CATERVA_DIV_UNSIGNED)
+CATERVA_EXPR_KERNELS(uint16, uint16_t, uint32_t, u, CATERVA_DIV_UNSIGNED)
+CATERVA_EXPR_KERNELS(uint32, uint32_t, uint32_t, u, CATERVA_DIV_UNSIGNED)
+CATERVA_EXPR_KERNELS(uint64, uint64_t, uint64_t, u, CATERVA_DIV_UNSIGNED)
+CATERVA_EXPR_KERNELS(float32, float, float, f, CATERVA_DIV_FLOAT)
+CATERVA_EXPR_KERNELS(float64, double, double, f, CATERVA_DIV_FLOAT)
+
+typedef struct {
+    void (*row)(caterva_expr_op_t op, const uint8_t *a, const uint8_t *b, int64_t n,
+                uint8_t *dest);
+    void (*fill)(caterva_scalar_t value, int64_t n, uint8_t *dest);
+} caterva_expr_kernels_t;
+
+#define CATERVA_EXPR_KERNELS_ENTRY(name) {caterva_expr_row_##name, caterva_expr_fill_##name}
+
+// Indexed by caterva_dtype_t
+static const caterva_expr_kernels_t caterva_expr_kernels[] = {
+    CATERVA_EXPR_KERNELS_ENTRY(int8),
+    CATERVA_EXPR_KERNELS_ENTRY(int16),
+    CATERVA_EXPR_KERNELS_ENTRY(int32),
+    CATERVA_EXPR_KERNELS_ENTRY(int64),
+    CATERVA_EXPR_KERNELS_ENTRY(uint8),
+    CATERVA_EXPR_KERNELS_ENTRY(uint16),
+    CATERVA_EXPR_KERNELS_ENTRY(uint32),
+    CATERVA_EXPR_KERNELS_ENTRY(uint64),
+    CATERVA_EXPR_KERNELS_ENTRY(float32),
+    CATERVA_EXPR_KERNELS_ENTRY(float64),
+};
+
+// Check an expression and collect its distinct arrays. Returns the depth of the expression, or
+// -1 if it is not valid. When arrays is NULL, the arrays are only counted (with repetitions).
+static int caterva_expr_collect(const caterva_expr_t *expr, caterva_array_t **arrays,
+                                int *narrays) {
+    if (expr == NULL) {
+        return -1;
+    }
+    switch (expr->op) {
+        case CATERVA_EXPR_ARRAY:
+            if (expr->array == NULL) {
+                return -1;
+            }
+            if (arrays != NULL) {
+                for (int i = 0; i < *narrays; ++i) {
+                    if (arrays[i] == expr->array) {
+                        return 1;
+                    }
+                }
+                arrays[*narrays] = expr->array;
+            }
+            (*narrays)++;
+            return 1;
+        case CATERVA_EXPR_SCALAR:
+            return 1;
+        case CATERVA_EXPR_ADD:
+        case CATERVA_EXPR_SUB:
+        case CATERVA_EXPR_MUL:
+        case CATERVA_EXPR_DIV: {
+            int left = caterva_expr_collect(expr->left, arrays, narrays);
+            int right = caterva_expr_collect(expr->right, arrays, narrays);
+            if (left < 0 || right < 0) {
+                return -1;
+            }
+            return 1 + (left > right ? left : right);
+        }
+        default:
+            return -1;
+    }
+}
+
+typedef struct caterva_eval_job_s caterva_eval_job_t;
+
+// The user data of the prefilter of each thread
+typedef struct {
+    caterva_eval_job_t *job;
+    int thread;
+} caterva_eval_thread_t;
+
+struct caterva_eval_job_s {
+    const caterva_expr_t *expr;
+    const caterva_expr_kernels_t *kernels;
+    caterva_array_t **arrays;
+    //!< The distinct arrays of the expression.
+    int narrays;
+    caterva_array_t *result;
+    int32_t blocksize;
+    //!< The size of a block in bytes.
+    // Resources of each thread
+    caterva_eval_thread_t *threads;
+    blosc2_context **dctx;
+    blosc2_context **cctx;
+    uint8_t ***operands;
+    //!< The uncompressed chunk of every array.
+    uint8_t **scratch;
+    //!< A block per level of the expression.
+};
+
+// Evaluate an expression over a block into dest or, if it is NULL, into the scratch block of the
+// level (the arrays are not copied). Returns the block with the result.
+static const uint8_t *caterva_eval_block(caterva_eval_job_t *job, int thread,
+                                         const caterva_expr_t *expr, int32_t offset,
+                                         int32_t nbytes, int level, uint8_t *dest) {
+    int64_t n = nbytes / job->result->itemsize;
+    uint8_t *out = dest != NULL ? dest : &job->scratch[thread][level * job->blocksize];
+    switch (expr->op) {
+        case CATERVA_EXPR_ARRAY: {
+            int i = 0;
+            while (job->arrays[i] != expr->array) {
+                i++;
+            }
+            const uint8_t *src = &job->operands[thread][i][offset];
+            if (dest == NULL) {
+                return src;
+            }
+            memcpy(dest, src, nbytes);
+            return dest;
+        }
+        case CATERVA_EXPR_SCALAR:
+            job->kernels->fill(expr->value, n, out);
+            return out;
+        default: {
+            // The left operand can be computed in place
+            const uint8_t *a = caterva_eval_block(job, thread, expr->left, offset, nbytes, level,
+                                                  NULL);
+            const uint8_t *b = caterva_eval_block(job, thread, expr->right, offset, nbytes,
+                                                  level + 1, NULL);
+            job->kernels->row(expr->op, a, b, n, out);
+            return out;
+        }
+    }
+}
+
+// Produce a block of the result while it is compressed
+static int caterva_eval_prefilter(blosc2_prefilter_params *params) {
+    caterva_eval_thread_t *thread = (caterva_eval_thread_t *) params->user_data;
+    caterva_eval_block(thread->job, thread->thread, thread->job->expr, params->output_offset,
+                       params->output_size, 0, params->output);
+    return 0;
+}
+
+static int caterva_eval_task(void *arg, int64_t nchunk, int thread) {
+    caterva_eval_job_t *job = (caterva_eval_job_t *) arg;
+    caterva_array_t *result = job->result;
+    int32_t nbytes = (int32_t) (result->extchunknitems * result->itemsize);
+
+    for (int i = 0; i < job->narrays; ++i) {
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(job->arrays[i], nchunk, job->dctx[thread],
+                                                   job->operands[thread][i], nbytes));
+    }
+    // The source is not read, the blocks are produced by the prefilter
+    CATERVA_ERROR(caterva_compress_chunk_ctx(result, nchunk, job->cctx[thread],
+                                             job->operands[thread][0], nbytes));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_eval(caterva_ctx_t *ctx, const caterva_expr_t *expr, caterva_dtype_t dtype,
+                 caterva_storage_t *storage, caterva_array_t **result) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(expr);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(result);
+
+    caterva_eval_job_t job = {0};
+    job.expr = expr;
+    int depth = caterva_expr_collect(expr, NULL, &job.narrays);
+    if (depth < 0 || job.narrays == 0) {
+        CATERVA_TRACE_ERROR("The expression is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    job.arrays = malloc(job.narrays * sizeof(caterva_array_t *));
+    CATERVA_ERROR_NULL(job.arrays);
+    job.narrays = 0;
+    caterva_expr_collect(expr, job.arrays, &job.narrays);
+
+    // The blocks of every array must have the same items
+    caterva_array_t *array = job.arrays[0];
+    int rc = CATERVA_SUCCEED;
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the array");
+        rc = CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    for (int i = 1; i < job.narrays && rc == CATERVA_SUCCEED; ++i) {
+        caterva_array_t *other = job.arrays[i];
+        bool same = other->ndim == array->ndim && other->itemsize == array->itemsize;
+        for (int j = 0; j < array->ndim && same; ++j) {
+            same = other->shape[j] == array->shape[j] &&
+                   other->chunkshape[j] == array->chunkshape[j] &&
+                   other->blockshape[j] == array->blockshape[j];
+        }
+        if (!same) {
+            CATERVA_TRACE_ERROR("The arrays must have the same shapes and itemsize");
+            rc = CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+    caterva_params_t params = {0};
+    params.itemsize = array->itemsize;
+    params.ndim = array->ndim;
+    caterva_storage_t rstorage = *storage;
+    bool auto_shapes = true;
+    bool same_shapes = true;
+    for (int i = 0; i < array->ndim; ++i) {
+        params.shape[i] = array->shape[i];
+        auto_shapes = auto_shapes && rstorage.chunkshape[i] == 0;
+        same_shapes = same_shapes && rstorage.chunkshape[i] == array->chunkshape[i] &&
+                      rstorage.blockshape[i] == array->blockshape[i];
+    }
+    for (int i = 0; i < array->ndim && auto_shapes; ++i) {
+        rstorage.chunkshape[i] = array->chunkshape[i];
+        rstorage.blockshape[i] = array->blockshape[i];
+    }
+    if (rc == CATERVA_SUCCEED && !auto_shapes && !same_shapes) {
+        CATERVA_TRACE_ERROR("The result must have the chunkshape and blockshape of the arrays");
+        rc = CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_empty(ctx, &params, &rstorage, &job.result);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        free(job.arrays);
+        CATERVA_ERROR(rc);
+    }
+    job.kernels = &caterva_expr_kernels[dtype];
+    job.blocksize = (int32_t) (array->blocknitems * array->itemsize);
+
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = nchunks > 0 ? (int) nchunks : 1;
+    }
+    job.threads = calloc(nthreads, sizeof(caterva_eval_thread_t));
+    job.dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.cctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.operands = calloc(nthreads, sizeof(uint8_t **));
+    job.scratch = calloc(nthreads, sizeof(uint8_t *));
+    if (job.threads == NULL || job.dctx == NULL || job.cctx == NULL || job.operands == NULL ||
+        job.scratch == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.threads[t].job = &job;
+        job.threads[t].thread = t;
+        job.dctx[t] = caterva_create_thread_dctx(array);
+        job.cctx[t] = caterva_create_thread_cctx(job.result, caterva_eval_prefilter,
+                                                 &job.threads[t]);
+        job.operands[t] = calloc(job.narrays, sizeof(uint8_t *));
+        job.scratch[t] = ctx->cfg->alloc(depth * job.blocksize);
+        if (job.dctx[t] == NULL || job.cctx[t] == NULL || job.operands[t] == NULL ||
+            job.scratch[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+        for (int i = 0; i < job.narrays && rc == CATERVA_SUCCEED; ++i) {
+            job.operands[t][i] = ctx->cfg->alloc(array->extchunknitems * array->itemsize);
+            if (job.operands[t][i] == NULL) {
+                rc = CATERVA_ERR_NULL_POINTER;
+            }
+        }
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, nchunks, caterva_eval_task, &job);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job.dctx != NULL && job.dctx[t] != NULL) {
+            blosc2_free_ctx(job.dctx[t]);
+        }
+        if (job.cctx != NULL && job.cctx[t] != NULL) {
+            blosc2_free_ctx(job.cctx[t]);
+        }
+        if (job.operands != NULL && job.operands[t] != NULL) {
+            for (int i = 0; i < job.narrays; ++i) {
+                if (job.operands[t][i] != NULL) {
+                    ctx->cfg->free(job.operands[t][i]);
+                }
+            }
+            free(job.operands[t]);
+        }
+        if (job.scratch != NULL && job.scratch[t] != NULL) {
+            ctx->cfg->free(job.scratch[t]);
+        }
+    }
+    free(job.threads);
+    free(job.dctx);
+    free(job.cctx);
+    free(job.operands);
+    free(job.scratch);
+    free(job.arrays);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.result);
+    }
+    CATERVA_ERROR(rc);
+
+    *result = job.result;
+    return CATERVA_SUCCEED;
+}
+
+
+// Computed arrays
+
+typedef struct caterva_computed_job_s caterva_computed_job_t;
+
+// The user data of the prefilter of each thread
+typedef struct {
+    caterva_computed_job_t *job;
+    int thread;
+    int64_t nchunk;
+    //!< The chunk being compressed by the thread.
+} caterva_computed_thread_t;
+
+struct caterva_computed_job_s {
+    caterva_array_t *array;
+    caterva_prefilter_fn prefilter;
+    void *user_data;
+    uint8_t *src;
+    //!< The source of the compression (never read).
+    // Resources of each thread
+    caterva_computed_thread_t *threads;
+    blosc2_context **cctx;
+};
+
+// Pass the coordinates of a block to the prefilter of the user
+static int caterva_computed_prefilter(blosc2_prefilter_params *params) {
+    caterva_computed_thread_t *thread = (caterva_computed_thread_t *) params->user_data;
+    caterva_computed_job_t *job = thread->job;
+    caterva_array_t *array = job->array;
+
+    caterva_prefilter_params_t block = {0};
+    block.user_data = job->user_data;
+    block.ndim = array->ndim;
+    block.itemsize = array->itemsize;
+    block.nchunk = thread->nchunk;
+    block.nblock = (int32_t) (params->output_offset / (array->blocknitems * array->itemsize));
+    block.output = params->output;
+    block.output_size = params->output_size;
+    block.tid = thread->thread;
+    caterva_block_coords(array, block.nchunk, block.nblock, block.chunk_coords,
+                         block.block_start, block.block_shape);
+    for (int i = 0; i < array->ndim; ++i) {
+        block.blockshape[i] = array->blockshape[i];
+    }
+    return job->prefilter(&block);
+}
+
+static int caterva_computed_task(void *arg, int64_t nchunk, int thread) {
+    caterva_computed_job_t *job = (caterva_computed_job_t *) arg;
+    caterva_array_t *array = job->array;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+
+    job->threads[thread].nchunk = nchunk;
+    CATERVA_ERROR(caterva_compress_chunk_ctx(array, nchunk, job->cctx[thread], job->src, nbytes));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_from_prefilter(caterva_ctx_t *ctx, caterva_params_t *params,
+                           caterva_storage_t *storage, caterva_prefilter_fn prefilter,
+                           void *user_data, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(prefilter);
+    CATERVA_ERROR_NULL(array);
+
+    caterva_computed_job_t job = {0};
+    job.prefilter = prefilter;
+    job.user_data = user_data;
+    // Every chunk is replaced
+    CATERVA_ERROR(caterva_uninit(ctx, params, storage, &job.array));
+
+    int64_t nchunks = job.array->nchunks;
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = nchunks > 0 ? (int) nchunks : 1;
+    }
+    int rc = CATERVA_SUCCEED;
+    job.src = ctx->cfg->alloc(job.array->extchunknitems * job.array->itemsize);
+    job.threads = calloc(nthreads, sizeof(caterva_computed_thread_t));
+    job.cctx = calloc(nthreads, sizeof(blosc2_context *));
+    if (job.src == NULL || job.threads == NULL || job.cctx == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.threads[t].job = &job;
+        job.threads[t].thread = t;
+        job.cctx[t] = caterva_create_thread_cctx(job.array, caterva_computed_prefilter,
+                                                 &job.threads[t]);
+        if (job.cctx[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, nchunks, caterva_computed_task, &job);
+    }
+
+    for (int t = 0; t < nthreads && job.cctx != NULL; ++t) {
+        if (job.cctx[t] != NULL) {
+            blosc2_free_ctx(job.cctx[t]);
+        }
+    }
+    if (job.src != NULL) {
+        ctx->cfg->free(job.src);
+    }
+    free(job.threads);
+    free(job.cctx);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.array);
+    }
+    CATERVA_ERROR(rc);
+
+    *array = job.array;
+    return CATERVA_SUCCEED;
+}
+
+
+// Transpose
+
+// Gather n items separated by stride items into a row
+#define CATERVA_TRANSPOSE_KERNEL(name, type)                                                     \
+static void caterva_transpose_row_##name(const uint8_t *src, int64_t stride, int64_t n,         \
+                                         uint8_t *dest) {                                        \
+    const type *x = (const type *) src;                                                          \
+    type *y = (type *) dest;                                                                     \
+    for (int64_t j = 0; j < n; ++j) {                                                            \
+        y[j] = x[j * stride];                                                                    \
+    }                                                                                            \
+}
+
+CATERVA_TRANSPOSE_KERNEL(8, uint8_t)
+CATERVA_TRANSPOSE_KERNEL(16, uint16_t)
+CATERVA_TRANSPOSE_KERNEL(32, uint32_t)
+CATERVA_TRANSPOSE_KERNEL(64, uint64_t)
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *src;
+    caterva_array_t *dest;
+    const int8_t *perm;
+    int64_t tile_start[CATERVA_MAX_DIM];
+    int64_t tile_stop[CATERVA_MAX_DIM];
+    //!< The region of the destination in the tile.
+    int64_t src_start[CATERVA_MAX_DIM];
+    int64_t src_stop[CATERVA_MAX_DIM];
+    //!< The region of the source in the tile.
+    int64_t src_first[CATERVA_MAX_DIM];
+    int64_t src_count[CATERVA_MAX_DIM];
+    //!< The chunks of the source that overlap the tile.
+    int64_t dest_first[CATERVA_MAX_DIM];
+    int64_t dest_count[CATERVA_MAX_DIM];
+    //!< The chunks of the destination in the tile.
+    int64_t strides[CATERVA_MAX_DIM];
+    //!< The strides of the tile along the axes of the destination, in items.
+    uint8_t *tile;
+    //!< The items of the source region in C order.
+    // Resources of each thread
+    blosc2_context **dctx;
+    blosc2_context **cctx;
+    uint8_t **data;
+} caterva_transpose_job_t;
+
+// The index of a chunk given by its position in a range of chunks
+static int64_t caterva_range_nchunk(caterva_array_t *array, int64_t task,
+                                    const int64_t *first, const int64_t *count,
+                                    int64_t *coords) {
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        coords[i] = first[i] + task % count[i];
+        task /= count[i];
+    }
+    int64_t nchunk = 0;
+    for (int i = 0; i < array->ndim; ++i) {
+        nchunk = nchunk * (array->extshape[i] / array->chunkshape[i]) + coords[i];
+    }
+    return nchunk;
+}
+
+// Decompress a chunk of the source and copy its items in the region of the tile
+static int caterva_transpose_gather(void *arg, int64_t task, int thread) {
+    caterva_transpose_job_t *job = (caterva_transpose_job_t *) arg;
+    caterva_array_t *src = job->src;
+    int64_t coords[CATERVA_MAX_DIM];
+    int64_t nchunk = caterva_range_nchunk(src, task, job->src_first, job->src_count, coords);
+    CATERVA_ERROR(caterva_decompress_chunk_ctx(src, nchunk, job->dctx[thread], job->data[thread],
+                                               (int32_t) (src->extchunknitems * src->itemsize)));
+
+    caterva_region_rows_t rows;
+    rows.array = src;
+    rows.tile = job->tile;
+    rows.start = job->src_start;
+    rows.stop = job->src_stop;
+    rows.strides[src->ndim - 1] = 1;
+    for (int i = src->ndim - 2; i >= 0; --i) {
+        rows.strides[i] = rows.strides[i + 1] * (job->src_stop[i + 1] - job->src_start[i + 1]);
+    }
+    caterva_chunk_rows(src, nchunk, job->data[thread], caterva_region_row, &rows);
+    return CATERVA_SUCCEED;
+}
+
+// Build a chunk of the destination from the tile, block by block, and compress it. The source
+// items of a block are a small box of the tile, so the strided reads of a block stay in cache.
+static int caterva_transpose_scatter(void *arg, int64_t task, int thread) {
+    caterva_transpose_job_t *job = (caterva_transpose_job_t *) arg;
+    caterva_array_t *dest = job->dest;
+    int8_t ndim = dest->ndim;
+    uint8_t itemsize = dest->itemsize;
+    int64_t coords[CATERVA_MAX_DIM];
+    int64_t nchunk = caterva_range_nchunk(dest, task, job->dest_first, job->dest_count, coords);
+    uint8_t *data = job->data[thread];
+    int32_t nbytes = (int32_t) (dest->extchunknitems * itemsize);
+    // The padding is filled with zeros
+    memset(data, 0, nbytes);
+
+    int64_t nblocks = dest->extchunknitems / dest->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        int64_t chunk_coords[CATERVA_MAX_DIM];
+        int64_t block_start[CATERVA_MAX_DIM];
+        int32_t block_shape[CATERVA_MAX_DIM];
+        caterva_block_coords(dest, nchunk, nblock, chunk_coords, block_start, block_shape);
+        int64_t extent[CATERVA_MAX_DIM];
+        bool empty = false;
+        for (int i = 0; i < ndim; ++i) {
+            extent[i] = block_shape[i];
+            empty = empty || extent[i] == 0;
+        }
+        if (empty) {
+            continue;
+        }
+
+        uint8_t *block = &data[nblock * dest->blocknitems * itemsize];
+        int64_t stride = job->strides[ndim - 1];
+        int64_t first[CATERVA_MAX_DIM] = {0};
+        int64_t row[CATERVA_MAX_DIM] = {0};
+        do {
+            int64_t offset = 0;
+            int64_t tile_offset = block_start[ndim - 1] - job->tile_start[ndim - 1];
+            tile_offset *= stride;
+            for (int i = 0; i < ndim - 1; ++i) {
+                offset += row[i] * dest->item_block_strides[i];
+                tile_offset += (block_start[i] + row[i] - job->tile_start[i]) * job->strides[i];
+            }
+            const uint8_t *x = &job->tile[tile_offset * itemsize];
+            uint8_t *y = &block[offset * itemsize];
+            int64_t n = extent[ndim - 1];
+            switch (itemsize) {
+                case 1:
+                    caterva_transpose_row_8(x, stride, n, y);
+                    break;
+                case 2:
+                    caterva_transpose_row_16(x, stride, n, y);
+                    break;
+                case 4:
+                    caterva_transpose_row_32(x, stride, n, y);
+                    break;
+                case 8:
+                    caterva_transpose_row_64(x, stride, n, y);
+                    break;
+                default:
+                    for (int64_t j = 0; j < n; ++j) {
+                        memcpy(&y[j * itemsize], &x[j * stride * itemsize], itemsize);
+                    }
+                    break;
+            }
+        } while (caterva_selection_next((int8_t) (ndim - 1), row, first, extent));
+    }
+
+    CATERVA_ERROR(caterva_compress_chunk_ctx(dest, nchunk, job->cctx[thread], data, nbytes));
+    return CATERVA_SUCCEED;
+}
+
+// Transpose a tile of chunks of the destination: gather the source region and then build the
+// chunks of the destination
+static int caterva_transpose_tile(caterva_transpose_job_t *job, int nthreads) {
+    caterva_array_t *src = job->src;
+    caterva_array_t *dest = job->dest;
+    int64_t src_nchunks = 1;
+    int64_t dest_nchunks = 1;
+    for (int i = 0; i < dest->ndim; ++i) {
+        int8_t j = job->perm[i];
+        job->src_start[j] = job->tile_start[i];
+        job->src_stop[j] = job->tile_stop[i];
+        job->src_first[j] = job->tile_start[i] / src->chunkshape[j];
+        job->src_count[j] = (job->tile_stop[i] - 1) / src->chunkshape[j] + 1 -
+                            job->src_first[j];
+        job->dest_first[i] = job->tile_start[i] / dest->chunkshape[i];
+        job->dest_count[i] = (job->tile_stop[i] - 1) / dest->chunkshape[i] + 1 -
+                             job->dest_first[i];
+        src_nchunks *= job->src_count[j];
+        dest_nchunks *= job->dest_count[i];
+    }
+    int64_t src_strides[CATERVA_MAX_DIM];
+    src_strides[src->ndim - 1] = 1;
+    for (int i = src->ndim - 2; i >= 0; --i) {
+        src_strides[i] = src_strides[i + 1] * (job->src_stop[i + 1] - job->src_start[i + 1]);
+    }
+    for (int i = 0; i < dest->ndim; ++i) {
+        job->strides[i] = src_strides[job->perm[i]];
+    }
+
+    CATERVA_ERROR(caterva_parallel_for(nthreads, src_nchunks, caterva_transpose_gather, job));
+    CATERVA_ERROR(caterva_parallel_for(nthreads, dest_nchunks, caterva_transpose_scatter, job));
+    return CATERVA_SUCCEED;
+}
+
+// Transpose the source tile by tile; the tiles are boxes of chunks of the destination whose items
+// fit in the memory budget
+static int caterva_transpose_tiles(caterva_transpose_job_t *job) {
+    caterva_ctx_t *ctx = job->ctx;
+    caterva_array_t *src = job->src;
+    caterva_array_t *dest = job->dest;
+    int8_t ndim = dest->ndim;
+
+    int64_t nchunks = dest->extnitems / dest->chunknitems;
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = (int) nchunks;
+    }
+    // The buffers of the threads are taken from the budget
+    int64_t chunk_nbytes = src->extchunknitems * src->itemsize;
+    if (dest->extchunknitems * dest->itemsize > chunk_nbytes) {
+        chunk_nbytes = dest->extchunknitems * dest->itemsize;
+    }
+    int64_t budget = ctx->cfg->memory_budget - nthreads * chunk_nbytes;
+
+    // Halve the largest side of the tile until it fits, down to a single chunk
+    int64_t grid[CATERVA_MAX_DIM];
+    int64_t count[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        grid[i] = dest->extshape[i] / dest->chunkshape[i];
+        count[i] = grid[i];
+    }
+    while (ctx->cfg->memory_budget > 0) {
+        int64_t tile_nbytes = dest->itemsize;
+        int largest = -1;
+        int64_t largest_size = 1;
+        for (int i = 0; i < ndim; ++i) {
+            int64_t size = count[i] * dest->chunkshape[i];
+            size = size < dest->shape[i] ? size : dest->shape[i];
+            tile_nbytes *= size;
+            if (count[i] > 1 && size > largest_size) {
+                largest = i;
+                largest_size = size;
+            }
+        }
+        if (tile_nbytes <= budget || largest < 0) {
+            break;
+        }
+        count[largest] = (count[largest] + 1) / 2;
+    }
+    int64_t tile_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        int64_t size = count[i] * dest->chunkshape[i];
+        tile_nitems *= size < dest->shape[i] ? size : dest->shape[i];
+    }
+
+    int rc = CATERVA_SUCCEED;
+    job->tile = ctx->cfg->alloc(tile_nitems * dest->itemsize);
+    job->dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job->cctx = calloc(nthreads, sizeof(blosc2_context *));
+    job->data = calloc(nthreads, sizeof(uint8_t *));
+    if (job->tile == NULL || job->dctx == NULL || job->cctx == NULL || job->data == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job->dctx[t] = caterva_create_thread_dctx(src);
+        job->cctx[t] = caterva_create_thread_cctx(dest, NULL, NULL);
+        job->data[t] = ctx->cfg->alloc(chunk_nbytes);
+        if (job->dctx[t] == NULL || job->cctx[t] == NULL || job->data[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t tile[CATERVA_MAX_DIM] = {0};
+    int64_t ntiles[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        ntiles[i] = (grid[i] + count[i] - 1) / count[i];
+    }
+    while (rc == CATERVA_SUCCEED) {
+        for (int i = 0; i < ndim; ++i) {
+            job->tile_start[i] = tile[i] * count[i] * dest->chunkshape[i];
+            job->tile_stop[i] = (tile[i] + 1) * count[i] * dest->chunkshape[i];
+            if (job->tile_stop[i] > dest->shape[i]) {
+                job->tile_stop[i] = dest->shape[i];
+            }
+        }
+        rc = caterva_transpose_tile(job, nthreads);
+        if (!caterva_selection_next(ndim, tile, first, ntiles)) {
+            break;
+        }
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job->dctx != NULL && job->dctx[t] != NULL) {
+            blosc2_free_ctx(job->dctx[t]);
+        }
+        if (job->cctx != NULL && job->cctx[t] != NULL) {
+            blosc2_free_ctx(job->cctx[t]);
+        }
+        if (job->data != NULL && job->data[t] != NULL) {
+            ctx->cfg->free(job->data[t]);
+        }
+    }
+    if (job->tile != NULL) {
+        ctx->cfg->free(job->tile);
+    }
+    free(job->dctx);
+    free(job->cctx);
+    free(job->data);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_transpose(caterva_ctx_t *ctx, caterva_array_t *src, const int8_t *perm,
+                      caterva_storage_t *storage, caterva_array_t **dest) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(src);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(dest);
+
+    int8_t ndim = src->ndim;
+    if (ndim == 0) {
+        CATERVA_ERROR(caterva_copy(ctx, src, storage, dest));
+        return CATERVA_SUCCEED;
+    }
+    CATERVA_ERROR_NULL(perm);
+    bool seen[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < ndim; ++i) {
+        if (perm[i] < 0 || perm[i] >= ndim || seen[perm[i]]) {
+            CATERVA_TRACE_ERROR("The permutation of the axes is not valid");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        seen[perm[i]] = true;
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = src->itemsize;
+    params.ndim = ndim;
+    caterva_storage_t dstorage = *storage;
+    bool auto_shapes = true;
+    for (int i = 0; i < ndim; ++i) {
+        auto_shapes = auto_shapes && dstorage.chunkshape[i] == 0;
+    }
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = src->shape[perm[i]];
+        if (auto_shapes) {
+            dstorage.chunkshape[i] = src->chunkshape[perm[i]];
+            dstorage.blockshape[i] = src->blockshape[perm[i]];
+        }
+    }
+    caterva_transpose_job_t job = {0};
+    job.ctx = ctx;
+    job.src = src;
+    job.perm = perm;
+    CATERVA_ERROR(caterva_empty(ctx, &params, &dstorage, &job.dest));
+    if (job.dest->nitems == 0) {
+        *dest = job.dest;
+        return CATERVA_SUCCEED;
+    }
+
+    int rc = caterva_transpose_tiles(&job);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.dest);
+        CATERVA_ERROR(rc);
+    }
+    *dest = job.dest;
+    return CATERVA_SUCCEED;
+}
+
+
+// Stencils
+
+// The weighted sums of n consecutive items with the taps at the given offsets
+#define CATERVA_STENCIL_KERNEL(name, type)                                                       \
+static void caterva_stencil_row_##name(const uint8_t *src, const int64_t *offsets,             \
+                                       const double *weights, int64_t ntaps, int64_t n,        \
+                                       uint8_t *dest) {                                          \
+    const type *x = (const type *) src;                                                          \
+    type *y = (type *) dest;                                                                     \
+    for (int64_t j = 0; j < n; ++j) {                                                            \
+        double sum = 0;                                                                          \
+        for (int64_t t = 0; t < ntaps; ++t) {                                                    \
+            sum += weights[t] * (double) x[j + offsets[t]];                                      \
+        }                                                                                        \
+        y[j] = (type) sum;                                                                       \
+    }                                                                                            \
+}
+
+CATERVA_STENCIL_KERNEL(int8, int8_t)
+CATERVA_STENCIL_KERNEL(int16, int16_t)
+CATERVA_STENCIL_KERNEL(int32, int32_t)
+CATERVA_STENCIL_KERNEL(int64, int64_t)
+CATERVA_STENCIL_KERNEL(uint8, uint8_t)
+CATERVA_STENCIL_KERNEL(uint16, uint16_t)
+CATERVA_STENCIL_KERNEL(uint32, uint32_t)
+CATERVA_STENCIL_KERNEL(uint64, uint64_t)
+CATERVA_STENCIL_KERNEL(float32, float)
+CATERVA_STENCIL_KERNEL(float64, double)
+
+typedef void (*caterva_stencil_row_fn)(const uint8_t *src, const int64_t *offsets,
+                                       const double *weights, int64_t ntaps, int64_t n,
+                                       uint8_t *dest);
+
+// Indexed by caterva_dtype_t
+static const caterva_stencil_row_fn caterva_stencil_rows[] = {
+    caterva_stencil_row_int8,
+    caterva_stencil_row_int16,
+    caterva_stencil_row_int32,
+    caterva_stencil_row_int64,
+    caterva_stencil_row_uint8,
+    caterva_stencil_row_uint16,
+    caterva_stencil_row_uint32,
+    caterva_stencil_row_uint64,
+    caterva_stencil_row_float32,
+    caterva_stencil_row_float64,
+};
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    caterva_array_t *result;
+    const caterva_stencil_t *stencil;
+    const caterva_expr_kernels_t *kernels;
+    caterva_stencil_row_fn row;
+    int64_t *offsets;
+    //!< The offsets of the taps of the built-in kernel in the input of a block.
+    int64_t ntaps;
+    int64_t input_strides[CATERVA_MAX_DIM];
+    //!< The strides of the input of a block, in items.
+    int64_t tile_start[CATERVA_MAX_DIM];
+    int64_t tile_stop[CATERVA_MAX_DIM];
+    //!< The region of the result in the tile.
+    int64_t src_start[CATERVA_MAX_DIM];
+    int64_t src_stop[CATERVA_MAX_DIM];
+    //!< The region of the array in the tile, with the halo.
+    int64_t src_first[CATERVA_MAX_DIM];
+    int64_t src_count[CATERVA_MAX_DIM];
+    //!< The chunks of the array that overlap the tile.
+    int64_t dest_first[CATERVA_MAX_DIM];
+    int64_t dest_count[CATERVA_MAX_DIM];
+    //!< The chunks of the result in the tile.
+    int64_t strides[CATERVA_MAX_DIM];
+    //!< The strides of the tile, in items.
+    uint8_t *tile;
+    //!< The items of the array region in C order.
+    // Resources of each thread
+    blosc2_context **dctx;
+    blosc2_context **cctx;
+    uint8_t **data;
+    uint8_t **input;
+} caterva_stencil_job_t;
+
+// Decompress a chunk of the array and copy its items in the region of the tile
+static int caterva_stencil_gather(void *arg, int64_t task, int thread) {
+    caterva_stencil_job_t *job = (caterva_stencil_job_t *) arg;
+    caterva_array_t *array = job->array;
+    int64_t coords[CATERVA_MAX_DIM];
+    int64_t nchunk = caterva_range_nchunk(array, task, job->src_first, job->src_count, coords);
+    CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, job->dctx[thread],
+                                               job->data[thread],
+                                               (int32_t) (array->extchunknitems *
+                                                          array->itemsize)));
+
+    caterva_region_rows_t rows;
+    rows.array = array;
+    rows.tile = job->tile;
+    rows.start = job->src_start;
+    rows.stop = job->src_stop;
+    memcpy(rows.strides, job->strides, array->ndim * sizeof(int64_t));
+    caterva_chunk_rows(array, nchunk, job->data[thread], caterva_region_row, &rows);
+    return CATERVA_SUCCEED;
+}
+
+// Copy the items around a block from the tile into the input of the kernel, taking the items
+// outside the array from the boundary
+static void caterva_stencil_input(caterva_stencil_job_t *job, const int64_t *block_start,
+                                  const int32_t *block_shape, uint8_t *input) {
+    caterva_array_t *array = job->array;
+    const caterva_stencil_t *stencil = job->stencil;
+    int8_t ndim = array->ndim;
+    int8_t last = (int8_t) (ndim - 1);
+    uint8_t itemsize = array->itemsize;
+    bool constant = stencil->boundary == CATERVA_BOUNDARY_CONSTANT;
+    int64_t extent[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        extent[i] = block_shape[i] + 2 * (int64_t) stencil->halo[i];
+    }
+
+    // Every row along the last axis has items of the block, so only its ends can be outside
+    int64_t n = extent[last];
+    int64_t a = block_start[last] - stencil->halo[last];
+    int64_t left = a < 0 ? -a : 0;
+    int64_t right = a + n > array->shape[last] ? a + n - array->shape[last] : 0;
+    int64_t inner = n - left - right;
+    int64_t row_start = (a + left - job->src_start[last]) * job->strides[last];
+
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t row[CATERVA_MAX_DIM] = {0};
+    extent[last] = 1;
+    do {
+        int64_t offset = 0;
+        int64_t tile_offset = row_start;
+        bool outside = false;
+        for (int i = 0; i < last; ++i) {
+            int64_t c = block_start[i] - stencil->halo[i] + row[i];
+            if (c < 0 || c >= array->shape[i]) {
+                outside = true;
+                c = c < 0 ? 0 : array->shape[i] - 1;
+            }
+            offset += row[i] * job->input_strides[i];
+            tile_offset += (c - job->src_start[i]) * job->strides[i];
+        }
+        uint8_t *y = &input[offset * itemsize];
+        if (outside && constant) {
+            job->kernels->fill(stencil->value, n, y);
+            continue;
+        }
+        memcpy(&y[left * itemsize], &job->tile[tile_offset * itemsize], inner * itemsize);
+        if (constant) {
+            job->kernels->fill(stencil->value, left, y);
+            job->kernels->fill(stencil->value, right, &y[(left + inner) * itemsize]);
+        } else {
+            for (int64_t j = 0; j < left; ++j) {
+                memcpy(&y[j * itemsize], &y[left * itemsize], itemsize);
+            }
+            for (int64_t j = left + inner; j < n; ++j) {
+                memcpy(&y[j * itemsize], &y[(left + inner - 1) * itemsize], itemsize);
+            }
+        }
+    } while (caterva_selection_next(ndim, row, first, extent));
+}
+
+// Compute a chunk of the result from the tile, block by block, and compress it
+static int caterva_stencil_chunk(void *arg, int64_t task, int thread) {
+    caterva_stencil_job_t *job = (caterva_stencil_job_t *) arg;
+    caterva_array_t *result = job->result;
+    const caterva_stencil_t *stencil = job->stencil;
+    int8_t ndim = result->ndim;
+    int8_t last = (int8_t) (ndim - 1);
+    uint8_t itemsize = result->itemsize;
+    int64_t coords[CATERVA_MAX_DIM];
+    int64_t nchunk = caterva_range_nchunk(result, task, job->dest_first, job->dest_count, coords);
+    uint8_t *data = job->data[thread];
+    uint8_t *input = job->input[thread];
+    int32_t nbytes = (int32_t) (result->extchunknitems * itemsize);
+    // The padding is filled with zeros
+    memset(data, 0, nbytes);
+
+    int64_t nblocks = result->extchunknitems / result->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        caterva_stencil_params_t params;
+        int64_t chunk_coords[CATERVA_MAX_DIM];
+        caterva_block_coords(result, nchunk, nblock, chunk_coords, params.block_start,
+                             params.block_shape);
+        int64_t extent[CATERVA_MAX_DIM];
+        bool empty = false;
+        for (int i = 0; i < ndim; ++i) {
+            extent[i] = params.block_shape[i];
+            empty = empty || extent[i] == 0;
+        }
+        if (empty) {
+            continue;
+        }
+        caterva_stencil_input(job, params.block_start, params.block_shape, input);
+        uint8_t *block = &data[nblock * result->blocknitems * itemsize];
+
+        if (stencil->kernel != NULL) {
+            params.user_data = stencil->user_data;
+            params.ndim = ndim;
+            params.itemsize = itemsize;
+            memcpy(params.blockshape, result->blockshape, ndim * sizeof(int32_t));
+            memcpy(params.halo, stencil->halo, ndim * sizeof(int32_t));
+            params.input = input;
+            params.output = block;
+            params.tid = thread;
+            if (stencil->kernel(&params) != 0) {
+                CATERVA_TRACE_ERROR("The kernel of the stencil failed");
+                CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+            }
+            continue;
+        }
+        int64_t first[CATERVA_MAX_DIM] = {0};
+        int64_t row[CATERVA_MAX_DIM] = {0};
+        do {
+            int64_t offset = 0;
+            int64_t input_offset = 0;
+            for (int i = 0; i < last; ++i) {
+                offset += row[i] * result->item_block_strides[i];
+                input_offset += row[i] * job->input_strides[i];
+            }
+            job->row(&input[input_offset * itemsize], job->offsets, stencil->weights, job->ntaps,
+                     extent[last], &block[offset * itemsize]);
+        } while (caterva_selection_next(last, row, first, extent));
+    }
+
+    CATERVA_ERROR(caterva_compress_chunk_ctx(result, nchunk, job->cctx[thread], data, nbytes));
+    return CATERVA_SUCCEED;
+}
+
+// Compute a tile of chunks of the result: gather the array region with the halo and then compute
+// the chunks of the result
+static int caterva_stencil_tile(caterva_stencil_job_t *job, int nthreads) {
+    caterva_array_t *array = job->array;
+    caterva_array_t *result = job->result;
+    int8_t ndim = array->ndim;
+    int64_t src_nchunks = 1;
+    int64_t dest_nchunks = 1;
+    for (int i = 0; i < ndim; ++i) {
+        int64_t halo = job->stencil->halo[i];
+        job->src_start[i] = job->tile_start[i] - halo;
+        job->src_start[i] = job->src_start[i] < 0 ? 0 : job->src_start[i];
+        job->src_stop[i] = job->tile_stop[i] + halo;
+        job->src_stop[i] = job->src_stop[i] > array->shape[i] ? array->shape[i] : job->src_stop[i];
+        job->src_first[i] = job->src_start[i] / array->chunkshape[i];
+        job->src_count[i] = (job->src_stop[i] - 1) / array->chunkshape[i] + 1 - job->src_first[i];
+        job->dest_first[i] = job->tile_start[i] / result->chunkshape[i];
+        job->dest_count[i] = (job->tile_stop[i] - 1) / result->chunkshape[i] + 1 -
+                             job->dest_first[i];
+        src_nchunks *= job->src_count[i];
+        dest_nchunks *= job->dest_count[i];
+    }
+    job->strides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        job->strides[i] = job->strides[i + 1] * (job->src_stop[i + 1] - job->src_start[i + 1]);
+    }
+
+    CATERVA_ERROR(caterva_parallel_for(nthreads, src_nchunks, caterva_stencil_gather, job));
+    CATERVA_ERROR(caterva_parallel_for(nthreads, dest_nchunks, caterva_stencil_chunk, job));
+    return CATERVA_SUCCEED;
+}
+
+// Compute the result tile by tile; the tiles are boxes of chunks of the result whose items, with
+// the halo, fit in the memory budget
+static int caterva_stencil_tiles(caterva_stencil_job_t *job) {
+    caterva_ctx_t *ctx = job->ctx;
+    caterva_array_t *array = job->array;
+    caterva_array_t *result = job->result;
+    const int32_t *halo = job->stencil->halo;
+    int8_t ndim = result->ndim;
+
+    int64_t nchunks = result->extnitems / result->chunknitems;
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = (int) nchunks;
+    }
+    // The buffers of the threads are taken from the budget
+    int64_t chunk_nbytes = array->extchunknitems * array->itemsize;
+    if (result->extchunknitems * result->itemsize > chunk_nbytes) {
+        chunk_nbytes = result->extchunknitems * result->itemsize;
+    }
+    int64_t input_nbytes = result->itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        input_nbytes *= result->blockshape[i] + 2 * (int64_t) halo[i];
+    }
+    int64_t budget = ctx->cfg->memory_budget - nthreads * (chunk_nbytes + input_nbytes);
+
+    // Halve the largest side of the tile until it fits, down to a single chunk
+    int64_t grid[CATERVA_MAX_DIM];
+    int64_t count[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        grid[i] = result->extshape[i] / result->chunkshape[i];
+        count[i] = grid[i];
+    }
+    int64_t tile_nitems;
+    while (true) {
+        int64_t tile_nbytes = result->itemsize;
+        int largest = -1;
+        int64_t largest_size = 1;
+        for (int i = 0; i < ndim; ++i) {
+            int64_t size = count[i] * result->chunkshape[i];
+            size = size < result->shape[i] ? size : result->shape[i];
+            if (count[i] > 1 && size > largest_size) {
+                largest = i;
+                largest_size = size;
+            }
+            size += 2 * (int64_t) halo[i];
+            tile_nbytes *= size < result->shape[i] ? size : result->shape[i];
+        }
+        tile_nitems = tile_nbytes / result->itemsize;
+        if (ctx->cfg->memory_budget <= 0 || tile_nbytes <= budget || largest < 0) {
+            break;
+        }
+        count[largest] = (count[largest] + 1) / 2;
+    }
+
+    int rc = CATERVA_SUCCEED;
+    job->tile = ctx->cfg->alloc(tile_nitems * result->itemsize);
+    job->dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job->cctx = calloc(nthreads, sizeof(blosc2_context *));
+    job->data = calloc(nthreads, sizeof(uint8_t *));
+    job->input = calloc(nthreads, sizeof(uint8_t *));
+    if (job->tile == NULL || job->dctx == NULL || job->cctx == NULL || job->data == NULL ||
+        job->input == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job->dctx[t] = caterva_create_thread_dctx(array);
+        job->cctx[t] = caterva_create_thread_cctx(result, NULL, NULL);
+        job->data[t] = ctx->cfg->alloc(chunk_nbytes);
+        job->input[t] = ctx->cfg->alloc(input_nbytes);
+        if (job->dctx[t] == NULL || job->cctx[t] == NULL || job->data[t] == NULL ||
+            job->input[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t tile[CATERVA_MAX_DIM] = {0};
+    int64_t ntiles[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        ntiles[i] = (grid[i] + count[i] - 1) / count[i];
+    }
+    while (rc == CATERVA_SUCCEED) {
+        for (int i = 0; i < ndim; ++i) {
+            job->tile_start[i] = tile[i] * count[i] * result->chunkshape[i];
+            job->tile_stop[i] = (tile[i] + 1) * count[i] * result->chunkshape[i];
+            if (job->tile_stop[i] > result->shape[i]) {
+                job->tile_stop[i] = result->shape[i];
+            }
+        }
+        rc = caterva_stencil_tile(job, nthreads);
+        if (!caterva_selection_next(ndim, tile, first, ntiles)) {
+            break;
+        }
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job->dctx != NULL && job->dctx[t] != NULL) {
+            blosc2_free_ctx(job->dctx[t]);
+        }
+        if (job->cctx != NULL && job->cctx[t] != NULL) {
+            blosc2_free_ctx(job->cctx[t]);
+        }
+        if (job->data != NULL && job->data[t] != NULL) {
+            ctx->cfg->free(job->data[t]);
+        }
+        if (job->input != NULL && job->input[t] != NULL) {
+            ctx->cfg->free(job->input[t]);
+        }
+    }
+    if (job->tile != NULL) {
+        ctx->cfg->free(job->tile);
+    }
+    free(job->dctx);
+    free(job->cctx);
+    free(job->data);
+    free(job->input);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_stencil(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                    const caterva_stencil_t *stencil, caterva_storage_t *storage,
+                    caterva_array_t **result) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(stencil);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(result);
+
+    int8_t ndim = array->ndim;
+    if (ndim == 0) {
+        CATERVA_TRACE_ERROR("The array must have at least one dimension");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (stencil->boundary != CATERVA_BOUNDARY_CONSTANT &&
+        stencil->boundary != CATERVA_BOUNDARY_NEAREST) {
+        CATERVA_TRACE_ERROR("Unknown boundary of the stencil");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (stencil->kernel == NULL) {
+        CATERVA_ERROR_NULL(stencil->weights);
+    }
+
+    caterva_stencil_job_t job = {0};
+    job.ctx = ctx;
+    job.array = array;
+    job.stencil = stencil;
+    job.kernels = &caterva_expr_kernels[dtype];
+    job.row = caterva_stencil_rows[dtype];
+    caterva_params_t params = {0};
+    params.itemsize = array->itemsize;
+    params.ndim = ndim;
+    caterva_storage_t rstorage = *storage;
+    bool auto_shapes = true;
+    for (int i = 0; i < ndim; ++i) {
+        if (stencil->halo[i] < 0) {
+            CATERVA_TRACE_ERROR("The halo of the stencil can not be negative");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        params.shape[i] = array->shape[i];
+        auto_shapes = auto_shapes && rstorage.chunkshape[i] == 0;
+    }
+    for (int i = 0; i < ndim && auto_shapes; ++i) {
+        rstorage.chunkshape[i] = array->chunkshape[i];
+        rstorage.blockshape[i] = array->blockshape[i];
+    }
+    CATERVA_ERROR(caterva_empty(ctx, &params, &rstorage, &job.result));
+    if (job.result->nitems == 0) {
+        *result = job.result;
+        return CATERVA_SUCCEED;
+    }
+
+    // The offsets of the taps of the built-in kernel, in C order over 2 * halo + 1
+    caterva_array_t *res = job.result;
+    job.input_strides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        job.input_strides[i] = job.input_strides[i + 1] *
+                               (res->blockshape[i + 1] + 2 * (int64_t) stencil->halo[i + 1]);
+    }
+    int rc = CATERVA_SUCCEED;
+    if (stencil->kernel == NULL) {
+        int64_t taps[CATERVA_MAX_DIM];
+        job.ntaps = 1;
+        for (int i = 0; i < ndim; ++i) {
+            taps[i] = 2 * (int64_t) stencil->halo[i] + 1;
+            job.ntaps *= taps[i];
+        }
+        job.offsets = malloc(job.ntaps * sizeof(int64_t));
+        if (job.offsets == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+        int64_t first[CATERVA_MAX_DIM] = {0};
+        int64_t tap[CATERVA_MAX_DIM] = {0};
+        for (int64_t t = 0; t < job.ntaps && rc == CATERVA_SUCCEED; ++t) {
+            job.offsets[t] = 0;
+            for (int i = 0; i < ndim; ++i) {
+                job.offsets[t] += tap[i] * job.input_strides[i];
+            }
+            caterva_selection_next(ndim, tap, first, taps);
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_stencil_tiles(&job);
+    }
+    free(job.offsets);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.result);
+        CATERVA_ERROR(rc);
+    }
+    *result = job.result;
+    return CATERVA_SUCCEED;
+}
+
+
+// Matrix multiplication
+
+// C[m x n] += A[m x k] * B[k x n], where the rows of the matrices are separated by lda, ldb and
+// ldc items. Four rows of C are updated at once, so that every row of B is loaded once for them.
+#define CATERVA_MATMUL_KERNEL(name, type, utype)                                                 \
+static void caterva_matmul_kernel_##name(const uint8_t *a, int64_t lda, const uint8_t *b,       \
+                                         int64_t ldb, uint8_t *c, int64_t ldc, int64_t m,        \
+                                         int64_t n, int64_t k) {                                 \
+    const type *x = (const type *) a;                                                            \
+    const type *y = (const type *) b;                                                            \
+    type *z = (type *) c;                                                                        \
+    int64_t i = 0;                                                                               \
+    for (; i + 4 <= m; i += 4) {                                                                 \
+        type *z0 = &z[i * ldc];                                                                  \
+        type *z1 = z0 + ldc;                                                                     \
+        type *z2 = z1 + ldc;                                                                     \
+        type *z3 = z2 + ldc;                                                                     \
+        for (int64_t p = 0; p < k; ++p) {                                                        \
+            utype a0 = (utype) x[i * lda + p];                                                   \
+            utype a1 = (utype) x[(i + 1) * lda + p];                                             \
+            utype a2 = (utype) x[(i + 2) * lda + p];                                             \
+            utype a3 = (utype) x[(i + 3) * lda + p];                                             \
+            const type *yp = &y[p * ldb];                                                        \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                utype v = (utype) yp[j];                                                         \
+                z0[j] = (type) ((utype) z0[j] + a0 * v);                                         \
+                z1[j] = (type) ((utype) z1[j] + a1 * v);                                         \
+                z2[j] = (type) ((utype) z2[j] + a2 * v);                                         \
+                z3[j] = (type) ((utype) z3[j] + a3 * v);                                         \
+            }                                                                                    \
+        }                                                                                        \
+    }                                                                                            \
+    for (; i < m; ++i) {                                                                         \
+        type *z0 = &z[i * ldc];                                                                  \
+        for (int64_t p = 0; p < k; ++p) {                                                        \
+            utype a0 = (utype) x[i * lda + p];                                                   \
+            const type *yp = &y[p * ldb];                                                        \
+            for (int64_t j = 0; j < n; ++j) {                                                    \
+                z0[j] = (type) ((utype) z0[j] + a0 * (utype) yp[j]);                             \
+            }                                                                                    \
+        }                                                                                        \
+    }                                                                                            \
+}
+
+CATERVA_MATMUL_KERNEL(int8, int8_t, uint32_t)
+CATERVA_MATMUL_KERNEL(int16, int16_t, uint32_t)
+CATERVA_MATMUL_KERNEL(int32, int32_t, uint32_t)
+CATERVA_MATMUL_KERNEL(int64, int64_t, uint64_t)
+CATERVA_MATMUL_KERNEL(uint8, uint8_t, uint32_t)
+CATERVA_MATMUL_KERNEL(uint16, uint16_t, uint32_t)
+CATERVA_MATMUL_KERNEL(uint32, uint32_t, uint32_t)
+CATERVA_MATMUL_KERNEL(uint64, uint64_t, uint64_t)
+CATERVA_MATMUL_KERNEL(float32, float, float)
+CATERVA_MATMUL_KERNEL(float64, double, double)
+
+typedef void (*caterva_matmul_kernel_fn)(const uint8_t *a, int64_t lda, const uint8_t *b,
+                                         int64_t ldb, uint8_t *c, int64_t ldc, int64_t m,
+                                         int64_t n, int64_t k);
+
+// Indexed by caterva_dtype_t
+static const caterva_matmul_kernel_fn caterva_matmul_kernels[] = {
+    caterva_matmul_kernel_int8,
+    caterva_matmul_kernel_int16,
+    caterva_matmul_kernel_int32,
+    caterva_matmul_kernel_int64,
+    caterva_matmul_kernel_uint8,
+    caterva_matmul_kernel_uint16,
+    caterva_matmul_kernel_uint32,
+    caterva_matmul_kernel_uint64,
+    caterva_matmul_kernel_float32,
+    caterva_matmul_kernel_float64,
+};
+
+typedef struct {
+    caterva_array_t *a;
+    caterva_array_t *b;
+    caterva_array_t *result;
+    caterva_matmul_kernel_fn kernel;
+    // Resources of each thread
+    blosc2_context **adctx;
+    blosc2_context **bdctx;
+    blosc2_context **cctx;
+    uint8_t **data;
+    uint8_t **apanel;
+    uint8_t **bpanel;
+    uint8_t **acc;
+} caterva_matmul_job_t;
+
+// Decompress the chunks of a matrix that overlap a region and copy its items in C order
+static int caterva_matmul_panel(caterva_array_t *array, blosc2_context *dctx, uint8_t *data,
+                                int64_t *start, int64_t *stop, uint8_t *panel) {
+    int64_t first[2];
+    int64_t count[2];
+    for (int i = 0; i < 2; ++i) {
+        first[i] = start[i] / array->chunkshape[i];
+        count[i] = (stop[i] - 1) / array->chunkshape[i] + 1 - first[i];
+    }
+    caterva_region_rows_t rows;
+    rows.array = array;
+    rows.tile = panel;
+    rows.start = start;
+    rows.stop = stop;
+    rows.strides[0] = stop[1] - start[1];
+    rows.strides[1] = 1;
+    for (int64_t task = 0; task < count[0] * count[1]; ++task) {
+        int64_t coords[2];
+        int64_t nchunk = caterva_range_nchunk(array, task, first, count, coords);
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, dctx, data,
+                                                   (int32_t) (array->extchunknitems *
+                                                              array->itemsize)));
+        caterva_chunk_rows(array, nchunk, data, caterva_region_row, &rows);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Compute a chunk of the result panel by panel along the inner axis, and compress it
+static int caterva_matmul_chunk(void *arg, int64_t nchunk, int thread) {
+    caterva_matmul_job_t *job = (caterva_matmul_job_t *) arg;
+    caterva_array_t *a = job->a;
+    caterva_array_t *b = job->b;
+    caterva_array_t *result = job->result;
+    uint8_t itemsize = result->itemsize;
+    int64_t chunk_coords[CATERVA_MAX_DIM];
+    int64_t block_start[CATERVA_MAX_DIM];
+    int32_t block_shape[CATERVA_MAX_DIM];
+    caterva_block_coords(result, nchunk, 0, chunk_coords, block_start, block_shape);
+    int64_t start[2];
+    int64_t stop[2];
+    for (int i = 0; i < 2; ++i) {
+        start[i] = chunk_coords[i] * result->chunkshape[i];
+        stop[i] = start[i] + result->chunkshape[i];
+        stop[i] = stop[i] < result->shape[i] ? stop[i] : result->shape[i];
+    }
+    int64_t m = stop[0] - start[0];
+    int64_t n = stop[1] - start[1];
+    uint8_t *acc = job->acc[thread];
+    memset(acc, 0, m * n * itemsize);
+
+    // The panels along the inner axis are the chunks of a
+    int64_t k = a->shape[1];
+    for (int64_t k0 = 0; k0 < k;) {
+        int64_t k1 = (k0 / a->chunkshape[1] + 1) * a->chunkshape[1];
+        k1 = k1 < k ? k1 : k;
+        int64_t astart[2] = {start[0], k0};
+        int64_t astop[2] = {stop[0], k1};
+        int64_t bstart[2] = {k0, start[1]};
+        int64_t bstop[2] = {k1, stop[1]};
+        CATERVA_ERROR(caterva_matmul_panel(a, job->adctx[thread], job->data[thread], astart,
+                                           astop, job->apanel[thread]));
+        CATERVA_ERROR(caterva_matmul_panel(b, job->bdctx[thread], job->data[thread], bstart,
+                                           bstop, job->bpanel[thread]));
+        job->kernel(job->apanel[thread], k1 - k0, job->bpanel[thread], n, acc, n, m, n, k1 - k0);
+        k0 = k1;
+    }
+
+    // Copy the rows of the blocks; the padding is filled with zeros
+    uint8_t *data = job->data[thread];
+    int32_t nbytes = (int32_t) (result->extchunknitems * itemsize);
+    memset(data, 0, nbytes);
+    int64_t nblocks = result->extchunknitems / result->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        caterva_block_coords(result, nchunk, nblock, chunk_coords, block_start, block_shape);
+        uint8_t *block = &data[nblock * result->blocknitems * itemsize];
+        for (int32_t r = 0; r < block_shape[0] && block_shape[1] > 0; ++r) {
+            int64_t offset = (block_start[0] - start[0] + r) * n + block_start[1] - start[1];
+            memcpy(&block[r * result->item_block_strides[0] * itemsize], &acc[offset * itemsize],
+                   block_shape[1] * itemsize);
+        }
+    }
+    CATERVA_ERROR(caterva_compress_chunk_ctx(result, nchunk, job->cctx[thread], data, nbytes));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_matmul(caterva_ctx_t *ctx, caterva_array_t *a, caterva_array_t *b,
+                   caterva_dtype_t dtype, caterva_storage_t *storage, caterva_array_t **result) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(a);
+    CATERVA_ERROR_NULL(b);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(result);
+
+    if (a->ndim != 2 || b->ndim != 2 || a->shape[1] != b->shape[0]) {
+        CATERVA_TRACE_ERROR("The shapes of the matrices do not match");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != a->itemsize || b->itemsize != a->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the matrices");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = a->itemsize;
+    params.ndim = 2;
+    params.shape[0] = a->shape[0];
+    params.shape[1] = b->shape[1];
+    caterva_storage_t rstorage = *storage;
+    if (rstorage.chunkshape[0] == 0 && rstorage.chunkshape[1] == 0) {
+        rstorage.chunkshape[0] = a->chunkshape[0];
+        rstorage.chunkshape[1] = b->chunkshape[1];
+        rstorage.blockshape[0] = a->blockshape[0];
+        rstorage.blockshape[1] = b->blockshape[1];
+    }
+    caterva_matmul_job_t job = {0};
+    job.a = a;
+    job.b = b;
+    job.kernel = caterva_matmul_kernels[dtype];
+    CATERVA_ERROR(caterva_empty(ctx, &params, &rstorage, &job.result));
+    caterva_array_t *res = job.result;
+    if (res->nitems == 0) {
+        *result = res;
+        return CATERVA_SUCCEED;
+    }
+
+    int64_t nchunks = res->extnitems / res->chunknitems;
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = (int) nchunks;
+    }
+    int64_t chunk_nbytes = res->extchunknitems * res->itemsize;
+    if (a->extchunknitems * a->itemsize > chunk_nbytes) {
+        chunk_nbytes = a->extchunknitems * a->itemsize;
+    }
+    if (b->extchunknitems * b->itemsize > chunk_nbytes) {
+        chunk_nbytes = b->extchunknitems * b->itemsize;
+    }
+    int64_t panel = a->chunkshape[1] < a->shape[1] ? a->chunkshape[1] : a->shape[1];
+    int rc = CATERVA_SUCCEED;
+    job.adctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.bdctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.cctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.data = calloc(nthreads, sizeof(uint8_t *));
+    job.apanel = calloc(nthreads, sizeof(uint8_t *));
+    job.bpanel = calloc(nthreads, sizeof(uint8_t *));
+    job.acc = calloc(nthreads, sizeof(uint8_t *));
+    if (job.adctx == NULL || job.bdctx == NULL || job.cctx == NULL || job.data == NULL ||
+        job.apanel == NULL || job.bpanel == NULL || job.acc == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.adctx[t] = caterva_create_thread_dctx(a);
+        job.bdctx[t] = caterva_create_thread_dctx(b);
+        job.cctx[t] = caterva_create_thread_cctx(res, NULL, NULL);
+        job.data[t] = ctx->cfg->alloc(chunk_nbytes);
+        // The empty panels of an inner axis of length 0 are never used
+        job.apanel[t] = ctx->cfg->alloc(res->chunkshape[0] * (panel + 1) * res->itemsize);
+        job.bpanel[t] = ctx->cfg->alloc((panel + 1) * res->chunkshape[1] * res->itemsize);
+        job.acc[t] = ctx->cfg->alloc(res->chunknitems * res->itemsize);
+        if (job.adctx[t] == NULL || job.bdctx[t] == NULL || job.cctx[t] == NULL ||
+            job.data[t] == NULL || job.apanel[t] == NULL || job.bpanel[t] == NULL ||
+            job.acc[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, nchunks, caterva_matmul_chunk, &job);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job.adctx != NULL && job.adctx[t] != NULL) {
+            blosc2_free_ctx(job.adctx[t]);
+        }
+        if (job.bdctx != NULL && job.bdctx[t] != NULL) {
+            blosc2_free_ctx(job.bdctx[t]);
+        }
+        if (job.cctx != NULL && job.cctx[t] != NULL) {
+            blosc2_free_ctx(job.cctx[t]);
+        }
+        uint8_t **buffers[] = {job.data, job.apanel, job.bpanel, job.acc};
+        for (int j = 0; j < 4; ++j) {
+            if (buffers[j] != NULL && buffers[j][t] != NULL) {
+                ctx->cfg->free(buffers[j][t]);
+            }
+        }
+    }
+    free(job.adctx);
+    free(job.bdctx);
+    free(job.cctx);
+    free(job.data);
+    free(job.apanel);
+    free(job.bpanel);
+    free(job.acc);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.result);
+        CATERVA_ERROR(rc);
+    }
+    *result = job.result;
+    return CATERVA_SUCCEED;
+}
+
+
+// Scans
+
+// Scan n items of a row along the axis, starting from the carried item
+#define CATERVA_SCAN_KERNELS(name, type, utype)                                                  \
+static void caterva_scan_row_##name(caterva_scan_op_t op, uint8_t *src, int64_t n,              \
+                                    uint8_t *carry) {                                            \
+    type *x = (type *) src;                                                                      \
+    utype c = (utype) *(type *) carry;                                                           \
+    if (op == CATERVA_SCAN_SUM) {                                                                \
+        for (int64_t j = 0; j < n; ++j) {                                                        \
+            c = (utype) (type) (c + (utype) x[j]);                                               \
+            x[j] = (type) c;                                                                     \
+        }                                                                                        \
+    } else {                                                                                     \
+        for (int64_t j = 0; j < n; ++j) {                                                        \
+            c = (utype) (type) (c * (utype) x[j]);                                               \
+            x[j] = (type) c;                                                                     \
+        }                                                                                        \
+    }                                                                                            \
+    *(type *) carry = (type) c;                                                                  \
+}                                                                                                \
+                                                                                                 \
+/* Scan n items of different rows of the axis, each one starting from its carried item */      \
+static void caterva_scan_items_##name(caterva_scan_op_t op, uint8_t *src, int64_t n,            \
+                                      uint8_t *carry) {                                          \
+    type *x = (type *) src;                                                                      \
+    type *c = (type *) carry;                                                                    \
+    if (op == CATERVA_SCAN_SUM) {                                                                \
+        for (int64_t j = 0; j < n; ++j) {                                                        \
+            x[j] = (type) ((utype) c[j] + (utype) x[j]);                                         \
+            c[j] = x[j];                                                                         \
+        }                                                                                        \
+    } else {                                                                                     \
+        for (int64_t j = 0; j < n; ++j) {                                                        \
+            x[j] = (type) ((utype) c[j] * (utype) x[j]);                                         \
+            c[j] = x[j];                                                                         \
+        }                                                                                        \
+    }                                                                                            \
+}                                                                                                \
+                                                                                                 \
+static void caterva_scan_init_##name(caterva_scan_op_t op, int64_t n, uint8_t *carry) {         \
+    type *c = (type *) carry;                                                                    \
+    for (int64_t j = 0; j < n; ++j) {                                                            \
+        c[j] = op == CATERVA_SCAN_SUM ? (type) 0 : (type) 1;                                     \
+    }                                                                                            \
+}
+
+CATERVA_SCAN_KERNELS(int8, int8_t, uint32_t)
+CATERVA_SCAN_KERNELS(int16, int16_t, uint32_t)
+CATERVA_SCAN_KERNELS(int32, int32_t, uint32_t)
+CATERVA_SCAN_KERNELS(int64, int64_t, uint64_t)
+CATERVA_SCAN_KERNELS(uint8, uint8_t, uint32_t)
+CATERVA_SCAN_KERNELS(uint16, uint16_t, uint32_t)
+CATERVA_SCAN_KERNELS(uint32, uint32_t, uint32_t)
+CATERVA_SCAN_KERNELS(uint64, uint64_t, uint64_t)
+CATERVA_SCAN_KERNELS(float32, float, float)
+CATERVA_SCAN_KERNELS(float64, double, double)
+
+typedef struct {
+    void (*row)(caterva_scan_op_t op, uint8_t *src, int64_t n, uint8_t *carry);
+    void (*items)(caterva_scan_op_t op, uint8_t *src, int64_t n, uint8_t *carry);
+    void (*init)(caterva_scan_op_t op, int64_t n, uint8_t *carry);
+} caterva_scan_kernels_t;
+
+#define CATERVA_SCAN_KERNELS_ENTRY(name)                                                         \
+    {caterva_scan_row_##name, caterva_scan_items_##name, caterva_scan_init_##name}
+
+// Indexed by caterva_dtype_t
+static const caterva_scan_kernels_t caterva_scan_kernels[] = {
+    CATERVA_SCAN_KERNELS_ENTRY(int8),
+    CATERVA_SCAN_KERNELS_ENTRY(int16),
+    CATERVA_SCAN_KERNELS_ENTRY(int32),
+    CATERVA_SCAN_KERNELS_ENTRY(int64),
+    CATERVA_SCAN_KERNELS_ENTRY(uint8),
+    CATERVA_SCAN_KERNELS_ENTRY(uint16),
+    CATERVA_SCAN_KERNELS_ENTRY(uint32),
+    CATERVA_SCAN_KERNELS_ENTRY(uint64),
+    CATERVA_SCAN_KERNELS_ENTRY(float32),
+    CATERVA_SCAN_KERNELS_ENTRY(float64),
+};
+
+typedef struct {
+    caterva_array_t *array;
+    caterva_array_t *result;
+    const caterva_scan_kernels_t *kernels;
+    caterva_scan_op_t op;
+    int8_t axis;
+    int64_t carry_strides[CATERVA_MAX_DIM];
+    //!< The strides of the carried items over the chunkshape, 0 along the axis.
+    int64_t carry_nitems;
+    // Resources of each thread
+    blosc2_context **dctx;
+    blosc2_context **cctx;
+    uint8_t **data;
+    uint8_t **carry;
+} caterva_scan_job_t;
+
+// Scan the valid items of a decompressed chunk in place, block by block. The blocks and their
+// rows are visited in C order, so the items of every row of the axis are visited in order.
+static void caterva_scan_chunk(caterva_scan_job_t *job, int64_t nchunk, uint8_t *data,
+                               uint8_t *carry) {
+    caterva_array_t *array = job->array;
+    int8_t ndim = array->ndim;
+    int8_t last = (int8_t) (ndim - 1);
+    uint8_t itemsize = array->itemsize;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+        int64_t chunk_coords[CATERVA_MAX_DIM];
+        int64_t block_start[CATERVA_MAX_DIM];
+        int32_t block_shape[CATERVA_MAX_DIM];
+        caterva_block_coords(array, nchunk, nblock, chunk_coords, block_start, block_shape);
+        int64_t extent[CATERVA_MAX_DIM];
+        bool empty = false;
+        for (int i = 0; i < ndim; ++i) {
+            extent[i] = block_shape[i];
+            empty = empty || extent[i] == 0;
+        }
+        if (empty) {
+            continue;
+        }
+        uint8_t *block = &data[nblock * array->blocknitems * itemsize];
+        int64_t n = extent[last];
+        extent[last] = 1;
+        int64_t first[CATERVA_MAX_DIM] = {0};
+        int64_t row[CATERVA_MAX_DIM] = {0};
+        do {
+            int64_t offset = 0;
+            int64_t carry_offset = 0;
+            for (int i = 0; i < ndim; ++i) {
+                offset += row[i] * array->item_block_strides[i];
+                int64_t coord = block_start[i] - chunk_coords[i] * array->chunkshape[i] + row[i];
+                carry_offset += coord * job->carry_strides[i];
+            }
+            uint8_t *x = &block[offset * itemsize];
+            if (job->axis == last) {
+                job->kernels->row(job->op, x, n, &carry[carry_offset * itemsize]);
+            } else {
+                job->kernels->items(job->op, x, n, &carry[carry_offset * itemsize]);
+            }
+        } while (caterva_selection_next(ndim, row, first, extent));
+    }
+}
+
+// Scan the column of chunks along the axis, carrying the items from one chunk to the next
+static int caterva_scan_task(void *arg, int64_t column, int thread) {
+    caterva_scan_job_t *job = (caterva_scan_job_t *) arg;
+    caterva_array_t *array = job->array;
+    int8_t ndim = array->ndim;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    int64_t coords[CATERVA_MAX_DIM];
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t nchunks_i = array->extshape[i] / array->chunkshape[i];
+        if (i != job->axis) {
+            coords[i] = column % nchunks_i;
+            column /= nchunks_i;
+        }
+    }
+    uint8_t *carry = job->carry[thread];
+    job->kernels->init(job->op, job->carry_nitems, carry);
+
+    int64_t nchunks_axis = array->extshape[job->axis] / array->chunkshape[job->axis];
+    for (coords[job->axis] = 0; coords[job->axis] < nchunks_axis; ++coords[job->axis]) {
+        int64_t nchunk = 0;
+        for (int i = 0; i < ndim; ++i) {
+            nchunk = nchunk * (array->extshape[i] / array->chunkshape[i]) + coords[i];
+        }
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, job->dctx[thread],
+                                                   job->data[thread], nbytes));
+        caterva_scan_chunk(job, nchunk, job->data[thread], carry);
+        CATERVA_ERROR(caterva_compress_chunk_ctx(job->result, nchunk, job->cctx[thread],
+                                                 job->data[thread], nbytes));
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_scan(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                 caterva_scan_op_t op, int8_t axis, caterva_storage_t *storage,
+                 caterva_array_t **result) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(result);
+
+    int8_t ndim = array->ndim;
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (op != CATERVA_SCAN_SUM && op != CATERVA_SCAN_PROD) {
+        CATERVA_TRACE_ERROR("Unknown cumulative operation");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (axis < 0 || axis >= ndim) {
+        CATERVA_TRACE_ERROR("The axis is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = array->itemsize;
+    params.ndim = ndim;
+    caterva_storage_t rstorage = *storage;
+    bool auto_shapes = true;
+    bool same_shapes = true;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = array->shape[i];
+        auto_shapes = auto_shapes && rstorage.chunkshape[i] == 0;
+        same_shapes = same_shapes && rstorage.chunkshape[i] == array->chunkshape[i] &&
+                      rstorage.blockshape[i] == array->blockshape[i];
+    }
+    if (!auto_shapes && !same_shapes) {
+        CATERVA_TRACE_ERROR("The result must have the chunkshape and blockshape of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int i = 0; i < ndim; ++i) {
+        rstorage.chunkshape[i] = array->chunkshape[i];
+        rstorage.blockshape[i] = array->blockshape[i];
+    }
+    caterva_scan_job_t job = {0};
+    job.array = array;
+    job.kernels = &caterva_scan_kernels[dtype];
+    job.op = op;
+    job.axis = axis;
+    CATERVA_ERROR(caterva_empty(ctx, &params, &rstorage, &job.result));
+    if (job.result->nitems == 0) {
+        *result = job.result;
+        return CATERVA_SUCCEED;
+    }
+
+    // The carried items are the ones of a chunk without the axis
+    job.carry_nitems = 1;
+    for (int i = ndim - 1; i >= 0; --i) {
+        job.carry_strides[i] = i == axis ? 0 : job.carry_nitems;
+        job.carry_nitems *= i == axis ? 1 : array->chunkshape[i];
+    }
+    int64_t ncolumns = (array->extnitems / array->chunknitems) /
+                       (array->extshape[axis] / array->chunkshape[axis]);
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > ncolumns) {
+        nthreads = (int) ncolumns;
+    }
+    int rc = CATERVA_SUCCEED;
+    job.dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.cctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.data = calloc(nthreads, sizeof(uint8_t *));
+    job.carry = calloc(nthreads, sizeof(uint8_t *));
+    if (job.dctx == NULL || job.cctx == NULL || job.data == NULL || job.carry == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.dctx[t] = caterva_create_thread_dctx(array);
+        job.cctx[t] = caterva_create_thread_cctx(job.result, NULL, NULL);
+        job.data[t] = ctx->cfg->alloc(array->extchunknitems * array->itemsize);
+        job.carry[t] = ctx->cfg->alloc(job.carry_nitems * array->itemsize);
+        if (job.dctx[t] == NULL || job.cctx[t] == NULL || job.data[t] == NULL ||
+            job.carry[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, ncolumns, caterva_scan_task, &job);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job.dctx != NULL && job.dctx[t] != NULL) {
+            blosc2_free_ctx(job.dctx[t]);
+        }
+        if (job.cctx != NULL && job.cctx[t] != NULL) {
+            blosc2_free_ctx(job.cctx[t]);
+        }
+        if (job.data != NULL && job.data[t] != NULL) {
+            ctx->cfg->free(job.data[t]);
+        }
+        if (job.carry != NULL && job.carry[t] != NULL) {
+            ctx->cfg->free(job.carry[t]);
+        }
+    }
+    free(job.dctx);
+    free(job.cctx);
+    free(job.data);
+    free(job.carry);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.result);
+        CATERVA_ERROR(rc);
+    }
+    *result = job.result;
+    return CATERVA_SUCCEED;
+}
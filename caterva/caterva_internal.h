@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+/*
+ * The interface between the core array code (caterva.c) and the engines built on top of it: the
+ * reductions and the array expressions (caterva_compute.c), the statistics, the predicates and the
+ * overviews (caterva_query.c), and the joins and the virtual arrays (caterva_virtual.c).
+ */
+
+#ifndef CATERVA_CATERVA_INTERNAL_H_
+#define CATERVA_CATERVA_INTERNAL_H_
+
+#include <caterva.h>
+#include "caterva_utils.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// Chunk access (caterva.c)
+
+/**
+ * @brief Compute the coordinates of a block: the ones of its chunk in the grid of chunks, the
+ * ones of its first item in the array and the shape of its items inside the array.
+ */
+void caterva_block_coords(caterva_array_t *array, int64_t nchunk, int64_t nblock,
+                          int64_t *chunk_coords, int64_t *block_start, int32_t *block_shape);
+
+/**
+ * @brief Get a chunk of the super-chunk under the lock of its chunks.
+ */
+int caterva_get_chunk_locked(caterva_array_t *array, int64_t nchunk, uint8_t **chunk,
+                             bool *needs_free);
+
+/**
+ * @brief Take a decompression context for a read of the array from its pool. It must be given
+ * back with @ref caterva_release_dctx, along with the return code of the read.
+ */
+blosc2_context *caterva_acquire_dctx(caterva_array_t *array);
+
+void caterva_release_dctx(caterva_array_t *array, blosc2_context *dctx, int rc);
+
+/**
+ * @brief Create a decompression context for a thread that decompresses whole chunks by itself.
+ */
+blosc2_context *caterva_create_thread_dctx(caterva_array_t *array);
+
+/**
+ * @brief Decompress a chunk with a context owned by the calling thread.
+ */
+int caterva_decompress_chunk_ctx(caterva_array_t *array, int64_t nchunk, blosc2_context *dctx,
+                                 uint8_t *data, int32_t nbytes);
+
+/**
+ * @brief Create a compression context for a thread that compresses whole chunks by itself. When
+ * @p prefilter is not NULL, it produces the blocks of every chunk compressed by the context.
+ */
+blosc2_context *caterva_create_thread_cctx(caterva_array_t *array, blosc2_prefilter_fn prefilter,
+                                           void *user_data);
+
+/**
+ * @brief Compress a chunk with a context owned by the calling thread and replace it in the array.
+ */
+int caterva_compress_chunk_ctx(caterva_array_t *array, int64_t nchunk, blosc2_context *cctx,
+                               const uint8_t *data, int32_t nbytes);
+
+/**
+ * @brief The number of chunks in each row of chunks along the first axis.
+ */
+int64_t ring_chunks_per_row(caterva_array_t *array);
+
+/**
+ * @brief The uncompressed data of a chunk kept by the buffered append mode, or NULL if the chunk
+ * is only in the super-chunk.
+ */
+uint8_t *append_buffer_chunk(caterva_array_t *array, int64_t nchunk);
+
+bool append_buffer_pending(caterva_array_t *array);
+
+int append_buffer_flush(caterva_array_t *array);
+
+/**
+ * @brief Get a slice, applying the postfilter of the context when @p postfilter is true.
+ */
+int caterva_get_slice_buffer_filtered(caterva_ctx_t *ctx, caterva_array_t *array,
+                                      int64_t *start, int64_t *stop, void *buffer,
+                                      int64_t *buffershape, int64_t buffersize, bool postfilter);
+
+/**
+ * @brief Check a selector and compute the number of items it selects.
+ */
+int caterva_selector_nitems(int64_t len, const caterva_selector_t *selector, int64_t *nitems);
+
+/**
+ * @brief Advance an n-dimensional counter over [first, last); returns false once it wraps around.
+ */
+static inline bool caterva_selection_next(int8_t ndim, int64_t *counter, const int64_t *first,
+                                          const int64_t *last) {
+    for (int i = ndim - 1; i >= 0; --i) {
+        if (++counter[i] < last[i]) {
+            return true;
+        }
+        counter[i] = first[i];
+    }
+    return false;
+}
+
+
+// Rows and kernels (caterva_compute.c)
+
+/**
+ * @brief Called for every row of valid items along the last axis; @p coords are the coordinates
+ * of the first item of the row in the array.
+ */
+typedef void (*caterva_row_fn)(void *arg, const uint8_t *row, int64_t n, const int64_t *coords);
+
+/**
+ * @brief Visit the rows of valid items (i.e. not in the padding) of a decompressed chunk, block
+ * by block.
+ */
+void caterva_chunk_rows(caterva_array_t *array, int64_t nchunk, const uint8_t *data,
+                        caterva_row_fn fn, void *arg);
+
+/**
+ * @brief The buffer filled by @ref caterva_region_row.
+ */
+typedef struct {
+    caterva_array_t *array;
+    uint8_t *tile;
+    const int64_t *start;
+    const int64_t *stop;
+    int64_t strides[CATERVA_MAX_DIM];
+    //!< The strides of the buffer, in items.
+} caterva_region_rows_t;
+
+/**
+ * @brief Copy the rows of a chunk that are inside a region of the array into a buffer with the
+ * items of the region in C order.
+ */
+void caterva_region_row(void *arg, const uint8_t *row, int64_t n, const int64_t *coords);
+
+typedef enum {
+    CATERVA_KIND_SIGNED,
+    CATERVA_KIND_UNSIGNED,
+    CATERVA_KIND_FLOAT,
+} caterva_kind_t;
+
+/**
+ * @brief The partial result of a reduction.
+ */
+typedef struct caterva_reduce_acc_s caterva_reduce_acc_t;
+
+/**
+ * @brief The kernels of a type of items.
+ */
+typedef struct {
+    uint8_t itemsize;
+    caterva_kind_t kind;
+    void (*row)(const uint8_t *src, int64_t n, int64_t arg, caterva_reduce_op_t op,
+                caterva_reduce_acc_t *acc);
+    void (*items)(const uint8_t *src, int64_t n, int64_t arg, caterva_reduce_op_t op,
+                  caterva_reduce_acc_t *acc);
+    void (*store)(const caterva_reduce_acc_t *acc, uint8_t *dest);
+    void (*stats)(const uint8_t *src, int64_t n, caterva_stats_t *stats);
+    void (*compare)(const uint8_t *src, int64_t n, const caterva_predicate_t *predicate,
+                    uint8_t *out);
+} caterva_reduce_kernels_t;
+
+/**
+ * @brief The kernels of every type, indexed by caterva_dtype_t.
+ */
+extern const caterva_reduce_kernels_t caterva_reduce_kernels[];
+
+
+// Statistics and overviews (caterva_query.c)
+
+/**
+ * @brief Compute the statistics of a chunk and its blocks out of its uncompressed data. The
+ * chunks can be computed concurrently, as long as the layout of the statistics does not change.
+ */
+void caterva_stats_compute(caterva_array_t *array, int64_t nchunk, const uint8_t *data);
+
+void caterva_stats_update(caterva_array_t *array, int64_t nchunk, const uint8_t *data);
+
+/**
+ * @brief Follow a change of the shape of the array.
+ */
+int caterva_stats_reshape(caterva_array_t *array, int8_t old_ndim, const int64_t *old_shape,
+                          const int32_t *old_chunkshape, const int32_t *old_blockshape);
+
+/**
+ * @brief Mark the statistics of the chunks from @p nchunk on as out of date.
+ */
+void caterva_stats_invalidate(caterva_array_t *array, int64_t nchunk);
+
+/**
+ * @brief Drop the statistics of the first chunks, moving the rest to the front.
+ */
+void caterva_stats_shift(caterva_array_t *array, int64_t nchunks);
+
+int caterva_stats_store(caterva_array_t *array);
+
+int caterva_stats_load(caterva_array_t *array);
+
+void caterva_stats_free(caterva_array_t *array);
+
+/**
+ * @brief Mark the overviews to be rebuilt the next time they are got.
+ */
+int caterva_overviews_invalidate(caterva_array_t *array);
+
+/**
+ * @brief Update the overviews after a change of the items of the region [start, stop).
+ */
+int caterva_overviews_update(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *start,
+                             const int64_t *stop);
+
+int caterva_overviews_copy(caterva_array_t *src, caterva_array_t *dest);
+
+int caterva_overviews_load(caterva_array_t *array);
+
+void caterva_overviews_free(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Read the number of levels of the overviews stored in a super-chunk (0 if there are none).
+ */
+int caterva_overviews_read(blosc2_schunk *sc, struct caterva_overviews_s *overviews);
+
+/**
+ * @brief Remove the overviews stored next to an array stored in @p urlpath.
+ */
+void caterva_overviews_remove(const char *urlpath, int nlevels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CATERVA_CATERVA_INTERNAL_H_
@@ -0,0 +1,1610 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_internal.h"
+#include "blosc2.h"
+#include <math.h>
+
+
+// Statistics
+
+typedef struct {
+    caterva_array_t *array;
+    const caterva_reduce_kernels_t *kernels;
+    caterva_stats_t *blocks;
+    //!< The statistics of the blocks of the chunk.
+} caterva_stats_rows_t;
+
+static void caterva_stats_row(void *arg, const uint8_t *row, int64_t n, const int64_t *coords) {
+    caterva_stats_rows_t *rows = (caterva_stats_rows_t *) arg;
+    caterva_array_t *array = rows->array;
+    int64_t nblock = 0;
+    for (int i = 0; i < array->ndim; ++i) {
+        nblock += coords[i] % array->chunkshape[i] / array->blockshape[i] *
+                  array->block_chunk_strides[i];
+    }
+    rows->kernels->stats(row, n, &rows->blocks[nblock]);
+}
+
+// Merge the statistics of b into a
+static void caterva_stats_merge(caterva_kind_t kind, caterva_stats_t *a, const caterva_stats_t *b) {
+    if (b->nitems > b->nnans) {
+        if (a->nitems == a->nnans) {
+            a->min = b->min;
+            a->max = b->max;
+        } else {
+            switch (kind) {
+                case CATERVA_KIND_SIGNED:
+                    a->min.i = b->min.i < a->min.i ? b->min.i : a->min.i;
+                    a->max.i = b->max.i > a->max.i ? b->max.i : a->max.i;
+                    break;
+                case CATERVA_KIND_UNSIGNED:
+                    a->min.u = b->min.u < a->min.u ? b->min.u : a->min.u;
+                    a->max.u = b->max.u > a->max.u ? b->max.u : a->max.u;
+                    break;
+                default:
+                    a->min.f = b->min.f < a->min.f ? b->min.f : a->min.f;
+                    a->max.f = b->max.f > a->max.f ? b->max.f : a->max.f;
+                    break;
+            }
+        }
+    }
+    a->nitems += b->nitems;
+    a->nnans += b->nnans;
+}
+
+// Compute the statistics of a chunk and its blocks out of its uncompressed data. The chunks can
+// be computed concurrently, as long as the layout of the statistics does not change.
+void caterva_stats_compute(caterva_array_t *array, int64_t nchunk, const uint8_t *data) {
+    struct caterva_stats_s *stats = array->stats;
+    if (stats == NULL || nchunk >= stats->nchunks) {
+        return;
+    }
+    const caterva_reduce_kernels_t *kernels = &caterva_reduce_kernels[stats->dtype];
+    caterva_stats_rows_t rows = {array, kernels, &stats->blocks[nchunk * stats->nblocks]};
+    memset(rows.blocks, 0, stats->nblocks * sizeof(caterva_stats_t));
+    caterva_chunk_rows(array, nchunk, data, caterva_stats_row, &rows);
+
+    caterva_stats_t chunk = {0};
+    for (int64_t nblock = 0; nblock < stats->nblocks; ++nblock) {
+        caterva_stats_merge(kernels->kind, &chunk, &rows.blocks[nblock]);
+    }
+    stats->chunks[nchunk] = chunk;
+    stats->valid[nchunk] = true;
+}
+
+void caterva_stats_update(caterva_array_t *array, int64_t nchunk, const uint8_t *data) {
+    if (array->stats == NULL) {
+        return;
+    }
+    caterva_stats_compute(array, nchunk, data);
+    array->stats->dirty = true;
+}
+
+// Mark the statistics of the chunks from nchunk on as out of date
+void caterva_stats_invalidate(caterva_array_t *array, int64_t nchunk) {
+    struct caterva_stats_s *stats = array->stats;
+    if (stats == NULL) {
+        return;
+    }
+    for (int64_t i = nchunk < 0 ? 0 : nchunk; i < stats->nchunks; ++i) {
+        stats->valid[i] = false;
+    }
+    stats->dirty = true;
+}
+
+// Drop the statistics of the first chunks, moving the rest to the front
+void caterva_stats_shift(caterva_array_t *array, int64_t nchunks) {
+    struct caterva_stats_s *stats = array->stats;
+    if (stats == NULL) {
+        return;
+    }
+    if (nchunks > stats->nchunks) {
+        nchunks = stats->nchunks;
+    }
+    int64_t nkept = stats->nchunks - nchunks;
+    memmove(stats->valid, &stats->valid[nchunks], nkept * sizeof(bool));
+    memmove(stats->chunks, &stats->chunks[nchunks], nkept * sizeof(caterva_stats_t));
+    memmove(stats->blocks, &stats->blocks[nchunks * stats->nblocks],
+            nkept * stats->nblocks * sizeof(caterva_stats_t));
+    caterva_stats_invalidate(array, nkept);
+}
+
+// Make room for the statistics of nchunks chunks of nblocks blocks, keeping the first nkept ones
+static int caterva_stats_layout(caterva_array_t *array, struct caterva_stats_s *stats,
+                                int64_t nchunks, int64_t nblocks, int64_t nkept) {
+    // One more entry, so that empty arrays get valid pointers too
+    bool *valid = array->cfg->alloc((nchunks + 1) * sizeof(bool));
+    caterva_stats_t *chunks = array->cfg->alloc((nchunks + 1) * sizeof(caterva_stats_t));
+    caterva_stats_t *blocks = array->cfg->alloc((nchunks * nblocks + 1) * sizeof(caterva_stats_t));
+    if (valid == NULL || chunks == NULL || blocks == NULL) {
+        CATERVA_TRACE_ERROR("Can not allocate the statistics");
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    if (nkept > 0) {
+        memcpy(valid, stats->valid, nkept * sizeof(bool));
+        memcpy(chunks, stats->chunks, nkept * sizeof(caterva_stats_t));
+        memcpy(blocks, stats->blocks, nkept * nblocks * sizeof(caterva_stats_t));
+    }
+    for (int64_t i = nkept; i < nchunks; ++i) {
+        valid[i] = false;
+    }
+    if (stats->valid != NULL) {
+        array->cfg->free(stats->valid);
+        array->cfg->free(stats->chunks);
+        array->cfg->free(stats->blocks);
+    }
+    stats->valid = valid;
+    stats->chunks = chunks;
+    stats->blocks = blocks;
+    stats->nchunks = nchunks;
+    stats->nblocks = nblocks;
+    return CATERVA_SUCCEED;
+}
+
+// Follow a change of the shape of the array. The statistics of a chunk are kept if the layout of
+// the chunks only changes along the first axis and the chunk keeps its items.
+int caterva_stats_reshape(caterva_array_t *array, int8_t old_ndim,
+                          const int64_t *old_shape, const int32_t *old_chunkshape,
+                          const int32_t *old_blockshape) {
+    struct caterva_stats_s *stats = array->stats;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+
+    bool same = old_ndim == array->ndim && nblocks == stats->nblocks;
+    for (int i = 0; i < array->ndim && same; ++i) {
+        same = old_chunkshape[i] == array->chunkshape[i] &&
+               old_blockshape[i] == array->blockshape[i] &&
+               (i == 0 || old_shape[i] == array->shape[i]);
+    }
+    int64_t nkept = 0;
+    if (same && (array->ndim == 0 || old_shape[0] == array->shape[0])) {
+        nkept = stats->nchunks;
+    } else if (same) {
+        // Only the rows of chunks that are full in both shapes keep their items
+        int64_t nitems = old_shape[0] < array->shape[0] ? old_shape[0] : array->shape[0];
+        nkept = nitems / array->chunkshape[0] * ring_chunks_per_row(array);
+    }
+    nkept = nkept < nchunks ? nkept : nchunks;
+    nkept = nkept < stats->nchunks ? nkept : stats->nchunks;
+    if (nkept == nchunks && nchunks == stats->nchunks) {
+        return CATERVA_SUCCEED;
+    }
+
+    CATERVA_ERROR(caterva_stats_layout(array, stats, nchunks, nblocks, nkept));
+    stats->dirty = true;
+    return CATERVA_SUCCEED;
+}
+
+void caterva_stats_free(caterva_array_t *array) {
+    struct caterva_stats_s *stats = array->stats;
+    if (stats == NULL) {
+        return;
+    }
+    if (stats->valid != NULL) {
+        array->cfg->free(stats->valid);
+        array->cfg->free(stats->chunks);
+        array->cfg->free(stats->blocks);
+    }
+    array->cfg->free(stats);
+    array->stats = NULL;
+}
+
+#define CATERVA_STATS_HEADER_LEN (1 + 1 + 1 + 2 * (1 + sizeof(int64_t)) + 1 + sizeof(int32_t))
+#define CATERVA_STATS_ENTRY_LEN (4 * sizeof(int64_t))
+
+static uint8_t *caterva_stats_store_entry(uint8_t *pdata, caterva_stats_t *entry) {
+    swap_store(pdata, &entry->nitems, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    swap_store(pdata, &entry->nnans, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    swap_store(pdata, &entry->min.i, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    swap_store(pdata, &entry->max.i, sizeof(int64_t));
+    return pdata + sizeof(int64_t);
+}
+
+static uint8_t *caterva_stats_load_entry(uint8_t *pdata, caterva_stats_t *entry) {
+    swap_store(&entry->nitems, pdata, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    swap_store(&entry->nnans, pdata, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    swap_store(&entry->min.i, pdata, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    swap_store(&entry->max.i, pdata, sizeof(int64_t));
+    return pdata + sizeof(int64_t);
+}
+
+int caterva_stats_store(caterva_array_t *array) {
+    struct caterva_stats_s *stats = array->stats;
+    int64_t nentries = stats->nchunks * (1 + stats->nblocks);
+    int64_t bin_len = stats->nchunks + nentries * CATERVA_STATS_ENTRY_LEN;
+    if ((int64_t) CATERVA_STATS_HEADER_LEN + bin_len > INT32_MAX) {
+        CATERVA_TRACE_ERROR("The statistics are too large to be stored");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    int32_t sdata_len = (int32_t) (CATERVA_STATS_HEADER_LEN + bin_len);
+    uint8_t *sdata = malloc(sdata_len);
+    CATERVA_ERROR_NULL(sdata);
+
+    // Build an array with 5 entries (version, dtype, nchunks, nblocks, entries)
+    uint8_t *pdata = sdata;
+    *pdata++ = 0x90 + 5;
+    *pdata++ = CATERVA_METALAYER_VERSION;
+    *pdata++ = (uint8_t) stats->dtype;
+    *pdata++ = 0xd3;  // int64
+    swap_store(pdata, &stats->nchunks, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    *pdata++ = 0xd3;  // int64
+    swap_store(pdata, &stats->nblocks, sizeof(int64_t));
+    pdata += sizeof(int64_t);
+    *pdata++ = 0xc6;  // bin 32
+    int32_t bin_len32 = (int32_t) bin_len;
+    swap_store(pdata, &bin_len32, sizeof(int32_t));
+    pdata += sizeof(int32_t);
+    for (int64_t i = 0; i < stats->nchunks; ++i) {
+        *pdata++ = stats->valid[i];
+    }
+    for (int64_t i = 0; i < stats->nchunks; ++i) {
+        pdata = caterva_stats_store_entry(pdata, &stats->chunks[i]);
+    }
+    for (int64_t i = 0; i < stats->nchunks * stats->nblocks; ++i) {
+        pdata = caterva_stats_store_entry(pdata, &stats->blocks[i]);
+    }
+
+    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+    int rc;
+    if (blosc2_vlmeta_exists(array->sc, "caterva_stats") < 0) {
+        rc = blosc2_vlmeta_add(array->sc, "caterva_stats", sdata, sdata_len, &cparams);
+    } else {
+        rc = blosc2_vlmeta_update(array->sc, "caterva_stats", sdata, sdata_len, &cparams);
+    }
+    free(sdata);
+    if (rc < 0) {
+        CATERVA_TRACE_ERROR("Error storing the statistics");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    stats->dirty = false;
+    return CATERVA_SUCCEED;
+}
+
+int caterva_stats_load(caterva_array_t *array) {
+    if (blosc2_vlmeta_exists(array->sc, "caterva_stats") < 0) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *sdata;
+    int32_t sdata_len;
+    if (blosc2_vlmeta_get(array->sc, "caterva_stats", &sdata, &sdata_len) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int64_t nchunks = 0;
+    int64_t nblocks = 0;
+    int32_t bin_len = 0;
+    uint8_t dtype = 0;
+    if (sdata_len >= (int32_t) CATERVA_STATS_HEADER_LEN && sdata[0] == 0x90 + 5) {
+        uint8_t *pdata = sdata + 2;
+        dtype = *pdata++;
+        swap_store(&nchunks, pdata + 1, sizeof(int64_t));
+        pdata += 1 + sizeof(int64_t);
+        swap_store(&nblocks, pdata + 1, sizeof(int64_t));
+        pdata += 1 + sizeof(int64_t);
+        swap_store(&bin_len, pdata + 1, sizeof(int32_t));
+    }
+    if (sdata_len < (int32_t) CATERVA_STATS_HEADER_LEN || dtype > CATERVA_FLOAT64 ||
+        nchunks < 0 || nblocks < 0 || sdata_len != (int64_t) CATERVA_STATS_HEADER_LEN + bin_len ||
+        bin_len != nchunks + nchunks * (1 + nblocks) * (int64_t) CATERVA_STATS_ENTRY_LEN) {
+        free(sdata);
+        CATERVA_TRACE_ERROR("The statistics are not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    struct caterva_stats_s *stats = array->cfg->alloc(sizeof(struct caterva_stats_s));
+    CATERVA_ERROR_NULL(stats);
+    memset(stats, 0, sizeof(struct caterva_stats_s));
+    stats->dtype = (caterva_dtype_t) dtype;
+    int rc = caterva_stats_layout(array, stats, nchunks, nblocks, 0);
+    if (rc != CATERVA_SUCCEED) {
+        free(sdata);
+        array->cfg->free(stats);
+        CATERVA_ERROR(rc);
+    }
+    array->stats = stats;
+    uint8_t *pdata = sdata + CATERVA_STATS_HEADER_LEN;
+    for (int64_t i = 0; i < nchunks; ++i) {
+        stats->valid[i] = *pdata++ != 0;
+    }
+    for (int64_t i = 0; i < nchunks; ++i) {
+        pdata = caterva_stats_load_entry(pdata, &stats->chunks[i]);
+    }
+    for (int64_t i = 0; i < nchunks * nblocks; ++i) {
+        pdata = caterva_stats_load_entry(pdata, &stats->blocks[i]);
+    }
+    free(sdata);
+
+    // The statistics are recomputed if they do not match the layout of the array
+    if (nchunks != array->extnitems / array->chunknitems ||
+        nblocks != array->extchunknitems / array->blocknitems) {
+        CATERVA_ERROR(caterva_stats_layout(array, stats, array->extnitems / array->chunknitems,
+                                           array->extchunknitems / array->blocknitems, 0));
+        stats->dirty = true;
+    }
+    return CATERVA_SUCCEED;
+}
+
+typedef struct {
+    caterva_array_t *array;
+    // Resources of each thread
+    blosc2_context **dctx;
+    uint8_t **data;
+} caterva_stats_job_t;
+
+static int caterva_stats_task(void *arg, int64_t nchunk, int thread) {
+    caterva_stats_job_t *job = (caterva_stats_job_t *) arg;
+    caterva_array_t *array = job->array;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, job->dctx[thread],
+                                               job->data[thread], nbytes));
+    caterva_stats_compute(array, nchunk, job->data[thread]);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_enable_stats(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    if (dtype < CATERVA_INT8 || dtype > CATERVA_FLOAT64) {
+        CATERVA_TRACE_ERROR("`dtype` is not supported");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The itemsize of `dtype` does not match the array one");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    // Concurrent writes would update the statistics of their chunks at the same time
+    if (array->chunk_locks != NULL) {
+        CATERVA_TRACE_ERROR("The statistics can not be combined with the chunk locks");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_ERROR(append_buffer_flush(array));
+    caterva_stats_free(array);
+
+    struct caterva_stats_s *stats = ctx->cfg->alloc(sizeof(struct caterva_stats_s));
+    CATERVA_ERROR_NULL(stats);
+    memset(stats, 0, sizeof(struct caterva_stats_s));
+    stats->dtype = dtype;
+    array->stats = stats;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int rc = caterva_stats_layout(array, stats, nchunks, array->extchunknitems / array->blocknitems,
+                                  0);
+
+    // Every chunk is decompressed by one thread
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = nchunks > 0 ? (int) nchunks : 1;
+    }
+    caterva_stats_job_t job;
+    job.array = array;
+    job.dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.data = calloc(nthreads, sizeof(uint8_t *));
+    if (job.dctx == NULL || job.data == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.dctx[t] = caterva_create_thread_dctx(array);
+        job.data[t] = ctx->cfg->alloc(array->extchunknitems * array->itemsize);
+        if (job.dctx[t] == NULL || job.data[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, nchunks, caterva_stats_task, &job);
+    }
+    for (int t = 0; t < nthreads; ++t) {
+        if (job.dctx != NULL && job.dctx[t] != NULL) {
+            blosc2_free_ctx(job.dctx[t]);
+        }
+        if (job.data != NULL && job.data[t] != NULL) {
+            ctx->cfg->free(job.data[t]);
+        }
+    }
+    free(job.dctx);
+    free(job.data);
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_stats_store(array);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        caterva_stats_free(array);
+    }
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_disable_stats(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    if (array->stats == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    caterva_stats_free(array);
+    if (blosc2_vlmeta_exists(array->sc, "caterva_stats") >= 0 &&
+        blosc2_vlmeta_delete(array->sc, "caterva_stats") < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Bring the statistics of a chunk up to date. This writes the statistics, so it must not run at
+// the same time as other accesses to the array.
+static int caterva_stats_refresh(caterva_array_t *array, int64_t nchunk) {
+    if (array->stats == NULL) {
+        CATERVA_TRACE_ERROR("The statistics are not enabled");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (nchunk < 0 || nchunk >= array->stats->nchunks) {
+        CATERVA_TRACE_ERROR("The chunk is out of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
+    }
+    if (array->stats->valid[nchunk]) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *buffered = append_buffer_chunk(array, nchunk);
+    if (buffered != NULL) {
+        caterva_stats_update(array, nchunk, buffered);
+        return CATERVA_SUCCEED;
+    }
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    uint8_t *data = array->cfg->alloc(nbytes);
+    CATERVA_ERROR_NULL(data);
+    blosc2_context *dctx = caterva_acquire_dctx(array);
+    int rc = dctx == NULL ? CATERVA_ERR_NULL_POINTER : CATERVA_SUCCEED;
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_decompress_chunk_ctx(array, nchunk, dctx, data, nbytes);
+        caterva_release_dctx(array, dctx, rc);
+    }
+    if (rc == CATERVA_SUCCEED) {
+        caterva_stats_update(array, nchunk, data);
+    }
+    array->cfg->free(data);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_get_chunk_stats(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            caterva_stats_t *stats) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(stats);
+
+    CATERVA_ERROR(caterva_stats_refresh(array, nchunk));
+    *stats = array->stats->chunks[nchunk];
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_get_block_stats(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nchunk,
+                            int64_t nblock, caterva_stats_t *stats) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(stats);
+
+    CATERVA_ERROR(caterva_stats_refresh(array, nchunk));
+    if (nblock < 0 || nblock >= array->stats->nblocks) {
+        CATERVA_TRACE_ERROR("The block is out of the chunk");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
+    }
+    *stats = array->stats->blocks[nchunk * array->stats->nblocks + nblock];
+
+    return CATERVA_SUCCEED;
+}
+
+
+// Predicates
+
+typedef enum {
+    CATERVA_MATCH_NONE,
+    CATERVA_MATCH_SOME,
+    CATERVA_MATCH_ALL,
+} caterva_match_t;
+
+// The depth of a predicate, or -1 if it is not valid
+static int caterva_predicate_depth(const caterva_predicate_t *predicate) {
+    if (predicate == NULL || (int) predicate->op < 0 || predicate->op > CATERVA_PREDICATE_OR) {
+        return -1;
+    }
+    if (predicate->op != CATERVA_PREDICATE_AND && predicate->op != CATERVA_PREDICATE_OR) {
+        return 1;
+    }
+    int left = caterva_predicate_depth(predicate->left);
+    int right = caterva_predicate_depth(predicate->right);
+    if (left < 0 || right < 0) {
+        return -1;
+    }
+    return 1 + (left > right ? left : right);
+}
+
+static int caterva_scalar_cmp(caterva_kind_t kind, caterva_scalar_t a, caterva_scalar_t b) {
+    switch (kind) {
+        case CATERVA_KIND_SIGNED:
+            return (a.i > b.i) - (a.i < b.i);
+        case CATERVA_KIND_UNSIGNED:
+            return (a.u > b.u) - (a.u < b.u);
+        default:
+            return (a.f > b.f) - (a.f < b.f);
+    }
+}
+
+// Whether none, some or all the items described by some statistics match a predicate
+static caterva_match_t caterva_predicate_match(caterva_kind_t kind,
+                                               const caterva_predicate_t *predicate,
+                                               const caterva_stats_t *stats) {
+    if (predicate->op == CATERVA_PREDICATE_AND || predicate->op == CATERVA_PREDICATE_OR) {
+        caterva_match_t left = caterva_predicate_match(kind, predicate->left, stats);
+        caterva_match_t right = caterva_predicate_match(kind, predicate->right, stats);
+        if (predicate->op == CATERVA_PREDICATE_AND) {
+            return left < right ? left : right;
+        }
+        return left > right ? left : right;
+    }
+    if (stats->nitems == 0) {
+        return CATERVA_MATCH_NONE;
+    }
+    bool nan_match = predicate->op == CATERVA_PREDICATE_NE;
+    if (stats->nitems == stats->nnans) {
+        return nan_match ? CATERVA_MATCH_ALL : CATERVA_MATCH_NONE;
+    }
+    if (kind == CATERVA_KIND_FLOAT && (isnan(predicate->value.f) || isnan(predicate->upper.f))) {
+        return CATERVA_MATCH_SOME;
+    }
+
+    int lo = caterva_scalar_cmp(kind, stats->min, predicate->value);
+    int hi = caterva_scalar_cmp(kind, stats->max, predicate->value);
+    caterva_match_t match;
+    switch (predicate->op) {
+        case CATERVA_PREDICATE_LT:
+            match = hi < 0 ? CATERVA_MATCH_ALL : (lo >= 0 ? CATERVA_MATCH_NONE : CATERVA_MATCH_SOME);
+            break;
+        case CATERVA_PREDICATE_LE:
+            match = hi <= 0 ? CATERVA_MATCH_ALL : (lo > 0 ? CATERVA_MATCH_NONE : CATERVA_MATCH_SOME);
+            break;
+        case CATERVA_PREDICATE_GT:
+            match = lo > 0 ? CATERVA_MATCH_ALL : (hi <= 0 ? CATERVA_MATCH_NONE : CATERVA_MATCH_SOME);
+            break;
+        case CATERVA_PREDICATE_GE:
+            match = lo >= 0 ? CATERVA_MATCH_ALL : (hi < 0 ? CATERVA_MATCH_NONE : CATERVA_MATCH_SOME);
+            break;
+        case CATERVA_PREDICATE_EQ:
+            match = lo == 0 && hi == 0 ? CATERVA_MATCH_ALL :
+                    (lo > 0 || hi < 0 ? CATERVA_MATCH_NONE : CATERVA_MATCH_SOME);
+            break;
+        case CATERVA_PREDICATE_NE:
+            match = lo == 0 && hi == 0 ? CATERVA_MATCH_NONE :
+                    (lo > 0 || hi < 0 ? CATERVA_MATCH_ALL : CATERVA_MATCH_SOME);
+            break;
+        default: {
+            int lo_upper = caterva_scalar_cmp(kind, stats->min, predicate->upper);
+            int hi_upper = caterva_scalar_cmp(kind, stats->max, predicate->upper);
+            match = lo >= 0 && hi_upper < 0 ? CATERVA_MATCH_ALL :
+                    (hi < 0 || lo_upper >= 0 ? CATERVA_MATCH_NONE : CATERVA_MATCH_SOME);
+            break;
+        }
+    }
+    // The NaNs only match the inequality
+    if (stats->nnans > 0 && ((match == CATERVA_MATCH_ALL && !nan_match) ||
+                             (match == CATERVA_MATCH_NONE && nan_match))) {
+        match = CATERVA_MATCH_SOME;
+    }
+    return match;
+}
+
+// Evaluate a predicate over a row of n items into out. The scratch has room for a row per level
+// of the predicate.
+static void caterva_predicate_eval(const caterva_reduce_kernels_t *kernels,
+                                   const caterva_predicate_t *predicate, const uint8_t *src,
+                                   int64_t n, uint8_t *out, uint8_t *scratch) {
+    if (predicate->op != CATERVA_PREDICATE_AND && predicate->op != CATERVA_PREDICATE_OR) {
+        kernels->compare(src, n, predicate, out);
+        return;
+    }
+    caterva_predicate_eval(kernels, predicate->left, src, n, out, scratch);
+    caterva_predicate_eval(kernels, predicate->right, src, n, scratch, scratch + n);
+    if (predicate->op == CATERVA_PREDICATE_AND) {
+        for (int64_t j = 0; j < n; ++j) {
+            out[j] &= scratch[j];
+        }
+    } else {
+        for (int64_t j = 0; j < n; ++j) {
+            out[j] |= scratch[j];
+        }
+    }
+}
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    const caterva_reduce_kernels_t *kernels;
+    const caterva_predicate_t *predicate;
+    bool pruning;
+    //!< Whether the statistics of the array can be used.
+    caterva_array_t *mask;
+    //!< The boolean result (@ref caterva_where_mask only).
+    int64_t **matches;
+    int64_t *nmatches;
+    //!< The flat indexes of the matching items of each chunk (@ref caterva_where only).
+    // Resources of each thread
+    blosc2_context **dctx;
+    uint8_t **data;
+    uint8_t **scratch;
+    //!< The rows of the evaluation of each level of the predicate.
+    caterva_match_t **blocks;
+    bool **maskout;
+    uint8_t **tile;
+    //!< The mask of the chunk (@ref caterva_where_mask only).
+} caterva_where_job_t;
+
+typedef struct {
+    caterva_where_job_t *job;
+    int thread;
+    caterva_match_t match;
+    //!< The match of the whole chunk.
+    const caterva_match_t *blocks;
+    //!< The match of each block (only when the chunk matches partially).
+    int64_t *matches;
+    int64_t nmatches;
+    int64_t capacity;
+    int64_t tile_start[CATERVA_MAX_DIM];
+    int64_t tile_strides[CATERVA_MAX_DIM];
+    int rc;
+} caterva_where_rows_t;
+
+static void caterva_where_row(void *arg, const uint8_t *row, int64_t n, const int64_t *coords) {
+    caterva_where_rows_t *rows = (caterva_where_rows_t *) arg;
+    caterva_where_job_t *job = rows->job;
+    caterva_array_t *array = job->array;
+    if (rows->rc != CATERVA_SUCCEED) {
+        return;
+    }
+
+    caterva_match_t match = rows->match;
+    if (match == CATERVA_MATCH_SOME && rows->blocks != NULL) {
+        int64_t nblock = 0;
+        for (int i = 0; i < array->ndim; ++i) {
+            nblock += coords[i] % array->chunkshape[i] / array->blockshape[i] *
+                      array->block_chunk_strides[i];
+        }
+        match = rows->blocks[nblock];
+    }
+    if (match == CATERVA_MATCH_NONE) {
+        return;
+    }
+    uint8_t *out = job->scratch[rows->thread];
+    if (match == CATERVA_MATCH_ALL) {
+        memset(out, 1, n);
+    } else {
+        caterva_predicate_eval(job->kernels, job->predicate, row, n, out, out + n);
+    }
+
+    if (job->mask != NULL) {
+        int64_t offset = 0;
+        for (int i = 0; i < array->ndim; ++i) {
+            offset += (coords[i] - rows->tile_start[i]) * rows->tile_strides[i];
+        }
+        memcpy(&job->tile[rows->thread][offset], out, n);
+        rows->nmatches += n;
+        return;
+    }
+    int64_t flat = 0;
+    for (int i = 0; i < array->ndim; ++i) {
+        flat += coords[i] * array->item_array_strides[i];
+    }
+    if (rows->nmatches + n > rows->capacity) {
+        int64_t capacity = 2 * rows->capacity + n;
+        int64_t *matches = realloc(rows->matches, capacity * sizeof(int64_t));
+        if (matches == NULL) {
+            rows->rc = CATERVA_ERR_NULL_POINTER;
+            return;
+        }
+        rows->matches = matches;
+        rows->capacity = capacity;
+    }
+    for (int64_t j = 0; j < n; ++j) {
+        rows->matches[rows->nmatches] = flat + j;
+        rows->nmatches += out[j];
+    }
+}
+
+static int caterva_where_task(void *arg, int64_t nchunk, int thread) {
+    caterva_where_job_t *job = (caterva_where_job_t *) arg;
+    caterva_array_t *array = job->array;
+    struct caterva_stats_s *stats = array->stats;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+
+    caterva_where_rows_t rows = {0};
+    rows.job = job;
+    rows.thread = thread;
+    rows.match = CATERVA_MATCH_SOME;
+    bool pruning = job->pruning && stats->valid[nchunk];
+    if (pruning) {
+        rows.match = caterva_predicate_match(job->kernels->kind, job->predicate,
+                                             &stats->chunks[nchunk]);
+    }
+    if (rows.match == CATERVA_MATCH_NONE) {
+        return CATERVA_SUCCEED;
+    }
+
+    if (rows.match == CATERVA_MATCH_SOME) {
+        if (pruning) {
+            // The blocks that match as a whole or not at all are not decompressed
+            caterva_match_t *blocks = job->blocks[thread];
+            bool *maskout = job->maskout[thread];
+            bool skip = false;
+            for (int64_t nblock = 0; nblock < stats->nblocks; ++nblock) {
+                blocks[nblock] = caterva_predicate_match(
+                        job->kernels->kind, job->predicate,
+                        &stats->blocks[nchunk * stats->nblocks + nblock]);
+                maskout[nblock] = blocks[nblock] != CATERVA_MATCH_SOME;
+                skip = skip || maskout[nblock];
+            }
+            if (skip && blosc2_set_maskout(job->dctx[thread], maskout, (int) stats->nblocks) !=
+                        BLOSC2_ERROR_SUCCESS) {
+                CATERVA_TRACE_ERROR("Error setting the maskout");
+                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            }
+            rows.blocks = blocks;
+        }
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(array, nchunk, job->dctx[thread],
+                                                   job->data[thread], nbytes));
+    }
+
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t tilenitems = 1;
+    if (job->mask != NULL) {
+        int64_t rem = nchunk;
+        for (int i = array->ndim - 1; i >= 0; --i) {
+            int64_t nchunks_i = array->extshape[i] / array->chunkshape[i];
+            start[i] = rem % nchunks_i * array->chunkshape[i];
+            rem /= nchunks_i;
+            stop[i] = start[i] + array->chunkshape[i];
+            if (stop[i] > array->shape[i]) {
+                stop[i] = array->shape[i];
+            }
+            shape[i] = stop[i] - start[i];
+            rows.tile_start[i] = start[i];
+            rows.tile_strides[i] = tilenitems;
+            tilenitems *= shape[i];
+        }
+        memset(job->tile[thread], 0, tilenitems);
+    }
+
+    caterva_chunk_rows(array, nchunk, job->data[thread], caterva_where_row, &rows);
+    if (rows.rc != CATERVA_SUCCEED) {
+        free(rows.matches);
+        CATERVA_ERROR(rows.rc);
+    }
+
+    if (job->mask == NULL) {
+        job->matches[nchunk] = rows.matches;
+        job->nmatches[nchunk] = rows.nmatches;
+        return CATERVA_SUCCEED;
+    }
+    // The mask is created with zeros
+    if (rows.nmatches == 0) {
+        return CATERVA_SUCCEED;
+    }
+    caterva_parallel_lock();
+    int rc = caterva_set_slice_buffer(job->ctx, job->tile[thread], shape, tilenitems, start, stop,
+                                      job->mask);
+    caterva_parallel_unlock();
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+// Evaluate a predicate over every chunk of an array
+static int caterva_where_eval(caterva_where_job_t *job, caterva_dtype_t dtype) {
+    caterva_ctx_t *ctx = job->ctx;
+    caterva_array_t *array = job->array;
+
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    int depth = caterva_predicate_depth(job->predicate);
+    if (depth < 0) {
+        CATERVA_TRACE_ERROR("The predicate is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    job->kernels = &caterva_reduce_kernels[dtype];
+
+    job->pruning = array->stats != NULL && array->stats->dtype == dtype;
+
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    int64_t rowlen = array->ndim > 0 ? array->blockshape[array->ndim - 1] : 1;
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > nchunks) {
+        nthreads = nchunks > 0 ? (int) nchunks : 1;
+    }
+    int rc = CATERVA_SUCCEED;
+    job->dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job->data = calloc(nthreads, sizeof(uint8_t *));
+    job->scratch = calloc(nthreads, sizeof(uint8_t *));
+    job->blocks = calloc(nthreads, sizeof(caterva_match_t *));
+    job->maskout = calloc(nthreads, sizeof(bool *));
+    job->tile = calloc(nthreads, sizeof(uint8_t *));
+    if (job->dctx == NULL || job->data == NULL || job->scratch == NULL || job->blocks == NULL ||
+        job->maskout == NULL || job->tile == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job->dctx[t] = caterva_create_thread_dctx(array);
+        job->data[t] = ctx->cfg->alloc(array->extchunknitems * array->itemsize);
+        job->scratch[t] = ctx->cfg->alloc((depth + 1) * rowlen);
+        job->blocks[t] = ctx->cfg->alloc(nblocks * sizeof(caterva_match_t));
+        job->maskout[t] = ctx->cfg->alloc(nblocks * sizeof(bool));
+        if (job->dctx[t] == NULL || job->data[t] == NULL || job->scratch[t] == NULL ||
+            job->blocks[t] == NULL || job->maskout[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+        if (job->mask != NULL) {
+            job->tile[t] = ctx->cfg->alloc(array->chunknitems);
+            if (job->tile[t] == NULL) {
+                rc = CATERVA_ERR_NULL_POINTER;
+            }
+        }
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, nchunks, caterva_where_task, job);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job->dctx != NULL && job->dctx[t] != NULL) {
+            blosc2_free_ctx(job->dctx[t]);
+        }
+        if (job->data != NULL && job->data[t] != NULL) {
+            ctx->cfg->free(job->data[t]);
+        }
+        if (job->scratch != NULL && job->scratch[t] != NULL) {
+            ctx->cfg->free(job->scratch[t]);
+        }
+        if (job->blocks != NULL && job->blocks[t] != NULL) {
+            ctx->cfg->free(job->blocks[t]);
+        }
+        if (job->maskout != NULL && job->maskout[t] != NULL) {
+            ctx->cfg->free(job->maskout[t]);
+        }
+        if (job->tile != NULL && job->tile[t] != NULL) {
+            ctx->cfg->free(job->tile[t]);
+        }
+    }
+    free(job->dctx);
+    free(job->data);
+    free(job->scratch);
+    free(job->blocks);
+    free(job->maskout);
+    free(job->tile);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+static int caterva_compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *) a;
+    int64_t y = *(const int64_t *) b;
+    return (x > y) - (x < y);
+}
+
+int caterva_where(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                  const caterva_predicate_t *predicate, int64_t **coords, int64_t *ncoords) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(predicate);
+    CATERVA_ERROR_NULL(coords);
+    CATERVA_ERROR_NULL(ncoords);
+
+    *coords = NULL;
+    *ncoords = 0;
+    caterva_where_job_t job = {0};
+    job.ctx = ctx;
+    job.array = array;
+    job.predicate = predicate;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    job.matches = calloc(nchunks + 1, sizeof(int64_t *));
+    job.nmatches = calloc(nchunks + 1, sizeof(int64_t));
+    int rc = CATERVA_SUCCEED;
+    if (job.matches == NULL || job.nmatches == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_where_eval(&job, dtype);
+    }
+
+    // Gather the matches of every chunk and sort them in C order
+    int64_t nmatches = 0;
+    int64_t *matches = NULL;
+    if (rc == CATERVA_SUCCEED) {
+        for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+            nmatches += job.nmatches[nchunk];
+        }
+        matches = malloc((nmatches + 1) * sizeof(int64_t));
+        *coords = malloc((nmatches * array->ndim + 1) * sizeof(int64_t));
+        if (matches == NULL || *coords == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        int64_t k = 0;
+        for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+            if (job.nmatches[nchunk] > 0) {
+                memcpy(&matches[k], job.matches[nchunk], job.nmatches[nchunk] * sizeof(int64_t));
+                k += job.nmatches[nchunk];
+            }
+        }
+        qsort(matches, nmatches, sizeof(int64_t), caterva_compare_int64);
+        for (k = 0; k < nmatches; ++k) {
+            int64_t rem = matches[k];
+            for (int i = array->ndim - 1; i >= 0; --i) {
+                (*coords)[k * array->ndim + i] = rem % array->shape[i];
+                rem /= array->shape[i];
+            }
+        }
+        *ncoords = nmatches;
+    }
+    for (int64_t nchunk = 0; job.matches != NULL && nchunk < nchunks; ++nchunk) {
+        free(job.matches[nchunk]);
+    }
+    free(job.matches);
+    free(job.nmatches);
+    free(matches);
+    if (rc != CATERVA_SUCCEED) {
+        free(*coords);
+        *coords = NULL;
+    }
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_where_mask(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                       const caterva_predicate_t *predicate, caterva_storage_t *storage,
+                       caterva_array_t **mask) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(predicate);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(mask);
+
+    caterva_params_t params = {0};
+    params.itemsize = 1;
+    params.ndim = array->ndim;
+    caterva_storage_t mstorage = *storage;
+    bool auto_shapes = true;
+    for (int i = 0; i < array->ndim; ++i) {
+        auto_shapes = auto_shapes && mstorage.chunkshape[i] == 0;
+    }
+    for (int i = 0; i < array->ndim; ++i) {
+        params.shape[i] = array->shape[i];
+        if (auto_shapes) {
+            mstorage.chunkshape[i] = array->chunkshape[i];
+            mstorage.blockshape[i] = array->blockshape[i];
+        }
+    }
+
+    caterva_where_job_t job = {0};
+    job.ctx = ctx;
+    job.array = array;
+    job.predicate = predicate;
+    CATERVA_ERROR(caterva_zeros(ctx, &params, &mstorage, &job.mask));
+    int rc = caterva_where_eval(&job, dtype);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &job.mask);
+        CATERVA_ERROR(rc);
+    }
+
+    *mask = job.mask;
+    return CATERVA_SUCCEED;
+}
+
+
+// Overviews
+
+#define CATERVA_OVERVIEWS_HEADER_LEN 6
+#define CATERVA_OVERVIEWS_MAX_LEVELS 62
+
+// The reduction of a window of items, given by their offsets
+#define CATERVA_OVERVIEW_KERNEL(name, type, sumtype)                                              \
+static void caterva_overview_window_##name(caterva_overview_reducer_t reducer, const uint8_t *src, \
+                                           const int64_t *offsets, int n, uint8_t *dest) {      \
+    const type *x = (const type *) src;                                                          \
+    type v = x[offsets[0]];                                                                      \
+    if (reducer == CATERVA_OVERVIEW_MEAN) {                                                      \
+        sumtype sum = 0;                                                                         \
+        for (int j = 0; j < n; ++j) {                                                            \
+            sum += (sumtype) x[offsets[j]];                                                      \
+        }                                                                                        \
+        v = (type) (sum / n);                                                                    \
+    } else if (reducer == CATERVA_OVERVIEW_MAX) {                                                \
+        for (int j = 1; j < n; ++j) {                                                            \
+            v = x[offsets[j]] > v ? x[offsets[j]] : v;                                           \
+        }                                                                                        \
+    }                                                                                            \
+    *(type *) dest = v;                                                                          \
+}
+
+CATERVA_OVERVIEW_KERNEL(int8, int8_t, int64_t)
+CATERVA_OVERVIEW_KERNEL(int16, int16_t, int64_t)
+CATERVA_OVERVIEW_KERNEL(int32, int32_t, int64_t)
+CATERVA_OVERVIEW_KERNEL(int64, int64_t, int64_t)
+CATERVA_OVERVIEW_KERNEL(uint8, uint8_t, uint64_t)
+CATERVA_OVERVIEW_KERNEL(uint16, uint16_t, uint64_t)
+CATERVA_OVERVIEW_KERNEL(uint32, uint32_t, uint64_t)
+CATERVA_OVERVIEW_KERNEL(uint64, uint64_t, uint64_t)
+CATERVA_OVERVIEW_KERNEL(float32, float, double)
+CATERVA_OVERVIEW_KERNEL(float64, double, double)
+
+typedef void (*caterva_overview_window_fn)(caterva_overview_reducer_t reducer, const uint8_t *src,
+                                           const int64_t *offsets, int n, uint8_t *dest);
+
+// Indexed by caterva_dtype_t
+static const caterva_overview_window_fn caterva_overview_windows[] = {
+    caterva_overview_window_int8,
+    caterva_overview_window_int16,
+    caterva_overview_window_int32,
+    caterva_overview_window_int64,
+    caterva_overview_window_uint8,
+    caterva_overview_window_uint16,
+    caterva_overview_window_uint32,
+    caterva_overview_window_uint64,
+    caterva_overview_window_float32,
+    caterva_overview_window_float64,
+};
+
+// The urlpath of the overview of a level of an array stored in @p urlpath
+static char *caterva_overview_urlpath(const char *urlpath, int level) {
+    size_t len = strlen(urlpath) + 16;
+    char *path = malloc(len);
+    if (path != NULL) {
+        snprintf(path, len, "%s.ovr%d", urlpath, level);
+    }
+    return path;
+}
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *src;
+    caterva_array_t *dest;
+    caterva_overview_window_fn window;
+    caterva_overview_reducer_t reducer;
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    //!< The region of the overview to be computed.
+    int64_t chunk_first[CATERVA_MAX_DIM];
+    int64_t chunk_count[CATERVA_MAX_DIM];
+    //!< The chunks of the overview in the region.
+    // Resources of each thread
+    blosc2_context **dctx;
+    uint8_t **data;
+    uint8_t **src_tile;
+    uint8_t **dest_tile;
+} caterva_overview_job_t;
+
+// Compute the items of the region in a chunk of an overview from the previous level
+static int caterva_overview_task(void *arg, int64_t task, int thread) {
+    caterva_overview_job_t *job = (caterva_overview_job_t *) arg;
+    caterva_array_t *src = job->src;
+    caterva_array_t *dest = job->dest;
+    int8_t ndim = src->ndim;
+
+    int64_t dest_start[CATERVA_MAX_DIM];
+    int64_t dest_stop[CATERVA_MAX_DIM];
+    int64_t dest_shape[CATERVA_MAX_DIM];
+    int64_t src_start[CATERVA_MAX_DIM];
+    int64_t src_stop[CATERVA_MAX_DIM];
+    int64_t src_shape[CATERVA_MAX_DIM];
+    int64_t first[CATERVA_MAX_DIM];
+    int64_t last[CATERVA_MAX_DIM];
+    int64_t counter[CATERVA_MAX_DIM];
+    int64_t dest_nitems = 1;
+    for (int i = ndim - 1; i >= 0; --i) {
+        int64_t chunk = job->chunk_first[i] + task % job->chunk_count[i];
+        task /= job->chunk_count[i];
+        dest_start[i] = chunk * dest->chunkshape[i];
+        dest_start[i] = dest_start[i] > job->start[i] ? dest_start[i] : job->start[i];
+        dest_stop[i] = (chunk + 1) * dest->chunkshape[i];
+        dest_stop[i] = dest_stop[i] < job->stop[i] ? dest_stop[i] : job->stop[i];
+        dest_shape[i] = dest_stop[i] - dest_start[i];
+        dest_nitems *= dest_shape[i];
+        src_start[i] = 2 * dest_start[i];
+        src_stop[i] = 2 * dest_stop[i] < src->shape[i] ? 2 * dest_stop[i] : src->shape[i];
+        src_shape[i] = src_stop[i] - src_start[i];
+        first[i] = src_start[i] / src->chunkshape[i];
+        last[i] = (src_stop[i] - 1) / src->chunkshape[i] + 1;
+        counter[i] = first[i];
+    }
+
+    // Gather the region of the source from the chunks that contain it
+    caterva_region_rows_t rows;
+    rows.array = src;
+    rows.tile = job->src_tile[thread];
+    rows.start = src_start;
+    rows.stop = src_stop;
+    rows.strides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        rows.strides[i] = rows.strides[i + 1] * src_shape[i + 1];
+    }
+    int32_t nbytes = (int32_t) (src->extchunknitems * src->itemsize);
+    do {
+        int64_t nchunk = 0;
+        for (int i = 0; i < ndim; ++i) {
+            nchunk = nchunk * (src->extshape[i] / src->chunkshape[i]) + counter[i];
+        }
+        CATERVA_ERROR(caterva_decompress_chunk_ctx(src, nchunk, job->dctx[thread],
+                                                   job->data[thread], nbytes));
+        caterva_chunk_rows(src, nchunk, job->data[thread], caterva_region_row, &rows);
+    } while (caterva_selection_next(ndim, counter, first, last));
+
+    // Reduce the window of every item, clipped at the end of the source
+    int64_t offsets[1 << CATERVA_MAX_DIM];
+    uint8_t *dest_tile = job->dest_tile[thread];
+    for (int64_t k = 0; k < dest_nitems; ++k) {
+        int64_t origin[CATERVA_MAX_DIM];
+        int64_t rem = k;
+        for (int i = ndim - 1; i >= 0; --i) {
+            origin[i] = 2 * (rem % dest_shape[i]);
+            rem /= dest_shape[i];
+        }
+        int n = 0;
+        for (int corner = 0; corner < (1 << ndim); ++corner) {
+            int64_t offset = 0;
+            bool inside = true;
+            for (int i = 0; i < ndim && inside; ++i) {
+                int64_t coord = origin[i] + ((corner >> (ndim - 1 - i)) & 1);
+                inside = coord < src_shape[i];
+                offset += coord * rows.strides[i];
+            }
+            if (inside) {
+                offsets[n++] = offset;
+            }
+        }
+        job->window(job->reducer, rows.tile, offsets, n, &dest_tile[k * dest->itemsize]);
+    }
+
+    caterva_parallel_lock();
+    int rc = caterva_set_slice_buffer(job->ctx, dest_tile, dest_shape, dest_nitems * dest->itemsize,
+                                      dest_start, dest_stop, dest);
+    caterva_parallel_unlock();
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+// Compute the region [start, stop) of an overview from the previous level
+static int caterva_overview_compute(caterva_ctx_t *ctx, struct caterva_overviews_s *overviews,
+                                    caterva_array_t *src, caterva_array_t *dest,
+                                    const int64_t *start, const int64_t *stop) {
+    caterva_overview_job_t job = {0};
+    job.ctx = ctx;
+    job.src = src;
+    job.dest = dest;
+    job.window = caterva_overview_windows[overviews->dtype];
+    job.reducer = overviews->reducer;
+    int64_t ntasks = 1;
+    int64_t src_tile_nitems = 1;
+    for (int i = 0; i < dest->ndim; ++i) {
+        job.start[i] = start[i];
+        job.stop[i] = stop[i];
+        job.chunk_first[i] = start[i] / dest->chunkshape[i];
+        job.chunk_count[i] = (stop[i] - 1) / dest->chunkshape[i] + 1 - job.chunk_first[i];
+        ntasks *= job.chunk_count[i];
+        src_tile_nitems *= 2 * (int64_t) dest->chunkshape[i];
+    }
+
+    int nthreads = ctx->cfg->nthreads < 1 ? 1 : ctx->cfg->nthreads;
+    if (nthreads > ntasks) {
+        nthreads = (int) ntasks;
+    }
+    int rc = CATERVA_SUCCEED;
+    job.dctx = calloc(nthreads, sizeof(blosc2_context *));
+    job.data = calloc(nthreads, sizeof(uint8_t *));
+    job.src_tile = calloc(nthreads, sizeof(uint8_t *));
+    job.dest_tile = calloc(nthreads, sizeof(uint8_t *));
+    if (job.dctx == NULL || job.data == NULL || job.src_tile == NULL || job.dest_tile == NULL) {
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+    for (int t = 0; t < nthreads && rc == CATERVA_SUCCEED; ++t) {
+        job.dctx[t] = caterva_create_thread_dctx(src);
+        job.data[t] = ctx->cfg->alloc(src->extchunknitems * src->itemsize);
+        job.src_tile[t] = ctx->cfg->alloc(src_tile_nitems * src->itemsize);
+        job.dest_tile[t] = ctx->cfg->alloc(dest->chunknitems * dest->itemsize);
+        if (job.dctx[t] == NULL || job.data[t] == NULL || job.src_tile[t] == NULL ||
+            job.dest_tile[t] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_parallel_for(nthreads, ntasks, caterva_overview_task, &job);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (job.dctx != NULL && job.dctx[t] != NULL) {
+            blosc2_free_ctx(job.dctx[t]);
+        }
+        if (job.data != NULL && job.data[t] != NULL) {
+            ctx->cfg->free(job.data[t]);
+        }
+        if (job.src_tile != NULL && job.src_tile[t] != NULL) {
+            ctx->cfg->free(job.src_tile[t]);
+        }
+        if (job.dest_tile != NULL && job.dest_tile[t] != NULL) {
+            ctx->cfg->free(job.dest_tile[t]);
+        }
+    }
+    free(job.dctx);
+    free(job.data);
+    free(job.src_tile);
+    free(job.dest_tile);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+static int caterva_overviews_store(caterva_array_t *array) {
+    struct caterva_overviews_s *overviews = array->overviews;
+
+    // Build an array with 5 entries (version, nlevels, reducer, dtype, stale)
+    uint8_t sdata[CATERVA_OVERVIEWS_HEADER_LEN];
+    sdata[0] = 0x90 + 5;
+    sdata[1] = CATERVA_METALAYER_VERSION;
+    sdata[2] = (uint8_t) overviews->nlevels;
+    sdata[3] = (uint8_t) overviews->reducer;
+    sdata[4] = (uint8_t) overviews->dtype;
+    sdata[5] = overviews->stale ? 0xc3 : 0xc2;
+
+    blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+    int rc;
+    if (blosc2_vlmeta_exists(array->sc, "caterva_overviews") < 0) {
+        rc = blosc2_vlmeta_add(array->sc, "caterva_overviews", sdata, sizeof(sdata), &cparams);
+    } else {
+        rc = blosc2_vlmeta_update(array->sc, "caterva_overviews", sdata, sizeof(sdata), &cparams);
+    }
+    if (rc < 0) {
+        CATERVA_TRACE_ERROR("Error storing the overviews");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Read the number of levels of the overviews stored in a super-chunk (0 if there are none)
+int caterva_overviews_read(blosc2_schunk *sc, struct caterva_overviews_s *overviews) {
+    memset(overviews, 0, sizeof(struct caterva_overviews_s));
+    if (blosc2_vlmeta_exists(sc, "caterva_overviews") < 0) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *sdata;
+    int32_t sdata_len;
+    if (blosc2_vlmeta_get(sc, "caterva_overviews", &sdata, &sdata_len) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    bool valid = sdata_len == CATERVA_OVERVIEWS_HEADER_LEN && sdata[0] == 0x90 + 5 &&
+                 sdata[2] >= 1 && sdata[2] <= CATERVA_OVERVIEWS_MAX_LEVELS &&
+                 sdata[3] <= CATERVA_OVERVIEW_NEAREST && sdata[4] <= CATERVA_FLOAT64;
+    if (valid) {
+        overviews->nlevels = sdata[2];
+        overviews->reducer = (caterva_overview_reducer_t) sdata[3];
+        overviews->dtype = (caterva_dtype_t) sdata[4];
+        overviews->stale = sdata[5] != 0xc2;
+    }
+    free(sdata);
+    if (!valid) {
+        CATERVA_TRACE_ERROR("The overviews are not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_overviews_load(caterva_array_t *array) {
+    struct caterva_overviews_s loaded;
+    CATERVA_ERROR(caterva_overviews_read(array->sc, &loaded));
+    if (loaded.nlevels == 0) {
+        return CATERVA_SUCCEED;
+    }
+    struct caterva_overviews_s *overviews = array->cfg->alloc(sizeof(struct caterva_overviews_s));
+    CATERVA_ERROR_NULL(overviews);
+    *overviews = loaded;
+    overviews->levels = calloc(loaded.nlevels, sizeof(caterva_array_t *));
+    if (overviews->levels == NULL) {
+        array->cfg->free(overviews);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    // The overviews of an array in memory are not stored
+    if (array->sc->storage->urlpath == NULL) {
+        overviews->stale = true;
+    }
+    array->overviews = overviews;
+    return CATERVA_SUCCEED;
+}
+
+// Free the overviews that are opened, keeping the configuration
+static void caterva_overviews_close(caterva_ctx_t *ctx, struct caterva_overviews_s *overviews) {
+    for (int l = 0; l < overviews->nlevels; ++l) {
+        if (overviews->levels[l] != NULL) {
+            caterva_free(ctx, &overviews->levels[l]);
+            overviews->levels[l] = NULL;
+        }
+    }
+}
+
+void caterva_overviews_free(caterva_ctx_t *ctx, caterva_array_t *array) {
+    if (array->overviews == NULL) {
+        return;
+    }
+    caterva_overviews_close(ctx, array->overviews);
+    free(array->overviews->levels);
+    array->cfg->free(array->overviews);
+    array->overviews = NULL;
+}
+
+// The overviews are rebuilt the next time they are got
+int caterva_overviews_invalidate(caterva_array_t *array) {
+    if (array->overviews == NULL || array->overviews->stale) {
+        return CATERVA_SUCCEED;
+    }
+    array->overviews->stale = true;
+    if (array->sc != NULL) {
+        CATERVA_ERROR(caterva_overviews_store(array));
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Open the overviews stored next to the array, or mark them as stale if they can not be opened
+static int caterva_overviews_open(caterva_ctx_t *ctx, caterva_array_t *array) {
+    struct caterva_overviews_s *overviews = array->overviews;
+    if (overviews->stale || overviews->levels[0] != NULL) {
+        return CATERVA_SUCCEED;
+    }
+    char *urlpath = array->sc->storage->urlpath;
+    caterva_array_t *src = array;
+    for (int l = 0; l < overviews->nlevels && urlpath != NULL; ++l) {
+        char *path = caterva_overview_urlpath(urlpath, l + 1);
+        CATERVA_ERROR_NULL(path);
+        caterva_array_t *level = NULL;
+        int rc = caterva_open(ctx, path, &level);
+        free(path);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        overviews->levels[l] = level;
+        bool matches = level->ndim == src->ndim && level->itemsize == src->itemsize;
+        for (int i = 0; i < src->ndim && matches; ++i) {
+            matches = level->shape[i] == (src->shape[i] + 1) / 2;
+        }
+        if (!matches) {
+            break;
+        }
+        src = level;
+    }
+    if (src != array && src == overviews->levels[overviews->nlevels - 1]) {
+        return CATERVA_SUCCEED;
+    }
+    caterva_overviews_close(ctx, overviews);
+    CATERVA_ERROR(caterva_overviews_invalidate(array));
+    return CATERVA_SUCCEED;
+}
+
+// Create the overviews and compute them from the array
+static int caterva_overviews_build(caterva_ctx_t *ctx, caterva_array_t *array) {
+    struct caterva_overviews_s *overviews = array->overviews;
+    caterva_overviews_close(ctx, overviews);
+    // The chunks are read directly from the super-chunk
+    CATERVA_ERROR(append_buffer_flush(array));
+
+    char *urlpath = array->sc->storage->urlpath;
+    caterva_array_t *src = array;
+    for (int l = 0; l < overviews->nlevels; ++l) {
+        caterva_params_t params = {0};
+        params.itemsize = array->itemsize;
+        params.ndim = array->ndim;
+        caterva_storage_t storage = {0};
+        storage.contiguous = array->sc->storage->contiguous;
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        for (int i = 0; i < array->ndim; ++i) {
+            params.shape[i] = (src->shape[i] + 1) / 2;
+            int64_t extent = params.shape[i] > 0 ? params.shape[i] : 1;
+            storage.chunkshape[i] = (int32_t) (array->chunkshape[i] < extent ?
+                                               array->chunkshape[i] : extent);
+            storage.blockshape[i] = array->blockshape[i] < storage.chunkshape[i] ?
+                                    array->blockshape[i] : storage.chunkshape[i];
+        }
+        if (urlpath != NULL) {
+            storage.urlpath = caterva_overview_urlpath(urlpath, l + 1);
+            CATERVA_ERROR_NULL(storage.urlpath);
+            blosc2_remove_urlpath(storage.urlpath);
+        }
+        int rc = caterva_zeros(ctx, &params, &storage, &overviews->levels[l]);
+        free(storage.urlpath);
+        CATERVA_ERROR(rc);
+        caterva_array_t *level = overviews->levels[l];
+        if (level->nitems > 0) {
+            CATERVA_ERROR(caterva_overview_compute(ctx, overviews, src, level, start,
+                                                   level->shape));
+        }
+        src = level;
+    }
+    overviews->stale = false;
+    CATERVA_ERROR(caterva_overviews_store(array));
+    return CATERVA_SUCCEED;
+}
+
+// Update the overviews after a change of the items of the region [start, stop) of the array
+int caterva_overviews_update(caterva_ctx_t *ctx, caterva_array_t *array,
+                             const int64_t *start, const int64_t *stop) {
+    struct caterva_overviews_s *overviews = array->overviews;
+    if (overviews == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    CATERVA_ERROR(caterva_overviews_open(ctx, array));
+    if (overviews->stale) {
+        return CATERVA_SUCCEED;
+    }
+    CATERVA_ERROR(append_buffer_flush(array));
+
+    int64_t level_start[CATERVA_MAX_DIM];
+    int64_t level_stop[CATERVA_MAX_DIM];
+    for (int i = 0; i < array->ndim; ++i) {
+        level_start[i] = start[i];
+        level_stop[i] = stop[i];
+    }
+    caterva_array_t *src = array;
+    for (int l = 0; l < overviews->nlevels; ++l) {
+        bool empty = false;
+        for (int i = 0; i < array->ndim; ++i) {
+            level_start[i] /= 2;
+            level_stop[i] = (level_stop[i] + 1) / 2;
+            empty = empty || level_start[i] >= level_stop[i];
+        }
+        if (empty) {
+            break;
+        }
+        CATERVA_ERROR(caterva_overview_compute(ctx, overviews, src, overviews->levels[l],
+                                               level_start, level_stop));
+        src = overviews->levels[l];
+    }
+    return CATERVA_SUCCEED;
+}
+
+// The overviews of a copy are built the first time they are got
+int caterva_overviews_copy(caterva_array_t *src, caterva_array_t *dest) {
+    struct caterva_overviews_s *overviews = dest->cfg->alloc(sizeof(struct caterva_overviews_s));
+    CATERVA_ERROR_NULL(overviews);
+    *overviews = *src->overviews;
+    overviews->levels = calloc(overviews->nlevels, sizeof(caterva_array_t *));
+    if (overviews->levels == NULL) {
+        dest->cfg->free(overviews);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    overviews->stale = true;
+    dest->overviews = overviews;
+    CATERVA_ERROR(caterva_overviews_store(dest));
+    return CATERVA_SUCCEED;
+}
+
+// Remove the overviews stored next to an array stored in urlpath
+void caterva_overviews_remove(const char *urlpath, int nlevels) {
+    for (int l = 0; l < nlevels; ++l) {
+        char *path = caterva_overview_urlpath(urlpath, l + 1);
+        if (path != NULL) {
+            blosc2_remove_urlpath(path);
+            free(path);
+        }
+    }
+}
+
+int caterva_build_overviews(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                            int nlevels, caterva_overview_reducer_t reducer) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    if (array->ndim < 1 || array->ndim > CATERVA_MAX_DIM) {
+        CATERVA_TRACE_ERROR("The overviews need an array with dimensions");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (nlevels < 1 || nlevels > CATERVA_OVERVIEWS_MAX_LEVELS) {
+        CATERVA_TRACE_ERROR("The number of overviews is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if ((int) reducer < 0 || reducer > CATERVA_OVERVIEW_NEAREST) {
+        CATERVA_TRACE_ERROR("The reducer is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (array->chunk_locks != NULL) {
+        CATERVA_TRACE_ERROR("The overviews can not be combined with the chunk locks");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if ((int) dtype < 0 || dtype > CATERVA_FLOAT64 ||
+        caterva_reduce_kernels[dtype].itemsize != array->itemsize) {
+        CATERVA_TRACE_ERROR("The dtype does not match the itemsize of the array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    // The previous overviews are replaced
+    char *urlpath = array->sc->storage->urlpath;
+    if (array->overviews != NULL) {
+        int old_nlevels = array->overviews->nlevels;
+        caterva_overviews_free(ctx, array);
+        if (urlpath != NULL) {
+            caterva_overviews_remove(urlpath, old_nlevels);
+        }
+    }
+    struct caterva_overviews_s *overviews = array->cfg->alloc(sizeof(struct caterva_overviews_s));
+    CATERVA_ERROR_NULL(overviews);
+    memset(overviews, 0, sizeof(struct caterva_overviews_s));
+    overviews->dtype = dtype;
+    overviews->reducer = reducer;
+    overviews->nlevels = nlevels;
+    overviews->levels = calloc(nlevels, sizeof(caterva_array_t *));
+    if (overviews->levels == NULL) {
+        array->cfg->free(overviews);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    array->overviews = overviews;
+    CATERVA_ERROR(caterva_overviews_build(ctx, array));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_get_overview(caterva_ctx_t *ctx, caterva_array_t *array, int level,
+                         caterva_array_t **overview) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(overview);
+    if (array->overviews == NULL) {
+        CATERVA_TRACE_ERROR("The overviews are not built");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (level < 1 || level > array->overviews->nlevels) {
+        CATERVA_TRACE_ERROR("The level of the overview is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
+    }
+    if (array->ndim < 1) {
+        CATERVA_TRACE_ERROR("The overviews need an array with dimensions");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_ERROR(caterva_overviews_open(ctx, array));
+    if (array->overviews->stale) {
+        CATERVA_ERROR(caterva_overviews_build(ctx, array));
+    }
+    *overview = array->overviews->levels[level - 1];
+    return CATERVA_SUCCEED;
+}
+
+int caterva_remove_overviews(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    if (array->overviews == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    int nlevels = array->overviews->nlevels;
+    caterva_overviews_free(ctx, array);
+    if (array->sc->storage->urlpath != NULL) {
+        caterva_overviews_remove(array->sc->storage->urlpath, nlevels);
+    }
+    if (blosc2_vlmeta_exists(array->sc, "caterva_overviews") >= 0 &&
+        blosc2_vlmeta_delete(array->sc, "caterva_overviews") < 0) {
+        CATERVA_TRACE_ERROR("Error removing the overviews");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
@@ -10,6 +10,17 @@
  */
 #include <caterva_utils.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+#ifdef CATERVA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 
 // copyNdim where N = {2-8} - specializations of copy loops to be used by caterva_copy_buffer
 // since we don't have c++ templates, substitute manual specializations for up to known CATERVA_MAX_DIM (8)
@@ -348,6 +359,385 @@ int caterva_config_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *sc, caterva_co
     cfg->prefilter = ctx->cfg->prefilter;
     cfg->pparams = ctx->cfg->pparams;
     cfg->udbtune = ctx->cfg->udbtune;
+    cfg->postfilter = ctx->cfg->postfilter;
+    cfg->postparams = ctx->cfg->postparams;
+    cfg->memory_budget = ctx->cfg->memory_budget;
+
+    return CATERVA_SUCCEED;
+}
+
+
+// Fallbacks used when the cache sizes can not be detected
+#define CATERVA_L1_DEFAULT (32 * 1024)
+#define CATERVA_L2_DEFAULT (256 * 1024)
+#define CATERVA_L3_DEFAULT (8 * 1024 * 1024)
+
+#if defined(__linux__)
+static int64_t read_sysfs_cache_size(int level) {
+    char path[128];
+    for (int index = 0; index < 8; ++index) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+        FILE *f = fopen(path, "r");
+        if (f == NULL) {
+            break;
+        }
+        int cache_level = 0;
+        int rc = fscanf(f, "%d", &cache_level);
+        fclose(f);
+        if (rc != 1 || cache_level != level) {
+            continue;
+        }
+        // The L1 instruction cache is not interesting for us
+        char type[32] = {0};
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", index);
+        f = fopen(path, "r");
+        if (f != NULL) {
+            rc = fscanf(f, "%31s", type);
+            fclose(f);
+            if (rc == 1 && strcmp(type, "Instruction") == 0) {
+                continue;
+            }
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+        f = fopen(path, "r");
+        if (f == NULL) {
+            continue;
+        }
+        long size = 0;
+        char unit = 0;
+        rc = fscanf(f, "%ld%c", &size, &unit);
+        fclose(f);
+        if (rc < 1) {
+            continue;
+        }
+        if (unit == 'K') {
+            size *= 1024;
+        } else if (unit == 'M') {
+            size *= 1024 * 1024;
+        }
+        return size;
+    }
+    return 0;
+}
+#endif
+
+// The sizes of the L1, L2 and L3 caches, detected once
+static int64_t caterva_cache_sizes[3];
+
+static void caterva_detect_cache_sizes(void) {
+    int64_t sizes[3] = {0};
+#if defined(_WIN32)
+    DWORD len = 0;
+    GetLogicalProcessorInformation(NULL, &len);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = malloc(len);
+    if (info != NULL && GetLogicalProcessorInformation(info, &len)) {
+        for (DWORD i = 0; i < len / sizeof(*info); ++i) {
+            if (info[i].Relationship != RelationCache) {
+                continue;
+            }
+            CACHE_DESCRIPTOR *cache = &info[i].Cache;
+            if (cache->Level >= 1 && cache->Level <= 3 && cache->Type != CacheInstruction &&
+                sizes[cache->Level - 1] == 0) {
+                sizes[cache->Level - 1] = cache->Size;
+            }
+        }
+    }
+    free(info);
+#elif defined(__APPLE__)
+    const char *names[3] = {"hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize"};
+    for (int i = 0; i < 3; ++i) {
+        int64_t value = 0;
+        size_t len = sizeof(value);
+        if (sysctlbyname(names[i], &value, &len, NULL, 0) == 0) {
+            sizes[i] = value;
+        }
+    }
+#elif defined(__linux__)
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    sizes[0] = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    sizes[1] = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    sizes[2] = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    for (int i = 0; i < 3; ++i) {
+        // sysconf returns 0 or -1 in some containers and non-glibc systems
+        if (sizes[i] <= 0) {
+            sizes[i] = read_sysfs_cache_size(i + 1);
+        }
+    }
+#endif
+    if (sizes[0] <= 0) {
+        sizes[0] = CATERVA_L1_DEFAULT;
+    }
+    if (sizes[1] <= 0) {
+        sizes[1] = CATERVA_L2_DEFAULT;
+    }
+    if (sizes[2] <= 0) {
+        sizes[2] = CATERVA_L3_DEFAULT;
+    }
+    for (int i = 0; i < 3; ++i) {
+        caterva_cache_sizes[i] = sizes[i];
+    }
+}
+
+#ifdef CATERVA_HAVE_PTHREAD
+static pthread_once_t caterva_cache_sizes_once = PTHREAD_ONCE_INIT;
+#endif
+
+void caterva_get_cache_sizes(int64_t *l1, int64_t *l2, int64_t *l3) {
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_once(&caterva_cache_sizes_once, caterva_detect_cache_sizes);
+#else
+    if (caterva_cache_sizes[0] == 0) {
+        caterva_detect_cache_sizes();
+    }
+#endif
+
+    if (l1 != NULL) {
+        *l1 = caterva_cache_sizes[0];
+    }
+    if (l2 != NULL) {
+        *l2 = caterva_cache_sizes[1];
+    }
+    if (l3 != NULL) {
+        *l3 = caterva_cache_sizes[2];
+    }
+}
+
+// Pick the dimension to be halved: the largest one, leaving the preferred axes for the end
+static int shape_to_halve(int8_t ndim, const int32_t *shape, const bool *preferred) {
+    int dim = -1;
+    for (int pass = 0; pass < 2 && dim < 0; ++pass) {
+        for (int i = 0; i < ndim; ++i) {
+            if (shape[i] <= 1 || (pass == 0 && preferred[i])) {
+                continue;
+            }
+            if (dim < 0 || shape[i] > shape[dim]) {
+                dim = i;
+            }
+        }
+    }
+    return dim;
+}
+
+// Pick the dimension to be doubled: the shortest one, starting with the preferred axes
+static int shape_to_double(int8_t ndim, const int32_t *shape, const int32_t *maxshape,
+                           const bool *preferred) {
+    int dim = -1;
+    for (int pass = 0; pass < 2 && dim < 0; ++pass) {
+        for (int i = ndim - 1; i >= 0; --i) {
+            if (shape[i] >= maxshape[i] || (pass == 0 && !preferred[i])) {
+                continue;
+            }
+            if (dim < 0 || shape[i] < shape[dim]) {
+                dim = i;
+            }
+        }
+    }
+    return dim;
+}
 
+int caterva_compute_storage_shapes(caterva_params_t *params, caterva_storage_t *storage) {
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+
+    int8_t ndim = params->ndim;
+    bool auto_chunkshape = ndim > 0;
+    bool auto_blockshape = ndim > 0;
+    for (int i = 0; i < ndim; ++i) {
+        auto_chunkshape &= storage->chunkshape[i] == 0;
+        auto_blockshape &= storage->blockshape[i] == 0;
+    }
+    if (!auto_chunkshape && !auto_blockshape) {
+        return CATERVA_SUCCEED;
+    }
+
+    int64_t l1, l2, l3;
+    caterva_get_cache_sizes(&l1, &l2, &l3);
+    // Blocks are the unit of work of the Blosc threads, so they (and their compressed version)
+    // must fit in L2. Compressed chunks are read as a whole, so they should fit in the last level:
+    // the uncompressed target is scaled by the expected compression ratio, up to a limit for the
+    // memory of the decompressed chunks.
+    int64_t block_target = l2 / 2 > l1 ? l2 / 2 : l1;
+    int64_t cratio = storage->cratio > 1 ? storage->cratio : 1;
+    int64_t chunk_target = l3 * cratio;
+    if (chunk_target < 4 * block_target) {
+        chunk_target = 4 * block_target;
+    }
+    if (chunk_target > 256 * 1024 * 1024) {
+        chunk_target = 256 * 1024 * 1024;
+    }
+
+    // Dimensions with 0 items are not chunked
+    int32_t maxshape[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        int64_t extent = auto_chunkshape ? params->shape[i] : storage->chunkshape[i];
+        maxshape[i] = extent > INT32_MAX ? INT32_MAX : (int32_t) extent;
+    }
+
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t blocknbytes = params->itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        blockshape[i] = auto_blockshape ? maxshape[i] : storage->blockshape[i];
+        blocknbytes *= blockshape[i];
+    }
+    if (auto_blockshape) {
+        while (blocknbytes > block_target) {
+            int dim = shape_to_halve(ndim, blockshape, storage->preferred_axes);
+            if (dim < 0) {
+                break;
+            }
+            blocknbytes = blocknbytes / blockshape[dim];
+            blockshape[dim] = (blockshape[dim] + 1) / 2;
+            blocknbytes *= blockshape[dim];
+        }
+    }
+
+    if (auto_chunkshape) {
+        // Chunks are grown as multiples of the blockshape to avoid padding inside them
+        int32_t chunkshape[CATERVA_MAX_DIM];
+        int32_t chunkmaxshape[CATERVA_MAX_DIM];
+        int64_t chunknbytes = params->itemsize;
+        for (int i = 0; i < ndim; ++i) {
+            chunkshape[i] = blockshape[i];
+            if (blockshape[i] == 0) {
+                chunkmaxshape[i] = 0;
+            } else {
+                chunkmaxshape[i] = (int32_t) ((maxshape[i] + blockshape[i] - 1) / blockshape[i] *
+                                              blockshape[i]);
+            }
+            chunknbytes *= chunkshape[i];
+        }
+        bool grown[CATERVA_MAX_DIM] = {0};
+        while (chunknbytes > 0) {
+            int32_t candidate[CATERVA_MAX_DIM];
+            for (int i = 0; i < ndim; ++i) {
+                candidate[i] = grown[i] ? chunkmaxshape[i] : chunkshape[i];
+            }
+            int dim = shape_to_double(ndim, candidate, chunkmaxshape, storage->preferred_axes);
+            if (dim < 0) {
+                break;
+            }
+            int64_t newshape = (int64_t) chunkshape[dim] * 2;
+            if (newshape > chunkmaxshape[dim]) {
+                newshape = chunkmaxshape[dim];
+            }
+            int64_t newnbytes = chunknbytes / chunkshape[dim] * newshape;
+            if (newnbytes > chunk_target) {
+                // Do not try to grow this dimension again
+                grown[dim] = true;
+                continue;
+            }
+            chunknbytes = newnbytes;
+            chunkshape[dim] = (int32_t) newshape;
+        }
+        for (int i = 0; i < ndim; ++i) {
+            storage->chunkshape[i] = chunkshape[i];
+        }
+    }
+    for (int i = 0; i < ndim; ++i) {
+        storage->blockshape[i] = blockshape[i];
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+
+#ifdef CATERVA_HAVE_PTHREAD
+
+static pthread_mutex_t caterva_global_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct {
+    caterva_parallel_fn fn;
+    void *arg;
+    int64_t ntasks;
+    int64_t next_task;
+    int rc;
+    pthread_mutex_t mutex;
+} caterva_parallel_t;
+
+typedef struct {
+    caterva_parallel_t *parallel;
+    int thread;
+} caterva_parallel_thread_t;
+
+static void *caterva_parallel_worker(void *arg) {
+    caterva_parallel_thread_t *thread = (caterva_parallel_thread_t *) arg;
+    caterva_parallel_t *parallel = thread->parallel;
+    while (true) {
+        pthread_mutex_lock(&parallel->mutex);
+        if (parallel->rc != CATERVA_SUCCEED || parallel->next_task == parallel->ntasks) {
+            pthread_mutex_unlock(&parallel->mutex);
+            break;
+        }
+        int64_t task = parallel->next_task++;
+        pthread_mutex_unlock(&parallel->mutex);
+
+        int rc = parallel->fn(parallel->arg, task, thread->thread);
+        if (rc != CATERVA_SUCCEED) {
+            pthread_mutex_lock(&parallel->mutex);
+            if (parallel->rc == CATERVA_SUCCEED) {
+                parallel->rc = rc;
+            }
+            pthread_mutex_unlock(&parallel->mutex);
+            break;
+        }
+    }
+    return NULL;
+}
+
+#endif  // CATERVA_HAVE_PTHREAD
+
+void caterva_parallel_lock(void) {
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_lock(&caterva_global_mutex);
+#endif
+}
+
+void caterva_parallel_unlock(void) {
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_unlock(&caterva_global_mutex);
+#endif
+}
+
+int caterva_parallel_for(int nthreads, int64_t ntasks, caterva_parallel_fn fn, void *arg) {
+#ifdef CATERVA_HAVE_PTHREAD
+    if (nthreads > 1 && ntasks > 1) {
+        caterva_parallel_t parallel;
+        parallel.fn = fn;
+        parallel.arg = arg;
+        parallel.ntasks = ntasks;
+        parallel.next_task = 0;
+        parallel.rc = CATERVA_SUCCEED;
+        pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+        caterva_parallel_thread_t *args = malloc(nthreads * sizeof(caterva_parallel_thread_t));
+        int nstarted = 0;
+        if (threads != NULL && args != NULL && pthread_mutex_init(&parallel.mutex, NULL) == 0) {
+            for (; nstarted < nthreads; ++nstarted) {
+                args[nstarted].parallel = &parallel;
+                args[nstarted].thread = nstarted;
+                if (pthread_create(&threads[nstarted], NULL, caterva_parallel_worker,
+                                   &args[nstarted]) != 0) {
+                    break;
+                }
+            }
+            for (int i = 0; i < nstarted; ++i) {
+                pthread_join(threads[i], NULL);
+            }
+            pthread_mutex_destroy(&parallel.mutex);
+        }
+        free(threads);
+        free(args);
+        // If no thread could be started, fall back to the serial loop
+        if (nstarted > 0) {
+            CATERVA_ERROR(parallel.rc);
+            return CATERVA_SUCCEED;
+        }
+    }
+#else
+    CATERVA_UNUSED_PARAM(nthreads);
+#endif
+    for (int64_t task = 0; task < ntasks; ++task) {
+        CATERVA_ERROR(fn(arg, task, 0));
+    }
     return CATERVA_SUCCEED;
 }
@@ -14,12 +14,132 @@
 
 #include <caterva.h>
 #include <../contribs/c-blosc2/plugins/plugin_utils.h>
+#ifdef CATERVA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+/**
+ * @brief The chunks kept uncompressed by the buffered append mode.
+ *
+ * Only the last chunk along @p axis of each column of chunks can be buffered, so the slots are
+ * indexed by the chunk coordinates in the rest of dimensions (which can not change while the mode
+ * is enabled).
+ */
+struct caterva_append_buffer_s {
+    int8_t axis;
+    //!< The axis along which data is appended.
+    int64_t nslots;
+    //!< The number of chunk columns along @p axis.
+    int64_t *rows;
+    //!< The chunk coordinate along @p axis of each buffered chunk (-1 if the slot is empty).
+    uint8_t **chunks;
+    //!< The uncompressed data of each buffered chunk.
+    int64_t ncommits;
+    //!< The number of buffered chunks compressed since the mode was enabled.
+};
+
+/**
+ * @brief The layout of the chunks in the ring buffer mode.
+ *
+ * The chunks along the first axis are stored in a circular way, so the logical row of chunks
+ * @p i is stored in the physical row `(origin + i) % capacity`. The rows that are not used by
+ * the array are filled with zeros and reused by the appends.
+ */
+struct caterva_ring_s {
+    int64_t origin;
+    //!< The physical row of chunks where the array starts.
+    int64_t capacity;
+    //!< The number of physical rows of chunks in the super-chunk.
+};
+
+struct caterva_stats_s {
+    caterva_dtype_t dtype;
+    //!< The type of the items.
+    int64_t nchunks;
+    //!< The number of chunks with an entry.
+    int64_t nblocks;
+    //!< The number of blocks of each chunk.
+    bool *valid;
+    //!< Whether the entry of each chunk is up to date (the others are recomputed when needed).
+    caterva_stats_t *chunks;
+    //!< The statistics of each chunk.
+    caterva_stats_t *blocks;
+    //!< The statistics of each block, chunk after chunk.
+    bool dirty;
+    //!< Whether the statistics have changed since they were stored.
+};
+
+struct caterva_overviews_s {
+    caterva_dtype_t dtype;
+    //!< The type of the items.
+    caterva_overview_reducer_t reducer;
+    //!< The reduction of the windows.
+    int nlevels;
+    //!< The number of overviews.
+    caterva_array_t **levels;
+    //!< The overview of each level (@p NULL until it is opened or built).
+    bool stale;
+    //!< Whether the overviews must be rebuilt.
+};
+
+/**
+ * @brief The Blosc contexts kept for the reads and writes of an array.
+ *
+ * The reads mask the blocks out in a decompression context taken from a pool instead of the one
+ * of the super-chunk, so that concurrent reads do not race (and the same goes for the compression
+ * contexts of the writes with chunk locks). The contexts are created on demand and every pool
+ * has its own mutex.
+ */
+struct caterva_context_pool_s {
+    int ncontexts;
+    //!< The number of idle contexts.
+    int capacity;
+    //!< The room for contexts in @p contexts.
+    blosc2_context **contexts;
+    //!< The idle contexts.
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_mutex_t mutex;
+    //!< The lock of the idle contexts.
+#endif
+};
+
+#ifdef CATERVA_HAVE_PTHREAD
+/**
+ * @brief The lock of the chunks of the super-chunk of an array.
+ *
+ * The chunks are got from the super-chunk under the read lock, so that the reads of an array do
+ * not wait for each other nor for the reads of other arrays, and they are replaced under the
+ * write lock. Frames decode their index of chunk offsets with the context of the super-chunk, so
+ * the chunks of a frame are got under the write lock too.
+ */
+struct caterva_schunk_lock_s {
+    pthread_rwlock_t rwlock;
+    //!< The reader/writer lock of the chunks.
+};
+#endif
+
+/**
+ * @brief The locks of the chunks in the chunk locks mode.
+ *
+ * The chunk @p n is guarded by the lock `n % nlocks`, so that the locks do not depend on the
+ * shape of the array.
+ */
+struct caterva_chunk_locks_s {
+    int64_t nlocks;
+    //!< The number of locks.
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_rwlock_t *locks;
+    //!< The reader/writer lock of every group of chunks.
+#endif
+    struct caterva_context_pool_s cctx_pool;
+    //!< The compression contexts of the writes.
+};
+
 int caterva_copy_buffer(int8_t ndim,
                         uint8_t itemsize,
                         void *src, const int64_t *src_pad_shape,
@@ -36,6 +156,30 @@ int create_blosc_params(caterva_ctx_t *ctx,
 
 int caterva_config_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *sc, caterva_config_t *cfg);
 
+void caterva_get_cache_sizes(int64_t *l1, int64_t *l2, int64_t *l3);
+
+int caterva_compute_storage_shapes(caterva_params_t *params, caterva_storage_t *storage);
+
+/**
+ * @brief A task run by @ref caterva_parallel_for.
+ *
+ * @p thread is in `[0, nthreads)` and identifies the resources of the calling thread.
+ */
+typedef int (*caterva_parallel_fn)(void *arg, int64_t task, int thread);
+
+/**
+ * @brief Run the tasks `[0, ntasks)` with up to @p nthreads threads (or serially when threads
+ * are not available). The tasks are stopped after the first error, which is returned.
+ */
+int caterva_parallel_for(int nthreads, int64_t ntasks, caterva_parallel_fn fn, void *arg);
+
+/**
+ * @brief Serialize the writes of parallel tasks to a shared array, like the result of a reduction.
+ */
+void caterva_parallel_lock(void);
+
+void caterva_parallel_unlock(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,920 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_internal.h"
+#include "blosc2.h"
+
+
+// Joins
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t **arrays;
+    int64_t narrays;
+    int8_t axis;
+    bool stack;
+    //!< Whether the arrays are stacked along a new axis instead of concatenated.
+    int64_t *offsets;
+    //!< The offset of every array along the axis of the result (@p narrays + 1 entries).
+    bool *reuse;
+    //!< Whether the compressed chunks of every array can be moved to the result.
+    caterva_array_t *dest;
+} caterva_join_job_t;
+
+// The region of an array that corresponds to a region of the result inside it
+static void caterva_join_region(caterva_join_job_t *job, int64_t n, const int64_t *start,
+                                const int64_t *stop, int64_t *array_start, int64_t *array_stop) {
+    int j = 0;
+    for (int i = 0; i < job->dest->ndim; ++i) {
+        if (i == job->axis) {
+            if (job->stack) {
+                continue;
+            }
+            array_start[j] = start[i] - job->offsets[n];
+            array_stop[j] = stop[i] - job->offsets[n];
+        } else {
+            array_start[j] = start[i];
+            array_stop[j] = stop[i];
+        }
+        j++;
+    }
+}
+
+// Whether the chunks of an array can be moved to the result without decompressing them. The
+// chunks kept by the buffered append mode are not compressed yet, so they are read as slices.
+static bool caterva_join_reusable(caterva_join_job_t *job, int64_t n) {
+    caterva_array_t *array = job->arrays[n];
+    caterva_array_t *dest = job->dest;
+    if (job->offsets[n] % dest->chunkshape[job->axis] != 0 || array->sc == NULL ||
+        append_buffer_pending(array)) {
+        return false;
+    }
+    int j = 0;
+    for (int i = 0; i < dest->ndim; ++i) {
+        int32_t chunkshape = 1;
+        int32_t blockshape = 1;
+        if (!job->stack || i != job->axis) {
+            chunkshape = array->chunkshape[j];
+            blockshape = array->blockshape[j];
+            j++;
+        }
+        if (chunkshape != dest->chunkshape[i] || blockshape != dest->blockshape[i]) {
+            return false;
+        }
+    }
+    blosc2_schunk *a = array->sc;
+    blosc2_schunk *b = dest->sc;
+    return a->compcode == b->compcode && a->compcode_meta == b->compcode_meta &&
+           a->clevel == b->clevel && a->typesize == b->typesize &&
+           memcmp(a->filters, b->filters, sizeof(a->filters)) == 0 &&
+           memcmp(a->filters_meta, b->filters_meta, sizeof(a->filters_meta)) == 0;
+}
+
+// Move a compressed chunk of an array to the result
+static int caterva_join_move(caterva_join_job_t *job, int64_t n, int64_t nchunk,
+                             const int64_t *coords) {
+    caterva_array_t *array = job->arrays[n];
+    int64_t array_nchunk = 0;
+    for (int i = 0; i < job->dest->ndim; ++i) {
+        if (i == job->axis) {
+            if (job->stack) {
+                continue;
+            }
+            int64_t coord = coords[i] - job->offsets[n] / job->dest->chunkshape[i];
+            array_nchunk = array_nchunk * (array->extshape[i] / array->chunkshape[i]) + coord;
+        } else {
+            int j = job->stack && i > job->axis ? i - 1 : i;
+            array_nchunk = array_nchunk * (array->extshape[j] / array->chunkshape[j]) + coords[i];
+        }
+    }
+    uint8_t *chunk;
+    bool needs_free;
+    int cbytes = caterva_get_chunk_locked(array, array_nchunk, &chunk, &needs_free);
+    if (cbytes < 0) {
+        CATERVA_TRACE_ERROR("Blosc can not get the chunk");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int64_t rc = blosc2_schunk_update_chunk(job->dest->sc, nchunk, chunk, true);
+    if (needs_free) {
+        free(chunk);
+    }
+    if (rc < 0) {
+        CATERVA_TRACE_ERROR("Blosc can not update the chunk");
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Build a chunk of the result from the parts of the arrays that overlap it
+static int caterva_join_encode(caterva_join_job_t *job, const int64_t *start, const int64_t *stop,
+                               uint8_t *data, uint8_t *part) {
+    caterva_array_t *dest = job->dest;
+    int8_t axis = job->axis;
+    uint8_t itemsize = dest->itemsize;
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t outer = 1;
+    int64_t inner = itemsize;
+    for (int i = 0; i < dest->ndim; ++i) {
+        shape[i] = stop[i] - start[i];
+        if (i < axis) {
+            outer *= shape[i];
+        } else if (i > axis) {
+            inner *= shape[i];
+        }
+    }
+
+    for (int64_t n = 0; n < job->narrays; ++n) {
+        int64_t first = start[axis] > job->offsets[n] ? start[axis] : job->offsets[n];
+        int64_t last = stop[axis] < job->offsets[n + 1] ? stop[axis] : job->offsets[n + 1];
+        if (first >= last) {
+            continue;
+        }
+        int64_t part_start[CATERVA_MAX_DIM];
+        int64_t part_stop[CATERVA_MAX_DIM];
+        int64_t part_shape[CATERVA_MAX_DIM];
+        memcpy(part_start, start, dest->ndim * sizeof(int64_t));
+        memcpy(part_stop, stop, dest->ndim * sizeof(int64_t));
+        part_start[axis] = first;
+        part_stop[axis] = last;
+        int64_t array_start[CATERVA_MAX_DIM];
+        int64_t array_stop[CATERVA_MAX_DIM];
+        caterva_join_region(job, n, part_start, part_stop, array_start, array_stop);
+        caterva_array_t *array = job->arrays[n];
+        int64_t part_nbytes = itemsize;
+        for (int i = 0; i < array->ndim; ++i) {
+            part_shape[i] = array_stop[i] - array_start[i];
+            part_nbytes *= part_shape[i];
+        }
+        CATERVA_ERROR(caterva_get_slice_buffer_filtered(job->ctx, array, array_start, array_stop,
+                                                        part, part_shape, part_nbytes, false));
+        // The part is a range of the axis for every index of the previous axes
+        int64_t length = (last - first) * inner;
+        for (int64_t k = 0; k < outer; ++k) {
+            memcpy(&data[(k * shape[axis] + first - start[axis]) * inner], &part[k * length],
+                   length);
+        }
+    }
+    CATERVA_ERROR(caterva_set_slice_buffer(job->ctx, data, shape, dest->chunknitems * itemsize,
+                                           (int64_t *) start, (int64_t *) stop, dest));
+    return CATERVA_SUCCEED;
+}
+
+// Move or build every chunk of the result
+static int caterva_join_chunks(caterva_join_job_t *job) {
+    caterva_array_t *dest = job->dest;
+    int8_t ndim = dest->ndim;
+    int8_t axis = job->axis;
+    uint8_t *data = job->ctx->cfg->alloc(dest->chunknitems * dest->itemsize);
+    uint8_t *part = job->ctx->cfg->alloc(dest->chunknitems * dest->itemsize);
+    int rc = data == NULL || part == NULL ? CATERVA_ERR_NULL_POINTER : CATERVA_SUCCEED;
+
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t coords[CATERVA_MAX_DIM] = {0};
+    int64_t grid[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        grid[i] = dest->extshape[i] / dest->chunkshape[i];
+    }
+    int64_t nchunk = 0;
+    while (rc == CATERVA_SUCCEED) {
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t stop[CATERVA_MAX_DIM];
+        for (int i = 0; i < ndim; ++i) {
+            start[i] = coords[i] * dest->chunkshape[i];
+            stop[i] = start[i] + dest->chunkshape[i];
+            stop[i] = stop[i] < dest->shape[i] ? stop[i] : dest->shape[i];
+        }
+        // A chunk inside an aligned array is moved, and the ones across arrays are re-encoded
+        int64_t n = 0;
+        while (job->offsets[n + 1] <= start[axis]) {
+            n++;
+        }
+        if (stop[axis] <= job->offsets[n + 1] && job->reuse[n]) {
+            rc = caterva_join_move(job, n, nchunk, coords);
+        } else {
+            rc = caterva_join_encode(job, start, stop, data, part);
+        }
+        nchunk++;
+        if (!caterva_selection_next(ndim, coords, first, grid)) {
+            break;
+        }
+    }
+
+    if (data != NULL) {
+        job->ctx->cfg->free(data);
+    }
+    if (part != NULL) {
+        job->ctx->cfg->free(part);
+    }
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+static int caterva_join(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays,
+                        int8_t axis, bool stack, caterva_storage_t *storage,
+                        caterva_array_t **dest) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(arrays);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(dest);
+    if (narrays < 1) {
+        CATERVA_TRACE_ERROR("There must be at least one array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int64_t n = 0; n < narrays; ++n) {
+        CATERVA_ERROR_NULL(arrays[n]);
+    }
+    caterva_array_t *array = arrays[0];
+    int8_t ndim = (int8_t) (stack ? array->ndim + 1 : array->ndim);
+    if (axis < 0 || axis >= ndim || ndim > CATERVA_MAX_DIM) {
+        CATERVA_TRACE_ERROR("The axis is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int64_t n = 1; n < narrays; ++n) {
+        caterva_array_t *other = arrays[n];
+        bool same = other->ndim == array->ndim && other->itemsize == array->itemsize;
+        for (int i = 0; i < array->ndim && same; ++i) {
+            same = other->shape[i] == array->shape[i] || (!stack && i == axis);
+        }
+        if (!same) {
+            CATERVA_TRACE_ERROR("The arrays must have the same shapes and itemsize");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+    }
+
+    caterva_join_job_t job = {0};
+    job.ctx = ctx;
+    job.arrays = arrays;
+    job.narrays = narrays;
+    job.axis = axis;
+    job.stack = stack;
+    caterva_params_t params = {0};
+    params.itemsize = array->itemsize;
+    params.ndim = ndim;
+    caterva_storage_t dstorage = *storage;
+    bool auto_shapes = true;
+    for (int i = 0; i < ndim; ++i) {
+        auto_shapes = auto_shapes && dstorage.chunkshape[i] == 0;
+    }
+    for (int i = 0, j = 0; i < ndim; ++i) {
+        if (stack && i == axis) {
+            params.shape[i] = narrays;
+            if (auto_shapes) {
+                dstorage.chunkshape[i] = 1;
+                dstorage.blockshape[i] = 1;
+            }
+            continue;
+        }
+        if (i == axis) {
+            params.shape[i] = 0;
+            for (int64_t n = 0; n < narrays; ++n) {
+                params.shape[i] += arrays[n]->shape[j];
+            }
+        } else {
+            params.shape[i] = array->shape[j];
+        }
+        if (auto_shapes) {
+            dstorage.chunkshape[i] = array->chunkshape[j];
+            dstorage.blockshape[i] = array->blockshape[j];
+        }
+        j++;
+    }
+    job.offsets = malloc((narrays + 1) * sizeof(int64_t));
+    job.reuse = malloc(narrays * sizeof(bool));
+    int rc = job.offsets == NULL || job.reuse == NULL ? CATERVA_ERR_NULL_POINTER : CATERVA_SUCCEED;
+    if (rc == CATERVA_SUCCEED) {
+        job.offsets[0] = 0;
+        for (int64_t n = 0; n < narrays; ++n) {
+            job.offsets[n + 1] = job.offsets[n] + (stack ? 1 : arrays[n]->shape[axis]);
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_empty(ctx, &params, &dstorage, &job.dest);
+    }
+    if (rc == CATERVA_SUCCEED && job.dest->nitems > 0) {
+        for (int64_t n = 0; n < narrays; ++n) {
+            job.reuse[n] = caterva_join_reusable(&job, n);
+        }
+        rc = caterva_join_chunks(&job);
+    }
+    free(job.offsets);
+    free(job.reuse);
+    if (rc != CATERVA_SUCCEED) {
+        if (job.dest != NULL) {
+            caterva_free(ctx, &job.dest);
+        }
+        CATERVA_ERROR(rc);
+    }
+    *dest = job.dest;
+    return CATERVA_SUCCEED;
+}
+
+int caterva_concatenate(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays,
+                        int8_t axis, caterva_storage_t *storage, caterva_array_t **dest) {
+    CATERVA_ERROR(caterva_join(ctx, arrays, narrays, axis, false, storage, dest));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_stack(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays, int8_t axis,
+                  caterva_storage_t *storage, caterva_array_t **dest) {
+    CATERVA_ERROR(caterva_join(ctx, arrays, narrays, axis, true, storage, dest));
+    return CATERVA_SUCCEED;
+}
+
+
+// Virtual arrays
+
+static int caterva_virtual_alloc(caterva_ctx_t *ctx, int64_t nsources, caterva_virtual_t **varray) {
+    caterva_virtual_t *v = ctx->cfg->alloc(sizeof(caterva_virtual_t));
+    CATERVA_ERROR_NULL(v);
+    memset(v, 0, sizeof(caterva_virtual_t));
+    v->cfg = ctx->cfg->alloc(sizeof(caterva_config_t));
+    v->nsources = nsources;
+    v->sources = calloc(nsources, sizeof(caterva_array_t *));
+    v->urlpaths = calloc(nsources, sizeof(char *));
+    v->offsets = calloc(nsources + 1, sizeof(int64_t));
+    if (v->cfg == NULL || v->sources == NULL || v->urlpaths == NULL || v->offsets == NULL) {
+        caterva_virtual_free(ctx, &v);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    memcpy(v->cfg, ctx->cfg, sizeof(caterva_config_t));
+    *varray = v;
+    return CATERVA_SUCCEED;
+}
+
+// Get a source of a virtual array, opening it the first time
+static int caterva_virtual_source(caterva_ctx_t *ctx, caterva_virtual_t *varray, int64_t n,
+                                  caterva_array_t **source) {
+    if (varray->sources[n] == NULL) {
+        caterva_array_t *array;
+        CATERVA_ERROR(caterva_open(ctx, varray->urlpaths[n], &array));
+        bool same = array->ndim == varray->ndim && array->itemsize == varray->itemsize;
+        for (int i = 0; i < varray->ndim && same; ++i) {
+            int64_t len = varray->shape[i];
+            if (i == varray->axis) {
+                len = varray->offsets[n + 1] - varray->offsets[n];
+            }
+            same = array->shape[i] == len;
+        }
+        if (!same) {
+            caterva_free(ctx, &array);
+            CATERVA_TRACE_ERROR("The array %s does not match the virtual array",
+                                varray->urlpaths[n]);
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        varray->sources[n] = array;
+    }
+    *source = varray->sources[n];
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_new(caterva_ctx_t *ctx, caterva_array_t **arrays, int64_t narrays,
+                        int8_t axis, caterva_virtual_t **varray) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(arrays);
+    CATERVA_ERROR_NULL(varray);
+    if (narrays < 1) {
+        CATERVA_TRACE_ERROR("There must be at least one array");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int64_t n = 0; n < narrays; ++n) {
+        CATERVA_ERROR_NULL(arrays[n]);
+    }
+    caterva_array_t *array = arrays[0];
+    if (axis < 0 || axis >= array->ndim) {
+        CATERVA_TRACE_ERROR("The axis is not valid");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    for (int64_t n = 1; n < narrays; ++n) {
+        caterva_array_t *other = arrays[n];
+        bool same = other->ndim == array->ndim && other->itemsize == array->itemsize;
+        for (int i = 0; i < array->ndim && same; ++i) {
+            same = other->shape[i] == array->shape[i] || i == axis;
+        }
+        if (!same) {
+            CATERVA_TRACE_ERROR("The arrays must have the same shapes and itemsize");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+    }
+
+    caterva_virtual_t *v;
+    CATERVA_ERROR(caterva_virtual_alloc(ctx, narrays, &v));
+    v->ndim = array->ndim;
+    v->itemsize = array->itemsize;
+    v->axis = axis;
+    for (int i = 0; i < array->ndim; ++i) {
+        v->shape[i] = array->shape[i];
+    }
+    for (int64_t n = 0; n < narrays; ++n) {
+        v->sources[n] = arrays[n];
+        v->offsets[n + 1] = v->offsets[n] + arrays[n]->shape[axis];
+        char *urlpath = arrays[n]->sc->storage->urlpath;
+        if (urlpath != NULL) {
+            v->urlpaths[n] = strdup(urlpath);
+            if (v->urlpaths[n] == NULL) {
+                caterva_virtual_free(ctx, &v);
+                CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+            }
+        }
+    }
+    v->shape[axis] = v->offsets[narrays];
+    v->owned = false;
+    *varray = v;
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_save(caterva_ctx_t *ctx, caterva_virtual_t *varray, const char *urlpath) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    CATERVA_ERROR_NULL(urlpath);
+    int64_t sdata_len = 1 + 1 + 1 + 2 + 1 + (1 + varray->ndim * (1 + sizeof(int64_t))) + 5;
+    for (int64_t n = 0; n < varray->nsources; ++n) {
+        if (varray->urlpaths[n] == NULL || strlen(varray->urlpaths[n]) > UINT16_MAX) {
+            CATERVA_TRACE_ERROR("The sources of a stored virtual array must be persistent");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        sdata_len += 1 + (1 + sizeof(int64_t)) + (1 + sizeof(uint16_t)) +
+                     strlen(varray->urlpaths[n]);
+    }
+    if (sdata_len > INT32_MAX) {
+        CATERVA_TRACE_ERROR("The virtual array has too many sources");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    uint8_t *sdata = malloc(sdata_len);
+    CATERVA_ERROR_NULL(sdata);
+    uint8_t *pdata = sdata;
+
+    // Build an array with 6 entries (version, ndim, itemsize, axis, shape, sources)
+    *pdata++ = 0x90 + 6;
+    *pdata++ = CATERVA_METALAYER_VERSION;
+    *pdata++ = (uint8_t) varray->ndim;
+    *pdata++ = 0xcc;  // uint8
+    *pdata++ = varray->itemsize;
+    *pdata++ = (uint8_t) varray->axis;
+    *pdata++ = (uint8_t) (0x90 + varray->ndim);
+    for (int i = 0; i < varray->ndim; ++i) {
+        *pdata++ = 0xd3;  // int64
+        swap_store(pdata, &varray->shape[i], sizeof(int64_t));
+        pdata += sizeof(int64_t);
+    }
+    // Every source is an array with its length along the axis and its urlpath
+    *pdata++ = 0xdd;  // array 32
+    uint32_t nsources = (uint32_t) varray->nsources;
+    swap_store(pdata, &nsources, sizeof(uint32_t));
+    pdata += sizeof(uint32_t);
+    for (int64_t n = 0; n < varray->nsources; ++n) {
+        *pdata++ = 0x90 + 2;
+        *pdata++ = 0xd3;  // int64
+        int64_t length = varray->offsets[n + 1] - varray->offsets[n];
+        swap_store(pdata, &length, sizeof(int64_t));
+        pdata += sizeof(int64_t);
+        *pdata++ = 0xda;  // str 16
+        uint16_t len = (uint16_t) strlen(varray->urlpaths[n]);
+        swap_store(pdata, &len, sizeof(uint16_t));
+        pdata += sizeof(uint16_t);
+        memcpy(pdata, varray->urlpaths[n], len);
+        pdata += len;
+    }
+
+    blosc2_remove_urlpath(urlpath);
+    blosc2_storage storage = BLOSC2_STORAGE_DEFAULTS;
+    storage.contiguous = true;
+    storage.urlpath = (char *) urlpath;
+    blosc2_schunk *sc = blosc2_schunk_new(&storage);
+    int rc = CATERVA_ERR_BLOSC_FAILED;
+    if (sc != NULL) {
+        blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
+        if (blosc2_vlmeta_add(sc, "caterva_virtual", sdata, (int32_t) (pdata - sdata),
+                              &cparams) >= 0) {
+            rc = CATERVA_SUCCEED;
+        }
+        blosc2_schunk_free(sc);
+    }
+    free(sdata);
+    if (rc != CATERVA_SUCCEED) {
+        CATERVA_TRACE_ERROR("Error storing the virtual array");
+        CATERVA_ERROR(rc);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Parse the description of a virtual array stored by caterva_virtual_save
+static int caterva_virtual_load(caterva_ctx_t *ctx, const uint8_t *sdata, int32_t sdata_len,
+                                caterva_virtual_t **varray) {
+    const uint8_t *pdata = sdata;
+    const uint8_t *end = sdata + sdata_len;
+    if (sdata_len < 7 || pdata[0] != 0x90 + 6 || pdata[3] != 0xcc) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    int8_t ndim = (int8_t) pdata[2];
+    uint8_t itemsize = pdata[4];
+    int8_t axis = (int8_t) pdata[5];
+    pdata += 6;
+    if (ndim < 1 || ndim > CATERVA_MAX_DIM || axis >= ndim || *pdata++ != 0x90 + ndim ||
+        end - pdata < ndim * (1 + (int64_t) sizeof(int64_t)) + 5) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    int64_t shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        pdata += 1;
+        swap_store(&shape[i], pdata, sizeof(int64_t));
+        pdata += sizeof(int64_t);
+    }
+    if (*pdata++ != 0xdd) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    uint32_t nsources;
+    swap_store(&nsources, pdata, sizeof(uint32_t));
+    pdata += sizeof(uint32_t);
+    if (nsources < 1) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    caterva_virtual_t *v;
+    CATERVA_ERROR(caterva_virtual_alloc(ctx, nsources, &v));
+    v->ndim = ndim;
+    v->itemsize = itemsize;
+    v->axis = axis;
+    memcpy(v->shape, shape, ndim * sizeof(int64_t));
+    v->owned = true;
+    int rc = CATERVA_SUCCEED;
+    for (int64_t n = 0; n < nsources && rc == CATERVA_SUCCEED; ++n) {
+        int64_t length;
+        uint16_t len = 0;
+        if (end - pdata < 2 + (int64_t) sizeof(int64_t) + 1 + (int64_t) sizeof(uint16_t)) {
+            rc = CATERVA_ERR_INVALID_ARGUMENT;
+            break;
+        }
+        pdata += 2;
+        swap_store(&length, pdata, sizeof(int64_t));
+        pdata += sizeof(int64_t) + 1;
+        swap_store(&len, pdata, sizeof(uint16_t));
+        pdata += sizeof(uint16_t);
+        if (end - pdata < len || length < 0) {
+            rc = CATERVA_ERR_INVALID_ARGUMENT;
+            break;
+        }
+        v->offsets[n + 1] = v->offsets[n] + length;
+        v->urlpaths[n] = malloc(len + 1);
+        if (v->urlpaths[n] == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+            break;
+        }
+        memcpy(v->urlpaths[n], pdata, len);
+        v->urlpaths[n][len] = '\0';
+        pdata += len;
+    }
+    if (rc == CATERVA_SUCCEED && v->offsets[nsources] != shape[axis]) {
+        rc = CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (rc != CATERVA_SUCCEED) {
+        caterva_virtual_free(ctx, &v);
+        CATERVA_ERROR(rc);
+    }
+    *varray = v;
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_open(caterva_ctx_t *ctx, const char *urlpath, caterva_virtual_t **varray) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(urlpath);
+    CATERVA_ERROR_NULL(varray);
+    blosc2_schunk *sc = blosc2_schunk_open(urlpath);
+    if (sc == NULL) {
+        CATERVA_TRACE_ERROR("Error opening the virtual array %s", urlpath);
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    uint8_t *sdata = NULL;
+    int32_t sdata_len;
+    int rc = CATERVA_ERR_INVALID_ARGUMENT;
+    if (blosc2_vlmeta_exists(sc, "caterva_virtual") >= 0 &&
+        blosc2_vlmeta_get(sc, "caterva_virtual", &sdata, &sdata_len) >= 0) {
+        rc = caterva_virtual_load(ctx, sdata, sdata_len, varray);
+        free(sdata);
+    }
+    blosc2_schunk_free(sc);
+    if (rc != CATERVA_SUCCEED) {
+        CATERVA_TRACE_ERROR("%s is not a virtual array", urlpath);
+        CATERVA_ERROR(rc);
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_free(caterva_ctx_t *ctx, caterva_virtual_t **varray) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    caterva_virtual_t *v = *varray;
+    if (v == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    for (int64_t n = 0; n < v->nsources; ++n) {
+        if (v->owned && v->sources != NULL && v->sources[n] != NULL) {
+            caterva_free(ctx, &v->sources[n]);
+        }
+        if (v->urlpaths != NULL) {
+            free(v->urlpaths[n]);
+        }
+    }
+    free(v->sources);
+    free(v->urlpaths);
+    free(v->offsets);
+    void (*auxfree)(void *) = ctx->cfg->free;
+    if (v->cfg != NULL) {
+        auxfree = v->cfg->free;
+        auxfree(v->cfg);
+    }
+    auxfree(v);
+    *varray = NULL;
+    return CATERVA_SUCCEED;
+}
+
+// Copy the items of a piece read from a source into the buffer. The index j of the piece along
+// the axis is the index pos[j] of the buffer, and the other indexes are the same.
+static void caterva_virtual_scatter(caterva_virtual_t *varray, const uint8_t *piece,
+                                    const int64_t *piece_shape, const int64_t *pos,
+                                    uint8_t *buffer, const int64_t *buffershape) {
+    int8_t ndim = varray->ndim;
+    uint8_t itemsize = varray->itemsize;
+    int64_t strides[CATERVA_MAX_DIM];
+    strides[ndim - 1] = 1;
+    for (int i = ndim - 2; i >= 0; --i) {
+        strides[i] = strides[i + 1] * buffershape[i + 1];
+    }
+    // The rows along the last axis are copied at once, unless the last axis is the joined one
+    int64_t last[CATERVA_MAX_DIM];
+    memcpy(last, piece_shape, ndim * sizeof(int64_t));
+    int64_t row = 1;
+    if (varray->axis != ndim - 1) {
+        row = piece_shape[ndim - 1];
+        last[ndim - 1] = 1;
+    }
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t counter[CATERVA_MAX_DIM] = {0};
+    do {
+        int64_t offset = 0;
+        for (int i = 0; i < ndim; ++i) {
+            offset += (i == varray->axis ? pos[counter[i]] : counter[i]) * strides[i];
+        }
+        memcpy(&buffer[offset * itemsize], piece, row * itemsize);
+        piece += row * itemsize;
+    } while (caterva_selection_next(ndim, counter, first, last));
+}
+
+// Read the selection of every source into the buffer. The slices with a step of 1 are read
+// with caterva_get_slice_buffer and the other selections with caterva_get_selection.
+static int caterva_virtual_read(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                const caterva_selector_t *selectors, uint8_t *buffer,
+                                const int64_t *buffershape, int64_t buffersize) {
+    int8_t ndim = varray->ndim;
+    int8_t axis = varray->axis;
+    int64_t nitems[CATERVA_MAX_DIM];
+    int64_t size = varray->itemsize;
+    bool slices = true;
+    for (int i = 0; i < ndim; ++i) {
+        CATERVA_ERROR(caterva_selector_nitems(varray->shape[i], &selectors[i], &nitems[i]));
+        if (buffershape[i] < nitems[i]) {
+            CATERVA_TRACE_ERROR("The buffer shape can not be smaller than the selection");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+        }
+        size *= buffershape[i];
+        slices = slices && selectors[i].kind == CATERVA_SELECTOR_SLICE &&
+                 (selectors[i].step == 0 || selectors[i].step == 1);
+    }
+    if (buffersize < size) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    int64_t nselected = nitems[axis];
+    for (int i = 0; i < ndim; ++i) {
+        if (nitems[i] == 0) {
+            return CATERVA_SUCCEED;
+        }
+    }
+
+    // The indexes selected along the axis, and the ones of every source with their positions
+    int64_t *indexes = malloc(3 * nselected * sizeof(int64_t));
+    CATERVA_ERROR_NULL(indexes);
+    int64_t *local = indexes + nselected;
+    int64_t *pos = local + nselected;
+    const caterva_selector_t *selector = &selectors[axis];
+    int64_t k = 0;
+    switch (selector->kind) {
+        case CATERVA_SELECTOR_SLICE: {
+            int64_t step = selector->step == 0 ? 1 : selector->step;
+            for (int64_t j = 0; j < nselected; ++j) {
+                indexes[j] = selector->start + j * step;
+            }
+            break;
+        }
+        case CATERVA_SELECTOR_LIST:
+            memcpy(indexes, selector->indexes, nselected * sizeof(int64_t));
+            break;
+        default:
+            for (int64_t j = 0; j < varray->shape[axis]; ++j) {
+                if (selector->mask[j]) {
+                    indexes[k++] = j;
+                }
+            }
+            break;
+    }
+
+    int rc = CATERVA_SUCCEED;
+    for (int64_t n = 0; n < varray->nsources && rc == CATERVA_SUCCEED; ++n) {
+        int64_t count = 0;
+        for (int64_t j = 0; j < nselected; ++j) {
+            if (indexes[j] >= varray->offsets[n] && indexes[j] < varray->offsets[n + 1]) {
+                local[count] = indexes[j] - varray->offsets[n];
+                pos[count] = j;
+                count++;
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        caterva_array_t *source;
+        rc = caterva_virtual_source(ctx, varray, n, &source);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        int64_t piece_shape[CATERVA_MAX_DIM];
+        int64_t piece_size = varray->itemsize;
+        for (int i = 0; i < ndim; ++i) {
+            piece_shape[i] = i == axis ? count : nitems[i];
+            piece_size *= piece_shape[i];
+        }
+        uint8_t *piece = ctx->cfg->alloc(piece_size);
+        if (piece == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+            break;
+        }
+        if (slices) {
+            int64_t start[CATERVA_MAX_DIM];
+            int64_t stop[CATERVA_MAX_DIM];
+            for (int i = 0; i < ndim; ++i) {
+                start[i] = i == axis ? local[0] : selectors[i].start;
+                stop[i] = start[i] + piece_shape[i];
+            }
+            rc = caterva_get_slice_buffer(ctx, source, start, stop, piece, piece_shape,
+                                          piece_size);
+        } else {
+            caterva_selector_t source_selectors[CATERVA_MAX_DIM];
+            memcpy(source_selectors, selectors, ndim * sizeof(caterva_selector_t));
+            caterva_selector_t *source_selector = &source_selectors[axis];
+            memset(source_selector, 0, sizeof(caterva_selector_t));
+            source_selector->kind = CATERVA_SELECTOR_LIST;
+            source_selector->indexes = local;
+            source_selector->nindexes = count;
+            rc = caterva_get_selection(ctx, source, source_selectors, piece, piece_shape,
+                                       piece_size);
+        }
+        if (rc == CATERVA_SUCCEED) {
+            caterva_virtual_scatter(varray, piece, piece_shape, pos, buffer, buffershape);
+        }
+        ctx->cfg->free(piece);
+    }
+    free(indexes);
+    CATERVA_ERROR(rc);
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_get_slice_buffer(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                     int64_t *start, int64_t *stop, void *buffer,
+                                     int64_t *buffershape, int64_t buffersize) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    CATERVA_ERROR_NULL(start);
+    CATERVA_ERROR_NULL(stop);
+    CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR_NULL(buffershape);
+    caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < varray->ndim; ++i) {
+        selectors[i].kind = CATERVA_SELECTOR_SLICE;
+        selectors[i].start = start[i];
+        selectors[i].stop = stop[i];
+        selectors[i].step = 1;
+    }
+    CATERVA_ERROR(caterva_virtual_read(ctx, varray, selectors, buffer, buffershape, buffersize));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_get_selection(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                  const caterva_selector_t *selectors, void *buffer,
+                                  int64_t *buffershape, int64_t buffersize) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    CATERVA_ERROR_NULL(selectors);
+    CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR_NULL(buffershape);
+    CATERVA_ERROR(caterva_virtual_read(ctx, varray, selectors, buffer, buffershape, buffersize));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_get_orthogonal_selection(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                                             int64_t **selection, int64_t *selection_size,
+                                             void *buffer, int64_t *buffershape,
+                                             int64_t buffersize) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    CATERVA_ERROR_NULL(selection);
+    CATERVA_ERROR_NULL(selection_size);
+    CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR_NULL(buffershape);
+    caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < varray->ndim; ++i) {
+        selectors[i].kind = CATERVA_SELECTOR_LIST;
+        selectors[i].indexes = selection[i];
+        selectors[i].nindexes = selection_size[i];
+    }
+    CATERVA_ERROR(caterva_virtual_read(ctx, varray, selectors, buffer, buffershape, buffersize));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_to_buffer(caterva_ctx_t *ctx, caterva_virtual_t *varray, void *buffer,
+                              int64_t buffersize) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    CATERVA_ERROR_NULL(buffer);
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    CATERVA_ERROR(caterva_virtual_get_slice_buffer(ctx, varray, start, varray->shape, buffer,
+                                                   varray->shape, buffersize));
+    return CATERVA_SUCCEED;
+}
+
+int caterva_virtual_get_slice(caterva_ctx_t *ctx, caterva_virtual_t *varray,
+                              const int64_t *start, const int64_t *stop,
+                              caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(varray);
+    CATERVA_ERROR_NULL(start);
+    CATERVA_ERROR_NULL(stop);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+    int8_t ndim = varray->ndim;
+    caterva_params_t params = {0};
+    params.itemsize = varray->itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        if (start[i] < 0 || stop[i] < start[i] || stop[i] > varray->shape[i]) {
+            CATERVA_TRACE_ERROR("The slice is out of bounds");
+            CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
+        }
+        params.shape[i] = stop[i] - start[i];
+    }
+    caterva_array_t *dest;
+    CATERVA_ERROR(caterva_empty(ctx, &params, storage, &dest));
+    if (dest->nitems == 0) {
+        *array = dest;
+        return CATERVA_SUCCEED;
+    }
+
+    uint8_t *data = ctx->cfg->alloc(dest->chunknitems * dest->itemsize);
+    int rc = data == NULL ? CATERVA_ERR_NULL_POINTER : CATERVA_SUCCEED;
+    int64_t first[CATERVA_MAX_DIM] = {0};
+    int64_t coords[CATERVA_MAX_DIM] = {0};
+    int64_t grid[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        grid[i] = dest->extshape[i] / dest->chunkshape[i];
+    }
+    while (rc == CATERVA_SUCCEED) {
+        int64_t chunk_start[CATERVA_MAX_DIM];
+        int64_t chunk_stop[CATERVA_MAX_DIM];
+        int64_t src_start[CATERVA_MAX_DIM];
+        int64_t src_stop[CATERVA_MAX_DIM];
+        int64_t shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < ndim; ++i) {
+            chunk_start[i] = coords[i] * dest->chunkshape[i];
+            chunk_stop[i] = chunk_start[i] + dest->chunkshape[i];
+            chunk_stop[i] = chunk_stop[i] < dest->shape[i] ? chunk_stop[i] : dest->shape[i];
+            src_start[i] = start[i] + chunk_start[i];
+            src_stop[i] = start[i] + chunk_stop[i];
+            shape[i] = chunk_stop[i] - chunk_start[i];
+        }
+        int64_t nbytes = dest->chunknitems * dest->itemsize;
+        rc = caterva_virtual_get_slice_buffer(ctx, varray, src_start, src_stop, data, shape,
+                                              nbytes);
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_set_slice_buffer(ctx, data, shape, nbytes, chunk_start, chunk_stop,
+                                          dest);
+        }
+        if (!caterva_selection_next(ndim, coords, first, grid)) {
+            break;
+        }
+    }
+    if (data != NULL) {
+        ctx->cfg->free(data);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, &dest);
+        CATERVA_ERROR(rc);
+    }
+    *array = dest;
+    return CATERVA_SUCCEED;
+}
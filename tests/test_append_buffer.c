@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#include <caterva_utils.h>
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int8_t axis;
+    int64_t nappends;
+    int64_t rows;
+} test_shapes_t;
+
+
+CUTEST_TEST_DATA(append_buffer) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(append_buffer) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(
+            1,
+            8,
+    ));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, false},
+            {true, true},
+            {false, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, test_shapes_t, CUTEST_DATA(
+            {1, {5}, {8}, {2}, 0, 40, 1},
+            {2, {3, 7}, {10, 4}, {5, 2}, 0, 30, 1},
+            {2, {6, 4}, {6, 5}, {3, 2}, 1, 12, 2},
+            {3, {4, 5, 1}, {3, 4, 7}, {2, 2, 3}, 2, 10, 3},
+    ));
+}
+
+CUTEST_TEST_TEST(append_buffer) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    char *urlpath = "test_append_buffer.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    // The final array is filled with consecutive values
+    int64_t final_shape[CATERVA_MAX_DIM];
+    int64_t final_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        final_shape[i] = shapes.shape[i];
+    }
+    final_shape[shapes.axis] += shapes.nappends * shapes.rows;
+    for (int i = 0; i < params.ndim; ++i) {
+        final_nitems *= final_shape[i];
+    }
+    uint8_t *expected = malloc(final_nitems * itemsize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(expected, itemsize, final_nitems));
+
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        stop[i] = shapes.shape[i];
+    }
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_size = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        slice_shape[i] = stop[i] - start[i];
+        slice_size *= slice_shape[i];
+    }
+    uint8_t *slice = malloc(slice_size);
+    int64_t zeros[CATERVA_MAX_DIM] = {0};
+    caterva_copy_buffer(params.ndim, itemsize, expected, final_shape, zeros, stop,
+                        slice, slice_shape, zeros);
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, slice, slice_size, &params, &storage,
+                                            &src));
+    free(slice);
+    CATERVA_TEST_ASSERT(caterva_enable_append_buffer(data->ctx, src, shapes.axis));
+
+    uint8_t *buffer_dest = malloc(final_nitems * itemsize);
+    for (int n = 0; n < shapes.nappends; ++n) {
+        start[shapes.axis] = stop[shapes.axis];
+        stop[shapes.axis] += shapes.rows;
+        slice_size = itemsize;
+        for (int i = 0; i < params.ndim; ++i) {
+            slice_shape[i] = stop[i] - start[i];
+            slice_size *= slice_shape[i];
+        }
+        slice = malloc(slice_size);
+        caterva_copy_buffer(params.ndim, itemsize, expected, final_shape, start, stop,
+                            slice, slice_shape, zeros);
+        CATERVA_TEST_ASSERT(caterva_append(data->ctx, src, slice, slice_size, shapes.axis));
+        free(slice);
+
+        // The rows still buffered must be visible
+        int64_t nbytes = src->nitems * itemsize;
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, nbytes));
+        int64_t read_start[CATERVA_MAX_DIM] = {0};
+        uint8_t *current = malloc(nbytes);
+        caterva_copy_buffer(params.ndim, itemsize, expected, final_shape, read_start, stop,
+                            current, src->shape, zeros);
+        for (int64_t i = 0; i < nbytes; ++i) {
+            CUTEST_ASSERT("Elements are not equal", current[i] == buffer_dest[i]);
+        }
+
+        // Selections read the buffered chunks in place too
+        caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+        for (int i = 0; i < params.ndim; ++i) {
+            selectors[i].kind = CATERVA_SELECTOR_SLICE;
+            selectors[i].stop = src->shape[i];
+            selectors[i].step = 1;
+        }
+        memset(buffer_dest, 0, nbytes);
+        CATERVA_TEST_ASSERT(caterva_get_selection(data->ctx, src, selectors, buffer_dest,
+                                                  src->shape, nbytes));
+        CUTEST_ASSERT("Elements are not equal", memcmp(current, buffer_dest, nbytes) == 0);
+        free(current);
+    }
+
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shapes are not equal", src->shape[i] == final_shape[i]);
+    }
+
+    // Every chunk touched by the appends is compressed at most once by the buffer, in spite of
+    // the reads in between (a chunk filled by a single append is compressed directly)
+    int64_t first_row = shapes.shape[shapes.axis] / shapes.chunkshape[shapes.axis];
+    int64_t last_row = (final_shape[shapes.axis] - 1) / shapes.chunkshape[shapes.axis];
+    int64_t ncommits = last_row - first_row + 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        if (i != shapes.axis) {
+            ncommits *= src->extshape[i] / src->chunkshape[i];
+        }
+    }
+    CUTEST_ASSERT("Chunks compressed more than once", src->append_buffer->ncommits <= ncommits);
+
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, final_nitems * itemsize));
+    for (int64_t i = 0; i < final_nitems * itemsize; ++i) {
+        CUTEST_ASSERT("Elements are not equal", expected[i] == buffer_dest[i]);
+    }
+
+    // Freeing the array must compress the pending chunks
+    caterva_array_t *dest;
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &dest));
+    } else {
+        caterva_storage_t copy_storage = {0};
+        for (int i = 0; i < params.ndim; ++i) {
+            copy_storage.chunkshape[i] = src->chunkshape[i];
+            copy_storage.blockshape[i] = src->blockshape[i];
+        }
+        CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &copy_storage, &dest));
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    }
+    memset(buffer_dest, 0, final_nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, buffer_dest, final_nitems * itemsize));
+    for (int64_t i = 0; i < final_nitems * itemsize; ++i) {
+        CUTEST_ASSERT("Elements are not equal", expected[i] == buffer_dest[i]);
+    }
+
+    /* Free mallocs */
+    free(expected);
+    free(buffer_dest);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    caterva_remove(data->ctx, urlpath);
+
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(append_buffer) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(append_buffer);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#include <caterva_utils.h>
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    bool preferred_axes[CATERVA_MAX_DIM];
+    int32_t cratio;
+} test_auto_shapes_shapes_t;
+
+
+CUTEST_TEST_DATA(auto_shapes) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(auto_shapes) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(
+            1, 8
+    ));
+    CUTEST_PARAMETRIZE(shapes, test_auto_shapes_shapes_t, CUTEST_DATA(
+            {1, {5}, {0}, 0},
+            {1, {200000}, {0}, 0},
+            {2, {20, 0}, {0}, 0},
+            {2, {1000, 900}, {0}, 0},
+            {2, {1000, 900}, {true, false}, 0},
+            {3, {120, 340, 230}, {false, false, true}, 0},
+            {4, {10, 21, 30, 55}, {0}, 0},
+            {2, {1000, 900}, {0}, 16},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, false},
+    ));
+}
+
+
+CUTEST_TEST_TEST(auto_shapes) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_auto_shapes_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < shapes.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < shapes.ndim; ++i) {
+        storage.preferred_axes[i] = shapes.preferred_axes[i];
+    }
+    storage.cratio = shapes.cratio;
+
+    int64_t buffersize = itemsize;
+    for (int i = 0; i < shapes.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    int64_t l1, l2, l3;
+    caterva_get_cache_sizes(&l1, &l2, &l3);
+    CUTEST_ASSERT("Cache sizes are not valid", l1 > 0 && l2 > 0 && l3 > 0);
+
+    /* Testing */
+    int64_t blocknbytes = itemsize;
+    for (int i = 0; i < shapes.ndim; ++i) {
+        CUTEST_ASSERT("Storage shapes are not updated",
+                      storage.chunkshape[i] == src->chunkshape[i] &&
+                      storage.blockshape[i] == src->blockshape[i]);
+        CUTEST_ASSERT("Blockshape is larger than chunkshape",
+                      src->blockshape[i] <= src->chunkshape[i]);
+        if (shapes.shape[i] == 0) {
+            CUTEST_ASSERT("Empty dimension is chunked", src->chunkshape[i] == 0);
+            continue;
+        }
+        CUTEST_ASSERT("Blockshape is not valid", src->blockshape[i] > 0);
+        CUTEST_ASSERT("Chunkshape is not a multiple of blockshape",
+                      src->chunkshape[i] % src->blockshape[i] == 0);
+        CUTEST_ASSERT("Chunkshape is larger than needed",
+                      src->chunkshape[i] < shapes.shape[i] + src->blockshape[i]);
+        blocknbytes *= src->blockshape[i];
+    }
+    CUTEST_ASSERT("Block does not fit in cache", blocknbytes <= (l2 > 2 * l1 ? l2 : 2 * l1));
+
+    // The expected compression ratio makes the chunks larger, but never smaller
+    int64_t chunknbytes = itemsize;
+    int64_t chunknbytes_plain = itemsize;
+    caterva_storage_t plain = {0};
+    for (int i = 0; i < shapes.ndim; ++i) {
+        plain.preferred_axes[i] = shapes.preferred_axes[i];
+    }
+    CATERVA_TEST_ASSERT(caterva_compute_storage_shapes(&params, &plain));
+    for (int i = 0; i < shapes.ndim; ++i) {
+        chunknbytes *= src->chunkshape[i];
+        chunknbytes_plain *= plain.chunkshape[i];
+    }
+    int64_t cratio = shapes.cratio > 1 ? shapes.cratio : 1;
+    int64_t chunk_limit = l3 * cratio > 2 * l2 ? l3 * cratio : 2 * l2;
+    CUTEST_ASSERT("Compressed chunk does not fit in cache",
+                  chunknbytes <= (chunk_limit > 4 * l1 ? chunk_limit : 4 * l1));
+    CUTEST_ASSERT("Chunk is smaller with a compression ratio", chunknbytes >= chunknbytes_plain);
+    for (int i = 0; i < shapes.ndim; ++i) {
+        // Preferred axes are only cut once the rest can not be reduced
+        if (shapes.preferred_axes[i] && src->blockshape[i] < shapes.shape[i]) {
+            for (int j = 0; j < shapes.ndim; ++j) {
+                if (!shapes.preferred_axes[j]) {
+                    CUTEST_ASSERT("Preferred axis cut first", src->blockshape[j] == 1);
+                }
+            }
+        }
+    }
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    for (int i = 0; i < buffersize; ++i) {
+        CUTEST_ASSERT("Elements are not equals", buffer[i] == buffer_dest[i]);
+    }
+
+    /* Free mallocs */
+    free(buffer);
+    free(buffer_dest);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    return CATERVA_SUCCEED;
+}
+
+
+CUTEST_TEST_TEARDOWN(auto_shapes) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(auto_shapes);
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#ifdef CATERVA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define NWRITERS 3
+#define NREADERS 3
+#define NITERS 8
+
+
+CUTEST_TEST_DATA(chunk_locks) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(chunk_locks) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    // Every column written by a writer crosses several chunks, which it only updates in part
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {2, {20, 16}, {10, 8}, {5, 4}},
+            {3, {9, 12, 6}, {4, 5, 6}, {2, 3, 3}},
+    ));
+}
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    int column;
+    //!< The column of items (along the last axis) written or read by the thread.
+    int rc;
+    //!< CATERVA_SUCCEED, a caterva error or 1 for a wrong item.
+} test_worker_t;
+
+// The region of a column of items along the first axis, at the start of the rest of axes but the
+// last one
+static int64_t test_column(caterva_array_t *array, int column, int64_t *start, int64_t *stop,
+                           int64_t *shape) {
+    int8_t ndim = array->ndim;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = 0;
+        stop[i] = i == 0 ? array->shape[0] : 1;
+    }
+    start[ndim - 1] = column;
+    stop[ndim - 1] = column + 1;
+    for (int i = 0; i < ndim; ++i) {
+        shape[i] = stop[i] - start[i];
+    }
+    return array->shape[0];
+}
+
+// Write the column of the writer again and again, with slices and orthogonal selections
+static void *test_write(void *arg) {
+    test_worker_t *worker = (test_worker_t *) arg;
+    caterva_array_t *array = worker->array;
+    int8_t ndim = array->ndim;
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t n = test_column(array, worker->column, start, stop, shape);
+    int32_t *buffer = malloc(n * sizeof(int32_t));
+    int64_t *indexes = malloc(ndim * n * sizeof(int64_t));
+    worker->rc = CATERVA_SUCCEED;
+
+    for (int iter = 0; iter < NITERS && worker->rc == CATERVA_SUCCEED; ++iter) {
+        for (int64_t k = 0; k < n; ++k) {
+            buffer[k] = worker->column * 1000 + iter + 1;
+        }
+        if (iter % 2 == 0) {
+            worker->rc = caterva_set_slice_buffer(worker->ctx, buffer, shape,
+                                                  n * sizeof(int32_t), start, stop, array);
+            continue;
+        }
+        int64_t *selection[CATERVA_MAX_DIM];
+        for (int i = 0; i < ndim; ++i) {
+            selection[i] = &indexes[i * n];
+            for (int64_t k = 0; k < shape[i]; ++k) {
+                selection[i][k] = start[i] + k;
+            }
+        }
+        worker->rc = caterva_set_orthogonal_selection(worker->ctx, array, selection, shape,
+                                                      buffer, shape, n * sizeof(int32_t));
+    }
+
+    free(indexes);
+    free(buffer);
+    return NULL;
+}
+
+// Read the column of the reader, which must always come from a single write
+static void *test_read(void *arg) {
+    test_worker_t *worker = (test_worker_t *) arg;
+    caterva_array_t *array = worker->array;
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t n = test_column(array, worker->column, start, stop, shape);
+    int32_t *buffer = malloc(n * sizeof(int32_t));
+    worker->rc = CATERVA_SUCCEED;
+
+    for (int iter = 0; iter < 2 * NITERS && worker->rc == CATERVA_SUCCEED; ++iter) {
+        worker->rc = caterva_get_slice_buffer(worker->ctx, array, start, stop, buffer, shape,
+                                              n * sizeof(int32_t));
+        for (int64_t k = 1; k < n && worker->rc == CATERVA_SUCCEED; ++k) {
+            worker->rc = buffer[k] == buffer[0] ? CATERVA_SUCCEED : 1;
+        }
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+CUTEST_TEST_TEST(chunk_locks) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_chunk_locks.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int32_t);
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_zeros(data->ctx, &params, &storage, &array));
+    CATERVA_TEST_ASSERT(caterva_enable_chunk_locks(data->ctx, array));
+
+    // Writers of their own columns, which share chunks, and readers of the same columns
+    test_worker_t workers[NWRITERS + NREADERS];
+    for (int w = 0; w < NWRITERS + NREADERS; ++w) {
+        workers[w].ctx = data->ctx;
+        workers[w].array = array;
+        workers[w].column = w % NWRITERS;
+        workers[w].rc = CATERVA_SUCCEED;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_t threads[NWRITERS + NREADERS];
+    for (int w = 0; w < NWRITERS + NREADERS; ++w) {
+        CUTEST_ASSERT("Can not start the thread",
+                      pthread_create(&threads[w], NULL, w < NWRITERS ? test_write : test_read,
+                                     &workers[w]) == 0);
+    }
+    for (int w = 0; w < NWRITERS + NREADERS; ++w) {
+        pthread_join(threads[w], NULL);
+    }
+#else
+    for (int w = 0; w < NWRITERS + NREADERS; ++w) {
+        if (w < NWRITERS) {
+            test_write(&workers[w]);
+        } else {
+            test_read(&workers[w]);
+        }
+    }
+#endif
+    for (int w = 0; w < NWRITERS + NREADERS; ++w) {
+        CUTEST_ASSERT("A read saw a partial write", workers[w].rc != 1);
+        CATERVA_TEST_ASSERT(workers[w].rc);
+    }
+
+    // No write is lost
+    int32_t *result = malloc(nitems * sizeof(int32_t));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, array, result, nitems * sizeof(int32_t)));
+    for (int64_t k = 0; k < nitems; ++k) {
+        int64_t column = k % shapes.shape[params.ndim - 1];
+        bool written = column < NWRITERS;
+        for (int i = 1; i < params.ndim - 1; ++i) {
+            int64_t stride = 1;
+            for (int j = i + 1; j < params.ndim; ++j) {
+                stride *= shapes.shape[j];
+            }
+            written = written && k / stride % shapes.shape[i] == 0;
+        }
+        int32_t expected = written ? (int32_t) (column * 1000 + NITERS) : 0;
+        CUTEST_ASSERT("Lost write", result[k] == expected);
+    }
+    free(result);
+
+    // The mode can not be combined with the buffered append mode nor with statistics
+    CUTEST_ASSERT("The append buffer must be rejected",
+                  caterva_enable_append_buffer(data->ctx, array, 0) != CATERVA_SUCCEED);
+    CUTEST_ASSERT("The statistics must be rejected",
+                  caterva_enable_stats(data->ctx, array, CATERVA_INT32) != CATERVA_SUCCEED);
+    CATERVA_TEST_ASSERT(caterva_disable_chunk_locks(data->ctx, array));
+    CATERVA_TEST_ASSERT(caterva_enable_stats(data->ctx, array, CATERVA_INT32));
+    CUTEST_ASSERT("The chunk locks must be rejected with statistics",
+                  caterva_enable_chunk_locks(data->ctx, array) != CATERVA_SUCCEED);
+    CATERVA_TEST_ASSERT(caterva_disable_stats(data->ctx, array));
+    CATERVA_TEST_ASSERT(caterva_enable_append_buffer(data->ctx, array, 0));
+    CUTEST_ASSERT("The chunk locks must be rejected",
+                  caterva_enable_chunk_locks(data->ctx, array) != CATERVA_SUCCEED);
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(chunk_locks) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(chunk_locks);
+}
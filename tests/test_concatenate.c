@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define NARRAYS 3
+
+
+CUTEST_TEST_DATA(concatenate) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(concatenate) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(stack, bool, CUTEST_DATA(false, true));
+
+    // Whether the arrays start at a multiple of the chunkshape along the axis
+    CUTEST_PARAMETRIZE(aligned, bool, CUTEST_DATA(true, false));
+
+    // The first or the last axis
+    CUTEST_PARAMETRIZE(last_axis, bool, CUTEST_DATA(false, true));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+CUTEST_TEST_TEST(concatenate) {
+    CUTEST_GET_PARAMETER(stack, bool);
+    CUTEST_GET_PARAMETER(aligned, bool);
+    CUTEST_GET_PARAMETER(last_axis, bool);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_concatenate.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    // The arrays with a different length along the axis when they are concatenated
+    int8_t ndim = shapes.ndim;
+    int8_t axis = (int8_t) (last_axis ? ndim - 1 : 0);
+    int32_t cs = shapes.chunkshape[axis];
+    int64_t lengths[NARRAYS] = {cs, 2 * cs, cs + 1};
+    if (!aligned) {
+        lengths[0] = cs - 1;
+        lengths[1] = cs + 2;
+        lengths[2] = 3;
+    }
+    uint8_t itemsize = sizeof(int32_t);
+    caterva_array_t *arrays[NARRAYS];
+    int32_t *buffers[NARRAYS];
+    int64_t offsets[NARRAYS + 1] = {0};
+    for (int n = 0; n < NARRAYS; ++n) {
+        caterva_params_t params;
+        params.itemsize = itemsize;
+        params.ndim = ndim;
+        int64_t nitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            params.shape[i] = shapes.shape[i];
+            if (!stack && i == axis) {
+                params.shape[i] = lengths[n];
+            }
+            nitems *= params.shape[i];
+        }
+        offsets[n + 1] = offsets[n] + (stack ? 1 : params.shape[axis]);
+        caterva_storage_t storage = {0};
+        for (int i = 0; i < ndim; ++i) {
+            storage.chunkshape[i] = shapes.chunkshape[i];
+            storage.blockshape[i] = shapes.blockshape[i];
+        }
+        // The chunks of the first array are special chunks of zeros, which are not compressed
+        // again to the same bytes
+        buffers[n] = malloc(nitems * itemsize);
+        for (int64_t i = 0; i < nitems; ++i) {
+            buffers[n][i] = n == 0 ? 0 : (int32_t) (n * 100000 + i);
+        }
+        if (n == 0) {
+            CATERVA_TEST_ASSERT(caterva_zeros(data->ctx, &params, &storage, &arrays[n]));
+        } else {
+            CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffers[n], nitems * itemsize,
+                                                    &params, &storage, &arrays[n]));
+        }
+    }
+
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    caterva_array_t *dest;
+    if (stack) {
+        CATERVA_TEST_ASSERT(caterva_stack(data->ctx, arrays, NARRAYS, axis, &storage, &dest));
+    } else {
+        CATERVA_TEST_ASSERT(caterva_concatenate(data->ctx, arrays, NARRAYS, axis, &storage,
+                                                &dest));
+    }
+    CUTEST_ASSERT("Wrong number of dimensions", dest->ndim == (stack ? ndim + 1 : ndim));
+    CUTEST_ASSERT("Wrong length of the axis", dest->shape[axis] == offsets[NARRAYS]);
+
+    int32_t *result = malloc(dest->nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, result, dest->nitems * itemsize));
+    for (int64_t k = 0; k < dest->nitems; ++k) {
+        int64_t coords[CATERVA_MAX_DIM];
+        int64_t rem = k;
+        for (int i = dest->ndim - 1; i >= 0; --i) {
+            coords[i] = rem % dest->shape[i];
+            rem /= dest->shape[i];
+        }
+        int n = 0;
+        while (offsets[n + 1] <= coords[axis]) {
+            n++;
+        }
+        // The index of the item in its array
+        int64_t index = 0;
+        for (int i = 0, j = 0; i < dest->ndim; ++i) {
+            if (stack && i == axis) {
+                continue;
+            }
+            int64_t coord = i == axis ? coords[i] - offsets[n] : coords[i];
+            index = index * arrays[n]->shape[j] + coord;
+            j++;
+        }
+        CUTEST_ASSERT("Wrong item", result[k] == buffers[n][index]);
+    }
+    free(result);
+
+    // The first chunk of an aligned array is moved as it is
+    if (aligned) {
+        uint8_t *chunk;
+        uint8_t *dest_chunk;
+        bool needs_free;
+        bool dest_needs_free;
+        int cbytes = blosc2_schunk_get_chunk(arrays[0]->sc, 0, &chunk, &needs_free);
+        int dest_cbytes = blosc2_schunk_get_chunk(dest->sc, 0, &dest_chunk, &dest_needs_free);
+        CUTEST_ASSERT("The chunk must be moved",
+                      cbytes == dest_cbytes && memcmp(chunk, dest_chunk, cbytes) == 0);
+        if (needs_free) {
+            free(chunk);
+        }
+        if (dest_needs_free) {
+            free(dest_chunk);
+        }
+    }
+
+    // The arrays must have the same shapes except along the axis, which must be valid
+    caterva_array_t *wrong;
+    caterva_storage_t wrong_storage = {0};
+    CUTEST_ASSERT("The axis must be checked",
+                  caterva_concatenate(data->ctx, arrays, NARRAYS, (int8_t) (ndim + 1),
+                                      &wrong_storage, &wrong) != CATERVA_SUCCEED);
+    if (!stack && ndim > 1) {
+        int8_t other = (int8_t) (ndim - 1 - axis);
+        CUTEST_ASSERT("The shapes must be checked",
+                      caterva_stack(data->ctx, arrays, NARRAYS, other, &wrong_storage,
+                                    &wrong) != CATERVA_SUCCEED);
+    }
+
+    for (int n = 0; n < NARRAYS; ++n) {
+        free(buffers[n]);
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &arrays[n]));
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(concatenate) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(concatenate);
+}
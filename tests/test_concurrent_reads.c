@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#ifdef CATERVA_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define NREADERS 4
+#define NITERS 6
+
+
+CUTEST_TEST_DATA(concurrent_reads) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(concurrent_reads) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    // Frames fetch their chunks one read at a time, but still decompress them concurrently
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    int reader;
+    int rc;
+    //!< CATERVA_SUCCEED, a caterva error or 1 for a wrong item.
+} test_reader_t;
+
+// The item at a flat index of the array
+static int32_t test_item(int64_t index) {
+    return (int32_t) (index * 7 + 3);
+}
+
+// Read slices and orthogonal selections that depend on the reader and check their items
+static void *test_read(void *arg) {
+    test_reader_t *reader = (test_reader_t *) arg;
+    caterva_array_t *array = reader->array;
+    int8_t ndim = array->ndim;
+    int32_t *buffer = malloc(array->nitems * sizeof(int32_t));
+    int64_t *indexes = malloc(ndim * array->nitems * sizeof(int64_t));
+    reader->rc = CATERVA_SUCCEED;
+
+    for (int iter = 0; iter < NITERS && reader->rc == CATERVA_SUCCEED; ++iter) {
+        int shift = reader->reader + iter;
+
+        // A slice
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t stop[CATERVA_MAX_DIM];
+        int64_t shape[CATERVA_MAX_DIM];
+        int64_t nitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            start[i] = shift % array->shape[i];
+            stop[i] = array->shape[i] - shift / 2 % (array->shape[i] - start[i]);
+            shape[i] = stop[i] - start[i];
+            nitems *= shape[i];
+        }
+        reader->rc = caterva_get_slice_buffer(reader->ctx, array, start, stop, buffer, shape,
+                                              nitems * sizeof(int32_t));
+        for (int64_t k = 0; k < nitems && reader->rc == CATERVA_SUCCEED; ++k) {
+            int64_t index = 0;
+            int64_t rem = k;
+            int64_t stride = 1;
+            for (int i = ndim - 1; i >= 0; --i) {
+                index += (start[i] + rem % shape[i]) * stride;
+                rem /= shape[i];
+                stride *= array->shape[i];
+            }
+            reader->rc = buffer[k] == test_item(index) ? CATERVA_SUCCEED : 1;
+        }
+        if (reader->rc != CATERVA_SUCCEED) {
+            break;
+        }
+
+        // An orthogonal selection with every few items, backwards
+        int64_t *selection[CATERVA_MAX_DIM];
+        int64_t selection_size[CATERVA_MAX_DIM];
+        nitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            selection[i] = &indexes[i * array->nitems];
+            selection_size[i] = 0;
+            for (int64_t j = array->shape[i] - 1 - shift % 3; j >= 0; j -= 2 + shift % 3) {
+                selection[i][selection_size[i]++] = j;
+            }
+            nitems *= selection_size[i];
+        }
+        reader->rc = caterva_get_orthogonal_selection(reader->ctx, array, selection,
+                                                      selection_size, buffer, selection_size,
+                                                      nitems * sizeof(int32_t));
+        for (int64_t k = 0; k < nitems && reader->rc == CATERVA_SUCCEED; ++k) {
+            int64_t index = 0;
+            int64_t rem = k;
+            int64_t stride = 1;
+            for (int i = ndim - 1; i >= 0; --i) {
+                index += selection[i][rem % selection_size[i]] * stride;
+                rem /= selection_size[i];
+                stride *= array->shape[i];
+            }
+            reader->rc = buffer[k] == test_item(index) ? CATERVA_SUCCEED : 1;
+        }
+    }
+
+    free(indexes);
+    free(buffer);
+    return NULL;
+}
+
+CUTEST_TEST_TEST(concurrent_reads) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_concurrent_reads.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int32_t);
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+    int32_t *buffer = malloc(nitems * sizeof(int32_t));
+    for (int64_t i = 0; i < nitems; ++i) {
+        buffer[i] = test_item(i);
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * sizeof(int32_t), &params,
+                                            &storage, &array));
+
+    // Leave statistics out of date with a write, which the reads must not store
+    CATERVA_TEST_ASSERT(caterva_enable_stats(data->ctx, array, CATERVA_INT32));
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t nwritten = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        stop[i] = shapes.chunkshape[i];
+        shape[i] = stop[i];
+        nwritten *= shape[i];
+    }
+    int32_t *written = malloc(nwritten * sizeof(int32_t));
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, array, start, stop, written, shape,
+                                                 nwritten * sizeof(int32_t)));
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, written, shape,
+                                                 nwritten * sizeof(int32_t), start, stop, array));
+    free(written);
+
+    // Several threads read the same array at once (or one after the other without threads)
+    test_reader_t readers[NREADERS];
+    for (int r = 0; r < NREADERS; ++r) {
+        readers[r].ctx = data->ctx;
+        readers[r].array = array;
+        readers[r].reader = r;
+        readers[r].rc = CATERVA_SUCCEED;
+    }
+#ifdef CATERVA_HAVE_PTHREAD
+    pthread_t threads[NREADERS];
+    for (int r = 0; r < NREADERS; ++r) {
+        CUTEST_ASSERT("Can not start the thread",
+                      pthread_create(&threads[r], NULL, test_read, &readers[r]) == 0);
+    }
+    for (int r = 0; r < NREADERS; ++r) {
+        pthread_join(threads[r], NULL);
+    }
+#else
+    for (int r = 0; r < NREADERS; ++r) {
+        test_read(&readers[r]);
+    }
+#endif
+    for (int r = 0; r < NREADERS; ++r) {
+        CUTEST_ASSERT("Wrong item", readers[r].rc != 1);
+        CATERVA_TEST_ASSERT(readers[r].rc);
+    }
+
+    // The contexts of the reads are kept for the next ones
+    int32_t *result = malloc(nitems * sizeof(int32_t));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, array, result, nitems * sizeof(int32_t)));
+    CUTEST_ASSERT("Wrong items", memcmp(result, buffer, nitems * sizeof(int32_t)) == 0);
+    free(result);
+
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(concurrent_reads) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(concurrent_reads);
+}
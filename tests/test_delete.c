@@ -55,6 +55,8 @@ CUTEST_TEST_SETUP(delete) {
             {2, {18, 12}, {6, 6}, {3, 3}, 1, 0, 6}, // delete at the beginning
             {3, {12, 10, 27}, {3, 5, 9}, {3, 4, 4}, 2, 9, 9}, // delete in the middle
             {4, {10, 10, 5, 30}, {5, 7, 3, 3}, {2, 2, 1, 1}, 3, 12, 9}, // delete in the middle
+            {2, {18, 12}, {6, 5}, {3, 2}, 1, 4, 3}, // delete in the middle (unaligned)
+            {3, {13, 10, 14}, {3, 5, 4}, {2, 4, 4}, 0, 2, 7}, // delete in the middle (unaligned)
 
     ));
 }
@@ -85,106 +87,57 @@ CUTEST_TEST_TEST(delete) {
     }
 
     /* Create caterva_array_t with original data */
-    caterva_array_t *src;
-    uint8_t *value = malloc(itemsize);
-    int8_t fill_value = 1;
-    switch (itemsize) {
-        case 8:
-            ((int64_t *) value)[0] = (int64_t) fill_value;
-            break;
-        case 4:
-            ((int32_t *) value)[0] = (int32_t) fill_value;
-            break;
-        case 2:
-            ((int16_t *) value)[0] = (int16_t) fill_value;
-            break;
-        case 1:
-            ((int8_t *) value)[0] = fill_value;
-            break;
-        default:
-            break;
-    }
-    CATERVA_ERROR(caterva_full(data->ctx, &params, &storage, value, &src));
-
-    int64_t bufferlen = 1;
-    int64_t stop[CATERVA_MAX_DIM];
-    int64_t buffer_shape[CATERVA_MAX_DIM];
+    int64_t nitems = 1;
     for (int i = 0; i < params.ndim; ++i) {
-        if (i != shapes.axis) {
-            bufferlen *= shapes.shape[i];
-            stop[i] = shapes.shape[i];
-            buffer_shape[i] = shapes.shape[i];
-        }
-        else {
-            bufferlen *= shapes.delete_len;
-            stop[i] = shapes.start + shapes.delete_len;
-            buffer_shape[i] = shapes.delete_len;
-        }
+        nitems *= shapes.shape[i];
     }
-    // Set future deleted values to 0
-    int64_t start[CATERVA_MAX_DIM] = {0};
-    start[shapes.axis] = shapes.start;
-    uint8_t *buffer = calloc((size_t) bufferlen, (size_t) itemsize);
-    CATERVA_ERROR(caterva_set_slice_buffer(data->ctx, buffer, buffer_shape, bufferlen * itemsize, start, stop, src));
+    uint8_t *buffer = malloc(nitems * itemsize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, nitems));
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &src));
 
-    CATERVA_ERROR(caterva_delete(data->ctx, src, shapes.axis, shapes.start, shapes.delete_len));
+    CATERVA_TEST_ASSERT(caterva_delete(data->ctx, src, shapes.axis, shapes.start,
+                                       shapes.delete_len));
 
-    int64_t newshape[CATERVA_MAX_DIM] = {0};
-    for (int i = 0; i < shapes.ndim; ++i) {
-        newshape[i] = shapes.shape[i];
+    /* Build the expected items by removing the deleted ones from a copy of the original data */
+    int64_t nrows = 1;
+    for (int i = 0; i < shapes.axis; ++i) {
+        nrows *= shapes.shape[i];
     }
-    newshape[shapes.axis] -= shapes.delete_len;
-
-    // Create aux array to compare values
-    caterva_array_t *aux;
-    caterva_params_t aux_params;
-    aux_params.itemsize = itemsize;
-    aux_params.ndim = shapes.ndim;
-    for (int i = 0; i < aux_params.ndim; ++i) {
-        aux_params.shape[i] = newshape[i];
+    int64_t stride = itemsize;
+    for (int i = shapes.axis + 1; i < shapes.ndim; ++i) {
+        stride *= shapes.shape[i];
     }
-    caterva_storage_t aux_storage = {0};
-    aux_storage.contiguous = backend.contiguous;
-    for (int i = 0; i < params.ndim; ++i) {
-        aux_storage.chunkshape[i] = shapes.chunkshape[i];
-        aux_storage.blockshape[i] = shapes.blockshape[i];
+    int64_t row_len = shapes.shape[shapes.axis] * stride;
+    int64_t head_len = shapes.start * stride;
+    int64_t tail_len = row_len - head_len - shapes.delete_len * stride;
+    int64_t new_row_len = head_len + tail_len;
+    uint8_t *expected = malloc(nrows * new_row_len);
+    for (int64_t row = 0; row < nrows; ++row) {
+        memcpy(&expected[row * new_row_len], &buffer[row * row_len], head_len);
+        memcpy(&expected[row * new_row_len + head_len],
+               &buffer[row * row_len + head_len + shapes.delete_len * stride], tail_len);
     }
-    CATERVA_ERROR(caterva_full(data->ctx, &aux_params, &aux_storage, value, &aux));
 
+    for (int i = 0; i < shapes.ndim; ++i) {
+        int64_t shape = shapes.shape[i] - (i == shapes.axis ? shapes.delete_len : 0);
+        CUTEST_ASSERT("Wrong shape", src->shape[i] == shape);
+    }
+    CUTEST_ASSERT("Wrong number of items", src->nitems * itemsize == nrows * new_row_len);
 
     /* Fill buffer with whole array data */
     uint8_t *src_buffer = data->ctx->cfg->alloc((size_t) (src->nitems * itemsize));
     CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, src_buffer, src->nitems * itemsize));
+    CUTEST_ASSERT("Elements are not equal!",
+                  memcmp(src_buffer, expected, src->nitems * itemsize) == 0);
 
-    for (uint64_t i = 0; i < (uint64_t) src->nitems; ++i) {
-        switch (itemsize) {
-            case 8:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint64_t *) src_buffer)[i] == (uint64_t) fill_value);
-                break;
-            case 4:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint32_t *) src_buffer)[i] == (uint32_t) fill_value);
-                break;
-            case 2:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint16_t *) src_buffer)[i] == (uint16_t) fill_value);
-                break;
-            case 1:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint8_t *) src_buffer)[i] == (uint8_t) fill_value);
-                break;
-            default:
-                CATERVA_TEST_ASSERT(CATERVA_ERR_INVALID_ARGUMENT);
-        }
-    }
     /* Free mallocs */
-    free(value);
     free(buffer);
+    free(expected);
     data->ctx->cfg->free(src_buffer);
 
     CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
-    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &aux));
 
     caterva_remove(data->ctx, urlpath);
 
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(eval) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(eval) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT16,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {20, 14}, {8, 5}, {3, 2}},
+            {3, {12, 10, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+static caterva_array_t *test_array(caterva_ctx_t *ctx, caterva_dtype_t dtype,
+                                   caterva_params_t *params, caterva_storage_t *storage,
+                                   double *values, int64_t nitems, int seed) {
+    uint8_t *buffer = malloc(nitems * params->itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        values[i] = (double) ((i * seed) % 23) - 9;
+        if (dtype == CATERVA_INT16) {
+            int16_t v = (int16_t) values[i];
+            memcpy(&buffer[i * params->itemsize], &v, sizeof(v));
+        } else {
+            memcpy(&buffer[i * params->itemsize], &values[i], sizeof(double));
+        }
+    }
+    caterva_array_t *array = NULL;
+    caterva_from_buffer(ctx, buffer, nitems * params->itemsize, params, storage, &array);
+    free(buffer);
+    return array;
+}
+
+CUTEST_TEST_TEST(eval) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_eval.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    uint8_t itemsize = dtype == CATERVA_INT16 ? 2 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+    double *a_values = malloc(nitems * sizeof(double));
+    double *b_values = malloc(nitems * sizeof(double));
+    caterva_array_t *a = test_array(data->ctx, dtype, &params, &storage, a_values, nitems, 7);
+    caterva_array_t *b = test_array(data->ctx, dtype, &params, &storage, b_values, nitems, 5);
+    CUTEST_ASSERT("Can not create the arrays", a != NULL && b != NULL);
+
+    // (a * b + a) / (b - 3), with a repeated operand
+    caterva_scalar_t three;
+    if (dtype == CATERVA_INT16) {
+        three.i = 3;
+    } else {
+        three.f = 3;
+    }
+    caterva_expr_t ea = {.op = CATERVA_EXPR_ARRAY, .array = a};
+    caterva_expr_t eb = {.op = CATERVA_EXPR_ARRAY, .array = b};
+    caterva_expr_t e3 = {.op = CATERVA_EXPR_SCALAR, .value = three};
+    caterva_expr_t mul = {.op = CATERVA_EXPR_MUL, .left = &ea, .right = &eb};
+    caterva_expr_t add = {.op = CATERVA_EXPR_ADD, .left = &mul, .right = &ea};
+    caterva_expr_t sub = {.op = CATERVA_EXPR_SUB, .left = &eb, .right = &e3};
+    caterva_expr_t div = {.op = CATERVA_EXPR_DIV, .left = &add, .right = &sub};
+
+    caterva_storage_t rstorage = {0};
+    if (backend.persistent) {
+        rstorage.urlpath = urlpath;
+    }
+    rstorage.contiguous = backend.contiguous;
+    caterva_array_t *result;
+    CATERVA_TEST_ASSERT(caterva_eval(data->ctx, &div, dtype, &rstorage, &result));
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Wrong shape", result->shape[i] == shapes.shape[i]);
+        CUTEST_ASSERT("Wrong chunkshape", result->chunkshape[i] == shapes.chunkshape[i]);
+    }
+
+    uint8_t *buffer = malloc(nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, result, buffer, nitems * itemsize));
+    for (int64_t i = 0; i < nitems; ++i) {
+        double x = a_values[i];
+        double y = b_values[i];
+        if (dtype == CATERVA_INT16) {
+            int16_t num = (int16_t) (x * y + x);
+            int16_t den = (int16_t) (y - 3);
+            int16_t expected = den == 0 ? 0 : (int16_t) (num / den);
+            int16_t v;
+            memcpy(&v, &buffer[i * itemsize], sizeof(v));
+            CUTEST_ASSERT("Wrong result", v == expected);
+        } else {
+            double expected = (x * y + x) / (y - 3);
+            double v;
+            memcpy(&v, &buffer[i * itemsize], sizeof(v));
+            CUTEST_ASSERT("Wrong result", v == expected || (v != v && expected != expected));
+        }
+    }
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &result));
+
+    // The arrays must be chunked in the same way
+    caterva_storage_t other_storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        other_storage.chunkshape[i] = shapes.shape[i];
+        other_storage.blockshape[i] = shapes.blockshape[i];
+    }
+    caterva_array_t *c = test_array(data->ctx, dtype, &params, &other_storage, b_values, nitems,
+                                    3);
+    eb.array = c;
+    CUTEST_ASSERT("The chunkshapes must be the same",
+                  caterva_eval(data->ctx, &div, dtype, &rstorage, &result) != CATERVA_SUCCEED);
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &c));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &a));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &b));
+    free(a_values);
+    free(b_values);
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(eval) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(eval);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(from_prefilter) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(from_prefilter) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}},
+            {1, {50}, {20}, {7}},
+            {2, {20, 14}, {8, 5}, {3, 2}},
+            {3, {12, 10, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+// Store the flat index in the array of every item
+static int test_prefilter(caterva_prefilter_params_t *params) {
+    const int64_t *shape = (const int64_t *) params->user_data;
+    if (params->tid < 0 || params->tid >= 2 || params->itemsize != sizeof(int64_t)) {
+        return -1;
+    }
+    int64_t blocknitems = 1;
+    for (int i = 0; i < params->ndim; ++i) {
+        blocknitems *= params->blockshape[i];
+    }
+    if (params->output_size != blocknitems * params->itemsize) {
+        return -1;
+    }
+    int64_t *output = (int64_t *) params->output;
+    for (int64_t k = 0; k < blocknitems; ++k) {
+        int64_t rem = k;
+        int64_t index = 0;
+        int64_t stride = 1;
+        bool inside = true;
+        for (int i = params->ndim - 1; i >= 0; --i) {
+            int64_t coord = rem % params->blockshape[i];
+            rem /= params->blockshape[i];
+            inside = inside && coord < params->block_shape[i];
+            index += (params->block_start[i] + coord) * stride;
+            stride *= shape[i];
+        }
+        output[k] = inside ? index : -1;
+    }
+    return 0;
+}
+
+CUTEST_TEST_TEST(from_prefilter) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_from_prefilter.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_prefilter(data->ctx, &params, &storage, test_prefilter,
+                                               params.shape, &array));
+    int64_t *buffer = malloc(nitems * sizeof(int64_t));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, array, buffer, nitems * sizeof(int64_t)));
+    for (int64_t i = 0; i < nitems; ++i) {
+        CUTEST_ASSERT("Wrong item", buffer[i] == i);
+    }
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(from_prefilter) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(from_prefilter);
+}
@@ -55,6 +55,8 @@ CUTEST_TEST_SETUP(insert) {
             {2, {18, 6}, {6, 6}, {3, 3}, {18, 12}, 1, 0}, // insert at the beginning
             {3, {12, 10, 14}, {3, 5, 9}, {3, 4, 4}, {12, 10, 18}, 2, 9}, // insert in the middle
             {4, {10, 10, 5, 5}, {5, 7, 3, 3}, {2, 2, 1, 1}, {10, 10, 5, 30}, 3, 3}, // insert in the middle
+            {2, {18, 12}, {6, 5}, {3, 2}, {18, 3}, 1, 7}, // insert in the middle (unaligned)
+            {3, {11, 10, 14}, {3, 5, 4}, {2, 4, 4}, {4, 10, 14}, 0, 1}, // insert in the middle (unaligned)
 
     ));
 }
@@ -84,76 +86,63 @@ CUTEST_TEST_TEST(insert) {
         storage.blockshape[i] = shapes.blockshape[i];
     }
 
+    int64_t nitems = 1;
     int64_t buffersize = itemsize;
     for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
         buffersize *= shapes.buffershape[i];
     }
 
-    /* Create caterva_array_t filled with 1 */
+    /* Create caterva_array_t with original data, followed by the items to insert */
+    uint8_t *src_data = malloc(nitems * itemsize + buffersize);
+    CUTEST_ASSERT("Buffer filled incorrectly",
+                  fill_buf(src_data, itemsize, nitems + buffersize / itemsize));
+    uint8_t *buffer = &src_data[nitems * itemsize];
     caterva_array_t *src;
-    uint8_t *value = malloc(itemsize);
-    int8_t fill_value = 1;
-    switch (itemsize) {
-        case 8:
-            ((int64_t *) value)[0] = (int64_t) fill_value;
-            break;
-        case 4:
-            ((int32_t *) value)[0] = (int32_t) fill_value;
-            break;
-        case 2:
-            ((int16_t *) value)[0] = (int16_t) fill_value;
-            break;
-        case 1:
-            ((int8_t *) value)[0] = fill_value;
-            break;
-        default:
-            break;
-    }
-    CATERVA_ERROR(caterva_full(data->ctx, &params, &storage, value, &src));
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, src_data, nitems * itemsize, &params,
+                                            &storage, &src));
 
-    uint8_t *buffer = data->ctx->cfg->alloc(buffersize);
-    fill_buf(buffer, itemsize, buffersize / itemsize);
-    CATERVA_ERROR(caterva_insert(data->ctx, src, buffer, buffersize, shapes.axis, shapes.start));
+    CATERVA_TEST_ASSERT(caterva_insert(data->ctx, src, buffer, buffersize, shapes.axis,
+                                       shapes.start));
 
-    int64_t start[CATERVA_MAX_DIM] = {0};
-    start[shapes.axis] = shapes.start;
-    int64_t stop[CATERVA_MAX_DIM];
-    for (int i = 0; i < shapes.ndim; ++i) {
-        stop[i] = shapes.shape[i];
+    /* Build the expected items by inserting the buffer into a copy of the original data */
+    int64_t nrows = 1;
+    for (int i = 0; i < shapes.axis; ++i) {
+        nrows *= shapes.shape[i];
+    }
+    int64_t stride = itemsize;
+    for (int i = shapes.axis + 1; i < shapes.ndim; ++i) {
+        stride *= shapes.shape[i];
+    }
+    int64_t row_len = shapes.shape[shapes.axis] * stride;
+    int64_t head_len = shapes.start * stride;
+    int64_t insert_len = shapes.buffershape[shapes.axis] * stride;
+    int64_t new_row_len = row_len + insert_len;
+    uint8_t *expected = malloc(nrows * new_row_len);
+    for (int64_t row = 0; row < nrows; ++row) {
+        uint8_t *dest = &expected[row * new_row_len];
+        memcpy(dest, &src_data[row * row_len], head_len);
+        memcpy(dest + head_len, &buffer[row * insert_len], insert_len);
+        memcpy(dest + head_len + insert_len, &src_data[row * row_len + head_len],
+               row_len - head_len);
     }
-    stop[shapes.axis] = shapes.start + shapes.buffershape[shapes.axis];
-
-    /* Fill buffer with a slice from the new chunks */
-    uint8_t *res_buffer = data->ctx->cfg->alloc(buffersize);
-    CATERVA_ERROR(caterva_get_slice_buffer(data->ctx, src, start, stop, res_buffer,
-                                           shapes.buffershape, buffersize));
-
-    for (uint64_t i = 0; i < (uint64_t) buffersize / itemsize; ++i) {
-        switch (itemsize) {
-            case 8:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint64_t *) buffer)[i] == ((uint64_t *) res_buffer)[i]);
-                break;
-            case 4:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint32_t *) buffer)[i] == ((uint32_t *) res_buffer)[i]);
-                break;
-            case 2:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint16_t *) buffer)[i] == ((uint16_t *) res_buffer)[i]);
-                break;
-            case 1:
-                CUTEST_ASSERT("Elements are not equal!",
-                              ((uint8_t *) buffer)[i] == ((uint8_t *) res_buffer)[i]);
-                break;
-            default:
-                CATERVA_TEST_ASSERT(CATERVA_ERR_INVALID_ARGUMENT);
-        }
+
+    for (int i = 0; i < shapes.ndim; ++i) {
+        int64_t shape = shapes.shape[i] + (i == shapes.axis ? shapes.buffershape[i] : 0);
+        CUTEST_ASSERT("Wrong shape", src->shape[i] == shape);
     }
+    CUTEST_ASSERT("Wrong number of items", src->nitems * itemsize == nrows * new_row_len);
+
+    /* Fill buffer with whole array data */
+    uint8_t *src_buffer = data->ctx->cfg->alloc(src->nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, src_buffer, src->nitems * itemsize));
+    CUTEST_ASSERT("Elements are not equal!",
+                  memcmp(src_buffer, expected, src->nitems * itemsize) == 0);
+
     /* Free mallocs */
-    free(value);
-    data->ctx->cfg->free(buffer);
-    data->ctx->cfg->free(res_buffer);
+    free(src_data);
+    free(expected);
+    data->ctx->cfg->free(src_buffer);
 
     CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
     caterva_remove(data->ctx, urlpath);
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int64_t m;
+    int64_t k;
+    int64_t n;
+    int32_t achunkshape[2];
+    int32_t ablockshape[2];
+    int32_t bchunkshape[2];
+    int32_t bblockshape[2];
+} test_matmul_shapes_t;
+
+
+CUTEST_TEST_DATA(matmul) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(matmul) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT8,
+            CATERVA_INT32,
+            CATERVA_UINT64,
+            CATERVA_FLOAT32,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, test_matmul_shapes_t, CUTEST_DATA(
+            {10, 7, 9, {4, 3}, {2, 2}, {3, 5}, {2, 2}},
+            {23, 31, 17, {8, 10}, {3, 4}, {10, 6}, {5, 3}},
+            {13, 20, 11, {13, 20}, {7, 10}, {6, 11}, {6, 4}},
+            {5, 0, 4, {3, 2}, {2, 2}, {2, 3}, {2, 2}},
+    ));
+}
+
+// The value of an integer as an item of dtype
+static void test_store(caterva_dtype_t dtype, uint8_t *dest, int64_t v) {
+    switch (dtype) {
+        case CATERVA_INT8:
+            *(int8_t *) dest = (int8_t) v;
+            break;
+        case CATERVA_INT32:
+            *(int32_t *) dest = (int32_t) v;
+            break;
+        case CATERVA_UINT64:
+            *(uint64_t *) dest = (uint64_t) v;
+            break;
+        case CATERVA_FLOAT32:
+            *(float *) dest = (float) v;
+            break;
+        default:
+            *(double *) dest = (double) v;
+            break;
+    }
+}
+
+CUTEST_TEST_TEST(matmul) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_matmul_shapes_t);
+
+    char *urlpath = "test_matmul.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    uint8_t itemsize = dtype == CATERVA_INT8 ? 1 : dtype == CATERVA_INT32 ? 4 :
+                       dtype == CATERVA_FLOAT32 ? 4 : 8;
+    int64_t m = shapes.m;
+    int64_t k = shapes.k;
+    int64_t n = shapes.n;
+    int64_t *x = malloc((m * k + 1) * sizeof(int64_t));
+    int64_t *y = malloc((k * n + 1) * sizeof(int64_t));
+    uint8_t *abuffer = malloc((m * k + 1) * itemsize);
+    uint8_t *bbuffer = malloc((k * n + 1) * itemsize);
+    for (int64_t i = 0; i < m * k; ++i) {
+        x[i] = (i * 7) % 11 - 5;
+        test_store(dtype, &abuffer[i * itemsize], x[i]);
+    }
+    for (int64_t i = 0; i < k * n; ++i) {
+        y[i] = (i * 5) % 13 - 4;
+        test_store(dtype, &bbuffer[i * itemsize], y[i]);
+    }
+
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = 2;
+    params.shape[0] = m;
+    params.shape[1] = k;
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < 2; ++i) {
+        storage.chunkshape[i] = shapes.achunkshape[i];
+        storage.blockshape[i] = shapes.ablockshape[i];
+    }
+    caterva_array_t *a;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, abuffer, m * k * itemsize, &params,
+                                            &storage, &a));
+    params.shape[0] = k;
+    params.shape[1] = n;
+    for (int i = 0; i < 2; ++i) {
+        storage.chunkshape[i] = shapes.bchunkshape[i];
+        storage.blockshape[i] = shapes.bblockshape[i];
+    }
+    caterva_array_t *b;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, bbuffer, k * n * itemsize, &params,
+                                            &storage, &b));
+
+    // With the chunks of the operands and with other ones
+    uint8_t *result = malloc(m * n * itemsize);
+    uint8_t *expected = malloc(itemsize);
+    for (int auto_shapes = 0; auto_shapes < 2; ++auto_shapes) {
+        caterva_storage_t rstorage = {0};
+        if (backend.persistent) {
+            rstorage.urlpath = urlpath;
+        }
+        rstorage.contiguous = backend.contiguous;
+        if (!auto_shapes) {
+            rstorage.chunkshape[0] = 4;
+            rstorage.chunkshape[1] = 5;
+            rstorage.blockshape[0] = 3;
+            rstorage.blockshape[1] = 2;
+        }
+        caterva_array_t *c;
+        CATERVA_TEST_ASSERT(caterva_matmul(data->ctx, a, b, dtype, &rstorage, &c));
+        CUTEST_ASSERT("Wrong shape", c->shape[0] == m && c->shape[1] == n);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, c, result, m * n * itemsize));
+        for (int64_t i = 0; i < m; ++i) {
+            for (int64_t j = 0; j < n; ++j) {
+                int64_t sum = 0;
+                for (int64_t p = 0; p < k; ++p) {
+                    sum += x[i * k + p] * y[p * n + j];
+                }
+                test_store(dtype, expected, sum);
+                CUTEST_ASSERT("Wrong item", memcmp(&result[(i * n + j) * itemsize], expected,
+                                                   itemsize) == 0);
+            }
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &c));
+        caterva_remove(data->ctx, urlpath);
+    }
+
+    // The inner axes must match
+    caterva_storage_t rstorage = {0};
+    caterva_array_t *c;
+    CUTEST_ASSERT("The shapes must be checked",
+                  caterva_matmul(data->ctx, b, b, dtype, &rstorage, &c) != CATERVA_SUCCEED ||
+                  k == n);
+
+    free(result);
+    free(expected);
+    free(x);
+    free(y);
+    free(abuffer);
+    free(bbuffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &a));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &b));
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(matmul) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(matmul);
+}
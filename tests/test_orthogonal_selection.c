@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+
+#include "test_common.h"
+
+#define MAX_SELECTION 8
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t selection_size[CATERVA_MAX_DIM];
+    int64_t selection[CATERVA_MAX_DIM][MAX_SELECTION];
+} test_selection_t;
+
+
+CUTEST_TEST_DATA(orthogonal_selection) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(orthogonal_selection) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(
+            1,
+            8,
+    ));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(selections, test_selection_t, CUTEST_DATA(
+            {1, {20}, {7}, {3}, {5}, {{19, 0, 3, 4, 5}}}, // runs and unsorted
+            {2, {14, 10}, {8, 5}, {2, 2}, {3, 6}, {{13, 1, 5}, {0, 1, 2, 3, 4, 5}}},
+            {2, {14, 10}, {8, 5}, {2, 2}, {4, 3}, {{7, 8, 7, 2}, {9, 4, 5}}}, // duplicates
+            {3, {12, 10, 14}, {3, 5, 9}, {3, 4, 4}, {2, 3, 7},
+             {{0, 11}, {9, 3, 4}, {2, 3, 4, 5, 6, 7, 13}}},
+            {4, {10, 8, 6, 7}, {4, 4, 3, 3}, {2, 2, 2, 2}, {2, 2, 3, 4},
+             {{9, 0}, {3, 4}, {5, 0, 1}, {6, 0, 1, 2}}},
+    ));
+}
+
+CUTEST_TEST_TEST(orthogonal_selection) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(selections, test_selection_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    char *urlpath = "test_orthogonal_selection.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = selections.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = selections.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = selections.chunkshape[i];
+        storage.blockshape[i] = selections.blockshape[i];
+    }
+
+    int64_t nitems = 1;
+    int64_t sel_nitems = 1;
+    int64_t strides[CATERVA_MAX_DIM];
+    for (int i = params.ndim - 1; i >= 0; --i) {
+        strides[i] = nitems;
+        nitems *= params.shape[i];
+        sel_nitems *= selections.selection_size[i];
+    }
+
+    uint8_t *buffer = data->ctx->cfg->alloc(nitems * itemsize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, nitems));
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &src));
+
+    int64_t *selection[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        selection[i] = selections.selection[i];
+    }
+
+    // Get the selection and compare it with the source buffer
+    uint8_t *selbuffer = data->ctx->cfg->alloc(sel_nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_get_orthogonal_selection(data->ctx, src, selection,
+                                                         selections.selection_size, selbuffer,
+                                                         selections.selection_size,
+                                                         sel_nitems * itemsize));
+    for (int64_t k = 0; k < sel_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += selection[i][rem % selections.selection_size[i]] * strides[i];
+            rem /= selections.selection_size[i];
+        }
+        CUTEST_ASSERT("Elements are not equals!",
+                      memcmp(&selbuffer[k * itemsize], &buffer[index * itemsize], itemsize) == 0);
+    }
+
+    // Set the selection to new values and compare the whole array with the model
+    for (int64_t k = 0; k < sel_nitems * itemsize; ++k) {
+        selbuffer[k] = (uint8_t) (k % 251 + 3);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_orthogonal_selection(data->ctx, src, selection,
+                                                         selections.selection_size, selbuffer,
+                                                         selections.selection_size,
+                                                         sel_nitems * itemsize));
+    for (int64_t k = 0; k < sel_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += selection[i][rem % selections.selection_size[i]] * strides[i];
+            rem /= selections.selection_size[i];
+        }
+        memcpy(&buffer[index * itemsize], &selbuffer[k * itemsize], itemsize);
+    }
+
+    uint8_t *destbuffer = data->ctx->cfg->alloc(nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, destbuffer, nitems * itemsize));
+    CUTEST_ASSERT("Elements are not equals!",
+                  memcmp(destbuffer, buffer, nitems * itemsize) == 0);
+
+    /* Free mallocs */
+    data->ctx->cfg->free(buffer);
+    data->ctx->cfg->free(selbuffer);
+    data->ctx->cfg->free(destbuffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    caterva_remove(data->ctx, urlpath);
+
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(orthogonal_selection) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(orthogonal_selection);
+}
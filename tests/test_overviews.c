@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva_utils.h>
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(overviews) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(overviews) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT16,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(reducer, caterva_overview_reducer_t, CUTEST_DATA(
+            CATERVA_OVERVIEW_MEAN,
+            CATERVA_OVERVIEW_MAX,
+            CATERVA_OVERVIEW_NEAREST,
+    ));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+            {false, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+static double test_load(caterva_dtype_t dtype, const uint8_t *src) {
+    if (dtype == CATERVA_INT16) {
+        int16_t v;
+        memcpy(&v, src, sizeof(v));
+        return v;
+    }
+    double v;
+    memcpy(&v, src, sizeof(v));
+    return v;
+}
+
+static void test_store(caterva_dtype_t dtype, uint8_t *dest, double v) {
+    int16_t i16 = (int16_t) v;
+    if (dtype == CATERVA_INT16) {
+        memcpy(dest, &i16, sizeof(i16));
+    } else {
+        memcpy(dest, &v, sizeof(v));
+    }
+}
+
+// Reduce the windows of 2 items along every axis of values, as the overviews do
+static double *test_reduce(caterva_dtype_t dtype, caterva_overview_reducer_t reducer,
+                           int8_t ndim, const int64_t *shape, const double *values,
+                           int64_t *reduced_shape) {
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        reduced_shape[i] = (shape[i] + 1) / 2;
+        nitems *= reduced_shape[i];
+    }
+    double *reduced = malloc(nitems * sizeof(double));
+    for (int64_t k = 0; k < nitems; ++k) {
+        int64_t origin[CATERVA_MAX_DIM];
+        int64_t rem = k;
+        for (int i = ndim - 1; i >= 0; --i) {
+            origin[i] = 2 * (rem % reduced_shape[i]);
+            rem /= reduced_shape[i];
+        }
+        double sum = 0;
+        double max = 0;
+        int n = 0;
+        for (int corner = 0; corner < (1 << ndim); ++corner) {
+            int64_t index = 0;
+            bool inside = true;
+            for (int i = 0; i < ndim; ++i) {
+                int64_t coord = origin[i] + ((corner >> (ndim - 1 - i)) & 1);
+                inside = inside && coord < shape[i];
+                index = index * shape[i] + coord;
+            }
+            if (!inside) {
+                continue;
+            }
+            double v = values[index];
+            max = n == 0 || v > max ? v : max;
+            sum += v;
+            n++;
+        }
+        if (reducer == CATERVA_OVERVIEW_MEAN) {
+            // The integer means are truncated
+            reduced[k] = dtype == CATERVA_INT16 ? (double) ((int64_t) sum / n) : sum / n;
+        } else if (reducer == CATERVA_OVERVIEW_MAX) {
+            reduced[k] = max;
+        } else {
+            int64_t index = 0;
+            for (int i = 0; i < ndim; ++i) {
+                index = index * shape[i] + origin[i];
+            }
+            reduced[k] = values[index];
+        }
+    }
+    return reduced;
+}
+
+// Compare every overview with the chained reductions of values
+static int test_check(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                      caterva_overview_reducer_t reducer, int nlevels, const double *values) {
+    int8_t ndim = array->ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        shape[i] = array->shape[i];
+    }
+    double *level_values = NULL;
+    const double *src = values;
+    for (int level = 1; level <= nlevels; ++level) {
+        int64_t reduced_shape[CATERVA_MAX_DIM];
+        double *reduced = test_reduce(dtype, reducer, ndim, shape, src, reduced_shape);
+        free(level_values);
+        level_values = reduced;
+        src = reduced;
+
+        caterva_array_t *overview;
+        CATERVA_TEST_ASSERT(caterva_get_overview(ctx, array, level, &overview));
+        int64_t nitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            CUTEST_ASSERT("Wrong shape of an overview", overview->shape[i] == reduced_shape[i]);
+            shape[i] = reduced_shape[i];
+            nitems *= shape[i];
+        }
+        uint8_t *buffer = malloc(nitems * array->itemsize);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, overview, buffer, nitems * array->itemsize));
+        for (int64_t k = 0; k < nitems; ++k) {
+            double v = test_load(dtype, &buffer[k * array->itemsize]);
+            CUTEST_ASSERT("Wrong item of an overview", v == level_values[k]);
+        }
+        free(buffer);
+    }
+    free(level_values);
+    return 0;
+}
+
+CUTEST_TEST_TEST(overviews) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(reducer, caterva_overview_reducer_t);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_overviews.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    uint8_t itemsize = dtype == CATERVA_INT16 ? 2 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    double *values = malloc(nitems * sizeof(double));
+    uint8_t *buffer = malloc(nitems * itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        values[i] = (double) ((i * 7919) % 101) - 37;
+        test_store(dtype, &buffer[i * itemsize], values[i]);
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &array));
+    caterva_array_t *overview;
+    CUTEST_ASSERT("The overviews must not be built",
+                  caterva_get_overview(data->ctx, array, 1, &overview) != CATERVA_SUCCEED);
+    int nlevels = 3;
+    CATERVA_TEST_ASSERT(caterva_build_overviews(data->ctx, array, dtype, nlevels, reducer));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, reducer, nlevels, values));
+    CUTEST_ASSERT("The level must be valid",
+                  caterva_get_overview(data->ctx, array, nlevels + 1, &overview) != CATERVA_SUCCEED);
+
+    // A slice updates the overviews incrementally
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = 1;
+        stop[i] = shapes.shape[i] / 2 + 1;
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    for (int64_t k = 0; k < slice_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        int64_t stride = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += (start[i] + rem % slice_shape[i]) * stride;
+            rem /= slice_shape[i];
+            stride *= shapes.shape[i];
+        }
+        values[index] = (double) (1000 + k % 1000);
+        test_store(dtype, &buffer[k * itemsize], values[index]);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, buffer, slice_shape,
+                                                 slice_nitems * itemsize, start, stop, array));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, reducer, nlevels, values));
+
+    // And so does an orthogonal selection with the last item of every axis
+    int64_t last[CATERVA_MAX_DIM];
+    int64_t *selection[CATERVA_MAX_DIM];
+    int64_t selection_size[CATERVA_MAX_DIM];
+    int64_t index = 0;
+    for (int i = 0; i < params.ndim; ++i) {
+        last[i] = shapes.shape[i] - 1;
+        selection[i] = &last[i];
+        selection_size[i] = 1;
+        index = index * shapes.shape[i] + last[i];
+    }
+    values[index] = 5000;
+    test_store(dtype, buffer, values[index]);
+    CATERVA_TEST_ASSERT(caterva_set_orthogonal_selection(data->ctx, array, selection,
+                                                         selection_size, buffer, selection_size,
+                                                         itemsize));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, reducer, nlevels, values));
+
+    // The overviews are kept with the array
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &array));
+        CUTEST_ASSERT("The overviews must be loaded", array->overviews != NULL);
+        CUTEST_ASSERT("The overviews must not be stale", !array->overviews->stale);
+        CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, reducer, nlevels, values));
+    }
+    caterva_storage_t copy_storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        copy_storage.chunkshape[i] = shapes.chunkshape[i];
+        copy_storage.blockshape[i] = shapes.blockshape[i];
+    }
+    caterva_array_t *copy;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, array, &copy_storage, &copy));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, copy, dtype, reducer, nlevels, values));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &copy));
+
+    // A resize rebuilds the overviews
+    int64_t new_shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        new_shape[i] = shapes.shape[i];
+    }
+    new_shape[0] -= 1;
+    CATERVA_TEST_ASSERT(caterva_resize(data->ctx, array, new_shape, NULL));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, reducer, nlevels, values));
+
+    CATERVA_TEST_ASSERT(caterva_remove_overviews(data->ctx, array));
+    CUTEST_ASSERT("The overviews must be removed",
+                  caterva_get_overview(data->ctx, array, 1, &overview) != CATERVA_SUCCEED);
+
+    free(values);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(overviews) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(overviews);
+}
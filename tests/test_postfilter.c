@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+typedef struct {
+    int64_t shape[CATERVA_MAX_DIM];
+    //!< The shape of the array, to check the coordinates of the blocks.
+    bool fail;
+    //!< Whether the postfilter fails.
+} test_postparams_t;
+
+CUTEST_TEST_DATA(postfilter) {
+    caterva_ctx_t *ctx;
+    caterva_ctx_t *filter_ctx;
+    test_postparams_t postparams;
+};
+
+
+// Check that every item is its flat index in the array and multiply it by three
+static int test_postfilter(caterva_postfilter_params_t *params) {
+    test_postparams_t *postparams = (test_postparams_t *) params->user_data;
+    const int64_t *input = (const int64_t *) params->input;
+    int64_t *output = (int64_t *) params->output;
+    int64_t blocknitems = params->size / params->itemsize;
+    if (postparams->fail) {
+        return -1;
+    }
+    for (int64_t k = 0; k < blocknitems; ++k) {
+        int64_t rem = k;
+        int64_t index = 0;
+        int64_t stride = 1;
+        bool inside = true;
+        for (int i = params->ndim - 1; i >= 0; --i) {
+            int64_t coord = rem % params->blockshape[i];
+            rem /= params->blockshape[i];
+            inside = inside && coord < params->block_shape[i];
+            index += (params->block_start[i] + coord) * stride;
+            stride *= postparams->shape[i];
+        }
+        if (inside && input[k] != index) {
+            return -1;
+        }
+        output[k] = input[k] * 3;
+    }
+    return 0;
+}
+
+CUTEST_TEST_SETUP(postfilter) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+    cfg.postfilter = test_postfilter;
+    cfg.postparams = &data->postparams;
+    data->postparams.fail = false;
+    caterva_ctx_new(&cfg, &data->filter_ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}},
+            {1, {50}, {20}, {7}},
+            {2, {20, 14}, {8, 5}, {3, 2}},
+            {3, {12, 10, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+// Check that the items of a buffer with the items of the array are their flat index by factor
+static int test_check(const int64_t *buffer, int64_t nitems, int64_t factor) {
+    for (int64_t i = 0; i < nitems; ++i) {
+        CUTEST_ASSERT("Wrong item", buffer[i] == i * factor);
+    }
+    return 0;
+}
+
+// Get a selection of the whole array
+static int test_get_selection(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *buffer,
+                              int64_t *nitems) {
+    caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+    int64_t shape[CATERVA_MAX_DIM] = {0};
+    *nitems = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        selectors[i].kind = CATERVA_SELECTOR_SLICE;
+        selectors[i].start = 0;
+        selectors[i].stop = array->shape[i];
+        selectors[i].step = 1;
+        shape[i] = array->shape[i];
+        *nitems *= shape[i];
+    }
+    return caterva_get_selection(ctx, array, selectors, buffer, shape,
+                                 *nitems * sizeof(int64_t));
+}
+
+// Check a selection of the whole array, whose items are their flat index by factor
+static int test_check_selection(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *buffer,
+                                int64_t factor) {
+    int64_t nitems;
+    CATERVA_TEST_ASSERT(test_get_selection(ctx, array, buffer, &nitems));
+    return test_check(buffer, nitems, factor);
+}
+
+CUTEST_TEST_TEST(postfilter) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_postfilter.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    // The array grows by a chunk along the first axis
+    int64_t row_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        data->postparams.shape[i] = shapes.shape[i];
+        row_nitems *= i > 0 ? shapes.shape[i] : 1;
+    }
+    int64_t nitems = row_nitems * (params.ndim > 0 ? shapes.shape[0] : 1);
+    int64_t maxnitems = nitems + (params.ndim > 0 ? row_nitems * shapes.chunkshape[0] : 0);
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    int64_t *values = malloc(maxnitems * sizeof(int64_t));
+    for (int64_t i = 0; i < maxnitems; ++i) {
+        values[i] = i;
+    }
+    int64_t *buffer = malloc(maxnitems * sizeof(int64_t));
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, values, nitems * sizeof(int64_t), &params,
+                                            &storage, &array));
+
+    // The whole array and a slice
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->filter_ctx, array, buffer,
+                                          nitems * sizeof(int64_t)));
+    CATERVA_TEST_ASSERT(test_check(buffer, nitems, 3));
+    CATERVA_TEST_ASSERT(test_check_selection(data->filter_ctx, array, buffer, 3));
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.shape[i] / 3;
+        stop[i] = shapes.shape[i];
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->filter_ctx, array, start, stop, buffer,
+                                                 slice_shape, slice_nitems * sizeof(int64_t)));
+    for (int64_t k = 0; k < slice_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        int64_t stride = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += (start[i] + rem % slice_shape[i]) * stride;
+            rem /= slice_shape[i];
+            stride *= shapes.shape[i];
+        }
+        CUTEST_ASSERT("Wrong item in the slice", buffer[k] == index * 3);
+    }
+
+    // A failed postfilter fails the read (and releases its resources)
+    data->postparams.fail = true;
+    CUTEST_ASSERT("The read must fail",
+                  caterva_get_slice_buffer(data->filter_ctx, array, start, stop, buffer,
+                                           slice_shape, slice_nitems * sizeof(int64_t)) !=
+                  CATERVA_SUCCEED);
+    int64_t sel_nitems;
+    CUTEST_ASSERT("The selection must fail",
+                  test_get_selection(data->filter_ctx, array, buffer, &sel_nitems) !=
+                  CATERVA_SUCCEED);
+    data->postparams.fail = false;
+
+    // Writes and copies keep the stored items
+    for (int64_t k = 0; k < slice_nitems; ++k) {
+        buffer[k] /= 3;
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->filter_ctx, buffer, slice_shape,
+                                                 slice_nitems * sizeof(int64_t), start, stop,
+                                                 array));
+    caterva_storage_t copy_storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        copy_storage.chunkshape[i] = shapes.chunkshape[i];
+        copy_storage.blockshape[i] = shapes.blockshape[i];
+    }
+    caterva_array_t *copy;
+    CATERVA_TEST_ASSERT(caterva_copy(data->filter_ctx, array, &copy_storage, &copy));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, copy, buffer, nitems * sizeof(int64_t)));
+    CATERVA_TEST_ASSERT(test_check(buffer, nitems, 1));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &copy));
+
+    // The chunks kept uncompressed by the buffered append mode
+    if (params.ndim > 0) {
+        CATERVA_TEST_ASSERT(caterva_enable_append_buffer(data->ctx, array, 0));
+        CATERVA_TEST_ASSERT(caterva_append(data->ctx, array, &values[nitems],
+                                           (maxnitems - nitems) * sizeof(int64_t), 0));
+        data->postparams.shape[0] = array->shape[0];
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->filter_ctx, array, buffer,
+                                              maxnitems * sizeof(int64_t)));
+        CATERVA_TEST_ASSERT(test_check(buffer, maxnitems, 3));
+        CATERVA_TEST_ASSERT(test_check_selection(data->filter_ctx, array, buffer, 3));
+    }
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    free(buffer);
+    free(values);
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(postfilter) {
+    caterva_ctx_free(&data->ctx);
+    caterva_ctx_free(&data->filter_ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(postfilter);
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <math.h>
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(reduce) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(reduce) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT16,
+            CATERVA_UINT32,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(op, caterva_reduce_op_t, CUTEST_DATA(
+            CATERVA_REDUCE_SUM,
+            CATERVA_REDUCE_MIN,
+            CATERVA_REDUCE_MAX,
+            CATERVA_REDUCE_MEAN,
+            CATERVA_REDUCE_STD,
+            CATERVA_REDUCE_ARGMIN,
+            CATERVA_REDUCE_ARGMAX,
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {20, 14}, {8, 5}, {3, 2}},
+            {3, {12, 10, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+// A deterministic value with negative numbers, repetitions and a unique extreme
+static double test_value(caterva_dtype_t dtype, int64_t i) {
+    double v = (double) ((i * 7919) % 101) - 37;
+    if (dtype == CATERVA_UINT32) {
+        v += 37;
+    }
+    if (dtype == CATERVA_FLOAT64) {
+        v /= 4;
+    }
+    return v;
+}
+
+static void test_store(caterva_dtype_t dtype, uint8_t *dest, double v) {
+    int16_t i16 = (int16_t) v;
+    uint32_t u32 = (uint32_t) v;
+    switch (dtype) {
+        case CATERVA_INT16:
+            memcpy(dest, &i16, sizeof(i16));
+            break;
+        case CATERVA_UINT32:
+            memcpy(dest, &u32, sizeof(u32));
+            break;
+        default:
+            memcpy(dest, &v, sizeof(v));
+    }
+}
+
+static double test_load(caterva_dtype_t dtype, caterva_reduce_op_t op, const uint8_t *src) {
+    int16_t i16;
+    uint32_t u32;
+    int64_t i64;
+    uint64_t u64;
+    double f64;
+    if (op == CATERVA_REDUCE_ARGMIN || op == CATERVA_REDUCE_ARGMAX) {
+        memcpy(&i64, src, sizeof(i64));
+        return (double) i64;
+    }
+    if (op == CATERVA_REDUCE_MEAN || op == CATERVA_REDUCE_STD || dtype == CATERVA_FLOAT64) {
+        memcpy(&f64, src, sizeof(f64));
+        return f64;
+    }
+    if (op == CATERVA_REDUCE_SUM) {
+        if (dtype == CATERVA_INT16) {
+            memcpy(&i64, src, sizeof(i64));
+            return (double) i64;
+        }
+        memcpy(&u64, src, sizeof(u64));
+        return (double) u64;
+    }
+    if (dtype == CATERVA_INT16) {
+        memcpy(&i16, src, sizeof(i16));
+        return i16;
+    }
+    memcpy(&u32, src, sizeof(u32));
+    return u32;
+}
+
+// Reduce the items from start every stride, n times
+static double test_reduce(caterva_reduce_op_t op, const double *values, int64_t start,
+                          int64_t stride, int64_t n, bool flat) {
+    double sum = 0;
+    double best = values[start];
+    int64_t arg = 0;
+    for (int64_t j = 0; j < n; ++j) {
+        double v = values[start + j * stride];
+        sum += v;
+        if ((op == CATERVA_REDUCE_MIN || op == CATERVA_REDUCE_ARGMIN) ? v < best : v > best) {
+            best = v;
+            arg = j;
+        }
+    }
+    double mean = sum / (double) n;
+    double m2 = 0;
+    for (int64_t j = 0; j < n; ++j) {
+        double d = values[start + j * stride] - mean;
+        m2 += d * d;
+    }
+    switch (op) {
+        case CATERVA_REDUCE_SUM:
+            return sum;
+        case CATERVA_REDUCE_MIN:
+        case CATERVA_REDUCE_MAX:
+            return best;
+        case CATERVA_REDUCE_MEAN:
+            return mean;
+        case CATERVA_REDUCE_STD:
+            return sqrt(m2 / (double) n);
+        default:
+            return flat ? (double) (start + arg * stride) : (double) arg;
+    }
+}
+
+CUTEST_TEST_TEST(reduce) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(op, caterva_reduce_op_t);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    uint8_t itemsize = dtype == CATERVA_INT16 ? 2 : (dtype == CATERVA_UINT32 ? 4 : 8);
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    int64_t strides[CATERVA_MAX_DIM];
+    for (int i = params.ndim - 1; i >= 0; --i) {
+        params.shape[i] = shapes.shape[i];
+        strides[i] = nitems;
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    double *values = malloc(nitems * sizeof(double));
+    uint8_t *buffer = malloc(nitems * itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        values[i] = test_value(dtype, i);
+        test_store(dtype, &buffer[i * itemsize], values[i]);
+    }
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &src));
+
+    // Whole array
+    caterva_storage_t rstorage = {0};
+    caterva_array_t *res;
+    uint8_t value[8];
+    CATERVA_TEST_ASSERT(caterva_reduce(data->ctx, src, dtype, op, -1, &rstorage, &res));
+    CUTEST_ASSERT("The result must have 0 dimensions", res->ndim == 0);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, res, value, res->itemsize));
+    double expected = test_reduce(op, values, 0, 1, nitems, true);
+    CUTEST_ASSERT("Wrong reduction of the array",
+                  fabs(test_load(dtype, op, value) - expected) <= 1e-9 * (1 + fabs(expected)));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &res));
+
+    // Every axis
+    for (int8_t axis = 0; axis < params.ndim && params.ndim > 1; ++axis) {
+        CATERVA_TEST_ASSERT(caterva_reduce(data->ctx, src, dtype, op, axis, &rstorage, &res));
+        CUTEST_ASSERT("Wrong number of dimensions", res->ndim == params.ndim - 1);
+        uint8_t *rbuffer = malloc(res->nitems * res->itemsize);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, res, rbuffer,
+                                              res->nitems * res->itemsize));
+        for (int64_t k = 0; k < res->nitems; ++k) {
+            // The first item reduced into k
+            int64_t start = 0;
+            int64_t rem = k;
+            for (int i = params.ndim - 1; i >= 0; --i) {
+                if (i == axis) {
+                    continue;
+                }
+                start += rem % params.shape[i] * strides[i];
+                rem /= params.shape[i];
+            }
+            expected = test_reduce(op, values, start, strides[axis], params.shape[axis], false);
+            double actual = test_load(dtype, op, &rbuffer[k * res->itemsize]);
+            CUTEST_ASSERT("Wrong reduction along an axis",
+                          fabs(actual - expected) <= 1e-9 * (1 + fabs(expected)));
+        }
+        free(rbuffer);
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &res));
+    }
+
+    free(values);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(reduce) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(reduce);
+}
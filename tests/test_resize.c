@@ -62,7 +62,8 @@ CUTEST_TEST_SETUP(resize_shape) {
             {2, {50, 50}, {25, 13}, {8, 8}, {49, 51}, false, {49, 50}}, // shrink and extend
             {2, {143, 41}, {18, 13}, {7, 7}, {50, 50}, false, {50, 41}}, // shrink and extend
             {4, {10, 10, 5, 5}, {5, 7, 3, 3}, {2, 2, 1, 1}, {11, 20, 2, 2}, false, {10, 10, 2, 2}}, // shrink and extend
-
+            {2, {40, 30}, {5, 6}, {5, 3}, {40, 42}, true, {40, 12}}, // extend inner dim only - start
+            {2, {40, 30}, {5, 6}, {5, 3}, {40, 18}, true, {40, 6}}, // shrink inner dim only - start
     ));
 }
 
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t append_rows;
+    int64_t delete_rows;
+} test_shapes_t;
+
+// The item (row, col) of the (infinite) series has the value row * ncols + col
+static int check_window(caterva_ctx_t *ctx, caterva_array_t *array, int64_t first_row) {
+    int64_t nitems = array->nitems;
+    int64_t ncols = array->nitems / array->shape[0];
+    int64_t *buffer = malloc(nitems * sizeof(int64_t));
+    CATERVA_ERROR(caterva_to_buffer(ctx, array, buffer, nitems * sizeof(int64_t)));
+    for (int64_t i = 0; i < nitems; ++i) {
+        if (buffer[i] != first_row * ncols + i) {
+            free(buffer);
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+    free(buffer);
+    return CATERVA_SUCCEED;
+}
+
+static int append_rows(caterva_ctx_t *ctx, caterva_array_t *array, int64_t first_row,
+                       int64_t nrows) {
+    int64_t ncols = array->nitems / array->shape[0];
+    int64_t *buffer = malloc(nrows * ncols * sizeof(int64_t));
+    for (int64_t i = 0; i < nrows * ncols; ++i) {
+        buffer[i] = first_row * ncols + i;
+    }
+    CATERVA_ERROR(caterva_append(ctx, array, buffer, nrows * ncols * sizeof(int64_t), 0));
+    free(buffer);
+    return CATERVA_SUCCEED;
+}
+
+
+CUTEST_TEST_DATA(ring_buffer) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(ring_buffer) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, false},
+            {true, true},
+            {false, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, test_shapes_t, CUTEST_DATA(
+            {1, {20}, {5}, {2}, 5, 5},
+            {2, {12, 7}, {4, 3}, {2, 2}, 4, 4},
+            {2, {12, 7}, {4, 3}, {2, 2}, 5, 4},
+            {3, {10, 4, 5}, {2, 3, 5}, {1, 2, 2}, 7, 6},
+    ));
+}
+
+CUTEST_TEST_TEST(ring_buffer) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_shapes_t);
+
+    char *urlpath = "test_ring_buffer.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= params.shape[i];
+    }
+    int64_t *buffer = malloc(nitems * sizeof(int64_t));
+    for (int64_t i = 0; i < nitems; ++i) {
+        buffer[i] = i;
+    }
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * sizeof(int64_t), &params,
+                                            &storage, &src));
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_enable_ring_buffer(data->ctx, src));
+
+    // Keep a rolling window of the series
+    int64_t first_row = 0;
+    int64_t last_row = shapes.shape[0];
+    int64_t max_nchunks = 0;
+    for (int n = 0; n < 12; ++n) {
+        CATERVA_TEST_ASSERT(append_rows(data->ctx, src, last_row, shapes.append_rows));
+        last_row += shapes.append_rows;
+        CATERVA_TEST_ASSERT(check_window(data->ctx, src, first_row));
+        if (max_nchunks == 0) {
+            max_nchunks = src->sc->nchunks;
+        }
+        CATERVA_TEST_ASSERT(caterva_delete(data->ctx, src, 0, 0, shapes.delete_rows));
+        first_row += shapes.delete_rows;
+        CUTEST_ASSERT("Shape is not correct", src->shape[0] == last_row - first_row);
+        CATERVA_TEST_ASSERT(check_window(data->ctx, src, first_row));
+    }
+    if (shapes.append_rows == shapes.delete_rows) {
+        CUTEST_ASSERT("The freed chunks are not reused", src->sc->nchunks == max_nchunks);
+    }
+
+    // The layout must survive a reopening or a copy
+    caterva_array_t *dest;
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+        CUTEST_ASSERT("Ring buffer mode is not persistent", src->ring != NULL);
+        CATERVA_TEST_ASSERT(check_window(data->ctx, src, first_row));
+    }
+    caterva_storage_t copy_storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        copy_storage.chunkshape[i] = src->chunkshape[i];
+        copy_storage.blockshape[i] = src->blockshape[i] == 1 ? 1 : src->blockshape[i] - 1;
+    }
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &copy_storage, &dest));
+    CATERVA_TEST_ASSERT(check_window(data->ctx, dest, first_row));
+    CATERVA_TEST_ASSERT(caterva_delete(data->ctx, dest, 0, 0, shapes.chunkshape[0]));
+    CATERVA_TEST_ASSERT(check_window(data->ctx, dest, first_row + shapes.chunkshape[0]));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    // Unaligned operations rearrange the chunks
+    CATERVA_TEST_ASSERT(append_rows(data->ctx, src, last_row, 1));
+    CATERVA_TEST_ASSERT(caterva_delete(data->ctx, src, 0, src->shape[0] - 1, 1));
+    CATERVA_TEST_ASSERT(check_window(data->ctx, src, first_row));
+    CATERVA_TEST_ASSERT(caterva_disable_ring_buffer(data->ctx, src));
+    CATERVA_TEST_ASSERT(check_window(data->ctx, src, first_row));
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    caterva_remove(data->ctx, urlpath);
+
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(ring_buffer) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(ring_buffer);
+}
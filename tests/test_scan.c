@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(scan) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(scan) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT8,
+            CATERVA_INT32,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(op, caterva_scan_op_t, CUTEST_DATA(
+            CATERVA_SCAN_SUM,
+            CATERVA_SCAN_PROD,
+    ));
+
+    // The first or the last axis
+    CUTEST_PARAMETRIZE(last_axis, bool, CUTEST_DATA(false, true));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+// The result of an operation with the type of the items, for integer values
+static double test_op(caterva_dtype_t dtype, caterva_scan_op_t op, double a, double b) {
+    double v = op == CATERVA_SCAN_SUM ? a + b : a * b;
+    if (dtype == CATERVA_INT8) {
+        return (double) (int8_t) (int64_t) v;
+    }
+    if (dtype == CATERVA_INT32) {
+        return (double) (int32_t) (int64_t) v;
+    }
+    return v;
+}
+
+static double test_load(caterva_dtype_t dtype, const uint8_t *src) {
+    if (dtype == CATERVA_INT8) {
+        return (double) *(const int8_t *) src;
+    }
+    if (dtype == CATERVA_INT32) {
+        return (double) *(const int32_t *) src;
+    }
+    return *(const double *) src;
+}
+
+CUTEST_TEST_TEST(scan) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(op, caterva_scan_op_t);
+    CUTEST_GET_PARAMETER(last_axis, bool);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_scan.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    int8_t ndim = shapes.ndim;
+    int8_t axis = (int8_t) (last_axis ? ndim - 1 : 0);
+    uint8_t itemsize = dtype == CATERVA_INT8 ? 1 : dtype == CATERVA_INT32 ? 4 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    // Values in {-1, 1, 2, 3}, so that the products do not vanish
+    double *values = malloc(nitems * sizeof(double));
+    uint8_t *buffer = malloc(nitems * itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        int64_t v = (i * 7) % 4;
+        values[i] = v == 0 ? -1 : (double) v;
+        if (dtype == CATERVA_INT8) {
+            ((int8_t *) buffer)[i] = (int8_t) values[i];
+        } else if (dtype == CATERVA_INT32) {
+            ((int32_t *) buffer)[i] = (int32_t) values[i];
+        } else {
+            ((double *) buffer)[i] = values[i];
+        }
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &array));
+
+    caterva_storage_t rstorage = {0};
+    if (backend.persistent) {
+        rstorage.urlpath = urlpath;
+    }
+    rstorage.contiguous = backend.contiguous;
+    caterva_array_t *result;
+    CATERVA_TEST_ASSERT(caterva_scan(data->ctx, array, dtype, op, axis, &rstorage, &result));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, result, buffer, nitems * itemsize));
+
+    // The items are scanned in C order, so the previous item along the axis is already scanned
+    int64_t stride = 1;
+    for (int i = ndim - 1; i > axis; --i) {
+        stride *= shapes.shape[i];
+    }
+    for (int64_t k = 0; k < nitems; ++k) {
+        if (k / stride % shapes.shape[axis] != 0) {
+            values[k] = test_op(dtype, op, values[k - stride], values[k]);
+        }
+        CUTEST_ASSERT("Wrong item", test_load(dtype, &buffer[k * itemsize]) == values[k]);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &result));
+    caterva_remove(data->ctx, urlpath);
+
+    // The axis and the chunkshape of the result
+    CUTEST_ASSERT("The axis must be checked",
+                  caterva_scan(data->ctx, array, dtype, op, ndim, &rstorage, &result) !=
+                  CATERVA_SUCCEED);
+    rstorage.urlpath = NULL;
+    rstorage.chunkshape[0] = shapes.chunkshape[0] + 1;
+    rstorage.blockshape[0] = shapes.blockshape[0];
+    CUTEST_ASSERT("The chunkshape must be checked",
+                  caterva_scan(data->ctx, array, dtype, op, axis, &rstorage, &result) !=
+                  CATERVA_SUCCEED);
+
+    free(values);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(scan) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(scan);
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+
+#include "test_common.h"
+
+#define MAX_INDEXES 6
+
+// A selector whose mask selects the items where index % mask_mod == 0. Lists with more than
+// MAX_INDEXES indexes are generated as (j * mask_mod + 5) % shape.
+typedef struct {
+    caterva_selector_kind_t kind;
+    int64_t start;
+    int64_t stop;
+    int64_t step;
+    int64_t nindexes;
+    int64_t indexes[MAX_INDEXES];
+    int64_t mask_mod;
+} test_selector_t;
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    test_selector_t selectors[CATERVA_MAX_DIM];
+} test_selection_t;
+
+#define SLICE(start, stop, step) {CATERVA_SELECTOR_SLICE, start, stop, step, 0, {0}, 0}
+#define LIST(n, ...) {CATERVA_SELECTOR_LIST, 0, 0, 0, n, {__VA_ARGS__}, 0}
+#define MASK(mod) {CATERVA_SELECTOR_MASK, 0, 0, 0, 0, {0}, mod}
+#define GENLIST(n, mul) {CATERVA_SELECTOR_LIST, 0, 0, 0, n, {0}, mul}
+
+
+CUTEST_TEST_DATA(selection) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(selection) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    // The chunks of the selections are split across the threads
+    cfg.nthreads = 4;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(
+            2,
+            8,
+    ));
+
+    CUTEST_PARAMETRIZE(selections, test_selection_t, CUTEST_DATA(
+            {1, {20}, {7}, {3}, {SLICE(2, 19, 1)}},
+            {1, {20}, {7}, {3}, {SLICE(19, -1, -3)}},
+            {2, {14, 10}, {8, 5}, {2, 2}, {SLICE(0, 14, 1), LIST(3, 9, 0, 4)}},
+            {2, {14, 10}, {8, 5}, {2, 2}, {MASK(3), SLICE(1, 10, 2)}},
+            {3, {12, 10, 14}, {3, 5, 9}, {3, 4, 4}, {SLICE(0, 12, 1), LIST(3, 3, 7, 3), SLICE(2, 13, 1)}},
+            {3, {12, 10, 14}, {3, 5, 9}, {3, 4, 4}, {LIST(2, 11, 0), MASK(2), SLICE(13, 0, -1)}},
+            {2, {14, 10}, {8, 5}, {2, 2}, {LIST(4, 13, 9, 8, 1), LIST(5, 0, 2, 2, 3, 9)}}, // monotone
+            {2, {300, 10}, {64, 5}, {16, 2}, {GENLIST(600, 37), SLICE(0, 10, 1)}},
+            {2, {14, 10}, {8, 5}, {2, 2}, {SLICE(0, 14, 1), SLICE(0, 10, 1)}}, // full
+            {2, {14, 10}, {8, 5}, {2, 2}, {SLICE(0, 8, 1), SLICE(2, 10, 1)}}, // full blocks
+            {2, {14, 5}, {8, 5}, {2, 2}, {MASK(1), LIST(6, 4, 3, 2, 1, 0, 2)}}, // full, duplicates
+            {1, {5000}, {1000}, {100}, {GENLIST(400, 2371)}},
+            {2, {256, 60}, {16, 10}, {4, 5}, {SLICE(1, 255, 2), GENLIST(50, 7)}}, // many chunks
+    ));
+}
+
+CUTEST_TEST_TEST(selection) {
+    CUTEST_GET_PARAMETER(selections, test_selection_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = selections.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = selections.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = selections.chunkshape[i];
+        storage.blockshape[i] = selections.blockshape[i];
+    }
+
+    // Build the selectors and the list of values selected per axis
+    caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+    bool masks[CATERVA_MAX_DIM][64];
+    int64_t values[CATERVA_MAX_DIM][1024];
+    int64_t genindexes[CATERVA_MAX_DIM][1024];
+    int64_t sel_shape[CATERVA_MAX_DIM];
+    int64_t sel_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        test_selector_t *ts = &selections.selectors[i];
+        selectors[i].kind = ts->kind;
+        sel_shape[i] = 0;
+        switch (ts->kind) {
+            case CATERVA_SELECTOR_SLICE:
+                selectors[i].start = ts->start;
+                selectors[i].stop = ts->stop;
+                selectors[i].step = ts->step;
+                for (int64_t v = ts->start; ts->step > 0 ? v < ts->stop : v > ts->stop; v += ts->step) {
+                    values[i][sel_shape[i]++] = v;
+                }
+                break;
+            case CATERVA_SELECTOR_LIST:
+                selectors[i].indexes = ts->indexes;
+                selectors[i].nindexes = ts->nindexes;
+                if (ts->nindexes > MAX_INDEXES) {
+                    for (int64_t j = 0; j < ts->nindexes; ++j) {
+                        genindexes[i][j] = (j * ts->mask_mod + 5) % params.shape[i];
+                    }
+                    selectors[i].indexes = genindexes[i];
+                }
+                for (int64_t j = 0; j < ts->nindexes; ++j) {
+                    values[i][sel_shape[i]++] = selectors[i].indexes[j];
+                }
+                break;
+            case CATERVA_SELECTOR_MASK:
+                for (int64_t v = 0; v < params.shape[i]; ++v) {
+                    masks[i][v] = v % ts->mask_mod == 0;
+                    if (masks[i][v]) {
+                        values[i][sel_shape[i]++] = v;
+                    }
+                }
+                selectors[i].mask = masks[i];
+                break;
+        }
+        sel_nitems *= sel_shape[i];
+    }
+
+    int64_t nitems = 1;
+    int64_t strides[CATERVA_MAX_DIM];
+    for (int i = params.ndim - 1; i >= 0; --i) {
+        strides[i] = nitems;
+        nitems *= params.shape[i];
+    }
+    uint8_t *buffer = data->ctx->cfg->alloc(nitems * itemsize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, nitems));
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &src));
+
+    // Get the selection and compare it with the source buffer
+    uint8_t *selbuffer = data->ctx->cfg->alloc(sel_nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_get_selection(data->ctx, src, selectors, selbuffer, sel_shape,
+                                              sel_nitems * itemsize));
+    for (int64_t k = 0; k < sel_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += values[i][rem % sel_shape[i]] * strides[i];
+            rem /= sel_shape[i];
+        }
+        CUTEST_ASSERT("Elements are not equals!",
+                      memcmp(&selbuffer[k * itemsize], &buffer[index * itemsize], itemsize) == 0);
+    }
+
+    // Set the selection to new values and compare the whole array with the model
+    for (int64_t k = 0; k < sel_nitems * itemsize; ++k) {
+        selbuffer[k] = (uint8_t) (k % 251 + 3);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_selection(data->ctx, src, selectors, selbuffer, sel_shape,
+                                              sel_nitems * itemsize));
+    for (int64_t k = 0; k < sel_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += values[i][rem % sel_shape[i]] * strides[i];
+            rem /= sel_shape[i];
+        }
+        memcpy(&buffer[index * itemsize], &selbuffer[k * itemsize], itemsize);
+    }
+
+    uint8_t *destbuffer = data->ctx->cfg->alloc(nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, destbuffer, nitems * itemsize));
+    CUTEST_ASSERT("Elements are not equals!",
+                  memcmp(destbuffer, buffer, nitems * itemsize) == 0);
+
+    /* Free mallocs */
+    data->ctx->cfg->free(buffer);
+    data->ctx->cfg->free(selbuffer);
+    data->ctx->cfg->free(destbuffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(selection) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(selection);
+}
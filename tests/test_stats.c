@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <math.h>
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(stats) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(stats) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT16,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {20, 14}, {8, 5}, {3, 2}},
+            {3, {12, 10, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+static void test_store(caterva_dtype_t dtype, uint8_t *dest, double v) {
+    int16_t i16 = (int16_t) v;
+    if (dtype == CATERVA_INT16) {
+        memcpy(dest, &i16, sizeof(i16));
+    } else {
+        memcpy(dest, &v, sizeof(v));
+    }
+}
+
+static double test_min(caterva_dtype_t dtype, const caterva_stats_t *stats) {
+    return dtype == CATERVA_INT16 ? (double) stats->min.i : stats->min.f;
+}
+
+static double test_max(caterva_dtype_t dtype, const caterva_stats_t *stats) {
+    return dtype == CATERVA_INT16 ? (double) stats->max.i : stats->max.f;
+}
+
+// Compare the statistics of every chunk and block with the ones of the items in values
+static int test_check(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                      const double *values) {
+    int8_t ndim = array->ndim;
+    int64_t nchunks = array->extnitems / array->chunknitems;
+    int64_t nblocks = array->extchunknitems / array->blocknitems;
+    caterva_stats_t *expected = calloc(nchunks * nblocks, sizeof(caterva_stats_t));
+
+    for (int64_t k = 0; k < array->nitems; ++k) {
+        int64_t nchunk = 0;
+        int64_t nblock = 0;
+        int64_t rem = k;
+        int64_t chunk_stride = 1;
+        int64_t block_stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            int64_t index = rem % array->shape[i];
+            rem /= array->shape[i];
+            nchunk += index / array->chunkshape[i] * chunk_stride;
+            nblock += index % array->chunkshape[i] / array->blockshape[i] * block_stride;
+            chunk_stride *= array->extshape[i] / array->chunkshape[i];
+            block_stride *= array->extchunkshape[i] / array->blockshape[i];
+        }
+        caterva_stats_t *e = &expected[nchunk * nblocks + nblock];
+        double v = values[k];
+        if (isnan(v)) {
+            e->nnans++;
+        } else if (e->nitems == e->nnans) {
+            e->min.f = v;
+            e->max.f = v;
+        } else {
+            e->min.f = v < e->min.f ? v : e->min.f;
+            e->max.f = v > e->max.f ? v : e->max.f;
+        }
+        e->nitems++;
+    }
+
+    for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+        caterva_stats_t chunk_stats;
+        CATERVA_TEST_ASSERT(caterva_get_chunk_stats(ctx, array, nchunk, &chunk_stats));
+        caterva_stats_t chunk = {0};
+        for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+            caterva_stats_t stats;
+            CATERVA_TEST_ASSERT(caterva_get_block_stats(ctx, array, nchunk, nblock, &stats));
+            caterva_stats_t *e = &expected[nchunk * nblocks + nblock];
+            CUTEST_ASSERT("Wrong number of items in a block", stats.nitems == e->nitems);
+            CUTEST_ASSERT("Wrong number of NaNs in a block", stats.nnans == e->nnans);
+            if (e->nitems > e->nnans) {
+                CUTEST_ASSERT("Wrong minimum of a block", test_min(dtype, &stats) == e->min.f);
+                CUTEST_ASSERT("Wrong maximum of a block", test_max(dtype, &stats) == e->max.f);
+                if (chunk.nitems == chunk.nnans || e->min.f < chunk.min.f) {
+                    chunk.min.f = e->min.f;
+                }
+                if (chunk.nitems == chunk.nnans || e->max.f > chunk.max.f) {
+                    chunk.max.f = e->max.f;
+                }
+            }
+            chunk.nitems += e->nitems;
+            chunk.nnans += e->nnans;
+        }
+        CUTEST_ASSERT("Wrong number of items in a chunk", chunk_stats.nitems == chunk.nitems);
+        CUTEST_ASSERT("Wrong number of NaNs in a chunk", chunk_stats.nnans == chunk.nnans);
+        if (chunk.nitems > chunk.nnans) {
+            CUTEST_ASSERT("Wrong minimum of a chunk", test_min(dtype, &chunk_stats) == chunk.min.f);
+            CUTEST_ASSERT("Wrong maximum of a chunk", test_max(dtype, &chunk_stats) == chunk.max.f);
+        }
+    }
+    free(expected);
+    return 0;
+}
+
+CUTEST_TEST_TEST(stats) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_stats.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    uint8_t itemsize = dtype == CATERVA_INT16 ? 2 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    if (backend.persistent) {
+        storage.urlpath = urlpath;
+    }
+    storage.contiguous = backend.contiguous;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    // Room for the rows added by the resize
+    int64_t maxnitems = nitems / shapes.shape[0] * (shapes.shape[0] + shapes.chunkshape[0] + 1);
+    double *values = calloc(maxnitems, sizeof(double));
+    uint8_t *buffer = malloc(maxnitems * itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        values[i] = (double) ((i * 7919) % 101) - 37;
+        if (dtype == CATERVA_FLOAT64 && i % 13 == 5) {
+            values[i] = NAN;
+        }
+        test_store(dtype, &buffer[i * itemsize], values[i]);
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &array));
+    caterva_stats_t stats;
+    CUTEST_ASSERT("The statistics must be disabled",
+                  caterva_get_chunk_stats(data->ctx, array, 0, &stats) != CATERVA_SUCCEED);
+    CATERVA_TEST_ASSERT(caterva_enable_stats(data->ctx, array, dtype));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, values));
+
+    // A slice
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slice_shape[CATERVA_MAX_DIM];
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = 1;
+        stop[i] = shapes.shape[i] / 2 + 1;
+        slice_shape[i] = stop[i] - start[i];
+        slice_nitems *= slice_shape[i];
+    }
+    for (int64_t k = 0; k < slice_nitems; ++k) {
+        int64_t index = 0;
+        int64_t rem = k;
+        int64_t stride = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            index += (start[i] + rem % slice_shape[i]) * stride;
+            rem /= slice_shape[i];
+            stride *= shapes.shape[i];
+        }
+        values[index] = (double) (1000 + k);
+        test_store(dtype, &buffer[k * itemsize], values[index]);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, buffer, slice_shape,
+                                                 slice_nitems * itemsize, start, stop, array));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, values));
+
+    // An orthogonal selection with the last item of every axis
+    int64_t last[CATERVA_MAX_DIM];
+    int64_t *selection[CATERVA_MAX_DIM];
+    int64_t selection_size[CATERVA_MAX_DIM];
+    int64_t index = 0;
+    for (int i = 0; i < params.ndim; ++i) {
+        last[i] = shapes.shape[i] - 1;
+        selection[i] = &last[i];
+        selection_size[i] = 1;
+        index = index * shapes.shape[i] + last[i];
+    }
+    values[index] = -500;
+    test_store(dtype, buffer, values[index]);
+    CATERVA_TEST_ASSERT(caterva_set_orthogonal_selection(data->ctx, array, selection,
+                                                         selection_size, buffer, selection_size,
+                                                         itemsize));
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, values));
+
+    // A resize adding zeros at the end of the first axis
+    int64_t new_shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        new_shape[i] = shapes.shape[i];
+    }
+    new_shape[0] += shapes.chunkshape[0] + 1;
+    CATERVA_TEST_ASSERT(caterva_resize(data->ctx, array, new_shape, NULL));
+    for (int64_t i = nitems; i < maxnitems; ++i) {
+        values[i] = 0;
+    }
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array, dtype, values));
+
+    // The statistics are stored with the array
+    caterva_array_t *array2;
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &array));
+        array2 = array;
+    } else {
+        uint8_t *cframe;
+        int64_t cframe_len;
+        bool needs_free;
+        CATERVA_TEST_ASSERT(caterva_to_cframe(data->ctx, array, &cframe, &cframe_len,
+                                              &needs_free));
+        CATERVA_TEST_ASSERT(caterva_from_cframe(data->ctx, cframe, cframe_len, true, &array2));
+        if (needs_free) {
+            free(cframe);
+        }
+    }
+    CUTEST_ASSERT("The statistics must be loaded", array2->stats != NULL);
+    CATERVA_TEST_ASSERT(test_check(data->ctx, array2, dtype, values));
+    if (array2 != array) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array2));
+    }
+
+    CATERVA_TEST_ASSERT(caterva_disable_stats(data->ctx, array));
+    CUTEST_ASSERT("The statistics must be disabled",
+                  caterva_get_chunk_stats(data->ctx, array, 0, &stats) != CATERVA_SUCCEED);
+
+    free(values);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(stats) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(stats);
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(stencil) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(stencil) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT32,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(boundary, caterva_boundary_t, CUTEST_DATA(
+            CATERVA_BOUNDARY_CONSTANT,
+            CATERVA_BOUNDARY_NEAREST,
+    ));
+
+    // The memory budget, 0 for no limit and 1 for tiles of a single chunk
+    CUTEST_PARAMETRIZE(budget, int64_t, CUTEST_DATA(0, 1));
+
+    // A halo of 1 along every axis, or a halo larger than a chunk along the first axis
+    CUTEST_PARAMETRIZE(wide, bool, CUTEST_DATA(false, true));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+static double test_load(caterva_dtype_t dtype, const uint8_t *src) {
+    if (dtype == CATERVA_INT32) {
+        return (double) *(const int32_t *) src;
+    }
+    return *(const double *) src;
+}
+
+// The maximum of the items around every item
+static int test_max_kernel(caterva_stencil_params_t *params) {
+    caterva_dtype_t dtype = *(caterva_dtype_t *) params->user_data;
+    int8_t ndim = params->ndim;
+    int64_t nitems = 1;
+    int64_t input_shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        nitems *= params->block_shape[i];
+        input_shape[i] = params->blockshape[i] + 2 * params->halo[i];
+    }
+    for (int64_t k = 0; k < nitems; ++k) {
+        int64_t coords[CATERVA_MAX_DIM];
+        int64_t rem = k;
+        int64_t offset = 0;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            coords[i] = rem % params->block_shape[i];
+            rem /= params->block_shape[i];
+            offset += coords[i] * stride;
+            stride *= params->blockshape[i];
+        }
+        int64_t window[CATERVA_MAX_DIM] = {0};
+        double max = -1e300;
+        bool more = true;
+        while (more) {
+            int64_t input_offset = 0;
+            for (int i = 0; i < ndim; ++i) {
+                input_offset = input_offset * input_shape[i] + coords[i] + window[i];
+            }
+            double v = test_load(dtype, &params->input[input_offset * params->itemsize]);
+            max = v > max ? v : max;
+            more = false;
+            for (int i = ndim - 1; i >= 0 && !more; --i) {
+                window[i]++;
+                more = window[i] < 2 * params->halo[i] + 1;
+                if (!more) {
+                    window[i] = 0;
+                }
+            }
+        }
+        uint8_t *dest = &params->output[offset * params->itemsize];
+        if (dtype == CATERVA_INT32) {
+            *(int32_t *) dest = (int32_t) max;
+        } else {
+            *(double *) dest = max;
+        }
+    }
+    return 0;
+}
+
+CUTEST_TEST_TEST(stencil) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(boundary, caterva_boundary_t);
+    CUTEST_GET_PARAMETER(budget, int64_t);
+    CUTEST_GET_PARAMETER(wide, bool);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    data->ctx->cfg->memory_budget = budget;
+    int8_t ndim = shapes.ndim;
+    uint8_t itemsize = dtype == CATERVA_INT32 ? 4 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+    double *values = malloc(nitems * sizeof(double));
+    uint8_t *buffer = malloc(nitems * itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        values[i] = (double) ((i * 7) % 23) - 5;
+        if (dtype == CATERVA_INT32) {
+            ((int32_t *) buffer)[i] = (int32_t) values[i];
+        } else {
+            ((double *) buffer)[i] = values[i];
+        }
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &array));
+
+    caterva_stencil_t stencil = {0};
+    int64_t taps[CATERVA_MAX_DIM];
+    int64_t ntaps = 1;
+    for (int i = 0; i < ndim; ++i) {
+        stencil.halo[i] = wide ? (i == 0 ? shapes.chunkshape[0] + 1 : 0) : 1;
+        taps[i] = 2 * stencil.halo[i] + 1;
+        ntaps *= taps[i];
+    }
+    double *weights = malloc(ntaps * sizeof(double));
+    for (int64_t t = 0; t < ntaps; ++t) {
+        weights[t] = (double) (t % 5) - 1.5;
+    }
+    stencil.boundary = boundary;
+    if (dtype == CATERVA_INT32) {
+        stencil.value.i = 3;
+    } else {
+        stencil.value.f = 3;
+    }
+    stencil.weights = weights;
+
+    // The expected weighted sums and maximums
+    double *sums = malloc(nitems * sizeof(double));
+    double *maxs = malloc(nitems * sizeof(double));
+    for (int64_t k = 0; k < nitems; ++k) {
+        int64_t coords[CATERVA_MAX_DIM];
+        int64_t rem = k;
+        for (int i = ndim - 1; i >= 0; --i) {
+            coords[i] = rem % shapes.shape[i];
+            rem /= shapes.shape[i];
+        }
+        double sum = 0;
+        double max = -1e300;
+        for (int64_t t = 0; t < ntaps; ++t) {
+            int64_t trem = t;
+            int64_t index = 0;
+            bool outside = false;
+            int64_t tap[CATERVA_MAX_DIM];
+            for (int i = ndim - 1; i >= 0; --i) {
+                tap[i] = trem % taps[i];
+                trem /= taps[i];
+            }
+            for (int i = 0; i < ndim; ++i) {
+                int64_t c = coords[i] - stencil.halo[i] + tap[i];
+                if (c < 0 || c >= shapes.shape[i]) {
+                    outside = true;
+                    c = c < 0 ? 0 : shapes.shape[i] - 1;
+                }
+                index = index * shapes.shape[i] + c;
+            }
+            double v = values[index];
+            if (outside && boundary == CATERVA_BOUNDARY_CONSTANT) {
+                v = 3;
+            }
+            sum += weights[t] * v;
+            max = v > max ? v : max;
+        }
+        sums[k] = dtype == CATERVA_INT32 ? (double) (int32_t) sum : sum;
+        maxs[k] = max;
+    }
+
+    // The built-in kernel, with the chunkshape of the array and with another one
+    uint8_t *result = malloc(nitems * itemsize);
+    for (int auto_shapes = 0; auto_shapes < 2; ++auto_shapes) {
+        caterva_storage_t rstorage = {0};
+        for (int i = 0; i < ndim && !auto_shapes; ++i) {
+            rstorage.chunkshape[i] = shapes.chunkshape[i] / 2 + 1;
+            rstorage.blockshape[i] = shapes.blockshape[i] / 2 + 1;
+        }
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_stencil(data->ctx, array, dtype, &stencil, &rstorage, &dest));
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, result, nitems * itemsize));
+        for (int64_t k = 0; k < nitems; ++k) {
+            CUTEST_ASSERT("Wrong weighted sum", test_load(dtype, &result[k * itemsize]) == sums[k]);
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    }
+
+    // A kernel of the user
+    caterva_storage_t rstorage = {0};
+    caterva_array_t *dest;
+    stencil.kernel = test_max_kernel;
+    stencil.user_data = &dtype;
+    stencil.weights = NULL;
+    CATERVA_TEST_ASSERT(caterva_stencil(data->ctx, array, dtype, &stencil, &rstorage, &dest));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, result, nitems * itemsize));
+    for (int64_t k = 0; k < nitems; ++k) {
+        CUTEST_ASSERT("Wrong maximum", test_load(dtype, &result[k * itemsize]) == maxs[k]);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    // A negative halo
+    stencil.halo[0] = -1;
+    CUTEST_ASSERT("The halo must be checked",
+                  caterva_stencil(data->ctx, array, dtype, &stencil, &rstorage, &dest) !=
+                  CATERVA_SUCCEED);
+
+    free(result);
+    free(sums);
+    free(maxs);
+    free(weights);
+    free(values);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(stencil) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(stencil);
+}
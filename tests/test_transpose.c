@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(transpose) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(transpose) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 3, 8));
+
+    // The memory budget, 0 for no limit and 1 for tiles of a single chunk
+    CUTEST_PARAMETRIZE(budget, int64_t, CUTEST_DATA(0, 1, 4096));
+
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {false, false},
+            {true, true},
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+            {3, {10, 0, 9}, {5, 4, 9}, {2, 3, 4}},
+            {4, {6, 7, 5, 4}, {3, 4, 2, 4}, {2, 2, 2, 3}},
+    ));
+}
+
+CUTEST_TEST_TEST(transpose) {
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+    CUTEST_GET_PARAMETER(budget, int64_t);
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpath = "test_transpose.b2frame";
+    caterva_remove(data->ctx, urlpath);
+    data->ctx->cfg->memory_budget = budget;
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+    uint8_t *buffer = malloc(nitems * itemsize + 1);
+    for (int64_t i = 0; i < nitems * itemsize; ++i) {
+        buffer[i] = (uint8_t) (i * 7 + i / 251);
+    }
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &src));
+
+    // Reverse the axes, with the chunk and block shapes of the source and with other ones
+    int8_t perm[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        perm[i] = (int8_t) (params.ndim - 1 - i);
+    }
+    for (int auto_shapes = 0; auto_shapes < 2; ++auto_shapes) {
+        caterva_storage_t dstorage = {0};
+        if (backend.persistent) {
+            dstorage.urlpath = urlpath;
+        }
+        dstorage.contiguous = backend.contiguous;
+        for (int i = 0; i < params.ndim && !auto_shapes; ++i) {
+            dstorage.chunkshape[i] = shapes.chunkshape[i] / 2 + 1;
+            dstorage.blockshape[i] = shapes.blockshape[i] / 2 + 1;
+        }
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_transpose(data->ctx, src, perm, &dstorage, &dest));
+        for (int i = 0; i < params.ndim; ++i) {
+            CUTEST_ASSERT("Wrong shape", dest->shape[i] == shapes.shape[perm[i]]);
+            if (auto_shapes) {
+                CUTEST_ASSERT("Wrong chunkshape",
+                              dest->chunkshape[i] == shapes.chunkshape[perm[i]]);
+            }
+        }
+
+        uint8_t *result = malloc(nitems * itemsize + 1);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, result, nitems * itemsize));
+        for (int64_t k = 0; k < nitems; ++k) {
+            // The index in the source of the item k of the result
+            int64_t rem = k;
+            int64_t coords[CATERVA_MAX_DIM];
+            for (int i = params.ndim - 1; i >= 0; --i) {
+                coords[perm[i]] = rem % dest->shape[i];
+                rem /= dest->shape[i];
+            }
+            int64_t index = 0;
+            for (int i = 0; i < params.ndim; ++i) {
+                index = index * shapes.shape[i] + coords[i];
+            }
+            CUTEST_ASSERT("Wrong item", memcmp(&result[k * itemsize], &buffer[index * itemsize],
+                                               itemsize) == 0);
+        }
+        free(result);
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+        caterva_remove(data->ctx, urlpath);
+    }
+
+    // An invalid permutation
+    if (params.ndim > 1) {
+        int8_t wrong[CATERVA_MAX_DIM] = {0};
+        caterva_storage_t dstorage = {0};
+        caterva_array_t *dest;
+        CUTEST_ASSERT("The permutation must be checked",
+                      caterva_transpose(data->ctx, src, wrong, &dstorage, &dest) !=
+                      CATERVA_SUCCEED);
+    }
+
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(transpose) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(transpose);
+}
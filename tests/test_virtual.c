@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define NARRAYS 3
+
+
+CUTEST_TEST_DATA(virtual) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(virtual) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    // The first or the last axis
+    CUTEST_PARAMETRIZE(last_axis, bool, CUTEST_DATA(false, true));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {21, 14}, {8, 5}, {3, 2}},
+            {3, {12, 11, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+// The index in the whole virtual array of the item k of a selection with the given indexes
+static int64_t test_index(int8_t ndim, const int64_t *shape, int64_t *const *indexes,
+                          const int64_t *nindexes, int64_t k) {
+    int64_t coords[CATERVA_MAX_DIM];
+    for (int i = ndim - 1; i >= 0; --i) {
+        coords[i] = indexes[i][k % nindexes[i]];
+        k /= nindexes[i];
+    }
+    int64_t index = 0;
+    for (int i = 0; i < ndim; ++i) {
+        index = index * shape[i] + coords[i];
+    }
+    return index;
+}
+
+CUTEST_TEST_TEST(virtual) {
+    CUTEST_GET_PARAMETER(last_axis, bool);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    char *urlpaths[NARRAYS] = {"test_virtual_0.b2frame", "test_virtual_1.b2frame",
+                               "test_virtual_2.b2frame"};
+    char *urlpath = "test_virtual.b2frame";
+    caterva_remove(data->ctx, urlpath);
+
+    // Three persistent arrays with different lengths along the axis
+    int8_t ndim = shapes.ndim;
+    int8_t axis = (int8_t) (last_axis ? ndim - 1 : 0);
+    int32_t cs = shapes.chunkshape[axis];
+    int64_t lengths[NARRAYS] = {cs - 1, cs + 2, 3};
+    uint8_t itemsize = sizeof(int32_t);
+    caterva_array_t *arrays[NARRAYS];
+    int64_t offsets[NARRAYS + 1] = {0};
+    int64_t shape[CATERVA_MAX_DIM];
+    for (int n = 0; n < NARRAYS; ++n) {
+        caterva_remove(data->ctx, urlpaths[n]);
+        caterva_params_t params;
+        params.itemsize = itemsize;
+        params.ndim = ndim;
+        int64_t nitems = 1;
+        for (int i = 0; i < ndim; ++i) {
+            params.shape[i] = i == axis ? lengths[n] : shapes.shape[i];
+            nitems *= params.shape[i];
+        }
+        offsets[n + 1] = offsets[n] + lengths[n];
+        caterva_storage_t storage = {0};
+        storage.urlpath = urlpaths[n];
+        storage.contiguous = true;
+        for (int i = 0; i < ndim; ++i) {
+            storage.chunkshape[i] = shapes.chunkshape[i];
+            storage.blockshape[i] = shapes.blockshape[i];
+        }
+        int32_t *buffer = malloc(nitems * itemsize);
+        for (int64_t i = 0; i < nitems; ++i) {
+            buffer[i] = (int32_t) (n * 100000 + i);
+        }
+        CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                                &storage, &arrays[n]));
+        free(buffer);
+    }
+
+    // The items of the whole virtual array, in the same order
+    int64_t nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        shape[i] = i == axis ? offsets[NARRAYS] : shapes.shape[i];
+        nitems *= shape[i];
+    }
+    int32_t *expected = malloc(nitems * itemsize);
+    for (int64_t k = 0; k < nitems; ++k) {
+        int64_t coords[CATERVA_MAX_DIM];
+        int64_t rem = k;
+        for (int i = ndim - 1; i >= 0; --i) {
+            coords[i] = rem % shape[i];
+            rem /= shape[i];
+        }
+        int n = 0;
+        while (offsets[n + 1] <= coords[axis]) {
+            n++;
+        }
+        int64_t index = 0;
+        for (int i = 0; i < ndim; ++i) {
+            int64_t coord = i == axis ? coords[i] - offsets[n] : coords[i];
+            index = index * arrays[n]->shape[i] + coord;
+        }
+        expected[k] = (int32_t) (n * 100000 + index);
+    }
+
+    caterva_virtual_t *varray;
+    CATERVA_TEST_ASSERT(caterva_virtual_new(data->ctx, arrays, NARRAYS, axis, &varray));
+    CUTEST_ASSERT("Wrong length of the axis", varray->shape[axis] == offsets[NARRAYS]);
+    int32_t *result = malloc(nitems * itemsize);
+    CATERVA_TEST_ASSERT(caterva_virtual_to_buffer(data->ctx, varray, result, nitems * itemsize));
+    CUTEST_ASSERT("Wrong items", memcmp(result, expected, nitems * itemsize) == 0);
+
+    // A slice spanning the three arrays, into a larger buffer
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t buffershape[CATERVA_MAX_DIM];
+    int64_t *slice_indexes[CATERVA_MAX_DIM];
+    int64_t slice_nindexes[CATERVA_MAX_DIM];
+    int64_t buffernitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        start[i] = 1;
+        stop[i] = shape[i] - 1;
+        buffershape[i] = stop[i] - start[i] + 1;
+        buffernitems *= buffershape[i];
+        slice_nindexes[i] = stop[i] - start[i];
+        slice_indexes[i] = malloc(slice_nindexes[i] * sizeof(int64_t));
+        for (int64_t j = 0; j < slice_nindexes[i]; ++j) {
+            slice_indexes[i][j] = start[i] + j;
+        }
+    }
+    CATERVA_TEST_ASSERT(caterva_virtual_get_slice_buffer(data->ctx, varray, start, stop, result,
+                                                         buffershape, buffernitems * itemsize));
+    int64_t slice_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        slice_nitems *= slice_nindexes[i];
+    }
+    for (int64_t k = 0; k < slice_nitems; ++k) {
+        int64_t offset = 0;
+        int64_t rem = k;
+        int64_t stride = 1;
+        for (int i = ndim - 1; i >= 0; --i) {
+            offset += rem % slice_nindexes[i] * stride;
+            rem /= slice_nindexes[i];
+            stride *= buffershape[i];
+        }
+        CUTEST_ASSERT("Wrong slice",
+                      result[offset] ==
+                      expected[test_index(ndim, shape, slice_indexes, slice_nindexes, k)]);
+    }
+
+    // An orthogonal selection with unordered and repeated indexes of every array
+    int64_t *selection[CATERVA_MAX_DIM];
+    int64_t selection_size[CATERVA_MAX_DIM];
+    int64_t selection_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        selection_size[i] = 4;
+        selection[i] = malloc(selection_size[i] * sizeof(int64_t));
+        selection[i][0] = shape[i] - 1;
+        selection[i][1] = 0;
+        selection[i][2] = shape[i] / 2;
+        selection[i][3] = shape[i] - 1;
+        selection_nitems *= selection_size[i];
+    }
+    CATERVA_TEST_ASSERT(caterva_virtual_get_orthogonal_selection(
+            data->ctx, varray, selection, selection_size, result, selection_size,
+            selection_nitems * itemsize));
+    for (int64_t k = 0; k < selection_nitems; ++k) {
+        CUTEST_ASSERT("Wrong orthogonal selection",
+                      result[k] == expected[test_index(ndim, shape, selection, selection_size, k)]);
+    }
+
+    // A selection with a reversed slice along the axis and masks along the other axes
+    caterva_selector_t selectors[CATERVA_MAX_DIM] = {0};
+    bool *masks[CATERVA_MAX_DIM];
+    int64_t *indexes[CATERVA_MAX_DIM];
+    int64_t nindexes[CATERVA_MAX_DIM];
+    int64_t selectors_nitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        masks[i] = malloc(shape[i] * sizeof(bool));
+        indexes[i] = malloc(shape[i] * sizeof(int64_t));
+        nindexes[i] = 0;
+        if (i == axis) {
+            selectors[i].kind = CATERVA_SELECTOR_SLICE;
+            selectors[i].start = shape[i] - 1;
+            selectors[i].stop = -1;
+            selectors[i].step = -2;
+            for (int64_t j = shape[i] - 1; j > -1; j -= 2) {
+                indexes[i][nindexes[i]++] = j;
+            }
+        } else {
+            selectors[i].kind = CATERVA_SELECTOR_MASK;
+            selectors[i].mask = masks[i];
+            for (int64_t j = 0; j < shape[i]; ++j) {
+                masks[i][j] = j % 3 != 1;
+                if (masks[i][j]) {
+                    indexes[i][nindexes[i]++] = j;
+                }
+            }
+        }
+        selectors_nitems *= nindexes[i];
+    }
+    CATERVA_TEST_ASSERT(caterva_virtual_get_selection(data->ctx, varray, selectors, result,
+                                                      nindexes, selectors_nitems * itemsize));
+    for (int64_t k = 0; k < selectors_nitems; ++k) {
+        CUTEST_ASSERT("Wrong selection",
+                      result[k] == expected[test_index(ndim, shape, indexes, nindexes, k)]);
+    }
+
+    // A slice materialized in a new array
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+    caterva_array_t *slice;
+    CATERVA_TEST_ASSERT(caterva_virtual_get_slice(data->ctx, varray, start, stop, &storage,
+                                                  &slice));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, slice, result, slice_nitems * itemsize));
+    for (int64_t k = 0; k < slice_nitems; ++k) {
+        CUTEST_ASSERT("Wrong materialized slice",
+                      result[k] ==
+                      expected[test_index(ndim, shape, slice_indexes, slice_nindexes, k)]);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &slice));
+
+    // The virtual array is stored without copying the arrays, which are opened when needed
+    CATERVA_TEST_ASSERT(caterva_virtual_save(data->ctx, varray, urlpath));
+    CATERVA_TEST_ASSERT(caterva_virtual_free(data->ctx, &varray));
+    for (int n = 0; n < NARRAYS; ++n) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &arrays[n]));
+    }
+    CATERVA_TEST_ASSERT(caterva_virtual_open(data->ctx, urlpath, &varray));
+    for (int i = 0; i < ndim; ++i) {
+        CUTEST_ASSERT("Wrong shape", varray->shape[i] == shape[i]);
+        start[i] = 0;
+        stop[i] = shape[i];
+        buffershape[i] = shape[i];
+    }
+    for (int n = 0; n < NARRAYS; ++n) {
+        CUTEST_ASSERT("The arrays must not be opened yet", varray->sources[n] == NULL);
+    }
+    start[axis] = offsets[1];
+    stop[axis] = offsets[2];
+    buffershape[axis] = lengths[1];
+    CATERVA_TEST_ASSERT(caterva_virtual_get_slice_buffer(data->ctx, varray, start, stop, result,
+                                                         buffershape, nitems * itemsize));
+    CUTEST_ASSERT("Only the second array must be opened",
+                  varray->sources[0] == NULL && varray->sources[1] != NULL &&
+                  varray->sources[2] == NULL);
+    CATERVA_TEST_ASSERT(caterva_virtual_to_buffer(data->ctx, varray, result, nitems * itemsize));
+    CUTEST_ASSERT("Wrong stored items", memcmp(result, expected, nitems * itemsize) == 0);
+
+    // Out of bounds slices and in-memory arrays can not be stored
+    stop[axis] = shape[axis] + 1;
+    CUTEST_ASSERT("The slice must be checked",
+                  caterva_virtual_get_slice_buffer(data->ctx, varray, start, stop, result,
+                                                   shape, nitems * itemsize) != CATERVA_SUCCEED);
+    CATERVA_TEST_ASSERT(caterva_virtual_free(data->ctx, &varray));
+    caterva_params_t params = {0};
+    params.itemsize = itemsize;
+    params.ndim = ndim;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_zeros(data->ctx, &params, &storage, &array));
+    CATERVA_TEST_ASSERT(caterva_virtual_new(data->ctx, &array, 1, axis, &varray));
+    CUTEST_ASSERT("The arrays must be persistent",
+                  caterva_virtual_save(data->ctx, varray, urlpath) != CATERVA_SUCCEED);
+    CATERVA_TEST_ASSERT(caterva_virtual_free(data->ctx, &varray));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+
+    for (int i = 0; i < ndim; ++i) {
+        free(slice_indexes[i]);
+        free(selection[i]);
+        free(masks[i]);
+        free(indexes[i]);
+    }
+    free(result);
+    free(expected);
+    for (int n = 0; n < NARRAYS; ++n) {
+        caterva_remove(data->ctx, urlpaths[n]);
+    }
+    caterva_remove(data->ctx, urlpath);
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(virtual) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(virtual);
+}
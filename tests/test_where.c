@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <math.h>
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(where) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(where) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_INT16,
+            CATERVA_FLOAT64,
+    ));
+
+    CUTEST_PARAMETRIZE(stats, bool, CUTEST_DATA(
+            false,
+            true,
+    ));
+
+    CUTEST_PARAMETRIZE(query, int, CUTEST_DATA(
+            0,
+            1,
+            2,
+            3,
+            4,
+    ));
+
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {50}, {20}, {7}},
+            {2, {20, 14}, {8, 5}, {3, 2}},
+            {3, {12, 10, 9}, {5, 4, 9}, {2, 3, 4}},
+    ));
+}
+
+static caterva_scalar_t test_scalar(caterva_dtype_t dtype, double v) {
+    caterva_scalar_t scalar;
+    if (dtype == CATERVA_INT16) {
+        scalar.i = (int64_t) v;
+    } else {
+        scalar.f = v;
+    }
+    return scalar;
+}
+
+static bool test_match(const caterva_predicate_t *predicate, double v) {
+    double value = predicate->value.f;
+    switch (predicate->op) {
+        case CATERVA_PREDICATE_LT:
+            return v < value;
+        case CATERVA_PREDICATE_LE:
+            return v <= value;
+        case CATERVA_PREDICATE_GT:
+            return v > value;
+        case CATERVA_PREDICATE_GE:
+            return v >= value;
+        case CATERVA_PREDICATE_EQ:
+            return v == value;
+        case CATERVA_PREDICATE_NE:
+            return v != value;
+        case CATERVA_PREDICATE_RANGE:
+            return v >= value && v < predicate->upper.f;
+        case CATERVA_PREDICATE_AND:
+            return test_match(predicate->left, v) && test_match(predicate->right, v);
+        default:
+            return test_match(predicate->left, v) || test_match(predicate->right, v);
+    }
+}
+
+CUTEST_TEST_TEST(where) {
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(stats, bool);
+    CUTEST_GET_PARAMETER(query, int);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+
+    // The predicates, with the values as doubles to check them
+    caterva_predicate_t expected[5][3] = {
+            {{.op = CATERVA_PREDICATE_GT, .value.f = 40}},
+            {{.op = CATERVA_PREDICATE_RANGE, .value.f = -10, .upper.f = 5}},
+            {{.op = CATERVA_PREDICATE_OR}, {.op = CATERVA_PREDICATE_LT, .value.f = -30},
+             {.op = CATERVA_PREDICATE_EQ, .value.f = 13}},
+            {{.op = CATERVA_PREDICATE_AND}, {.op = CATERVA_PREDICATE_GE, .value.f = 0},
+             {.op = CATERVA_PREDICATE_NE, .value.f = 7}},
+            {{.op = CATERVA_PREDICATE_NE, .value.f = 0}},
+    };
+    caterva_predicate_t predicate[3];
+    for (int p = 0; p < 3; ++p) {
+        predicate[p] = expected[query][p];
+        predicate[p].value = test_scalar(dtype, expected[query][p].value.f);
+        predicate[p].upper = test_scalar(dtype, expected[query][p].upper.f);
+    }
+    expected[query][0].left = &expected[query][1];
+    expected[query][0].right = &expected[query][2];
+    predicate[0].left = &predicate[1];
+    predicate[0].right = &predicate[2];
+
+    uint8_t itemsize = dtype == CATERVA_INT16 ? 2 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+        nitems *= shapes.shape[i];
+    }
+    caterva_storage_t storage = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.chunkshape[i] = shapes.chunkshape[i];
+        storage.blockshape[i] = shapes.blockshape[i];
+    }
+
+    // Values that change slowly, so that some chunks and blocks can be skipped
+    double *values = malloc(nitems * sizeof(double));
+    uint8_t *buffer = malloc(nitems * itemsize);
+    for (int64_t i = 0; i < nitems; ++i) {
+        values[i] = (double) (i * 7 / 13 % 101) - 37;
+        if (dtype == CATERVA_FLOAT64 && i % 17 == 3) {
+            values[i] = NAN;
+        }
+        if (dtype == CATERVA_INT16) {
+            int16_t v = (int16_t) values[i];
+            memcpy(&buffer[i * itemsize], &v, sizeof(v));
+        } else {
+            memcpy(&buffer[i * itemsize], &values[i], sizeof(double));
+        }
+    }
+    caterva_array_t *array;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &array));
+    if (stats) {
+        CATERVA_TEST_ASSERT(caterva_enable_stats(data->ctx, array, dtype));
+    }
+
+    // Coordinates
+    int64_t *coords;
+    int64_t ncoords;
+    CATERVA_TEST_ASSERT(caterva_where(data->ctx, array, dtype, predicate, &coords, &ncoords));
+    int64_t k = 0;
+    for (int64_t i = 0; i < nitems; ++i) {
+        if (!test_match(expected[query], values[i])) {
+            continue;
+        }
+        CUTEST_ASSERT("Too few matches", k < ncoords);
+        int64_t flat = 0;
+        for (int j = 0; j < params.ndim; ++j) {
+            flat = flat * params.shape[j] + coords[k * params.ndim + j];
+        }
+        CUTEST_ASSERT("Wrong coordinates", flat == i);
+        k++;
+    }
+    CUTEST_ASSERT("Too many matches", k == ncoords);
+    free(coords);
+
+    // Mask
+    caterva_storage_t mstorage = {0};
+    caterva_array_t *mask;
+    CATERVA_TEST_ASSERT(caterva_where_mask(data->ctx, array, dtype, predicate, &mstorage, &mask));
+    uint8_t *mbuffer = malloc(nitems);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, mask, mbuffer, nitems));
+    for (int64_t i = 0; i < nitems; ++i) {
+        CUTEST_ASSERT("Wrong mask", mbuffer[i] == test_match(expected[query], values[i]));
+    }
+    free(mbuffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &mask));
+
+    free(values);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &array));
+    return 0;
+}
+
+CUTEST_TEST_TEARDOWN(where) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(where);
+}